@@ -11,6 +11,40 @@ FDCT_WRAPPING_NS_BEGIN_NAMESPACE
 int fdct_wrapping_sepangle(double XL1, double XL2, int nbangle, CpxOffMat& Xhgh, vector<CpxNumMat>& csc);
 int fdct_wrapping_wavelet(CpxOffMat& Xhgh, vector<CpxNumMat>& csc);
 
+//-------------------------------------------------------------------
+//plans are created FFTW_THREADSAFE, which leaves them read-only after
+//creation, so one plan per size and direction is kept for the lifetime
+//of the process and shared by every call and every thread
+typedef pair< pair<int,int>, int > fdct_wrapping_plankey;
+static map<fdct_wrapping_plankey, fftwnd_plan> fdct_wrapping_plans;
+
+fftwnd_plan fdct_wrapping_plan(int n0, int n1, fftw_direction dir)
+{
+  fftwnd_plan p = NULL;
+#pragma omp critical (fftw_planner)
+  {
+	 fdct_wrapping_plankey key(pair<int,int>(n0,n1), int(dir));
+	 map<fdct_wrapping_plankey, fftwnd_plan>::iterator mit=fdct_wrapping_plans.find(key);
+	 if(mit!=fdct_wrapping_plans.end()) {
+		p = (*mit).second;
+	 } else {
+		p = fftw2d_create_plan(n0, n1, dir, FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE);
+		fdct_wrapping_plans[key] = p;
+	 }
+  }
+  return p;
+}
+
+void fdct_wrapping_clearplans()
+{
+#pragma omp critical (fftw_planner)
+  {
+	 for(map<fdct_wrapping_plankey, fftwnd_plan>::iterator mit=fdct_wrapping_plans.begin(); mit!=fdct_wrapping_plans.end(); mit++)
+		fftwnd_destroy_plan((*mit).second);
+	 fdct_wrapping_plans.clear();
+  }
+}
+
 //-------------------------------------------------------------------
 int fdct_wrapping(int N1, int N2, int nbscales, int nbangles_coarse, int allcurvelets, CpxNumMat& x, vector< vector<CpxNumMat> >& c)
 {
@@ -20,9 +54,7 @@ int fdct_wrapping(int N1, int N2, int nbscales, int nbangles_coarse, int allcurv
   int F1 = N1/2;  int F2 = N2/2;
   // ifft original data
   CpxNumMat T(x);
-  fftwnd_plan p = fftw2d_create_plan(N2, N1, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
-  fftwnd_one(p, (fftw_complex*)T.data(), NULL);
-  fftwnd_destroy_plan(p);
+  fftwnd_one(fdct_wrapping_plan(N2, N1, FFTW_FORWARD), (fftw_complex*)T.data(), NULL);
   double sqrtprod = sqrt(double(N1*N2));
   for(int j=0; j<N2; j++)	 for(int i=0; i<N1; i++)		T(i,j) /= sqrtprod;
   CpxOffMat O(N1, N2);
@@ -124,12 +156,8 @@ int fdct_wrapping(int N1, int N2, int nbscales, int nbangles_coarse, int allcurv
 int fdct_wrapping_sepangle(double XL1, double XL2, int nbangle, CpxOffMat& Xhgh, vector<CpxNumMat>& csc)
 {
   //WEDGE ORDERING: from -45 degree, counter-clockwise
-  typedef pair<int,int> intpair;
-  map<intpair, fftwnd_plan> planmap;
-  
   int nbquadrants = 4;
   int nd = nbangle / 4;
-  int wcnt = 0;
   
   //backup
   CpxOffMat Xhghb(Xhgh);
@@ -144,7 +172,10 @@ int fdct_wrapping_sepangle(double XL1, double XL2, int nbangle, CpxOffMat& Xhgh,
 	 //figure out XS, XF, XR
 	 double XW1 = XL1/nd;	 double XW2 = XL2/nd;
 	 int XS1, XS2;  int XF1, XF2;  double XR1, XR2;  fdct_wrapping_rangecompute(XL1, XL2, XS1, XS2, XF1, XF2, XR1, XR2);
+	 //the wedges of a quadrant only read Xhgh and each fills its own csc entry
+#pragma omp parallel for schedule(dynamic)
 	 for(int w=nd-1; w>=0; w--) {
+		int wcnt = qi*nd + (nd-1-w);
 		double xs = XR1/4 - (XW1/2)/4;
 		double xe = XR1;
 		double ys = -XR2 + (w-0.5)*XW2;
@@ -203,15 +234,7 @@ int fdct_wrapping_sepangle(double XL1, double XL2, int nbangle, CpxOffMat& Xhgh,
 		  CpxNumMat tpdata(xn,yn);
 		  fdct_wrapping_ifftshift(rpdata, tpdata);
 		  //ifft
-		  fftwnd_plan p = NULL;
-		  map<intpair,fftwnd_plan>::iterator mit=planmap.find( intpair(xn,yn) );
-		  if(mit!=planmap.end()) {
-			 p = (*mit).second;
-		  } else {
-			 p = fftw2d_create_plan(yn, xn, FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
-			 planmap[ intpair(xn, yn) ] = p;
-		  }
-		  fftwnd_one(p, (fftw_complex*)tpdata.data(), NULL);
+		  fftwnd_one(fdct_wrapping_plan(yn, xn, FFTW_BACKWARD), (fftw_complex*)tpdata.data(), NULL);
 		  double sqrtprod = sqrt(double(xn*yn));
 		  for(int j=0; j<yn; j++)		  for(int i=0; i<xn; i++)			 tpdata(i,j) /= sqrtprod;
 		  //store
@@ -221,18 +244,12 @@ int fdct_wrapping_sepangle(double XL1, double XL2, int nbangle, CpxOffMat& Xhgh,
 		//fdct_wrapping_fftshift(xn,yn,xh,yh,tpdata,wpdata);
 		//ROTATION
 		//fdct_wrapping_rotate_backward(q, wpdata, csc[wcnt]);
-		
-		wcnt++;
 	 } //end of w loop
   } //end of q loop
   //PUT THE RIGHT DATA BACK
   Xhgh = Xhghb;
   XL1 = XL1b;  XL2 = XL2b;
   
-  for(map<intpair, fftwnd_plan>::iterator mit=planmap.begin(); mit!=planmap.end(); mit++) {
-	 fftwnd_plan p = (*mit).second;
-	 fftwnd_destroy_plan(p);
-  }
   return 0;
 }
 //-----------------------------------------------------------------------
@@ -242,9 +259,7 @@ int fdct_wrapping_wavelet(CpxOffMat& Xhgh, vector<CpxNumMat>& csc)
   int F1 = -Xhgh.s();  int F2 = -Xhgh.t();
   CpxNumMat T(N1, N2);
   fdct_wrapping_ifftshift(Xhgh, T);
-  fftwnd_plan p = fftw2d_create_plan(N2, N1, FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
-  fftwnd_one(p, (fftw_complex*)T.data(), NULL);
-  fftwnd_destroy_plan(p);
+  fftwnd_one(fdct_wrapping_plan(N2, N1, FFTW_BACKWARD), (fftw_complex*)T.data(), NULL);
   double sqrtprod = sqrt(double(N1*N2));
   for(int j=0; j<N2; j++)
 	 for(int i=0; i<N1; i++)
@@ -66,6 +66,13 @@ int fdct_wrapping_param(int N1, int N2, int nbscales, int nbangles_coarse, int a
 //  the center sampling point at origin (0,0). Therefore, for any scale s, and wedge w, nx[s][w] * sx[s][w] = 1 and
 //  ny[s][w] * sy[s][w] = 1.
 
+fftwnd_plan fdct_wrapping_plan(int n0, int n1, fftw_direction dir);
+//this function returns the shared in-place FFTW_THREADSAFE plan of size n0 by n1 used by the transforms above
+//(created on first use, safe to call from several threads)
+
+void fdct_wrapping_clearplans();
+//this function destroys all shared plans; mex gateways register it with mexAtExit
+
 
 FDCT_WRAPPING_NS_END_NAMESPACE
 
@@ -110,9 +110,7 @@ int ifdct_wrapping(int N1, int N2, int nbscales, int nbangles_coarse, int allcur
   //------------------------------------------------------------
   CpxNumMat T(N1,N2);
   fdct_wrapping_ifftshift(O, T);
-  fftwnd_plan p = fftw2d_create_plan(N2, N1, FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
-  fftwnd_one(p, (fftw_complex*)T.data(), NULL);
-  fftwnd_destroy_plan(p);
+  fftwnd_one(fdct_wrapping_plan(N2, N1, FFTW_BACKWARD), (fftw_complex*)T.data(), NULL);
   double sqrtprod = sqrt(double(N1*N2)); //scale
   for(int i=0; i<N1; i++)	 for(int j=0; j<N2; j++)	 T(i,j) /= sqrtprod;
 
@@ -126,15 +124,11 @@ int ifdct_wrapping(int N1, int N2, int nbscales, int nbangles_coarse, int allcur
 //---------------------
 int fdct_wrapping_invsepangle(double XL1, double XL2, int nbangle, vector<CpxNumMat>& csc, CpxOffMat& Xhgh)
 {
-  typedef pair<int,int> intpair;
-  map<intpair, fftwnd_plan> planmap;
-  
   int XS1, XS2;  int XF1, XF2;  double XR1, XR2;	 fdct_wrapping_rangecompute(XL1, XL2, XS1, XS2, XF1, XF2, XR1, XR2);
   Xhgh.resize(XS1, XS2);
   
   int nbquadrants = 4;
   int nd = nbangle / 4;
-  int wcnt = 0;
   
   //backup
   CpxOffMat Xhghb(Xhgh);
@@ -149,7 +143,13 @@ int fdct_wrapping_invsepangle(double XL1, double XL2, int nbangle, vector<CpxNum
 	 //figure out XS, XF, XR
 	 double XW1 = XL1/nd;	 double XW2 = XL2/nd;
 	 int XS1, XS2;  int XF1, XF2;  double XR1, XR2;  fdct_wrapping_rangecompute(XL1, XL2, XS1, XS2, XF1, XF2, XR1, XR2);
+	 double R21 = XR2/XR1; //ratio
+	 //wedges overlap in Xhgh, so the FFT and windowing of each wedge run in
+	 //parallel into wpvals (in loop order) and the sum into Xhgh stays serial
+	 vector< vector<cpx> > wpvals(nd);
+#pragma omp parallel for schedule(dynamic)
 	 for(int w=nd-1; w>=0; w--) {
+		int wcnt = qi*nd + (nd-1-w);
 		double xs = XR1/4 - (XW1/2)/4;
 		double xe = XR1;
 		double ys = -XR2 + (w-0.5)*XW2;
@@ -181,15 +181,7 @@ int fdct_wrapping_invsepangle(double XL1, double XL2, int nbangle, vector<CpxNum
 		  int xn = csc[wcnt].m();		  int yn = csc[wcnt].n();
 		  CpxNumMat tpdata(csc[wcnt]);
 		  //fft
-		  fftwnd_plan p = NULL;
-		  map<intpair, fftwnd_plan>::iterator mit=planmap.find( intpair(xn,yn) );
-		  if(mit!=planmap.end()) {
-			 p = (*mit).second;
-		  } else {
-			 p = fftw2d_create_plan(yn, xn, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
-			 planmap[ intpair(xn, yn) ] = p;
-		  }
-		  fftwnd_one(p, (fftw_complex*)tpdata.data(), NULL);
+		  fftwnd_one(fdct_wrapping_plan(yn, xn, FFTW_FORWARD), (fftw_complex*)tpdata.data(), NULL);
 		  double sqrtprod = sqrt(double(xn*yn));
 		  for(int i=0; i<xn; i++)		  for(int j=0; j<yn; j++)			 tpdata(i,j) /= sqrtprod;
 		  //fftshift
@@ -199,7 +191,7 @@ int fdct_wrapping_invsepangle(double XL1, double XL2, int nbangle, vector<CpxNum
 		  fdct_wrapping_rotate_forward(q, rpdata, wpdata);
 		}
 		
-		double R21 = XR2/XR1; //ratio
+		vector<cpx>& vals = wpvals[w];
 		for(int xcur=xf; xcur<xe; xcur++) { //for each layer
 		  int yfm = (int)ceil( max(-XR2, R21*xcur*tan(thts)) );
 		  int yto = (int)floor( min(XR2, R21*xcur*tan(thte)) );
@@ -218,23 +210,40 @@ int fdct_wrapping_invsepangle(double XL1, double XL2, int nbangle, vector<CpxNum
 			 }
 			 double pou = wtht;
 			 wpdata(tmpx,tmpy) *= pou;
-			 Xhgh(xcur,ycur) += wpdata(tmpx,tmpy);
+			 vals.push_back( wpdata(tmpx,tmpy) );
 		  }
 		}
-		
-		wcnt++;
 	 }//w loop
+	 for(int w=nd-1; w>=0; w--) {
+		double xs = XR1/4 - (XW1/2)/4;
+		double xe = XR1;
+		int xf = int(ceil(xs));
+		double thts, thte;
+		if(w==0) {
+		  thts = atan2(-1.0, 1.0-1.0/nd);
+		  thte = atan2(-1.0+3.0/nd, 1.0);
+		} else if(w==nd-1) {
+		  thts = atan2(-1.0+(2.0*w-1.0)/nd, 1.0);
+		  thte = atan2(1.0, 1.0-1.0/nd);
+		} else {
+		  thts = atan2(-1.0+(2.0*w-1.0)/nd, 1.0);
+		  thte = atan2(-1.0+(2.0*w+3.0)/nd, 1.0);
+		}
+		const vector<cpx>& vals = wpvals[w];
+		size_t k = 0;
+		for(int xcur=xf; xcur<xe; xcur++) {
+		  int yfm = (int)ceil( max(-XR2, R21*xcur*tan(thts)) );
+		  int yto = (int)floor( min(XR2, R21*xcur*tan(thte)) );
+		  for(int ycur=yfm; ycur<=yto; ycur++)
+			 Xhgh(xcur,ycur) += vals[k++];
+		}
+		assert(k==vals.size());
+	 }
 	 fdct_wrapping_rotate_backward(q, Xhgh, Xhghb);
   } //q loop
   Xhgh = Xhghb;
   XL1 = XL1b;  XL2 = XL2b;
-
-  assert(wcnt==nbangle);
   
-  for(map<intpair, fftwnd_plan>::iterator mit=planmap.begin(); mit!=planmap.end(); mit++) {
-	 fftwnd_plan p = (*mit).second;
-	 fftwnd_destroy_plan(p);
-  }
   return 0;
 }
 
@@ -247,9 +256,7 @@ int fdct_wrapping_invwavelet(vector<CpxNumMat>& csc, CpxOffMat& Xhgh)
   
   CpxNumMat T(C);  //CpxNumMat T(N1, N2);  fdct_wrapping_ifftshift(N1, N2, F1, F2, C, T);
   
-  fftwnd_plan p = fftw2d_create_plan(N2, N1, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
-  fftwnd_one(p, (fftw_complex*)T.data(), NULL);
-  fftwnd_destroy_plan(p);
+  fftwnd_one(fdct_wrapping_plan(N2, N1, FFTW_FORWARD), (fftw_complex*)T.data(), NULL);
   double sqrtprod = sqrt(double(N1*N2));
   for(int j=0; j<N2; j++)
 	 for(int i=0; i<N1; i++)
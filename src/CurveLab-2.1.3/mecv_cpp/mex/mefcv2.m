@@ -0,0 +1,29 @@
+function c = mefcv2(x,N1,N2,ns,nag)
+
+% mefcv2 - Forward mirror-extended curvelet transform (mex version)
+%
+% Drop-in replacement for mefcv2.m in the mecv/ directory: same
+% arguments and same coefficient layout, so either one may come first
+% on the path.
+%
+% Inputs
+%     x         an N1-by-N2 matrix
+%     N1, N2    size of x
+%     ns        number of levels, including the coarsest level
+%               (ceil(log2(min(N1,N2)) - 3) is commonly used)
+%     nag       number of angles at the 2nd coarsest level, a multiple
+%               of 4 (16 is often used)
+%
+% Output
+%     c         Curvelet coefficients, c{j}{l}(n1,n2) is the coefficient at
+%               scale j, direction l (first quadrant only) and spatial
+%               index (n1,n2)
+%
+% See also mefcv2.m in the mecv/ directory.
+
+if(mod(nag,4)~=0)
+  error('wrong');
+end
+
+%call mex function
+c = mefcv2_mex(N1, N2, ns, nag, double(x));
@@ -0,0 +1,21 @@
+function x = meicv2(c,N1,N2,ns,nag)
+
+% meicv2 - Inverse mirror-extended curvelet transform (mex version)
+%
+% Drop-in replacement for meicv2.m in the mecv/ directory: same
+% arguments and same coefficient layout, so either one may come first
+% on the path.
+%
+% Inputs
+%     c         Curvelet coefficients, as returned by mefcv2
+%     N1, N2    size of the matrix to be recovered
+%     ns        number of levels, including the coarsest level
+%     nag       number of angles at the 2nd coarsest level, a multiple of 4
+%
+% Output
+%     x         An N1-by-N2 matrix
+%
+% See also meicv2.m in the mecv/ directory.
+
+% call mex function
+x = meicv2_mex(N1, N2, ns, nag, c);
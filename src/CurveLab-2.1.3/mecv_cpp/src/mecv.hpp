@@ -0,0 +1,51 @@
+/*
+   Copyright (C) 2004 Caltech
+   Written by Lexing Ying
+*/
+
+//THE HEADER FILE
+#ifndef _MECV_HPP_
+#define _MECV_HPP_
+
+#include "mecv_inc.hpp"
+#include "numvec.hpp"
+#include "nummat.hpp"
+using std::vector;
+using std::map;
+using std::pair;
+using std::max;
+using std::min;
+using std::abs;
+
+MECV_NS_BEGIN_NAMESPACE
+
+int mefcv2(int N1, int N2, int nbscales, int nbangles_coarse, CpxNumMat& x, vector< vector<CpxNumMat> >& c);
+//this function performs the forward mirror-extended curvelet transform
+//INPUTS:
+//  N1,N2 -- the size of the input image
+//  nbscales -- the total number of scales for subband decomposition, including the coarsest level
+//  nbangles_coarse -- the number of angles in the 2nd coarest scale, must be a multiple of 8
+//  x -- N1 by N2 matrix stored in CpxNumMat class
+//OUTPUTS:
+//  c -- the curvelet coefficients data structure coeffient at scale s, wedge w and indices (i,j) is accessed by c[s][w](i,j).
+//       Only the wedges in the first quadrant are kept, so c[s] holds nbangles/4 wedges.
+
+int meicv2(int N1, int N2, int nbscales, int nbangles_coarse, vector< vector<CpxNumMat> >& c, CpxNumMat& x);
+//this function performs the inverse mirror-extended curvelet transform
+//INPUTS:
+//  N1,N2 -- the size of the output image
+//  nbscales -- the total number of scales for subband decomposition, including the coarsest level
+//  nbangles_coarse -- the number of angles in the 2nd coarest scale, must be a multiple of 8
+//  c -- the curvelet coefficients data structure, as returned by mefcv2
+//OUTPUTS:
+//  x -- N1 by N2 matrix stored in CpxNumMat class
+
+int mecv_dct2(CpxNumMat& x);
+int mecv_idct2(CpxNumMat& x);
+//orthonormal 2D DCT-II and its inverse (same normalization as dct2/idct2 in the mecv directory), computed in place.
+//FFTW 2.x has no real-to-real (REDFT) plans, so each 1D DCT is an N-point complex FFT of the even/odd reordered
+//column (Makhoul's algorithm) followed by a twiddle.
+
+MECV_NS_END_NAMESPACE
+
+#endif
@@ -0,0 +1,89 @@
+/*
+   Copyright (C) 2004 Caltech
+   Written by Lexing Ying
+*/
+
+#include "mecv.hpp"
+#include "mecv_inline.hpp"
+
+MECV_NS_BEGIN_NAMESPACE
+
+//orthonormal DCT-II of one line of length N (stride xs), in place. v is a work vector of length N.
+//The line is reordered as v = [x(0) x(2) x(4) ... x(5) x(3) x(1)] so that a single N-point FFT
+//gives the cosine sums. The real and imaginary parts of x are separated from the FFT afterwards.
+inline int mecv_dct_line(int N, fftw_plan p, const cpx* tw, cpx* x, int xs, cpx* v)
+{
+  for(int n=0; 2*n<N; n++)	 v[n] = x[2*n*xs];
+  for(int n=0; 2*n+1<N; n++)	 v[N-1-n] = x[(2*n+1)*xs];
+  fftw_one(p, (fftw_complex*)v, NULL);
+  double w0 = sqrt(1.0/N);  double wk = sqrt(2.0/N);
+  for(int k=0; k<N; k++) {
+	 cpx a = v[k];
+	 cpx b = conj(v[(N-k)%N]);
+	 cpx re = (a+b)*0.5; //transform of the real part
+	 cpx im = (a-b)*cpx(0,-0.5); //transform of the imaginary part
+	 double w = (k==0) ? w0 : wk;
+	 x[k*xs] = w * cpx(real(tw[k]*re), real(tw[k]*im));
+  }
+  return 0;
+}
+
+//inverse of mecv_dct_line. The pre-twiddle is complex linear, so complex data needs no splitting.
+inline int mecv_idct_line(int N, fftw_plan p, const cpx* tw, cpx* x, int xs, cpx* v)
+{
+  double w0 = sqrt(1.0/N);  double wk = 0.5*sqrt(2.0/N);
+  v[0] = w0 * x[0];
+  for(int k=1; k<N; k++)
+	 v[k] = conj(tw[k]) * wk * (x[k*xs] - cpx(0,1)*x[(N-k)*xs]);
+  fftw_one(p, (fftw_complex*)v, NULL);
+  for(int n=0; 2*n<N; n++)	 x[2*n*xs] = v[n];
+  for(int n=0; 2*n+1<N; n++)	 x[(2*n+1)*xs] = v[N-1-n];
+  return 0;
+}
+
+//apply the 1D transform to every line of x along dimension dim (0 or 1)
+int mecv_dct_dim(CpxNumMat& x, int dim, int inverse)
+{
+  int m = x.m();  int n = x.n();
+  int N = (dim==0) ? m : n;
+  int nlines = (dim==0) ? n : m;
+  int xs = (dim==0) ? 1 : m; //stride along the line
+  int ls = (dim==0) ? m : 1; //stride between lines
+  if(N==0 || nlines==0) return 0;
+
+  CpxNumVec tw(N);
+  for(int k=0; k<N; k++)	 tw(k) = exp(cpx(0, -M_PI*k/(2.0*N)));
+  fftw_plan p = fftw_create_plan(N, inverse ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
+
+#pragma omp parallel
+  {
+	 CpxNumVec v(N);
+#pragma omp for schedule(static)
+	 for(int l=0; l<nlines; l++) {
+		if(inverse)
+		  mecv_idct_line(N, p, tw.data(), x.data()+l*ls, xs, v.data());
+		else
+		  mecv_dct_line(N, p, tw.data(), x.data()+l*ls, xs, v.data());
+	 }
+  }
+
+  fftw_destroy_plan(p);
+  return 0;
+}
+
+//-------------------------------------------------------------------
+int mecv_dct2(CpxNumMat& x)
+{
+  mecv_dct_dim(x, 0, 0);
+  mecv_dct_dim(x, 1, 0);
+  return 0;
+}
+
+int mecv_idct2(CpxNumMat& x)
+{
+  mecv_dct_dim(x, 0, 1);
+  mecv_dct_dim(x, 1, 1);
+  return 0;
+}
+
+MECV_NS_END_NAMESPACE
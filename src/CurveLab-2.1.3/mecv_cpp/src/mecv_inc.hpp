@@ -0,0 +1,49 @@
+/*
+   Copyright (C) 2004 Caltech
+   Written by Lexing Ying
+*/
+
+#ifndef _MECV_INC_HPP_
+#define _MECV_INC_HPP_
+
+//STL stuff
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <cfloat>
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <complex>
+
+#include <vector>
+#include <set>
+#include <map>
+#include <deque>
+#include <queue>
+#include <utility>
+#include <algorithm>
+//using namespace std;
+#include <string.h>
+//FFT stuff
+#include "fftw.h"
+//wedges are processed in parallel when compiled with -fopenmp
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define MECV_NS_BEGIN_NAMESPACE namespace mecv_ns {
+#define MECV_NS_END_NAMESPACE }
+
+MECV_NS_BEGIN_NAMESPACE
+
+//Complex number
+typedef std::complex<double> cpx;
+
+//AUX functions
+inline int pow2(int l) { assert(l>=0); return (1<<l); }
+
+MECV_NS_END_NAMESPACE
+
+#endif
@@ -0,0 +1,202 @@
+/*
+   Copyright (C) 2004 Caltech
+   Written by Lexing Ying
+*/
+
+#ifndef _MECV_INLINE_HPP_
+#define _MECV_INLINE_HPP_
+
+#include "mecv.hpp"
+
+MECV_NS_BEGIN_NAMESPACE
+
+//nonnegative remainder, mod(i,n) in matlab
+inline int mecv_mod(int i, int n)
+{
+  int r = i%n;
+  return (r<0) ? r+n : r;
+}
+
+//same as cvwindow.m
+inline int mecv_window(double x, double& l, double& r)
+{
+  double eps = 1e-16;
+  if(x<eps) {
+	 l = 0;	 r = 1;
+  } else if(x>1-eps) {
+	 l = 1;	 r = 0;
+  } else {
+	 l = exp(1-1/(1-exp(1-1/(1-x))));
+	 r = exp(1-1/(1-exp(1-1/x)));
+	 double norm = sqrt(l*l+r*r);
+	 l /= norm;
+	 r /= norm;
+  }
+  return 0;
+}
+
+//1D radial windows of a ring of radius R, for the indices ceil(-R):floor(R)
+//low(i) is the lowpass of radius R and mid(i) is the lowpass of radius R/2
+inline int mecv_ringwindows(double R, int& S, DblNumVec& low, DblNumVec& mid)
+{
+  S = int(ceil(-R));
+  int M = int(floor(R)) - S + 1;
+  low.resize(M);  mid.resize(M);
+  for(int k=0; k<M; k++) {
+	 int i = S+k;
+	 double l,r,a,b;
+	 mecv_window((i+R)/(R/2), l, r);	 a = l;
+	 mecv_window((i-R/2)/(R/2), l, r);	 b = r;
+	 low(k) = a*b;
+	 mecv_window((i+R/2)/(R/4), l, r);	 a = l;
+	 mecv_window((i-R/4)/(R/4), l, r);	 b = r;
+	 mid(k) = a*b;
+  }
+  return 0;
+}
+
+//mirror extension of one line, same as mescatter.m: f has N entries (stride fs), r has 2*(N+E) entries (stride rs)
+inline int mecv_scatter(int N, int E, const cpx* f, int fs, cpx* r, int rs)
+{
+  int A = 2*(N+E);
+  for(int t=0; t<A; t++)	 r[t*rs] = 0;
+  for(int t=0; t<E; t++)	 r[(N+E+t)*rs] = -f[mecv_mod(N-E+t,N)*fs];
+  for(int t=1; t<N; t++)	 r[(A-t)*rs] = f[t*fs];
+  r[0] = f[0] * sqrt(2.0);
+  for(int t=1; t<N; t++)	 r[t*rs] = f[t*fs];
+  for(int t=1; t<E; t++)	 r[(N+t)*rs] = -f[(N-t)*fs];
+  return 0;
+}
+
+//adjoint of mecv_scatter, same as mecombine.m: r has A entries (stride rs), f has A/2-E entries (stride fs)
+inline int mecv_combine(int A, int E, const cpx* r, int rs, cpx* f, int fs)
+{
+  int N = A/2-E;
+  for(int t=0; t<N; t++)	 f[t*fs] = 0;
+  for(int t=0; t<E; t++)	 f[mecv_mod(N-E+t,N)*fs] -= r[(N+E+t)*rs];
+  for(int t=1; t<N; t++)	 f[t*fs] += r[(A-t)*rs];
+  f[0] += r[0] * sqrt(2.0);
+  for(int t=1; t<N; t++)	 f[t*fs] += r[t*rs];
+  for(int t=1; t<E; t++)	 f[(N-t)*fs] -= r[(N+t)*rs];
+  return 0;
+}
+
+//apply mecv_scatter along both dimensions of f
+inline int mecv_scatter2(CpxNumMat& f, int E1, int E2, CpxNumMat& r)
+{
+  int N1 = f.m();  int N2 = f.n();
+  int A1 = 2*(N1+E1);  int A2 = 2*(N2+E2);
+  CpxNumMat t(A1, N2);
+  for(int j=0; j<N2; j++)
+	 mecv_scatter(N1, E1, f.data()+j*N1, 1, t.data()+j*A1, 1);
+  r.resize(A1, A2);
+  for(int i=0; i<A1; i++)
+	 mecv_scatter(N2, E2, t.data()+i, A1, r.data()+i, A1);
+  return 0;
+}
+
+//apply mecv_combine along both dimensions of r
+inline int mecv_combine2(CpxNumMat& r, int E1, int E2, CpxNumMat& f)
+{
+  int A1 = r.m();  int A2 = r.n();
+  int N1 = A1/2-E1;  int N2 = A2/2-E2;
+  CpxNumMat t(N1, A2);
+  for(int j=0; j<A2; j++)
+	 mecv_combine(A1, E1, r.data()+j*A1, 1, t.data()+j*N1, 1);
+  f.resize(N1, N2);
+  for(int i=0; i<N1; i++)
+	 mecv_combine(A2, E2, t.data()+i, N1, f.data()+i, N1);
+  return 0;
+}
+
+//angular boundaries of wedge g out of nd, same for the two halves of the quadrant
+inline int mecv_angles(int g, int nd, double& ts, double& tm, double& te)
+{
+  if(g==0) {
+	 ts = atan2(-1.0, 1.0-1.0/nd);
+	 tm = atan2(-1.0+1.0/nd, 1.0);
+	 te = atan2(-1.0+3.0/nd, 1.0);
+  } else if(g==nd-1) {
+	 ts = atan2(-1.0+(2.0*g-1.0)/nd, 1.0);
+	 tm = atan2(-1.0+(2.0*g+1.0)/nd, 1.0);
+	 te = atan2(1.0, 1.0-1.0/nd);
+  } else {
+	 ts = atan2(-1.0+(2.0*g-1.0)/nd, 1.0);
+	 tm = atan2(-1.0+(2.0*g+1.0)/nd, 1.0);
+	 te = atan2(-1.0+(2.0*g+3.0)/nd, 1.0);
+  }
+  return 0;
+}
+
+//geometry of one wedge of the first quadrant. For the first nd/2 wedges the radial
+//direction u is the first dimension; for the last nd/2 wedges (tr==1) it is the second.
+class MecvWedge {
+public:
+  int tr;
+  double Ru, Rv; //ring radii along u and v
+  double us, ue; //radial range
+  double ts, tm, te; //angular boundaries
+  int xn, yn; //size of the wrapped wedge, first and second dimension
+public:
+  MecvWedge(): tr(0), Ru(0), Rv(0), us(0), ue(0), ts(0), tm(0), te(0), xn(0), yn(0) {;}
+  MecvWedge(int g, int nd, int t, double R1, double R2): tr(t) {
+	 Ru = (tr==0) ? R1 : R2;
+	 Rv = (tr==0) ? R2 : R1;
+	 double Wu = 2*Ru/nd;	 double Wv = 2*Rv/nd;
+	 us = Ru/4-(Wu/2)/4;	 ue = Ru;
+	 double vs = -Rv + (2*g-1)*Wv/2;
+	 double ve = -Rv + (2*g+3)*Wv/2;
+	 int un = int(ceil(ue-us));	 int vn = int(ceil(ve-vs));
+	 xn = (tr==0) ? un : vn;
+	 yn = (tr==0) ? vn : un;
+	 mecv_angles(g, nd, ts, tm, te);
+  }
+};
+
+//the wedges of one scale, in the order of mefcv2.m
+inline int mecv_wedges(int nbangles, double R1, double R2, vector<MecvWedge>& wedges)
+{
+  int nd = nbangles/4;
+  wedges.clear();
+  for(int g=nd/2; g<nd; g++)
+	 wedges.push_back( MecvWedge(g, nd, 0, R1, R2) );
+  for(int f=nd-1; f>=nd/2; f--)
+	 wedges.push_back( MecvWedge(f, nd, 1, R1, R2) );
+  return 0;
+}
+
+//visit every frequency sample covered by the wedge: op(x, y, pou)
+template <class Op>
+inline int mecv_wedge_visit(const MecvWedge& W, Op& op)
+{
+  double Rvu = W.Rv/W.Ru;
+  double tants = tan(W.ts);  double tante = tan(W.te);
+  for(int u=int(ceil(W.us)); u<=W.ue; u++) {
+	 int vfm = int(ceil( max(-W.Rv, Rvu*u*tants) ));
+	 int vto = int(floor( min(W.Rv, Rvu*u*tante) ));
+	 for(int v=vfm; v<=vto; v++) {
+		double thtcur = atan2(v/W.Rv, u/W.Ru);
+		double al,ar,bl,br;
+		mecv_window((thtcur-W.ts)/(W.tm-W.ts), al, ar);
+		mecv_window((thtcur-W.tm)/(W.te-W.tm), bl, br);
+		if(W.tr==0)
+		  op(u, v, al*br);
+		else
+		  op(v, u, al*br);
+	 }
+  }
+  return 0;
+}
+
+inline double energy(CpxNumMat& m)
+{
+  double val=0;
+  cpx* data = m.data();
+  for(int i=0; i<m.m()*m.n(); i++)
+	 val += norm(data[i]);
+  return val;
+}
+
+MECV_NS_END_NAMESPACE
+
+#endif
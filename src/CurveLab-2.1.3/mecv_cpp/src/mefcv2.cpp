@@ -0,0 +1,138 @@
+/*
+   Copyright (C) 2004 Caltech
+   Written by Lexing Ying
+*/
+
+#include "mecv.hpp"
+#include "mecv_inline.hpp"
+
+MECV_NS_BEGIN_NAMESPACE
+
+//copy the wedge support of fh into the wrapped wedge wp, weighted by the angular window
+class MecvWrapOp {
+public:
+  const CpxNumMat& fh;
+  CpxNumMat& wp;
+  MecvWrapOp(const CpxNumMat& f, CpxNumMat& w): fh(f), wp(w) {;}
+  void operator()(int x, int y, double pou) {
+	 wp(mecv_mod(x,wp.m()), mecv_mod(y,wp.n())) = fh(mecv_mod(x,fh.m()), mecv_mod(y,fh.n())) * pou;
+  }
+};
+
+int mefcv2_sepangle(double R1, double R2, int nbangle, CpxNumMat& fh, vector<CpxNumMat>& csc);
+
+//-------------------------------------------------------------------
+int mefcv2(int N1, int N2, int nbscales, int nbangles_coarse, CpxNumMat& x, vector< vector<CpxNumMat> >& c)
+{
+  assert(N1==x.m() && N2==x.n());
+  assert(nbangles_coarse%4==0);
+
+  //1. dct
+  CpxNumMat T(x);
+  mecv_dct2(T);
+
+  //2. scatter
+  int E1 = (N1+2)/3;  int E2 = (N2+2)/3;
+  CpxNumMat fd;
+  mecv_scatter2(T, E1, E2, fd);
+  int A1 = fd.m();  int A2 = fd.n();
+
+  double G1 = 4.0/3.0*N1;  double G2 = 4.0/3.0*N2;
+  c.resize(nbscales);
+
+  for(int s=nbscales; s>=2; s--) {
+	 //get ring
+	 double R1 = pow(2.0, s-nbscales)*G1;
+	 double R2 = pow(2.0, s-nbscales)*G2;
+	 int S1, S2;
+	 DblNumVec low1, mid1;	 mecv_ringwindows(R1, S1, low1, mid1);
+	 DblNumVec low2, mid2;	 mecv_ringwindows(R2, S2, low2, mid2);
+	 int M1 = low1.m();  int M2 = low2.m();
+	 CpxNumMat fh(M1, M2);
+	 for(int j=0; j<M2; j++) {
+		int jf = mecv_mod(S2+j, M2);		int jd = mecv_mod(S2+j, A2);
+		for(int i=0; i<M1; i++) {
+		  double tmp = mid1(i)*mid2(j);
+		  double pass = low1(i)*low2(j) * sqrt(1-tmp*tmp);
+		  fh(mecv_mod(S1+i, M1), jf) = pass * fd(mecv_mod(S1+i, A1), jd);
+		}
+	 }
+	 int nbangles = nbangles_coarse * pow2( int(ceil(double(s-2)/2)) );
+	 mefcv2_sepangle(R1, R2, nbangles, fh, c[s-1]);
+  }
+
+  //do the first level
+  {
+	 int s = 1;
+	 double R1 = pow(2.0, s-nbscales)*G1;
+	 double R2 = pow(2.0, s-nbscales)*G2;
+	 int S1, S2;
+	 DblNumVec low1, mid1;	 mecv_ringwindows(R1, S1, low1, mid1);
+	 DblNumVec low2, mid2;	 mecv_ringwindows(R2, S2, low2, mid2);
+	 int M1 = low1.m();  int M2 = low2.m();
+	 int K1 = M1+1;  int K2 = M2+1;
+	 CpxNumMat tmp(K1, K2);
+	 for(int j=0; j<M2; j++)
+		for(int i=0; i<M1; i++)
+		  tmp(mecv_mod(S1+i, K1), mecv_mod(S2+j, K2)) = low1(i)*low2(j) * fd(mecv_mod(S1+i, A1), mecv_mod(S2+j, A2));
+	 CpxNumMat cmb;
+	 mecv_combine2(tmp, 0, 0, cmb);
+	 int xn = cmb.m();  int yn = cmb.n();
+	 fftwnd_plan p = fftw2d_create_plan(yn, xn, FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
+	 fftwnd_one(p, (fftw_complex*)cmb.data(), NULL);
+	 fftwnd_destroy_plan(p);
+	 double sqrtprod = sqrt(double(xn*yn));
+	 for(int j=0; j<yn; j++)		for(int i=0; i<xn; i++)		  cmb(i,j) /= 4*sqrtprod;
+	 c[0].resize(1);
+	 c[0][0] = cmb;
+  }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------
+int mefcv2_sepangle(double R1, double R2, int nbangle, CpxNumMat& fh, vector<CpxNumMat>& csc)
+{
+  //WEDGE ORDERING: the first quadrant only, as in mefcv2.m
+  typedef pair<int,int> intpair;
+  vector<MecvWedge> wedges;
+  mecv_wedges(nbangle, R1, R2, wedges);
+  int nw = wedges.size();
+  csc.resize(nw);
+
+  //the planner is not thread safe, so every plan is created before the parallel loop
+  map<intpair, fftwnd_plan> planmap;
+  vector<fftwnd_plan> plans(nw);
+  for(int w=0; w<nw; w++) {
+	 intpair key(wedges[w].xn, wedges[w].yn);
+	 map<intpair,fftwnd_plan>::iterator mit=planmap.find(key);
+	 if(mit==planmap.end()) {
+		fftwnd_plan p = fftw2d_create_plan(wedges[w].yn, wedges[w].xn, FFTW_BACKWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
+		planmap[key] = p;
+		plans[w] = p;
+	 } else {
+		plans[w] = (*mit).second;
+	 }
+  }
+
+#pragma omp parallel for schedule(dynamic)
+  for(int w=0; w<nw; w++) {
+	 int xn = wedges[w].xn;	 int yn = wedges[w].yn;
+	 CpxNumMat wpdata(xn, yn);
+	 MecvWrapOp op(fh, wpdata);
+	 mecv_wedge_visit(wedges[w], op);
+	 //IFFT
+	 fftwnd_one(plans[w], (fftw_complex*)wpdata.data(), NULL);
+	 double sqrtprod = sqrt(double(xn*yn));
+	 for(int j=0; j<yn; j++)		for(int i=0; i<xn; i++)		  wpdata(i,j) /= sqrtprod;
+	 csc[w] = wpdata;
+  }
+
+  for(map<intpair, fftwnd_plan>::iterator mit=planmap.begin(); mit!=planmap.end(); mit++) {
+	 fftwnd_plan p = (*mit).second;
+	 fftwnd_destroy_plan(p);
+  }
+  return 0;
+}
+
+MECV_NS_END_NAMESPACE
@@ -0,0 +1,135 @@
+/*
+   Copyright (C) 2004 Caltech
+   Written by Lexing Ying
+*/
+
+#include "mecv.hpp"
+#include "mecv_inline.hpp"
+
+MECV_NS_BEGIN_NAMESPACE
+
+//add the wrapped wedge wp back onto its support in fh, weighted by the angular window
+class MecvUnwrapOp {
+public:
+  CpxNumMat& fh;
+  const CpxNumMat& wp;
+  MecvUnwrapOp(CpxNumMat& f, const CpxNumMat& w): fh(f), wp(w) {;}
+  void operator()(int x, int y, double pou) {
+	 fh(mecv_mod(x,fh.m()), mecv_mod(y,fh.n())) += wp(mecv_mod(x,wp.m()), mecv_mod(y,wp.n())) * pou;
+  }
+};
+
+int meicv2_invsepangle(double R1, double R2, int nbangle, vector<CpxNumMat>& csc, CpxNumMat& fh);
+
+//-------------------------------------------------------------------------------
+int meicv2(int N1, int N2, int nbscales, int nbangles_coarse, vector< vector<CpxNumMat> >& c, CpxNumMat& x)
+{
+  assert(nbscales==int(c.size()));
+  assert(nbangles_coarse%4==0);
+
+  int E1 = (N1+2)/3;  int E2 = (N2+2)/3;
+  int A1 = 2*(N1+E1);  int A2 = 2*(N2+E2);
+  CpxNumMat fd(A1, A2);
+
+  double G1 = 4.0/3.0*N1;  double G2 = 4.0/3.0*N2;
+
+  for(int s=nbscales; s>=2; s--) {
+	 double R1 = pow(2.0, s-nbscales)*G1;
+	 double R2 = pow(2.0, s-nbscales)*G2;
+	 int S1, S2;
+	 DblNumVec low1, mid1;	 mecv_ringwindows(R1, S1, low1, mid1);
+	 DblNumVec low2, mid2;	 mecv_ringwindows(R2, S2, low2, mid2);
+	 int M1 = low1.m();  int M2 = low2.m();
+	 //get fh
+	 CpxNumMat fh(M1, M2);
+	 int nbangles = nbangles_coarse * pow2( int(ceil(double(s-2)/2)) );
+	 meicv2_invsepangle(R1, R2, nbangles, c[s-1], fh);
+	 //put back into fd
+	 for(int j=0; j<M2; j++) {
+		int jf = mecv_mod(S2+j, M2);		int jd = mecv_mod(S2+j, A2);
+		for(int i=0; i<M1; i++) {
+		  double tmp = mid1(i)*mid2(j);
+		  double pass = low1(i)*low2(j) * sqrt(1-tmp*tmp);
+		  fd(mecv_mod(S1+i, A1), jd) += pass * fh(mecv_mod(S1+i, M1), jf);
+		}
+	 }
+  }
+
+  {
+	 int s = 1;
+	 double R1 = pow(2.0, s-nbscales)*G1;
+	 double R2 = pow(2.0, s-nbscales)*G2;
+	 int S1, S2;
+	 DblNumVec low1, mid1;	 mecv_ringwindows(R1, S1, low1, mid1);
+	 DblNumVec low2, mid2;	 mecv_ringwindows(R2, S2, low2, mid2);
+	 int M1 = low1.m();  int M2 = low2.m();
+
+	 CpxNumMat T(c[0][0]);
+	 int xn = T.m();  int yn = T.n();
+	 fftwnd_plan p = fftw2d_create_plan(yn, xn, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
+	 fftwnd_one(p, (fftw_complex*)T.data(), NULL);
+	 fftwnd_destroy_plan(p);
+	 double sqrtprod = sqrt(double(xn*yn));
+	 for(int j=0; j<yn; j++)		for(int i=0; i<xn; i++)		  T(i,j) /= 4*sqrtprod;
+	 CpxNumMat tmp;
+	 mecv_scatter2(T, 0, 0, tmp);
+	 int K1 = tmp.m();  int K2 = tmp.n();
+	 for(int j=0; j<M2; j++)
+		for(int i=0; i<M1; i++)
+		  fd(mecv_mod(S1+i, A1), mecv_mod(S2+j, A2)) += low1(i)*low2(j) * tmp(mecv_mod(S1+i, K1), mecv_mod(S2+j, K2));
+  }
+
+  CpxNumMat T;
+  mecv_combine2(fd, E1, E2, T);
+  mecv_idct2(T);
+  x = T;
+
+  return 0;
+}
+
+//-------------------------------------------------------------------------------
+int meicv2_invsepangle(double R1, double R2, int nbangle, vector<CpxNumMat>& csc, CpxNumMat& fh)
+{
+  typedef pair<int,int> intpair;
+  vector<MecvWedge> wedges;
+  mecv_wedges(nbangle, R1, R2, wedges);
+  int nw = wedges.size();
+  assert(nw==int(csc.size()));
+
+  map<intpair, fftwnd_plan> planmap;
+  vector<fftwnd_plan> plans(nw);
+  for(int w=0; w<nw; w++) {
+	 intpair key(csc[w].m(), csc[w].n());
+	 map<intpair,fftwnd_plan>::iterator mit=planmap.find(key);
+	 if(mit==planmap.end()) {
+		fftwnd_plan p = fftw2d_create_plan(csc[w].n(), csc[w].m(), FFTW_FORWARD, FFTW_ESTIMATE | FFTW_IN_PLACE);
+		planmap[key] = p;
+		plans[w] = p;
+	 } else {
+		plans[w] = (*mit).second;
+	 }
+  }
+
+  //FFT every wedge in parallel, then accumulate the wedges one by one since their supports overlap
+  vector<CpxNumMat> wpdata(nw);
+#pragma omp parallel for schedule(dynamic)
+  for(int w=0; w<nw; w++) {
+	 wpdata[w] = csc[w];
+	 int xn = wpdata[w].m();	 int yn = wpdata[w].n();
+	 fftwnd_one(plans[w], (fftw_complex*)wpdata[w].data(), NULL);
+	 double sqrtprod = sqrt(double(xn*yn));
+	 for(int j=0; j<yn; j++)		for(int i=0; i<xn; i++)		  wpdata[w](i,j) /= sqrtprod;
+  }
+  for(int w=0; w<nw; w++) {
+	 MecvUnwrapOp op(fh, wpdata[w]);
+	 mecv_wedge_visit(wedges[w], op);
+  }
+
+  for(map<intpair, fftwnd_plan>::iterator mit=planmap.begin(); mit!=planmap.end(); mit++) {
+	 fftwnd_plan p = (*mit).second;
+	 fftwnd_destroy_plan(p);
+  }
+  return 0;
+}
+
+MECV_NS_END_NAMESPACE
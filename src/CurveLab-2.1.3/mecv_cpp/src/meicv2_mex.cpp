@@ -0,0 +1,42 @@
+/*
+   Copyright (C) 2004 Caltech
+   Written by Lexing Ying
+*/
+
+#include "mex.h"
+#include "matrix.h"
+
+#include "mecv.hpp"
+
+#include "mexaux.hpp"
+
+using namespace std;
+using namespace mecv_ns;
+
+//inverse mirror-extended curvelet transform
+extern void _main();
+
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+  if(nrhs!=5)
+	 mexErrMsgTxt("5 inputs required");
+  if(nlhs!=1)
+	 mexErrMsgTxt("1 outputs required");
+
+  int m; mex2cpp(prhs[0], m);
+  int n; mex2cpp(prhs[1], n);
+  int nbscales; mex2cpp(prhs[2], nbscales);
+  int nbangles_coarse; mex2cpp(prhs[3], nbangles_coarse);
+  vector< vector< CpxNumMat> > c; mex2cpp(prhs[4], c);
+  if(int(c.size())!=nbscales)
+	 mexErrMsgTxt("c must have nbscales cells");
+  if(nbangles_coarse%4!=0)
+	 mexErrMsgTxt("nbangles_coarse must be a multiple of 4");
+  
+  CpxNumMat x;
+  meicv2(m, n, nbscales, nbangles_coarse, c, x);
+  
+  cpp2mex(x, plhs[0]);
+  
+  return;
+}
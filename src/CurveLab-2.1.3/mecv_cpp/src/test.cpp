@@ -0,0 +1,99 @@
+/*
+   Copyright (C) 2004 Caltech
+   Written by Lexing Ying
+*/
+
+#include "mecv.hpp"
+#include "mecv_inline.hpp"
+
+using namespace std;
+using namespace mecv_ns;
+
+int optionsCreate(const char* optfile, map<string,string>& options)
+{
+  options.clear();
+  ifstream fin(optfile); assert(fin.good());
+  string name;  fin>>name;
+  while(fin.good()) {
+	 char cont[100];	 fin.getline(cont, 99);
+	 options[name] = string(cont);
+	 fin>>name;
+  }
+  fin.close();
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  clock_t ck0, ck1;
+  
+  assert(argc==2);
+  //get options
+  map<string, string> opts;  optionsCreate(argv[1], opts);
+  
+  //get input data
+  map<string,string>::iterator mi;
+  
+  int m;
+  mi = opts.find("-m"); assert(mi!=opts.end());
+  { istringstream ss((*mi).second); ss>>m; }
+  int n;
+  mi = opts.find("-n"); assert(mi!=opts.end());
+  { istringstream ss((*mi).second); ss>>n; }
+  
+  int nbscales;
+  mi = opts.find("-nbscales"); assert(mi!=opts.end());
+  { istringstream ss((*mi).second); ss>>nbscales; }
+  
+  int nbangles_coarse;
+  mi = opts.find("-nbangles_coarse"); assert(mi!=opts.end());
+  { istringstream ss((*mi).second); ss>>nbangles_coarse; }
+  
+  srand48( (long)time(NULL) );
+  CpxNumMat x(m,n);
+  for(int i=0; i<m; i++)
+	 for(int j=0; j<n; j++)
+		x(i,j) = cpx(drand48(), drand48());
+  
+  //dct against the direct sum on the first column (zero frequency along the second dimension)
+  {
+	 CpxNumMat d(x);
+	 mecv_dct2(d);
+	 CpxNumMat e(m,1);
+	 for(int k=0; k<m; k++) {
+		cpx val = 0;
+		for(int j=0; j<n; j++)
+		  for(int i=0; i<m; i++)
+			 val += x(i,j) * cos(M_PI*(2*i+1)*k/(2.0*m)) * sqrt(1.0/n);
+		e(k,0) = d(k,0) - val*((k==0) ? sqrt(1.0/m) : sqrt(2.0/m));
+	 }
+	 cerr<<"accuracy of dct "<<sqrt(energy(e)/m)<<endl;
+  }
+  
+  ck0 = clock();
+  
+  //mefcv2
+  vector< vector<CpxNumMat> > c;
+  mefcv2(m, n, nbscales, nbangles_coarse, x, c);
+  ck1 = clock();  cout<<"MEFCV2 takes "<<double(ck1-ck0)/CLOCKS_PER_SEC<<" seconds"<<endl;  ck0 = ck1;
+  
+  //meicv2
+  CpxNumMat y(x); clear(y);
+  meicv2(m, n, nbscales, nbangles_coarse, c, y);
+  ck1 = clock();  cout<<"MEICV2 takes "<<double(ck1-ck0)/CLOCKS_PER_SEC<<" seconds"<<endl;  ck0 = ck1;
+  
+  CpxNumMat e(m,n);
+  for(int i=0; i<m; i++)
+	 for(int j=0; j<n; j++)
+		e(i,j) = x(i,j) - y(i,j);
+  cerr<<"accuracy of inversion "<<sqrt(energy(e)/(m*n))<<endl;
+  
+  //tight frame: the coefficients carry the energy of the image
+  double ec = 0;
+  for(int s=0; s<int(c.size()); s++)
+	 for(int w=0; w<int(c[s].size()); w++)
+		ec += energy(c[s][w]);
+  cerr<<"energy ratio "<<ec/energy(x)<<endl;
+  
+  return 0;
+}
@@ -37,7 +37,7 @@ idxFullTraces = setdiff(1:nTraces, idxNullTraces);
 noisyData(:, idxNullTraces) = NaN;
 
 % inpainting
-interpData = inpaint_nans(noisyData, 4);
+interpData = inpaint_nansC(noisyData, 4);
 
 figure;
 subplot(1, 3, 1); imagesc(dataTrue); title('Original'); colormap(gray);
@@ -0,0 +1,49 @@
+function [B, flag, relres, iter] = inpaint_nansC(A, method, tol, maxit)
+% INPAINT_NANSC in-paints over nans in an array, compiled iterative solver
+% B = INPAINT_NANSC(A, method) gives the interpolant of INPAINT_NANS(A, method)
+% for methods 0-4 from inpaint_nans_mex, which solves for the NaN elements
+% only with multigrid preconditioned CG/BiCGSTAB instead of building the
+% sparse systems of INPAINT_NANS and solving them by backslash.
+% Method 5, or any method if inpaint_nans_mex is not compiled, runs
+% INPAINT_NANS.
+%
+% tol (default 1e-10) is the relative residual at which the iteration stops,
+% maxit (default 500) the maximum number of iterations. flag is 0 if tol
+% was reached, relres and iter are the final relative residual and the
+% number of iterations; without the flag output a warning is issued if tol
+% was not reached. The normal equations of method 3 are very ill-conditioned
+% for holes of more than a few hundred elements across, a larger tol may be
+% needed there.
+%
+% See also: INPAINT_NANS
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if (~exist('method', 'var') || isempty(method))
+    method = 0;
+end
+if (~exist('tol', 'var'))
+    tol = [];
+end
+if (~exist('maxit', 'var'))
+    maxit = [];
+end
+
+if (ismember(method, 0:4) && (exist('inpaint_nans_mex', 'file') == 3))
+    [B, flag, relres, iter] = inpaint_nans_mex(double(A), method, tol, maxit);
+    if (flag && nargout < 2)
+        warning('inpaint_nansC:noConvergence', ...
+            'Stopped after %d iterations at relative residual %g.', iter, relres);
+    end
+else
+    B = inpaint_nans(A, method);
+    flag = 0;
+    relres = 0;
+    iter = 0;
+end
@@ -0,0 +1,1113 @@
+/**************************************************************************
+ *
+ * File name: inpaint_nans_mex.c
+ *
+ * [B, FLAG, RELRES, ITER] = inpaint_nans_mex(A, METHOD, TOL, MAXIT)
+ *
+ * Fills in the NaNs of the array A with the interpolant of INPAINT_NANS
+ * for METHOD 0-4, solving for the NaN elements only:
+ *
+ *   0, 1  least squares del^2 (both methods pose the same problem)
+ *   2     del^2 = 0 at every NaN element (square, not symmetric)
+ *   3     least squares del^4, reduced to del^2 and to second differences
+ *         near the borders of the array
+ *   4     springs to the horizontal and vertical neighbors
+ *
+ * The rows of the system (of the normal equations for the least squares
+ * methods) are built straight from the stencils on the grid, the known
+ * elements only enter the right hand side. The system is solved by CG
+ * (BiCGSTAB for method 2) preconditioned with a geometric multigrid
+ * V-cycle: the unknowns at even rows and columns form the next coarser
+ * level, interpolation is polynomial (linear for METHOD 2 and 4, cubic
+ * for 0 and 1, quintic for 3), the coarse operators are Galerkin
+ * products and the smoother is l1 hybrid Gauss-Seidel (Gauss-Seidel in
+ * fixed blocks of rows, Jacobi between blocks), which runs in parallel
+ * and does not depend on the number of threads. For the least squares
+ * methods 0, 1 and 3 one step of the corrected seminormal equations
+ * follows (a second solve for the residual of the overdetermined system),
+ * since the normal equations alone square the condition number and lose
+ * up to half of the digits on large holes.
+ *
+ * FLAG is 0 if the relative residual dropped below TOL (default 1e-10)
+ * within MAXIT (default 500) iterations, 1 otherwise. RELRES and ITER are
+ * the final relative residual and the number of iterations.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+
+#include "mex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+/* Input Arguments */
+
+#define A_IN        prhs[0]
+#define METHOD_IN   prhs[1]
+#define TOL_IN      prhs[2]
+#define MAXIT_IN    prhs[3]
+
+
+/* Output Arguments */
+
+#define B_OUT       plhs[0]
+#define FLAG_OUT    plhs[1]
+#define RELRES_OUT  plhs[2]
+#define ITER_OUT    plhs[3]
+
+
+#define GS_BLOCK      512     /* rows per Gauss-Seidel block */
+#define NU            2       /* pre- and post-smoothing sweeps */
+#define COARSE_DIRECT 500     /* largest level solved by dense LU */
+#define COARSE_SWEEPS 10      /* sweeps on a larger coarsest level */
+#define MAX_LEVELS    24
+
+
+/* sparse matrix, compressed rows */
+
+typedef struct {
+  mwSize n, ncols;
+  mwIndex *ia;
+  int *ja;
+  double *a;
+} Csr;
+
+
+/* one level of the multigrid hierarchy; P interpolates from the next level */
+
+typedef struct {
+  Csr A, P, R;
+  double *d;                /* l1 diagonal of the smoother */
+  double *x, *b, *r, *xold;
+  double *lu;               /* dense LU of the coarsest level */
+  mwSize *piv;
+} Level;
+
+
+typedef struct {
+  int nlev;
+  Level lev[MAX_LEVELS];
+} Hierarchy;
+
+
+/* the grid problem of level 0 */
+
+typedef struct {
+  ptrdiff_t n, m;
+  int method;
+  const double *A;          /* input array, NaN at the unknowns */
+  const int *id;            /* unknown number of every element, -1 if known */
+} Grid;
+
+
+
+/**************************************************************************
+ * Stencils
+ *************************************************************************/
+
+
+/* row of the operator of methods 0, 1 and 3 at element (r, c): 5x5 window
+   w[(dr+2) + 5*(dc+2)], the same sums as the sparse() calls of INPAINT_NANS */
+
+static void ls_stencil(const Grid *g, ptrdiff_t r, ptrdiff_t c, double *w)
+{
+  static const double del4[25] = {
+    0, 0, 1, 0, 0,
+    0, 2,-8, 2, 0,
+    1,-8,20,-8, 1,
+    0, 2,-8, 2, 0,
+    0, 0, 1, 0, 0 };
+  ptrdiff_t n = g->n, m = g->m;
+  int k;
+
+  memset(w, 0, 25*sizeof(double));
+
+  if (g->method != 3) {
+    if (r > 0 && r < n-1) {
+      w[11] += 1; w[12] -= 2; w[13] += 1;
+    }
+    if (c > 0 && c < m-1) {
+      w[7] += 1; w[12] -= 2; w[17] += 1;
+    }
+    return;
+  }
+
+  if (r >= 2 && r <= n-3 && c >= 2 && c <= m-3) {
+    for (k=0; k<25; k++) w[k] += del4[k];
+  }
+  if (((r == 1 || r == n-2) && c >= 1 && c <= m-2) ||
+      ((c == 1 || c == m-2) && r >= 1 && r <= n-2)) {
+    w[7] += 1; w[11] += 1; w[12] -= 4; w[13] += 1; w[17] += 1;
+  }
+  if ((r == 0 || r == n-1) && c >= 1 && c <= m-2) {
+    w[7] += 1; w[12] -= 2; w[17] += 1;
+  }
+  if ((c == 0 || c == m-1) && r >= 1 && r <= n-2) {
+    w[11] += 1; w[12] -= 2; w[13] += 1;
+  }
+}
+
+
+/* row of methods 2 and 4 at the unknown (r, c), 5x5 window as above;
+   method 2 is negated to get a positive diagonal */
+
+static void direct_stencil(const Grid *g, ptrdiff_t r, ptrdiff_t c, double *w)
+{
+  ptrdiff_t n = g->n, m = g->m;
+
+  memset(w, 0, 25*sizeof(double));
+
+  if (g->method == 4) {
+    if (r > 0)   { w[11] -= 1; w[12] += 1; }
+    if (r < n-1) { w[13] -= 1; w[12] += 1; }
+    if (c > 0)   { w[7] -= 1;  w[12] += 1; }
+    if (c < m-1) { w[17] -= 1; w[12] += 1; }
+    return;
+  }
+
+  if (r > 0 && r < n-1) {
+    w[11] -= 1; w[12] += 2; w[13] -= 1;
+  }
+  if (c > 0 && c < m-1) {
+    w[7] -= 1; w[12] += 2; w[17] -= 1;
+  }
+
+  /* the corners of the array; the top right corner is coupled to the
+     last element of the previous column instead (assemble_row) */
+  if ((r == 0 || r == n-1) && (c == 0 || c == m-1)) {
+    w[12] = 2;
+    w[r == 0 ? 13 : 11] = -1;
+    if (r == n-1 || c == 0) w[c == 0 ? 17 : 7] = -1;
+  }
+}
+
+
+
+/**************************************************************************
+ * Assembly of level 0
+ *************************************************************************/
+
+
+/* row of unknown u at element (r, c) into col/val (sorted), rhs into *b;
+   returns the number of entries. col/val may be NULL to count only. */
+
+static int assemble_row(const Grid *g, ptrdiff_t r, ptrdiff_t c, int *col, double *val, double *b)
+{
+  double win[81], w[25], wp[25], rhs = 0, cu, x;
+  char used[81];
+  ptrdiff_t n = g->n, m = g->m, pr, pc, qr, qc;
+  int R, W, dr, dc, er, ec, k, cnt = 0, extra = -1;
+
+  memset(used, 0, sizeof(used));
+
+  if (g->method == 2 || g->method == 4) {
+    /* the row is the stencil of the unknown itself */
+    R = 1;
+    W = 2*R+1;
+    memset(win, 0, sizeof(win));
+    direct_stencil(g, r, c, w);
+    for (dc=-1; dc<=1; dc++) {
+      for (dr=-1; dr<=1; dr++) {
+        double a = w[(dr+2) + 5*(dc+2)];
+        if (a == 0) continue;
+        qr = r+dr;
+        qc = c+dc;
+        if (qr < 0 || qr >= n || qc < 0 || qc >= m) continue;
+        if (g->id[qr + qc*n] >= 0) {
+          win[(dr+R) + W*(dc+R)] += a;
+          used[(dr+R) + W*(dc+R)] = 1;
+        }
+        else {
+          rhs -= a*g->A[qr + qc*n];
+        }
+      }
+    }
+    if (g->method == 2 && r == 0 && c == m-1) {
+      /* fda(nm-n+1, nm-n) of INPAINT_NANS; it precedes the row */
+      qr = (m-1)*n - 1;
+      if (g->id[qr] >= 0) extra = g->id[qr];
+      else rhs += g->A[qr];
+    }
+  }
+  else {
+    /* normal equations: sum over the rows p whose stencil contains u */
+    R = (g->method == 3) ? 2 : 1;
+    W = 4*R+1;
+    memset(win, 0, sizeof(win));
+    for (dc=-R; dc<=R; dc++) {
+      for (dr=-R; dr<=R; dr++) {
+        pr = r-dr;
+        pc = c-dc;
+        if (pr < 0 || pr >= n || pc < 0 || pc >= m) continue;
+        ls_stencil(g, pr, pc, wp);
+        cu = wp[(dr+2) + 5*(dc+2)];
+        if (cu == 0) continue;
+        for (ec=-2; ec<=2; ec++) {
+          for (er=-2; er<=2; er++) {
+            double a = wp[(er+2) + 5*(ec+2)];
+            if (a == 0) continue;
+            qr = pr+er;
+            qc = pc+ec;
+            if (qr < 0 || qr >= n || qc < 0 || qc >= m) continue;
+            if (g->id[qr + qc*n] >= 0) {
+              k = (er-dr+2*R) + W*(ec-dc+2*R);
+              win[k] += cu*a;
+              used[k] = 1;
+            }
+            else {
+              x = g->A[qr + qc*n];
+              rhs -= cu*a*x;
+            }
+          }
+        }
+      }
+    }
+    R = 2*R;
+  }
+
+  /* an unknown no row depends on is set to 0 */
+  k = R + W*R;
+  if (win[k] == 0) {
+    memset(used, 0, sizeof(used));
+    win[k] = 1;
+    rhs = 0;
+    extra = -1;
+  }
+  used[k] = 1;
+
+  if (extra >= 0) {
+    if (col) {
+      col[cnt] = extra;
+      val[cnt] = -1;
+    }
+    cnt++;
+  }
+
+  /* column major window order is increasing unknown order */
+  for (dc=-R; dc<=R; dc++) {
+    for (dr=-R; dr<=R; dr++) {
+      k = (dr+R) + W*(dc+R);
+      if (!used[k]) continue;
+      if (col) {
+        col[cnt] = g->id[(r+dr) + (c+dc)*n];
+        val[cnt] = win[k];
+      }
+      cnt++;
+    }
+  }
+  if (b) *b = rhs;
+  return cnt;
+}
+
+
+static void assemble(const Grid *g, const mwIndex *pos, mwSize nu, Csr *A, double *b)
+{
+  ptrdiff_t u;
+
+  A->n = nu;
+  A->ncols = nu;
+  A->ia = (mwIndex*)mxMalloc((nu+1)*sizeof(mwIndex));
+  A->ia[0] = 0;
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (u=0; u<(ptrdiff_t)nu; u++) {
+    A->ia[u+1] = assemble_row(g, pos[u] % g->n, pos[u] / g->n, NULL, NULL, NULL);
+  }
+  for (u=0; u<(ptrdiff_t)nu; u++) A->ia[u+1] += A->ia[u];
+
+  A->ja = (int*)mxMalloc((A->ia[nu]+1)*sizeof(int));
+  A->a = (double*)mxMalloc((A->ia[nu]+1)*sizeof(double));
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (u=0; u<(ptrdiff_t)nu; u++) {
+    assemble_row(g, pos[u] % g->n, pos[u] / g->n, A->ja + A->ia[u], A->a + A->ia[u], b + u);
+  }
+}
+
+
+/* right hand side F'(g - F*x) of the correction of the least squares
+   methods 0, 1 and 3, F*x = g being the overdetermined system of
+   INPAINT_NANS: the residual of every row p whose stencil contains u is
+   formed from the filled in array B, so unlike b - A*x it does not lose
+   the digits that the squared condition number of the normal equations
+   costs */
+
+static void ls_correction(const Grid *g, const mwIndex *pos, mwSize nu, const double *B, double *b)
+{
+  ptrdiff_t n = g->n, m = g->m, u, r, c, pr, pc, qr, qc;
+  double wp[25], cu, res, s;
+  int R = (g->method == 3) ? 2 : 1, dr, dc, er, ec;
+
+  #pragma omp parallel for schedule(dynamic, 256) private(wp, cu, res, s, r, c, pr, pc, qr, qc, dr, dc, er, ec)
+  for (u=0; u<(ptrdiff_t)nu; u++) {
+    r = pos[u] % n;
+    c = pos[u] / n;
+    s = 0;
+    for (dc=-R; dc<=R; dc++) {
+      for (dr=-R; dr<=R; dr++) {
+        pr = r-dr;
+        pc = c-dc;
+        if (pr < 0 || pr >= n || pc < 0 || pc >= m) continue;
+        ls_stencil(g, pr, pc, wp);
+        cu = wp[(dr+2) + 5*(dc+2)];
+        if (cu == 0) continue;
+        res = 0;
+        for (ec=-2; ec<=2; ec++) {
+          for (er=-2; er<=2; er++) {
+            qr = pr+er;
+            qc = pc+ec;
+            if (wp[(er+2) + 5*(ec+2)] == 0 || qr < 0 || qr >= n || qc < 0 || qc >= m) continue;
+            res -= wp[(er+2) + 5*(ec+2)]*B[qr + qc*n];
+          }
+        }
+        s += cu*res;
+      }
+    }
+    b[u] = s;
+  }
+}
+
+
+
+/**************************************************************************
+ * Sparse kernels
+ *************************************************************************/
+
+
+static void csr_free(Csr *A)
+{
+  if (A->ia) mxFree(A->ia);
+  if (A->ja) mxFree(A->ja);
+  if (A->a) mxFree(A->a);
+  A->ia = NULL;
+  A->ja = NULL;
+  A->a = NULL;
+}
+
+
+/* y = A*x, or y = y + A*x */
+
+static void spmv(const Csr *A, const double *x, double *y, int add)
+{
+  ptrdiff_t i;
+  mwIndex k;
+
+  #pragma omp parallel for private(k) schedule(static)
+  for (i=0; i<(ptrdiff_t)A->n; i++) {
+    double s = add ? y[i] : 0;
+    for (k=A->ia[i]; k<A->ia[i+1]; k++) s += A->a[k] * x[A->ja[k]];
+    y[i] = s;
+  }
+}
+
+
+/* r = b - A*x */
+
+static void residual(const Csr *A, const double *b, const double *x, double *r)
+{
+  ptrdiff_t i;
+  mwIndex k;
+
+  #pragma omp parallel for private(k) schedule(static)
+  for (i=0; i<(ptrdiff_t)A->n; i++) {
+    double s = b[i];
+    for (k=A->ia[i]; k<A->ia[i+1]; k++) s -= A->a[k] * x[A->ja[k]];
+    r[i] = s;
+  }
+}
+
+
+static void transpose(const Csr *A, Csr *T)
+{
+  mwIndex i, k, *next;
+
+  T->n = A->ncols;
+  T->ncols = A->n;
+  T->ia = (mwIndex*)mxCalloc(T->n+1, sizeof(mwIndex));
+  T->ja = (int*)mxMalloc((A->ia[A->n]+1)*sizeof(int));
+  T->a = (double*)mxMalloc((A->ia[A->n]+1)*sizeof(double));
+
+  for (k=0; k<A->ia[A->n]; k++) T->ia[A->ja[k]+1]++;
+  for (i=0; i<T->n; i++) T->ia[i+1] += T->ia[i];
+
+  next = (mwIndex*)mxMalloc((T->n+1)*sizeof(mwIndex));
+  memcpy(next, T->ia, T->n*sizeof(mwIndex));
+  for (i=0; i<A->n; i++) {
+    for (k=A->ia[i]; k<A->ia[i+1]; k++) {
+      mwIndex p = next[A->ja[k]]++;
+      T->ja[p] = (int)i;
+      T->a[p] = A->a[k];
+    }
+  }
+  mxFree(next);
+}
+
+
+/* C = A*B (Gustavson, symbolic pass then numeric pass) */
+
+static void spgemm(const Csr *A, const Csr *B, Csr *C)
+{
+  ptrdiff_t i;
+  mwIndex nnz;
+
+  C->n = A->n;
+  C->ncols = B->ncols;
+  C->ia = (mwIndex*)mxMalloc((A->n+1)*sizeof(mwIndex));
+  C->ia[0] = 0;
+
+  #pragma omp parallel
+  {
+    int *mark = (int*)malloc((B->ncols+1)*sizeof(int));
+    mwIndex k, kk, cnt;
+    int c;
+
+    for (c=0; c<(int)B->ncols; c++) mark[c] = -1;
+
+    #pragma omp for schedule(dynamic, 256)
+    for (i=0; i<(ptrdiff_t)A->n; i++) {
+      cnt = 0;
+      for (k=A->ia[i]; k<A->ia[i+1]; k++) {
+        int j = A->ja[k];
+        for (kk=B->ia[j]; kk<B->ia[j+1]; kk++) {
+          c = B->ja[kk];
+          if (mark[c] != (int)i) {
+            mark[c] = (int)i;
+            cnt++;
+          }
+        }
+      }
+      C->ia[i+1] = cnt;
+    }
+    free(mark);
+  }
+
+  for (i=0; i<(ptrdiff_t)A->n; i++) C->ia[i+1] += C->ia[i];
+  nnz = C->ia[A->n];
+  C->ja = (int*)mxMalloc((nnz+1)*sizeof(int));
+  C->a = (double*)mxMalloc((nnz+1)*sizeof(double));
+
+  #pragma omp parallel
+  {
+    int *mark = (int*)malloc((B->ncols+1)*sizeof(int));
+    mwIndex *loc = (mwIndex*)malloc((B->ncols+1)*sizeof(mwIndex));
+    mwIndex k, kk, p;
+    int c;
+
+    for (c=0; c<(int)B->ncols; c++) mark[c] = -1;
+
+    #pragma omp for schedule(dynamic, 256)
+    for (i=0; i<(ptrdiff_t)A->n; i++) {
+      p = C->ia[i];
+      for (k=A->ia[i]; k<A->ia[i+1]; k++) {
+        int j = A->ja[k];
+        double a = A->a[k];
+        for (kk=B->ia[j]; kk<B->ia[j+1]; kk++) {
+          c = B->ja[kk];
+          if (mark[c] != (int)i) {
+            mark[c] = (int)i;
+            loc[c] = p;
+            C->ja[p] = c;
+            C->a[p++] = a*B->a[kk];
+          }
+          else {
+            C->a[loc[c]] += a*B->a[kk];
+          }
+        }
+      }
+    }
+    free(mark);
+    free(loc);
+  }
+}
+
+
+
+/**************************************************************************
+ * Multigrid
+ *************************************************************************/
+
+
+/* 1-D interpolation weights of fine index i from the coarse indices 0..nc-1:
+   injection at even i, symmetric 2, 4 or 6 point interpolation at odd i,
+   of lower order where the wider stencil does not fit */
+
+static int weights1(ptrdiff_t i, ptrdiff_t nc, int order, ptrdiff_t *ci, double *wi)
+{
+  static const double w4[4] = {-1.0/16, 9.0/16, 9.0/16, -1.0/16};
+  static const double w6[6] = {3.0/256, -25.0/256, 150.0/256, 150.0/256, -25.0/256, 3.0/256};
+  ptrdiff_t I = i/2;
+  int q;
+
+  ci[0] = I;
+  wi[0] = 1;
+  if (!(i & 1) || I+1 >= nc) return 1;
+
+  if (order >= 6 && I-2 >= 0 && I+3 < nc) {
+    for (q=0; q<6; q++) {
+      ci[q] = I-2+q;
+      wi[q] = w6[q];
+    }
+    return 6;
+  }
+  if (order >= 4 && I-1 >= 0 && I+2 < nc) {
+    for (q=0; q<4; q++) {
+      ci[q] = I-1+q;
+      wi[q] = w4[q];
+    }
+    return 4;
+  }
+  ci[1] = I+1;
+  wi[0] = wi[1] = 0.5;
+  return 2;
+}
+
+
+/* interpolation from the unknowns at even rows and columns; builds the
+   coarse unknown map idc (nc-by-mc) and the list of coarse positions.
+   Parents which are known elements are dropped: the error vanishes there. */
+
+static mwSize interpolation(const int *idf, const mwIndex *posf, mwSize nf_unk, ptrdiff_t nf,
+                            int *idc, mwIndex *posc, ptrdiff_t nc, ptrdiff_t mc, int order, Csr *P)
+{
+  ptrdiff_t I, J, u;
+  mwSize ncu = 0;
+
+  for (J=0; J<mc; J++) {
+    for (I=0; I<nc; I++) {
+      if (idf[2*I + 2*J*nf] >= 0) {
+        posc[ncu] = I + J*nc;
+        idc[I + J*nc] = (int)(ncu++);
+      }
+      else {
+        idc[I + J*nc] = -1;
+      }
+    }
+  }
+
+  P->n = nf_unk;
+  P->ncols = ncu;
+  P->ia = (mwIndex*)mxMalloc((nf_unk+1)*sizeof(mwIndex));
+  P->ja = (int*)mxMalloc((order*order*nf_unk+1)*sizeof(int));
+  P->a = (double*)mxMalloc((order*order*nf_unk+1)*sizeof(double));
+  P->ia[0] = 0;
+
+  for (u=0; u<(ptrdiff_t)nf_unk; u++) {
+    ptrdiff_t ci[6], cj[6];
+    double wi[6], wj[6];
+    int ni, nj, a, b;
+    mwIndex p = P->ia[u];
+
+    ni = weights1(posf[u] % nf, nc, order, ci, wi);
+    nj = weights1(posf[u] / nf, mc, order, cj, wj);
+    for (b=0; b<nj; b++) {
+      for (a=0; a<ni; a++) {
+        int c = idc[ci[a] + cj[b]*nc];
+        if (c >= 0) {
+          P->ja[p] = c;
+          P->a[p++] = wi[a]*wj[b];
+        }
+      }
+    }
+    P->ia[u+1] = p;
+  }
+
+  return ncu;
+}
+
+
+/* l1 diagonal: a_ii plus the absolute off-block entries of row i */
+
+static void l1_diagonal(const Csr *A, double *d)
+{
+  ptrdiff_t i;
+  mwIndex k;
+
+  #pragma omp parallel for private(k) schedule(static)
+  for (i=0; i<(ptrdiff_t)A->n; i++) {
+    ptrdiff_t blk = i / GS_BLOCK;
+    double aii = 0, off = 0, all = 0;
+    for (k=A->ia[i]; k<A->ia[i+1]; k++) {
+      if (A->ja[k] == i) aii += A->a[k];
+      else if (A->ja[k] / GS_BLOCK != blk) off += fabs(A->a[k]);
+      all += fabs(A->a[k]);
+    }
+    d[i] = (aii > 0) ? aii + off : ((all > 0) ? all : 1);
+  }
+}
+
+
+/* dense LU with partial pivoting; a zero pivot leaves its unknown at 0 */
+
+static void dense_lu(Level *L)
+{
+  mwSize n = L->A.n, i, j, k;
+  double *a, amax = 0;
+
+  L->lu = a = (double*)mxCalloc(n*n, sizeof(double));
+  L->piv = (mwSize*)mxMalloc((n+1)*sizeof(mwSize));
+
+  for (i=0; i<n; i++) {
+    mwIndex p;
+    for (p=L->A.ia[i]; p<L->A.ia[i+1]; p++) a[i + L->A.ja[p]*n] += L->A.a[p];
+  }
+  for (i=0; i<n*n; i++) if (fabs(a[i]) > amax) amax = fabs(a[i]);
+
+  for (k=0; k<n; k++) {
+    mwSize pk = k;
+    for (i=k+1; i<n; i++) if (fabs(a[i+k*n]) > fabs(a[pk+k*n])) pk = i;
+    L->piv[k] = pk;
+    if (pk != k) {
+      for (j=0; j<n; j++) {
+        double t = a[k+j*n];
+        a[k+j*n] = a[pk+j*n];
+        a[pk+j*n] = t;
+      }
+    }
+    if (fabs(a[k+k*n]) <= 1e-13*amax) {
+      a[k+k*n] = 0;
+      continue;
+    }
+    for (i=k+1; i<n; i++) a[i+k*n] /= a[k+k*n];
+    for (j=k+1; j<n; j++) {
+      double akj = a[k+j*n];
+      if (akj == 0) continue;
+      for (i=k+1; i<n; i++) a[i+j*n] -= a[i+k*n]*akj;
+    }
+  }
+}
+
+
+static void dense_solve(const Level *L, const double *b, double *x)
+{
+  mwSize n = L->A.n, i, k;
+  const double *a = L->lu;
+
+  memcpy(x, b, n*sizeof(double));
+  for (k=0; k<n; k++) {
+    double t = x[k];
+    x[k] = x[L->piv[k]];
+    x[L->piv[k]] = t;
+  }
+  for (k=0; k<n; k++) {
+    if (a[k+k*n] == 0) continue;
+    for (i=k+1; i<n; i++) x[i] -= a[i+k*n]*x[k];
+  }
+  for (k=n; k-- > 0; ) {
+    if (a[k+k*n] == 0) {
+      x[k] = 0;
+      continue;
+    }
+    x[k] /= a[k+k*n];
+    for (i=0; i<k; i++) x[i] -= a[i+k*n]*x[k];
+  }
+}
+
+
+/* one l1 hybrid Gauss-Seidel sweep, forward or backward within the blocks */
+
+static void smooth(Level *L, const double *b, double *x, int backward)
+{
+  const Csr *A = &L->A;
+  ptrdiff_t blk, nblk = (A->n + GS_BLOCK - 1) / GS_BLOCK;
+
+  memcpy(L->xold, x, A->n*sizeof(double));
+
+  #pragma omp parallel for schedule(dynamic, 4)
+  for (blk=0; blk<nblk; blk++) {
+    ptrdiff_t lo = blk*GS_BLOCK, hi = lo + GS_BLOCK, t, i;
+    mwIndex k;
+    if (hi > (ptrdiff_t)A->n) hi = A->n;
+    for (t=0; t<hi-lo; t++) {
+      double s;
+      i = backward ? hi-1-t : lo+t;
+      s = b[i];
+      for (k=A->ia[i]; k<A->ia[i+1]; k++) {
+        int j = A->ja[k];
+        s -= A->a[k] * ((j >= lo && j < hi) ? x[j] : L->xold[j]);
+      }
+      x[i] += s / L->d[i];
+    }
+  }
+}
+
+
+static void vcycle(Hierarchy *h, int l, const double *b, double *x)
+{
+  Level *L = h->lev + l, *C;
+  int s;
+
+  if (l == h->nlev-1) {
+    if (L->lu) {
+      dense_solve(L, b, x);
+    }
+    else {
+      memset(x, 0, L->A.n*sizeof(double));
+      for (s=0; s<COARSE_SWEEPS; s++) smooth(L, b, x, 0);
+      for (s=0; s<COARSE_SWEEPS; s++) smooth(L, b, x, 1);
+    }
+    return;
+  }
+
+  C = L + 1;
+  memset(x, 0, L->A.n*sizeof(double));
+  for (s=0; s<NU; s++) smooth(L, b, x, 0);
+  residual(&L->A, b, x, L->r);
+  spmv(&L->R, L->r, C->b, 0);
+  vcycle(h, l+1, C->b, C->x);
+  spmv(&L->P, C->x, x, 1);
+  for (s=0; s<NU; s++) smooth(L, b, x, 1);
+}
+
+
+static void level_alloc(Level *L)
+{
+  mwSize n = L->A.n + 1;
+  L->x = (double*)mxMalloc(n*sizeof(double));
+  L->b = (double*)mxMalloc(n*sizeof(double));
+  L->r = (double*)mxMalloc(n*sizeof(double));
+  L->xold = (double*)mxMalloc(n*sizeof(double));
+  L->d = (double*)mxMalloc(n*sizeof(double));
+  l1_diagonal(&L->A, L->d);
+}
+
+
+/* coarsens until a level is small enough, or has no coarse unknowns;
+   order is the order of the interpolation (2, 4 or 6) */
+
+static void setup(Hierarchy *h, const int *id0, const mwIndex *pos0, ptrdiff_t n, ptrdiff_t m, int order)
+{
+  const int *idf = id0;
+  const mwIndex *posf = pos0;
+  int *idc = NULL, *idprev = NULL;
+  mwIndex *posc = NULL, *posprev = NULL;
+  ptrdiff_t nf = n, mf = m, nc, mc;
+  int l = 0;
+
+  level_alloc(h->lev);
+
+  while (h->lev[l].A.n > COARSE_DIRECT && l < MAX_LEVELS-1) {
+    Level *L = h->lev + l, *C = h->lev + l + 1;
+    Csr AP;
+    mwSize ncu;
+
+    nc = (nf+1)/2;
+    mc = (mf+1)/2;
+    idc = (int*)mxMalloc((nc*mc+1)*sizeof(int));
+    posc = (mwIndex*)mxMalloc((L->A.n+1)*sizeof(mwIndex));
+    ncu = interpolation(idf, posf, L->A.n, nf, idc, posc, nc, mc, order, &L->P);
+    if (ncu == 0 || ncu == L->A.n) {
+      csr_free(&L->P);
+      mxFree(idc);
+      mxFree(posc);
+      break;
+    }
+
+    transpose(&L->P, &L->R);
+    spgemm(&L->A, &L->P, &AP);
+    spgemm(&L->R, &AP, &C->A);
+    csr_free(&AP);
+    level_alloc(C);
+
+    if (idprev) mxFree(idprev);
+    if (posprev) mxFree(posprev);
+    idf = idprev = idc;
+    posf = posprev = posc;
+    nf = nc;
+    mf = mc;
+    l++;
+  }
+  if (idprev) mxFree(idprev);
+  if (posprev) mxFree(posprev);
+
+  h->nlev = l+1;
+  if (h->lev[l].A.n <= COARSE_DIRECT) dense_lu(h->lev + l);
+}
+
+
+
+/**************************************************************************
+ * Krylov solvers
+ *************************************************************************/
+
+
+static double dot(const double *x, const double *y, mwSize n)
+{
+  double s = 0;
+  ptrdiff_t i;
+
+  #pragma omp parallel for reduction(+:s) schedule(static)
+  for (i=0; i<(ptrdiff_t)n; i++) s += x[i]*y[i];
+  return s;
+}
+
+
+/* y = x + beta*y */
+
+static void xpby(const double *x, double beta, double *y, mwSize n)
+{
+  ptrdiff_t i;
+
+  #pragma omp parallel for schedule(static)
+  for (i=0; i<(ptrdiff_t)n; i++) y[i] = x[i] + beta*y[i];
+}
+
+
+/* y = y + alpha*x */
+
+static void axpy(double alpha, const double *x, double *y, mwSize n)
+{
+  ptrdiff_t i;
+
+  #pragma omp parallel for schedule(static)
+  for (i=0; i<(ptrdiff_t)n; i++) y[i] += alpha*x[i];
+}
+
+
+static int pcg(Hierarchy *h, const double *b, double *x, double tol, int maxit, double *relres)
+{
+  const Csr *A = &h->lev[0].A;
+  mwSize n = A->n;
+  double *r, *z, *p, *q, bnorm, rz, rz1, alpha;
+  int it;
+
+  memset(x, 0, n*sizeof(double));
+  bnorm = sqrt(dot(b, b, n));
+  *relres = 0;
+  if (bnorm == 0) return 0;
+
+  r = (double*)mxMalloc(n*sizeof(double));
+  z = (double*)mxMalloc(n*sizeof(double));
+  p = (double*)mxMalloc(n*sizeof(double));
+  q = (double*)mxMalloc(n*sizeof(double));
+
+  memcpy(r, b, n*sizeof(double));
+  vcycle(h, 0, r, z);
+  memcpy(p, z, n*sizeof(double));
+  rz = dot(r, z, n);
+
+  for (it=1; it<=maxit; it++) {
+    spmv(A, p, q, 0);
+    alpha = rz / dot(p, q, n);
+    axpy(alpha, p, x, n);
+    axpy(-alpha, q, r, n);
+    *relres = sqrt(dot(r, r, n)) / bnorm;
+    if (*relres <= tol) break;
+    vcycle(h, 0, r, z);
+    rz1 = dot(r, z, n);
+    xpby(z, rz1/rz, p, n);
+    rz = rz1;
+  }
+
+  mxFree(r);
+  mxFree(z);
+  mxFree(p);
+  mxFree(q);
+  return it > maxit ? maxit : it;
+}
+
+
+static int pbicgstab(Hierarchy *h, const double *b, double *x, double tol, int maxit, double *relres)
+{
+  const Csr *A = &h->lev[0].A;
+  mwSize n = A->n;
+  double *r, *r0, *p, *v, *y, *s, *t, bnorm, rho = 1, rho1, alpha = 1, omega = 1, tt;
+  ptrdiff_t i;
+  int it;
+
+  memset(x, 0, n*sizeof(double));
+  bnorm = sqrt(dot(b, b, n));
+  *relres = 0;
+  if (bnorm == 0) return 0;
+
+  r = (double*)mxMalloc(n*sizeof(double));
+  r0 = (double*)mxMalloc(n*sizeof(double));
+  p = (double*)mxCalloc(n, sizeof(double));
+  v = (double*)mxCalloc(n, sizeof(double));
+  y = (double*)mxMalloc(n*sizeof(double));
+  s = (double*)mxMalloc(n*sizeof(double));
+  t = (double*)mxMalloc(n*sizeof(double));
+
+  memcpy(r, b, n*sizeof(double));
+  memcpy(r0, b, n*sizeof(double));
+  *relres = 1;
+
+  for (it=1; it<=maxit; it++) {
+    rho1 = dot(r0, r, n);
+    if (rho1 == 0) break;
+
+    /* p = r + beta*(p - omega*v) */
+    axpy(-omega, v, p, n);
+    xpby(r, (rho1/rho)*(alpha/omega), p, n);
+    rho = rho1;
+
+    vcycle(h, 0, p, y);
+    spmv(A, y, v, 0);
+    alpha = rho / dot(r0, v, n);
+    axpy(alpha, y, x, n);
+
+    #pragma omp parallel for schedule(static)
+    for (i=0; i<(ptrdiff_t)n; i++) s[i] = r[i] - alpha*v[i];
+    *relres = sqrt(dot(s, s, n)) / bnorm;
+    if (*relres <= tol) break;
+
+    vcycle(h, 0, s, y);
+    spmv(A, y, t, 0);
+    tt = dot(t, t, n);
+    omega = (tt > 0) ? dot(t, s, n) / tt : 0;
+    axpy(omega, y, x, n);
+
+    #pragma omp parallel for schedule(static)
+    for (i=0; i<(ptrdiff_t)n; i++) r[i] = s[i] - omega*t[i];
+    *relres = sqrt(dot(r, r, n)) / bnorm;
+    if (*relres <= tol || omega == 0) break;
+  }
+
+  mxFree(r);
+  mxFree(r0);
+  mxFree(p);
+  mxFree(v);
+  mxFree(y);
+  mxFree(s);
+  mxFree(t);
+  return it > maxit ? maxit : it;
+}
+
+
+
+/**************************************************************************
+ * Gateway
+ *************************************************************************/
+
+
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray*prhs[])
+
+{
+  double *A, *B, *x, *b, tol = 1e-10, relres = 0;
+  mwIndex *pos;
+  mwSize n, m, nm, nu, i;
+  int *id, method = 0, maxit = 500, iter = 0, l;
+  Grid g;
+  Hierarchy h;
+
+
+  /* Check for proper number of arguments */
+
+  if (nrhs < 1 || nrhs > 4) {
+    mexErrMsgTxt("Invalid number of input arguments.");
+  } else if (nlhs > 4) {
+    mexErrMsgTxt("Too many output arguments.");
+  }
+
+
+  /* Check the input */
+
+  if (!mxIsDouble(A_IN) || mxIsComplex(A_IN) || mxIsSparse(A_IN) || mxGetNumberOfDimensions(A_IN) > 2) {
+    mexErrMsgTxt("A should be a full real 2-D double array.");
+  }
+  if (nrhs > 1 && !mxIsEmpty(METHOD_IN)) {
+    double dm = mxGetScalar(METHOD_IN);
+    if (dm != 0 && dm != 1 && dm != 2 && dm != 3 && dm != 4) {
+      mexErrMsgTxt("Method must be one of: {0,1,2,3,4}.");
+    }
+    method = (int)dm;
+  }
+  if (nrhs > 2 && !mxIsEmpty(TOL_IN)) tol = mxGetScalar(TOL_IN);
+  if (nrhs > 3 && !mxIsEmpty(MAXIT_IN)) maxit = (int)mxGetScalar(MAXIT_IN);
+
+  n = mxGetM(A_IN);
+  m = mxGetN(A_IN);
+  nm = n*m;
+  if (method == 2 && (n == 1 || m == 1)) {
+    mexErrMsgTxt("Method 2 has problems for vector input. Please use another method.");
+  }
+
+  A = mxGetPr(A_IN);
+  B_OUT = mxCreateDoubleMatrix(n, m, mxREAL);
+  B = mxGetPr(B_OUT);
+  memcpy(B, A, nm*sizeof(double));
+
+
+  /* Number the unknowns */
+
+  id = (int*)mxMalloc((nm+1)*sizeof(int));
+  nu = 0;
+  for (i=0; i<nm; i++) id[i] = mxIsNaN(A[i]) ? (int)(nu++) : -1;
+  pos = (mwIndex*)mxMalloc((nu+1)*sizeof(mwIndex));
+  for (i=0; i<nm; i++) if (id[i] >= 0) pos[id[i]] = i;
+
+
+  /* Assemble, set up the multigrid hierarchy and solve */
+
+  if (nu > 0) {
+    g.n = n;
+    g.m = m;
+    g.method = method;
+    g.A = A;
+    g.id = id;
+
+    memset(&h, 0, sizeof(h));
+    b = (double*)mxMalloc(nu*sizeof(double));
+    x = (double*)mxMalloc(nu*sizeof(double));
+    assemble(&g, pos, nu, &h.lev[0].A, b);
+    /* the interpolation order grows with the order of the operator,
+       del^2 (2, 4), its normal equations (0, 1) and those of del^4 (3) */
+    setup(&h, id, pos, n, m, (method == 3) ? 6 : ((method <= 1) ? 4 : 2));
+
+    if (method == 2) {
+      iter = pbicgstab(&h, b, x, tol, maxit, &relres);
+    }
+    else {
+      iter = pcg(&h, b, x, tol, maxit, &relres);
+    }
+
+    for (i=0; i<nu; i++) B[pos[i]] = x[i];
+
+    if (method <= 1 || method == 3) {
+      /* one step of the corrected seminormal equations, which brings the
+         solution to the accuracy of a QR based least squares solve */
+      double bnorm = sqrt(dot(b, b, nu)), cnorm, *d;
+      d = (double*)mxMalloc(nu*sizeof(double));
+      ls_correction(&g, pos, nu, B, b);
+      cnorm = sqrt(dot(b, b, nu));
+      iter += pcg(&h, b, d, tol, maxit, &relres);
+      relres = (bnorm > 0) ? relres*cnorm/bnorm : 0;
+      for (i=0; i<nu; i++) B[pos[i]] = x[i] + d[i];
+      mxFree(d);
+    }
+
+    for (l=0; l<h.nlev; l++) {
+      Level *L = h.lev + l;
+      csr_free(&L->A);
+      csr_free(&L->P);
+      csr_free(&L->R);
+      mxFree(L->d);
+      mxFree(L->x);
+      mxFree(L->b);
+      mxFree(L->r);
+      mxFree(L->xold);
+      if (L->lu) mxFree(L->lu);
+      if (L->piv) mxFree(L->piv);
+    }
+    mxFree(b);
+    mxFree(x);
+  }
+  mxFree(id);
+  mxFree(pos);
+
+
+  /* Optional outputs */
+
+  if (nlhs > 1) FLAG_OUT = mxCreateDoubleScalar(relres <= tol ? 0 : 1);
+  if (nlhs > 2) RELRES_OUT = mxCreateDoubleScalar(relres);
+  if (nlhs > 3) ITER_OUT = mxCreateDoubleScalar(iter);
+
+  return;
+}
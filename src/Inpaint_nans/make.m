@@ -0,0 +1,11 @@
+close all;
+clear;
+clc;
+
+fprintf('Compiling with OpenMP ...\n');
+if (isunix) % Linux / MacOS
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" inpaint_nans_mex.c
+else        % Windows
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" inpaint_nans_mex.c
+end
+fprintf('Compiling complete!\n');
@@ -1,5 +1,13 @@
 function [K,W] = Algorithm1(Sigma, lambda)
 
+% Compiled solver: the Cholesky factor of every accepted point gives K and
+% the trace products are fused
+if exist('projGradCovselC') == 3
+    [K,W,f,fTrace] = projGradCovselC(Sigma,lambda,[],[],1200,1e-4);
+    appendTrace(fTrace);
+    return;
+end
+
 % Get problem size
 n = size(Sigma,1);
 
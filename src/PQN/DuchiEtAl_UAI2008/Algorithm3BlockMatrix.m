@@ -19,6 +19,14 @@ end
 % Get problem size
 n = size(Sigma,1);
 
+% Compiled solver: blocks projected in parallel, the Cholesky factor of
+% every accepted point gives K
+if exist('projGradCovselC') == 3
+   [K,W,f,fTrace] = projGradCovselC(Sigma,lambda,nIndices,normtype,500,1e-4);
+   appendTrace(fTrace);
+   return;
+end
+
 % Setup projection function
 if normtype == 2
   % funProj = @projectLinf2BlockMatrix;
@@ -0,0 +1,9 @@
+function appendTrace(l)
+% Append the objective values l to the global trace
+
+global trace
+if trace == 1
+    global fValues
+    fValues = [fValues;l];
+    drawnow
+end
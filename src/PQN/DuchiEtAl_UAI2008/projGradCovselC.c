@@ -0,0 +1,536 @@
+/* projGradCovselC.c
+
+   [K,W,f,fTrace] = projGradCovselC(Sigma,lambda,nIndices,normtype,maxIter,epsilon)
+
+   Projected gradient on the dual of the sparse inverse covariance problem
+   of Duchi, Gould and Koller (UAI 2008): logdet(Sigma+W) is maximized
+   over the W in the dual norm ball, K = inv(Sigma+W).
+
+   nIndices empty: Algorithm1.m, |W(i,j)| <= lambda(i,j) with diag(W) =
+   diag(lambda); the step t = trace(K*G)/trace(K*G*K*G) along the
+   gradient G (zero where a bound is active) is halved until the
+   objective does not decrease.
+   nIndices given: Algorithm3BlockMatrix.m with contiguous groups of sizes
+   nIndices and lambda nGroups-by-nGroups; diagonal blocks lie in a box,
+   off-diagonal blocks in an l2 ball (normtype 2) or l1 ball (normtype
+   Inf) of radius lambda(i,j), with an Armijo backtracking line search.
+
+   f is the final logdet(Sigma+W), fTrace lists every logdet evaluation
+   (-Inf if Sigma+W is not positive definite) in the order the MATLAB code
+   appends them to the global fValues. Progress is printed as in the
+   MATLAB code. If the line search fails at a point that is not positive
+   definite, the last positive definite W and its K are returned.
+
+   Every trial point is factored once (blocked Cholesky); the factor of
+   the accepted point gives K, so there is no separate inverse. The
+   traces are read from K.*G and K*G, the line search term
+   trace((D-W)*G) is summed while projecting, and the duality gap is a
+   single pass over K. Blocks are projected in parallel.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "oneProjectorCore.h"
+#include "mex.h"
+
+/* Columns per panel of the blocked factorizations and products */
+#define NB 32
+
+/* Rows per task of the panel updates */
+#define ROW_CHUNK 64
+
+/* Tile size of the transposed accesses */
+#define TILE 32
+
+/* Problems smaller than this are not worth the threads */
+#define PARALLEL_MIN 16384
+
+
+typedef struct
+{  double *values;
+   int     n, size;
+} Trace;
+
+
+/* ----------------------------------------------------------------------- */
+static void addTrace(Trace *trace, double value)
+/* ----------------------------------------------------------------------- */
+{  if (trace->n == trace->size)
+   {  trace->size = 2 * trace->size + 16;
+      trace->values = mxRealloc(trace->values, sizeof(double) * trace->size);
+   }
+   trace->values[trace->n++] = value;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static int cholesky(const double *Sigma, const double *W, int p, double *L, double *logdet)
+/* ----------------------------------------------------------------------- */
+/* Lower triangle of L = chol(Sigma+W)', blocked left-looking: a panel of
+   NB columns first receives the updates of all columns left of it, with
+   the rows split over the threads so every column of L is read once per
+   panel, then it is factored on its own. Returns 0 if Sigma+W is not
+   positive definite. */
+{  int i, j, k, j0, nb, c;
+
+   #pragma omp parallel for schedule(static) private(i) if ((long)p * p > PARALLEL_MIN)
+   for (j = 0; j < p; j++)
+      for (i = j; i < p; i++) L[i + (long)j*p] = Sigma[i + (long)j*p] + W[i + (long)j*p];
+
+   for (j0 = 0; j0 < p; j0 += NB)
+   {  nb = (j0 + NB < p) ? NB : p - j0;
+
+      #pragma omp parallel for schedule(static) private(i,j,k) if ((long)(p - j0) * j0 > PARALLEL_MIN)
+      for (c = j0; c < p; c += ROW_CHUNK)
+      {  int c1 = (c + ROW_CHUNK < p) ? c + ROW_CHUNK : p;
+         for (k = 0; k < j0; k++)
+         {  const double *Lk = L + (long)k*p;
+            for (j = j0; j < j0 + nb; j++)
+            {  double *col = L + (long)j*p, s = Lk[j];
+               if (s == 0) continue;
+               for (i = (c > j) ? c : j; i < c1; i++) col[i] -= s * Lk[i];
+            }
+         }
+      }
+
+      for (j = j0; j < j0 + nb; j++)
+      {  double *col = L + (long)j*p;
+         for (k = j0; k < j; k++)
+         {  const double *Lk = L + (long)k*p;
+            double s = Lk[j];
+            if (s != 0)
+               for (i = j; i < p; i++) col[i] -= s * Lk[i];
+         }
+         if (!(col[j] > 0)) return 0;
+         col[j] = sqrt(col[j]);
+         for (i = j+1; i < p; i++) col[i] /= col[j];
+      }
+   }
+
+   *logdet = 0;
+   for (j = 0; j < p; j++) *logdet += 2*log(L[j + (long)j*p]);
+   return 1;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static void inverseFromCholesky(const double *L, int p, double *M, double *K)
+/* ----------------------------------------------------------------------- */
+/* K = inv(L*L') = M'*M with M = inv(L) (lower triangular, p*p workspace).
+   Both steps work on panels of NB columns so that a column of L or M is
+   read once per panel. */
+{  int j0;
+
+   /* M = L^-1, forward substitution of NB unit vectors at a time */
+   #pragma omp parallel for schedule(dynamic) if ((long)p * p > PARALLEL_MIN)
+   for (j0 = 0; j0 < p; j0 += NB)
+   {  int i, j, k, j1 = (j0 + NB < p) ? j0 + NB : p;
+      for (j = j0; j < j1; j++)
+      {  double *col = M + (long)j*p;
+         for (i = 0; i < p; i++) col[i] = 0;
+         col[j] = 1;
+      }
+      for (k = j0; k < p; k++)
+      {  const double *Lk = L + (long)k*p;
+         for (j = j0; j < j1 && j <= k; j++)
+         {  double *col = M + (long)j*p, s;
+            col[k] /= Lk[k];
+            s = col[k];
+            if (s != 0)
+               for (i = k+1; i < p; i++) col[i] -= s * Lk[i];
+         }
+      }
+   }
+
+   /* K(i,j) = M(:,i)'*M(:,j) for i >= j, M(:,i) is zero above row i */
+   #pragma omp parallel for schedule(dynamic) if ((long)p * p > PARALLEL_MIN)
+   for (j0 = 0; j0 < p; j0 += NB)
+   {  int i, j, k, j1 = (j0 + NB < p) ? j0 + NB : p;
+      for (i = j0; i < p; i++)
+      {  const double *Mi = M + (long)i*p;
+         for (j = j0; j < j1 && j <= i; j++)
+         {  const double *Mj = M + (long)j*p;
+            double s = 0;
+            for (k = i; k < p; k++) s += Mi[k] * Mj[k];
+            K[i + (long)j*p] = s;
+            K[j + (long)i*p] = s;
+         }
+      }
+   }
+}
+
+
+/* ----------------------------------------------------------------------- */
+static void gradientSteps(const double *K, const double *G, int p, double *M,
+                          double *trKG, double *trKGKG)
+/* ----------------------------------------------------------------------- */
+/* trace(K*G) and trace(K*G*K*G) for symmetric K and G, M = K*G is formed
+   panel by panel skipping the zero entries of G (the active bounds) */
+{  int    j0, i, j;
+   double s1 = 0, s2 = 0;
+
+   #pragma omp parallel for schedule(dynamic) private(i,j) reduction(+:s1) if ((long)p * p > PARALLEL_MIN)
+   for (j0 = 0; j0 < p; j0 += NB)
+   {  int k, j1 = (j0 + NB < p) ? j0 + NB : p;
+      for (j = j0; j < j1; j++)
+      {  memset(M + (long)j*p, 0, sizeof(double) * p);
+         for (i = 0; i < p; i++) s1 += K[i + (long)j*p] * G[i + (long)j*p];
+      }
+      /* Four columns of K at a time, so a column of M is read once per four */
+      for (k = 0; k + 3 < p; k += 4)
+      {  const double *K0 = K + (long)k*p, *K1 = K0 + p, *K2 = K1 + p, *K3 = K2 + p;
+         for (j = j0; j < j1; j++)
+         {  double *col = M + (long)j*p;
+            const double *g = G + k + (long)j*p;
+            if (g[0] == 0 && g[1] == 0 && g[2] == 0 && g[3] == 0) continue;
+            for (i = 0; i < p; i++) col[i] += g[0] * K0[i] + g[1] * K1[i] + g[2] * K2[i] + g[3] * K3[i];
+         }
+      }
+      for ( ; k < p; k++)
+      {  const double *Kk = K + (long)k*p;
+         for (j = j0; j < j1; j++)
+         {  double *col = M + (long)j*p, g = G[k + (long)j*p];
+            if (g != 0)
+               for (i = 0; i < p; i++) col[i] += g * Kk[i];
+         }
+      }
+   }
+
+   /* trace(M*M) = sum_ij M(i,j)*M(j,i), tile by tile */
+   #pragma omp parallel for schedule(dynamic) private(i,j) reduction(+:s2) if ((long)p * p > PARALLEL_MIN)
+   for (j0 = 0; j0 < p; j0 += TILE)
+   {  int i0, j1 = (j0 + TILE < p) ? j0 + TILE : p;
+      for (i0 = 0; i0 < p; i0 += TILE)
+      {  int i1 = (i0 + TILE < p) ? i0 + TILE : p;
+         for (j = j0; j < j1; j++)
+            for (i = i0; i < i1; i++) s2 += M[i + (long)j*p] * M[j + (long)i*p];
+      }
+   }
+
+   *trKG = s1;
+   *trKGKG = s2;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double projectBlocks(const double *W, const double *K, double t, const int *offset,
+                            int m, const double *lambda, int normtype, int p, double *D)
+/* ----------------------------------------------------------------------- */
+/* D = projection of W + t*K onto the block constraints, as in
+   projectBlockL1.c and projectBlockL2.c but out of place. The blocks on
+   and below the diagonal are done in parallel, the others are copied
+   transposed. Returns trace((D-W)*K). */
+{  int    i, j, n = 0, failed = 0;
+   double dG = 0;
+
+   for (i = 0; i < m; i++)
+      if (offset[i+1] - offset[i] > n) n = offset[i+1] - offset[i];
+
+   #pragma omp parallel private(i) reduction(+:dG) if ((long)p * p > PARALLEL_MIN)
+   {  /* Scratch buffers of every thread */
+      double *scratchX = NULL, *scratchP = NULL;
+      if (normtype != 2)
+      {  scratchX = malloc(sizeof(double) * ((long)n * n + 1));
+         scratchP = malloc(sizeof(double) * ((long)n * n + 1));
+         if ((scratchX == NULL) || (scratchP == NULL))
+         {
+            #pragma omp atomic write
+            failed = 1;
+         }
+      }
+
+      #pragma omp for schedule(dynamic)
+      for (j = 0; j < m; j++)
+      {  if (normtype != 2 && ((scratchX == NULL) || (scratchP == NULL))) continue;
+         for (i = j; i < m; i++)
+         {  int     a, b, r, c, ri = offset[i], cj = offset[j];
+            double  tau = lambda[i + j*m], v, s, scale;
+
+            r = offset[i+1] - offset[i];
+            c = offset[j+1] - offset[j];
+
+            if (i == j)
+            {  /* Box on the diagonal blocks */
+               for (b = cj; b < cj + c; b++)
+                  for (a = ri; a < ri + r; a++)
+                  {  v = W[a + (long)b*p] + t * K[a + (long)b*p];
+                     if (v < -tau) v = -tau;
+                     else if (v > tau) v = tau;
+                     D[a + (long)b*p] = v;
+                     dG += (v - W[a + (long)b*p]) * K[a + (long)b*p];
+                  }
+               continue;
+            }
+
+            if (normtype == 2)
+            {  /* Scale to the l2 ball */
+               s = 0;
+               for (b = cj; b < cj + c; b++)
+                  for (a = ri; a < ri + r; a++)
+                  {  v = W[a + (long)b*p] + t * K[a + (long)b*p];
+                     D[a + (long)b*p] = v;
+                     s += v * v;
+                  }
+               s = sqrt(s);
+               scale = (s > tau) ? tau / s : 1;
+               for (b = cj; b < cj + c; b++)
+                  for (a = ri; a < ri + r; a++)
+                  {  D[a + (long)b*p] *= scale;
+                     dG += 2 * (D[a + (long)b*p] - W[a + (long)b*p]) * K[a + (long)b*p];
+                  }
+            }
+            else
+            {  /* Project the absolute values onto the l1 ball */
+               double *dst = scratchX;
+               for (b = cj; b < cj + c; b++)
+                  for (a = ri; a < ri + r; a++)
+                     *dst++ = fabs(W[a + (long)b*p] + t * K[a + (long)b*p]);
+               memcpy((void *)scratchP, (void *)scratchX, sizeof(double) * r * c);
+               projectI(scratchP, scratchX, tau, r*c);
+
+               /* Copy back with signs */
+               dst = scratchP;
+               for (b = cj; b < cj + c; b++)
+                  for (a = ri; a < ri + r; a++, dst++)
+                  {  v = (W[a + (long)b*p] + t * K[a + (long)b*p] < 0) ? -(*dst) : *dst;
+                     D[a + (long)b*p] = v;
+                     dG += 2 * (v - W[a + (long)b*p]) * K[a + (long)b*p];
+                  }
+            }
+         }
+      }
+
+      free(scratchX);
+      free(scratchP);
+   }
+   if (failed) mexErrMsgTxt("Out of memory");
+
+   /* Blocks above the diagonal */
+   #pragma omp parallel for schedule(dynamic) private(i) if ((long)p * p > PARALLEL_MIN)
+   for (j = 0; j < m; j++)
+   {  for (i = j+1; i < m; i++)
+      {  int p0, q0, a, b, ri = offset[i], cj = offset[j];
+         int r = offset[i+1] - offset[i], c = offset[j+1] - offset[j];
+         for (q0 = 0; q0 < c; q0 += TILE)
+            for (p0 = 0; p0 < r; p0 += TILE)
+               for (a = ri + p0; a < ri + r && a < ri + p0 + TILE; a++)
+                  for (b = cj + q0; b < cj + c && b < cj + q0 + TILE; b++)
+                     D[b + (long)a*p] = D[a + (long)b*p];
+      }
+   }
+
+   return dG;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double dualityGap(const double *Sigma, const double *K, const double *lambda,
+                         const int *offset, int m, int normtype, int p)
+/* ----------------------------------------------------------------------- */
+/* trace(Sigma*K) - p plus the penalty of K: lambda.*abs(K) elementwise
+   (offset == NULL) or, per block, the sum of abs on the diagonal and the
+   l2 or max norm off the diagonal */
+{  int    i, j;
+   double eta = 0;
+
+   if (offset == NULL)
+   {
+      #pragma omp parallel for schedule(static) private(i) reduction(+:eta) if ((long)p * p > PARALLEL_MIN)
+      for (j = 0; j < p; j++)
+         for (i = 0; i < p; i++)
+            eta += Sigma[i + (long)j*p] * K[i + (long)j*p] + lambda[i + (long)j*p] * fabs(K[i + (long)j*p]);
+      return eta - p;
+   }
+
+   #pragma omp parallel for schedule(dynamic) private(i) reduction(+:eta) if ((long)p * p > PARALLEL_MIN)
+   for (j = 0; j < m; j++)
+   {  for (i = j; i < m; i++)
+      {  int    a, b;
+         double k, s = 0, mak = 0;
+         for (b = offset[j]; b < offset[j+1]; b++)
+            for (a = offset[i]; a < offset[i+1]; a++)
+            {  k = K[a + (long)b*p];
+               s += Sigma[a + (long)b*p] * k;
+               if (i == j || normtype != 2)
+               {  if (i == j) mak += fabs(k);
+                  else if (fabs(k) > mak) mak = fabs(k);
+               }
+               else mak += k * k;
+            }
+         if (i == j)
+            eta += s + lambda[i + j*m] * mak;
+         else
+         {  if (normtype == 2) mak = sqrt(mak);
+            eta += 2 * s + (lambda[i + j*m] + lambda[j + i*m]) * mak;
+         }
+      }
+   }
+   return eta - p;
+}
+
+
+/* ----------------------------------------------------------------------- */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+/* ----------------------------------------------------------------------- */
+{  const double *Sigma, *lambda, *nIndices;
+   double       *K, *W, *Wt, *L, *M, *G, *swap, epsilon, f, f0, ft, t, trKG, trKGKG, dG, eta;
+   int          *offset, p, m, i, j, iter, maxIter, normtype, pd;
+   Trace         trace;
+
+   if (nrhs < 3)
+      mexErrMsgTxt("Usage: [K,W,f,fTrace] = projGradCovselC(Sigma,lambda,nIndices[,normtype,maxIter,epsilon])");
+
+   /* Extract parameters */
+   p        = mxGetM(prhs[0]);
+   Sigma    = mxGetPr(prhs[0]);
+   lambda   = mxGetPr(prhs[1]);
+   nIndices = mxIsEmpty(prhs[2]) ? NULL : mxGetPr(prhs[2]);
+   m        = nIndices ? (int)mxGetNumberOfElements(prhs[2]) : p;
+   normtype = (nrhs > 3 && !mxIsEmpty(prhs[3]) && mxGetScalar(prhs[3]) == 2) ? 2 : 0;
+   maxIter  = (nrhs > 4 && !mxIsEmpty(prhs[4])) ? (int)mxGetScalar(prhs[4]) : (nIndices ? 500 : 1200);
+   epsilon  = (nrhs > 5 && !mxIsEmpty(prhs[5])) ? mxGetScalar(prhs[5]) : 1e-4;
+   if (mxIsSparse(prhs[0]) || mxIsSparse(prhs[1]) || mxGetN(prhs[0]) != (mwSize)p)
+      mexErrMsgTxt("Sigma must be a full square matrix and lambda full");
+   if (mxGetM(prhs[1]) != (mwSize)m || mxGetN(prhs[1]) != (mwSize)m)
+      mexErrMsgTxt("lambda must be size(Sigma) or numel(nIndices)-by-numel(nIndices)");
+
+   offset = NULL;
+   if (nIndices)
+   {  offset = mxMalloc(sizeof(int) * (m + 1));
+      offset[0] = 0;
+      for (i = 0; i < m; i++) offset[i+1] = offset[i] + (int)nIndices[i];
+      if (offset[m] != p) mexErrMsgTxt("sum(nIndices) must be size(Sigma,1)");
+   }
+
+   plhs[0] = mxCreateDoubleMatrix(p, p, mxREAL);
+   plhs[1] = mxCreateDoubleMatrix(p, p, mxREAL);
+   K  = mxGetPr(plhs[0]);
+   W  = mxGetPr(plhs[1]);
+   Wt = mxCalloc((long)p * p + 1, sizeof(double));
+   L  = mxCalloc((long)p * p + 1, sizeof(double));
+   M  = mxCalloc((long)p * p + 1, sizeof(double));
+   G  = offset ? NULL : mxCalloc((long)p * p + 1, sizeof(double));
+   trace.values = NULL;
+   trace.n = trace.size = 0;
+
+   /* Initial W: the diagonal of lambda, zero elsewhere */
+   for (i = 0; i < m; i++)
+   {  if (offset)
+         for (j = offset[i]; j < offset[i+1]; j++) W[j + (long)j*p] = lambda[i + i*m];
+      else
+         W[i + (long)i*p] = lambda[i + i*m];
+   }
+   pd = cholesky(Sigma, W, p, L, &f);
+   if (!pd) f = -HUGE_VAL;
+   addTrace(&trace, f);
+   if (!pd)
+      mexErrMsgTxt("Sigma + diag(lambda) must be positive definite");
+   inverseFromCholesky(L, p, M, K);
+
+   /* Print header */
+   mexPrintf("%4s  %11s %9s %9s\n", "Iter", "Objective", "Gap", "Step");
+
+   /* Main loop */
+   iter = 0; t = 1;
+   while (1)
+   {  f0 = f;
+      if (offset == NULL)
+      {  /* Gradient without the diagonal and the components at their bounds */
+         #pragma omp parallel for schedule(static) private(i) if ((long)p * p > PARALLEL_MIN)
+         for (j = 0; j < p; j++)
+            for (i = 0; i < p; i++)
+            {  long   k = i + (long)j*p;
+               double g = K[k];
+               if (i == j || (W[k] == lambda[k] && g > 0) || (W[k] == -lambda[k] && g < 0)) g = 0;
+               G[k] = g;
+            }
+         gradientSteps(K, G, p, M, &trKG, &trKGKG);
+         t = trKG / trKGKG;
+
+         /* Halve the step until the objective does not decrease */
+         while (1)
+         {
+            #pragma omp parallel for schedule(static) private(i) if ((long)p * p > PARALLEL_MIN)
+            for (j = 0; j < p; j++)
+               for (i = 0; i < p; i++)
+               {  long   k = i + (long)j*p;
+                  double v = W[k] + t * G[k];
+                  if (v > lambda[k]) v = lambda[k];
+                  else if (v < -lambda[k]) v = -lambda[k];
+                  Wt[k] = v;
+               }
+            pd = cholesky(Sigma, Wt, p, L, &ft);
+            if (!pd) ft = -HUGE_VAL;
+            addTrace(&trace, ft);
+            if (ft >= f0 || t < 1e-6) break;
+            t = t / 2;
+         }
+      }
+      else
+      {  /* Armijo backtracking along the projection arc */
+         dG = projectBlocks(W, K, t, offset, m, lambda, normtype, p, Wt);
+         pd = cholesky(Sigma, Wt, p, L, &ft);
+         if (!pd) ft = -HUGE_VAL;
+         addTrace(&trace, ft);
+         while (ft < f0 + 1e-3 * dG)
+         {  if (t < 1e-6) break;
+            t = 0.5 * t;
+            dG = projectBlocks(W, K, t, offset, m, lambda, normtype, p, Wt);
+            pd = cholesky(Sigma, Wt, p, L, &ft);
+            if (!pd) ft = -HUGE_VAL;
+            addTrace(&trace, ft);
+         }
+      }
+
+      /* Update W and K */
+      if (pd)
+      {  f = ft;
+         swap = W; W = Wt; Wt = swap;
+         inverseFromCholesky(L, p, M, K);
+      }
+
+      /* Compute duality gap */
+      eta = dualityGap(Sigma, K, lambda, offset, m, normtype, p);
+
+      /* Increment iteration and print progress */
+      iter++;
+      mexPrintf("%4d  %11.4e %9.2e %9.2e\n", iter, pd ? f : -HUGE_VAL, eta, t);
+
+      /* Check stopping criterion */
+      if (eta < epsilon)
+      {  mexPrintf("Exit: Optimal solution\n");
+         break;
+      }
+      else if (iter >= maxIter)
+      {  mexPrintf("Exit: Maximum number of iterations reached\n");
+         break;
+      }
+      else if (t < 1e-6)
+      {  mexPrintf("Exit: Linesearch error\n");
+         break;
+      }
+
+      /* Increase t slightly */
+      if (offset) t = t / 0.5;
+   }
+
+   /* W and Wt may have been swapped */
+   if (W != mxGetPr(plhs[1]))
+   {  memcpy(Wt, W, sizeof(double) * p * p);
+      mxFree(W);
+   }
+   else mxFree(Wt);
+
+   if (nlhs > 2) plhs[2] = mxCreateDoubleScalar(f);
+   if (nlhs > 3)
+   {  plhs[3] = mxCreateDoubleMatrix(trace.n, 1, mxREAL);
+      memcpy(mxGetPr(plhs[3]), trace.values, sizeof(double) * trace.n);
+   }
+
+   if (trace.values) mxFree(trace.values);
+   if (offset) mxFree(offset);
+   if (G) mxFree(G);
+   mxFree(L);
+   mxFree(M);
+}
@@ -0,0 +1,494 @@
+/* L1precisionBCDC.c
+
+   [X,W,gap,fValues] = L1precisionBCDC(S,lambda,maxIter,optTol,W0)
+
+   Block coordinate descent for the sparse inverse covariance (graphical
+   lasso) problem, as in L1precisionBCD_traced.m: W = S + lambda*I is
+   improved one column at a time, every column solving the Lasso
+   subproblem min_b 1/2 b'*W11*b - s12'*b + lambda*|b|_1 by coordinate
+   descent warm started at its previous solution, w12 = W11*b.
+
+   Screening: nodes i,j can only interact if |S(i,j)| > lambda, the
+   connected components of that graph are solved independently (and in
+   parallel), isolated nodes are done after W(i,i) = S(i,i)+lambda.
+
+   X = W^-1 can be kept up to date with an O(q^2) update per column (q is
+   the size of the component), which also gives the change of logdet(W)
+   and the duality gap trace(S*X) + lambda*sum(abs(X(:))) - p without
+   refactoring W. fValues(1) is logdet(W0) (W0 = S + lambda*I by default)
+   of the whole matrix, and fValues(1+(t-1)*p+i) is logdet(W) after column
+   i of sweep t. The iterate W is block diagonal over the components (the
+   entries between components are zero, as in the solution), so these are
+   sums of the logdets of the components; they follow the fValues of the
+   MATLAB code when there is a single component. This costs O(q^2) per
+   column, so it is only done when fValues is requested; otherwise X is
+   formed from the regressions once per sweep (and symmetrized), as in
+   glasso.
+
+   A component stops when its gap is below optTol*q/p, so the total gap
+   is below optTol. W0 (optional) is a positive definite warm start whose
+   blocks are used for the components; W0 entries between different
+   components are ignored.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mex.h"
+
+/* Coordinate descent settings of the column subproblems */
+#define CD_TOL 1e-10
+#define CD_MAX_PASSES 1000
+
+
+/* ----------------------------------------------------------------------- */
+static int findComponents(const double *S, int p, double lambda, int *order, int *compStart)
+/* ----------------------------------------------------------------------- */
+/* Connected components of |S(i,j)| > lambda; the nodes of component c
+   are order[compStart[c]..compStart[c+1]-1] in increasing order.
+   Returns the number of components. */
+{  int  i, j, c, nComp = 0, head, tail, *comp, *stack, *count;
+
+   comp  = mxMalloc(sizeof(int) * p);
+   stack = mxMalloc(sizeof(int) * p);
+   for (i = 0; i < p; i++) comp[i] = -1;
+
+   for (i = 0; i < p; i++)
+   {  if (comp[i] >= 0) continue;
+      comp[i] = nComp;
+      stack[0] = i; tail = 1;
+      for (head = 0; head < tail; head++)
+      {  const double *col = S + (long)stack[head] * p;
+         for (j = 0; j < p; j++)
+         {  if (comp[j] < 0 && fabs(col[j]) > lambda)
+            {  comp[j] = nComp;
+               stack[tail++] = j;
+            }
+         }
+      }
+      nComp++;
+   }
+
+   /* Counting sort keeps the nodes of a component in increasing order */
+   count = mxCalloc(nComp + 1, sizeof(int));
+   for (i = 0; i < p; i++) count[comp[i]+1]++;
+   for (c = 0; c < nComp; c++) count[c+1] += count[c];
+   memcpy(compStart, count, sizeof(int) * (nComp + 1));
+   for (i = 0; i < p; i++) order[count[comp[i]]++] = i;
+
+   mxFree(comp);
+   mxFree(stack);
+   mxFree(count);
+   return nComp;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static int choleskyPD(const double *A, int q, double *L, double *logdet)
+/* ----------------------------------------------------------------------- */
+/* A = L*L' with L lower triangular (q*q, left-looking, all loops run down
+   columns) and logdet = logdet(A). Returns 0 if A is not positive
+   definite. */
+{  int     i, j, k;
+   double  s, *col;
+
+   for (j = 0; j < q; j++)
+   {  col = L + (long)j*q;
+      for (i = j; i < q; i++) col[i] = A[i + (long)j*q];
+      for (k = 0; k < j; k++)
+      {  const double *Lk = L + (long)k*q;
+         s = Lk[j];
+         if (s != 0)
+            for (i = j; i < q; i++) col[i] -= s * Lk[i];
+      }
+      if (!(col[j] > 0)) return 0;
+      col[j] = sqrt(col[j]);
+      for (i = j+1; i < q; i++) col[i] /= col[j];
+   }
+   *logdet = 0;
+   for (j = 0; j < q; j++) *logdet += 2*log(L[j + (long)j*q]);
+   return 1;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static int invertPD(const double *A, int q, double *Ainv, double *L, double *logdet)
+/* ----------------------------------------------------------------------- */
+/* Ainv = A^-1 by a Cholesky factorization, L is 2*q*q workspace. Returns
+   0 if A is not positive definite. */
+{  int     i, j, k;
+   double  s, *col, *M = L + (long)q*q;
+
+   if (!choleskyPD(A, q, L, logdet)) return 0;
+
+   /* M = L^-1 by forward substitution of the unit vectors */
+   for (j = 0; j < q; j++)
+   {  col = M + (long)j*q;
+      for (i = 0; i < q; i++) col[i] = 0;
+      col[j] = 1;
+      for (k = j; k < q; k++)
+      {  const double *Lk = L + (long)k*q;
+         col[k] /= Lk[k];
+         s = col[k];
+         for (i = k+1; i < q; i++) col[i] -= s * Lk[i];
+      }
+   }
+
+   /* Ainv = M' * M */
+   for (j = 0; j < q; j++)
+   {  for (i = j; i < q; i++)
+      {  const double *Mi = M + (long)i*q, *Mj = M + (long)j*q;
+         s = 0;
+         for (k = i; k < q; k++) s += Mi[k] * Mj[k];
+         Ainv[i + (long)j*q] = s;
+         Ainv[j + (long)i*q] = s;
+      }
+   }
+   return 1;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static void lassoColumn(const double *W, const double *S, int q, int j, double lambda,
+                        double *b, double *Wb)
+/* ----------------------------------------------------------------------- */
+/* Coordinate descent for min_b 1/2 b'*W11*b - s12'*b + lambda*|b|_1, W11
+   is W without row and column j and s12 = S(:,j) without entry j; b and
+   Wb = W11*b are full length q with b[j] = 0. Passes over the nonzero
+   coordinates are repeated until they converge, then one pass over all
+   coordinates checks whether the active set is complete. */
+{  int    k, l, pass, fullPass = 1;
+   double delta, maxDelta, r, bNew, *Wk;
+   const double *s12 = S + (long)j*q;
+
+   for (pass = 0; pass < CD_MAX_PASSES; pass++)
+   {  maxDelta = 0;
+      for (k = 0; k < q; k++)
+      {  if (k == j || (!fullPass && b[k] == 0)) continue;
+         Wk = (double *)W + (long)k*q;
+
+         /* Residual without the contribution of b[k] */
+         r = s12[k] - Wb[k] + Wk[k] * b[k];
+         if (r > lambda)       bNew = (r - lambda) / Wk[k];
+         else if (r < -lambda) bNew = (r + lambda) / Wk[k];
+         else                  bNew = 0;
+
+         delta = bNew - b[k];
+         if (delta != 0)
+         {  for (l = 0; l < q; l++) Wb[l] += Wk[l] * delta;
+            b[k] = bNew;
+            if (fabs(delta) * Wk[k] > maxDelta) maxDelta = fabs(delta) * Wk[k];
+         }
+      }
+      if (maxDelta < CD_TOL)
+      {  if (fullPass) break;
+         fullPass = 1;
+      }
+      else
+         fullPass = 0;
+   }
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double dualityGap(const double *S, const double *X, int q, double lambda)
+/* ----------------------------------------------------------------------- */
+{  long   k, n = (long)q*q;
+   double gap = -q;
+
+   for (k = 0; k < n; k++) gap += S[k] * X[k] + lambda * fabs(X[k]);
+   return gap;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static void precisionFromRegressions(const double *W, const double *B, double *X, int q)
+/* ----------------------------------------------------------------------- */
+/* X(:,j) = [-b; 1]/(w22 - w12'*b) for every column, then symmetrized */
+{  int    i, j, k;
+   double x22;
+
+   for (j = 0; j < q; j++)
+   {  const double *Wj = W + (long)j*q, *b = B + (long)j*q;
+      double       *Xj = X + (long)j*q;
+      x22 = Wj[j];
+      for (k = 0; k < q; k++) if (k != j) x22 -= Wj[k] * b[k];
+      x22 = 1 / x22;
+      for (k = 0; k < q; k++) Xj[k] = -b[k] * x22;
+      Xj[j] = x22;
+   }
+   for (j = 0; j < q; j++)
+      for (i = j+1; i < q; i++)
+      {  x22 = (X[i + (long)j*q] + X[j + (long)i*q]) / 2;
+         X[i + (long)j*q] = x22;
+         X[j + (long)i*q] = x22;
+      }
+}
+
+
+/* ----------------------------------------------------------------------- */
+static int solveComponent(double *S, double *W, double *X, int q, double lambda,
+                          int maxIter, double optTol, int warm, int trace,
+                          double *logdet0, double *dLogdet, double *gap)
+/* ----------------------------------------------------------------------- */
+/* Block coordinate descent on one component, S/W/X are q*q. With trace,
+   X = W^-1 is updated after every column and dLogdet[j + t*q] is the
+   change of logdet(W) by column j in sweep t (maxIter*q entries); that
+   costs O(q^2) per column. Without trace X is formed from the
+   regressions once per sweep, and W is only inverted to confirm
+   convergence. Returns the number of sweeps done, -1 if W is not
+   positive definite or -2 if the workspace cannot be allocated. Called
+   in the parallel region, so it uses malloc. */
+{  int    i, j, k, t;
+   double x22, schur, w22, xw, c, *B, *b, *Wb, *bStar, *x12, *L;
+
+   B     = calloc((long)q*q, sizeof(double));
+   Wb    = malloc(sizeof(double) * q);
+   bStar = malloc(sizeof(double) * q);
+   x12   = malloc(sizeof(double) * q);
+   L     = malloc(sizeof(double) * 2*(long)q*q);
+
+   if (!B || !Wb || !bStar || !x12 || !L)
+   {  free(B); free(Wb); free(bStar); free(x12); free(L);
+      return -2;
+   }
+
+   if ((trace || warm) && !invertPD(W, q, X, L, logdet0))
+   {  free(B); free(Wb); free(bStar); free(x12); free(L);
+      return -1;
+   }
+
+   /* A warm start also warm starts the regressions: b = W11^-1 w12 */
+   if (warm)
+   {  for (j = 0; j < q; j++)
+         for (k = 0; k < q; k++)
+            B[k + (long)j*q] = (k == j) ? 0 : -X[k + (long)j*q] / X[j + (long)j*q];
+   }
+
+   for (t = 0; t < maxIter; t++)
+   {  if (!trace && t > 0)
+      {  /* X is only close to W^-1 after every column was solved, a
+            small gap is confirmed with the exact inverse */
+         precisionFromRegressions(W, B, X, q);
+         if (dualityGap(S, X, q, lambda) < optTol && invertPD(W, q, X, L, &c)
+             && dualityGap(S, X, q, lambda) < optTol)
+         {  *gap = dualityGap(S, X, q, lambda);
+            break;
+         }
+      }
+      else if (trace)
+      {  *gap = dualityGap(S, X, q, lambda);
+         if (*gap < optTol) break;
+      }
+
+      for (j = 0; j < q; j++)
+      {  double *Wj = W + (long)j*q, *Xj = X + (long)j*q;
+         b = B + (long)j*q;
+         w22 = Wj[j];
+
+         /* Solve the Lasso subproblem, Wb = W11*b is the new w12 */
+         for (k = 0; k < q; k++) Wb[k] = 0;
+         for (k = 0; k < q; k++)
+         {  if (k == j || b[k] == 0) continue;
+            for (i = 0; i < q; i++) Wb[i] += W[i + (long)k*q] * b[k];
+         }
+         lassoColumn(W, S, q, j, lambda, b, Wb);
+         Wb[j] = 0;
+
+         if (trace)
+         {  /* W11^-1 = X11 - x12*x12'/x22, bStar = W11^-1 * w12new */
+            x22 = Xj[j];
+            memcpy(x12, Xj, sizeof(double) * q);
+            x12[j] = 0;
+            xw = 0;
+            for (k = 0; k < q; k++) xw += x12[k] * Wb[k];
+            for (k = 0; k < q; k++) bStar[k] = 0;
+            for (k = 0; k < q; k++)
+            {  const double *Xk = X + (long)k*q;
+               if (k == j || Wb[k] == 0) continue;
+               for (i = 0; i < q; i++) bStar[i] += Xk[i] * Wb[k];
+            }
+            for (k = 0; k < q; k++) bStar[k] -= x12[k] * xw / x22;
+            bStar[j] = 0;
+
+            schur = w22;
+            for (k = 0; k < q; k++) schur -= Wb[k] * bStar[k];
+            if (!(schur > 0))
+            {  /* Lost positive definiteness to round-off, skip the column */
+               dLogdet[j + (long)t*q] = 0;
+               continue;
+            }
+
+            /* logdet(W) = logdet(W11) + log(w22 - w12'*W11^-1*w12) */
+            dLogdet[j + (long)t*q] = log(schur) + log(x22);
+
+            /* X11 = W11^-1 + bStar*bStar'/schur, x12 = -bStar/schur */
+            for (k = 0; k < q; k++)
+            {  double *Xk = X + (long)k*q;
+               if (k == j) continue;
+               c = bStar[k] / schur;
+               for (i = 0; i < q; i++)
+                  if (i != j) Xk[i] += bStar[i] * c - x12[i] * x12[k] / x22;
+            }
+            for (k = 0; k < q; k++)
+            {  if (k == j) continue;
+               Xj[k] = -bStar[k] / schur;
+               X[j + (long)k*q] = Xj[k];
+            }
+            Xj[j] = 1 / schur;
+         }
+
+         for (k = 0; k < q; k++)
+         {  if (k == j) continue;
+            Wj[k] = Wb[k];
+            W[j + (long)k*q] = Wb[k];
+         }
+      }
+   }
+   if (t == maxIter)
+   {  if (!trace && !invertPD(W, q, X, L, &c))
+         precisionFromRegressions(W, B, X, q);
+      *gap = dualityGap(S, X, q, lambda);
+   }
+
+   free(B);
+   free(Wb);
+   free(bStar);
+   free(x12);
+   free(L);
+   return t;
+}
+
+
+/* ----------------------------------------------------------------------- */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+/* ----------------------------------------------------------------------- */
+{  const double *S, *W0;
+   double        lambda, optTol, *X, *W, *fValues, *dLogdet, *logdet0, *gaps, gap, f;
+   int           p, maxIter, nComp, nSweeps, trace, c, i, j, t, *order, *compStart, *sweeps;
+
+   if (nrhs < 2)
+      mexErrMsgTxt("Usage: [X,W,gap,fValues] = L1precisionBCDC(S,lambda[,maxIter,optTol,W0])");
+
+   /* Extract parameters */
+   S       = mxGetPr(prhs[0]);
+   p       = mxGetM(prhs[0]);
+   lambda  = mxGetScalar(prhs[1]);
+   maxIter = (nrhs > 2 && !mxIsEmpty(prhs[2])) ? (int)mxGetScalar(prhs[2]) : 100;
+   optTol  = (nrhs > 3 && !mxIsEmpty(prhs[3])) ? mxGetScalar(prhs[3]) : 1e-5;
+   W0      = (nrhs > 4 && !mxIsEmpty(prhs[4])) ? mxGetPr(prhs[4]) : NULL;
+   if (mxGetN(prhs[0]) != (mwSize)p || (W0 && (mxGetM(prhs[4]) != (mwSize)p || mxGetN(prhs[4]) != (mwSize)p)))
+      mexErrMsgTxt("S and W0 must be square and of the same size");
+   if (maxIter < 0) maxIter = 0;
+   trace   = nlhs > 3;
+
+   plhs[0] = mxCreateDoubleMatrix(p, p, mxREAL);
+   plhs[1] = mxCreateDoubleMatrix(p, p, mxREAL);
+   X = mxGetPr(plhs[0]);
+   W = mxGetPr(plhs[1]);
+
+   /* Screening */
+   order     = mxMalloc(sizeof(int) * (p + 1));
+   compStart = mxMalloc(sizeof(int) * (p + 2));
+   nComp     = findComponents(S, p, lambda, order, compStart);
+
+   dLogdet = mxCalloc(trace ? (long)maxIter * p + 1 : 1, sizeof(double));
+   logdet0 = mxCalloc(nComp + 1, sizeof(double));
+   gaps    = mxCalloc(nComp + 1, sizeof(double));
+   sweeps  = mxCalloc(nComp + 1, sizeof(int));
+
+   #pragma omp parallel for schedule(dynamic) private(i, j, t)
+   for (c = 0; c < nComp; c++)
+   {  int     q = compStart[c+1] - compStart[c], *idx = order + compStart[c];
+      double *Sc, *Wc, *Xc, *dl;
+
+      if (q == 1)
+      {  /* Isolated node */
+         i = idx[0];
+         W[i + (long)i*p] = S[i + (long)i*p] + lambda;
+         if (W0) W[i + (long)i*p] = W0[i + (long)i*p];
+         X[i + (long)i*p] = 1 / W[i + (long)i*p];
+         logdet0[c] = log(W[i + (long)i*p]);
+         gaps[c] = (S[i + (long)i*p] + lambda) * X[i + (long)i*p] - 1;
+         continue;
+      }
+
+      Sc = malloc(sizeof(double) * (long)q*q);
+      Wc = malloc(sizeof(double) * (long)q*q);
+      Xc = malloc(sizeof(double) * (long)q*q);
+      dl = calloc(trace ? (long)maxIter*q + 1 : 1, sizeof(double));
+      if (!Sc || !Wc || !Xc || !dl)
+      {  sweeps[c] = -2;
+         free(Sc); free(Wc); free(Xc); free(dl);
+         continue;
+      }
+      for (j = 0; j < q; j++)
+         for (i = 0; i < q; i++)
+         {  Sc[i + (long)j*q] = S[idx[i] + (long)idx[j]*p];
+            Wc[i + (long)j*q] = W0 ? W0[idx[i] + (long)idx[j]*p]
+                                   : Sc[i + (long)j*q] + (i == j ? lambda : 0);
+         }
+
+      sweeps[c] = solveComponent(Sc, Wc, Xc, q, lambda, maxIter, optTol * q / p,
+                                 W0 != NULL, trace, &logdet0[c], dl, &gaps[c]);
+
+      if (sweeps[c] >= 0)
+      {  for (t = 0; trace && t < sweeps[c]; t++)
+            for (j = 0; j < q; j++)
+               dLogdet[idx[j] + (long)t*p] = dl[j + (long)t*q];
+         for (j = 0; j < q; j++)
+            for (i = 0; i < q; i++)
+            {  W[idx[i] + (long)idx[j]*p] = Wc[i + (long)j*q];
+               X[idx[i] + (long)idx[j]*p] = Xc[i + (long)j*q];
+            }
+      }
+      free(Sc);
+      free(Wc);
+      free(Xc);
+      free(dl);
+   }
+
+   /* Assemble the trace of logdet(W) in the column order of the MATLAB code */
+   nSweeps = 0;
+   f = 0;
+   gap = 0;
+   for (c = 0; c < nComp; c++)
+   {  if (sweeps[c] == -2)
+         mexErrMsgTxt("Out of memory in L1precisionBCDC");
+      if (sweeps[c] < 0)
+         mexErrMsgTxt("W is not positive definite");
+      if (sweeps[c] > nSweeps) nSweeps = sweeps[c];
+      f += logdet0[c];
+      gap += gaps[c];
+   }
+   if (trace)
+   {  /* The first value is logdet of the whole starting matrix, the
+         entries between the components are dropped from then on */
+      double *W1 = mxMalloc(sizeof(double) * (long)p*p);
+      double *L  = mxMalloc(sizeof(double) * (long)p*p);
+      double  f0;
+      for (j = 0; j < p; j++)
+         for (i = 0; i < p; i++)
+            W1[i + (long)j*p] = W0 ? W0[i + (long)j*p] : S[i + (long)j*p] + (i == j ? lambda : 0);
+      if (!choleskyPD(W1, p, L, &f0))
+         mexErrMsgTxt("W is not positive definite");
+      mxFree(W1);
+      mxFree(L);
+
+      plhs[3] = mxCreateDoubleMatrix((long)nSweeps*p + 1, 1, mxREAL);
+      fValues = mxGetPr(plhs[3]);
+      fValues[0] = f0;
+      for (j = 0; j < nSweeps*p; j++)
+      {  f += dLogdet[j];
+         fValues[j+1] = f;
+      }
+   }
+   if (nlhs > 2) plhs[2] = mxCreateDoubleScalar(gap);
+
+   mxFree(order);
+   mxFree(compStart);
+   mxFree(dLogdet);
+   mxFree(logdet0);
+   mxFree(gaps);
+   mxFree(sweeps);
+}
@@ -15,6 +15,15 @@ maxIter = 2;
 A = [eye(p-1,p-1);-eye(p-1,p-1)];
 f = zeros(p-1,1);
 
+% Compiled solver: coordinate descent for the columns, split into the
+% connected components of abs(S) > lambda, objective traced without inverting W
+if exist('L1precisionBCDC') == 3
+    [X,W,gap,fTrace] = L1precisionBCDC(S,row,maxIter,optTol);
+    fValues = [fValues;fTrace];
+    fprintf('Iter = %d, OptCond = %.5f\n',(length(fTrace)-1)/p,gap);
+    return;
+end
+
 % Initial W
 W = S + row*eye(p,p);
 fValues(end+1,1) = logdet(W);
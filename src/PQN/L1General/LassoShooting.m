@@ -8,9 +8,24 @@ function [w,wp,m] = LassoShooting(X, y, lambda,varargin)
 % Modifications:
 %   We precompute the Hessian diagonals, since they do not 
 %   change between iterations
-[maxIter,verbose,optTol,zeroThreshold] = process_options(varargin,'maxIter',10000,'verbose',2,'optTol',1e-5,'zeroThreshold',1e-4);
+%
+% Option 'lambda2' adds lambda2*sum(w.^2) (elastic net). If LassoShootingC
+% is compiled it is used instead, unless the iterates wp are requested
+% (they are only recorded by the MATLAB code, with verbose = 2); lambda can
+% then be a decreasing vector (a path, w has a column for every value) and
+% X sparse.
+[maxIter,verbose,optTol,zeroThreshold,lambda2] = process_options(varargin,'maxIter',10000,'verbose',2,'optTol',1e-5,'zeroThreshold',1e-4,'lambda2',0);
 [n p] = size(X);
 
+if exist('LassoShootingC') == 3 && nargout < 2
+    [w,m] = LassoShootingC(X,y,lambda,lambda2,maxIter,optTol);
+    m = sum(m);
+    if verbose
+        fprintf('Number of iterations: %d\n',m);
+    end
+    return;
+end
+
 % Start from the Least Squares solution
 beta = (X'*X + lambda*eye(p))\(X'*y);
 % Start the log
@@ -23,7 +38,7 @@ end
 
 m = 0;
 
-XX2 = X'*X*2;
+XX2 = X'*X*2 + 2*lambda2*eye(p);
 Xy2 = X'*y*2;
 while m < maxIter
     
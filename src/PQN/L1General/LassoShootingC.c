@@ -0,0 +1,261 @@
+/* LassoShootingC.c
+
+   [W,nIter] = LassoShootingC(X,y,lambda,lambda2,maxIter,optTol,w0)
+
+   Shooting (coordinate descent) for the Lasso / elastic net
+      min_w sum((X*w-y).^2) + lambda*sum(abs(w)) + lambda2*sum(w.^2)
+   for every value in the vector lambda, column m of W is the solution
+   for lambda(m), warm started at the solution for lambda(m-1) (w0 for
+   the first one, default zeros). nIter(m) is the number of passes.
+   X can be dense or sparse.
+
+   Covariance updates: the gradient g = X'*(y-X*w) is updated with the
+   Gram column X'*x_k of a coordinate, which is only computed when the
+   coordinate first becomes nonzero. Passes only visit the active set;
+   after the active set converged the gradient of the other coordinates
+   is brought up to date (in parallel) and their optimality conditions
+   are checked, first for the coordinates that survive the strong rule
+   |2*g_j| >= 2*lambda(m) - lambda(m-1), then for all of them.
+
+   A pass has converged when the sum of the absolute changes is below
+   optTol (as LassoShooting.m), maxIter bounds the passes per lambda.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mex.h"
+
+/* Problems smaller than this are not worth the threads */
+#define PARALLEL_MIN 4096
+
+
+typedef struct
+{  const double  *pr;
+   const mwIndex *ir, *jc;     /* Only for sparse X */
+   int            n, p, sparse;
+} Design;
+
+
+/* ----------------------------------------------------------------------- */
+static double columnDot(const Design *X, int j, const double *v)
+/* ----------------------------------------------------------------------- */
+/* x_j' * v */
+{  double  s = 0;
+   long    i;
+
+   if (X->sparse)
+   {  for (i = X->jc[j]; i < (long)X->jc[j+1]; i++) s += X->pr[i] * v[X->ir[i]];
+   }
+   else
+   {  const double *x = X->pr + (long)j * X->n;
+      for (i = 0; i < X->n; i++) s += x[i] * v[i];
+   }
+   return s;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static void columnAxpy(const Design *X, int j, double a, double *v)
+/* ----------------------------------------------------------------------- */
+/* v += a * x_j */
+{  long i;
+
+   if (X->sparse)
+   {  for (i = X->jc[j]; i < (long)X->jc[j+1]; i++) v[X->ir[i]] += a * X->pr[i];
+   }
+   else
+   {  const double *x = X->pr + (long)j * X->n;
+      for (i = 0; i < X->n; i++) v[i] += a * x[i];
+   }
+}
+
+
+/* ----------------------------------------------------------------------- */
+static void gramColumn(const Design *X, int k, double *work, double *G)
+/* ----------------------------------------------------------------------- */
+/* G = X' * x_k, work is a zero vector of length n (and is left zero) */
+{  int j, p = X->p;
+
+   memset(work, 0, sizeof(double) * X->n);
+   columnAxpy(X, k, 1, work);
+
+   #pragma omp parallel for schedule(static) if ((long)p * X->n > PARALLEL_MIN)
+   for (j = 0; j < p; j++) G[j] = columnDot(X, j, work);
+
+   memset(work, 0, sizeof(double) * X->n);
+}
+
+
+/* ----------------------------------------------------------------------- */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+/* ----------------------------------------------------------------------- */
+{  Design        X;
+   const double *y, *lambda, *w0;
+   double        lambda2, optTol, lambdaPrev, lam, change, c, bNew, delta,
+                *W, *w, *wRef, *g, *d, *work, **G;
+   int           n, p, nLambda, maxIter, nActive, added, m, j, k, pass,
+                *active, *slot, *strong, *nIter;
+
+   if (nrhs < 3)
+      mexErrMsgTxt("Usage: [W,nIter] = LassoShootingC(X,y,lambda[,lambda2,maxIter,optTol,w0])");
+
+   /* Extract parameters */
+   X.pr     = mxGetPr(prhs[0]);
+   X.sparse = mxIsSparse(prhs[0]);
+   X.ir     = X.sparse ? mxGetIr(prhs[0]) : NULL;
+   X.jc     = X.sparse ? mxGetJc(prhs[0]) : NULL;
+   X.n      = n = mxGetM(prhs[0]);
+   X.p      = p = mxGetN(prhs[0]);
+   y        = mxGetPr(prhs[1]);
+   lambda   = mxGetPr(prhs[2]);
+   nLambda  = mxGetNumberOfElements(prhs[2]);
+   lambda2  = (nrhs > 3 && !mxIsEmpty(prhs[3])) ? mxGetScalar(prhs[3]) : 0;
+   maxIter  = (nrhs > 4 && !mxIsEmpty(prhs[4])) ? (int)mxGetScalar(prhs[4]) : 10000;
+   optTol   = (nrhs > 5 && !mxIsEmpty(prhs[5])) ? mxGetScalar(prhs[5]) : 1e-5;
+   w0       = (nrhs > 6 && !mxIsEmpty(prhs[6])) ? mxGetPr(prhs[6]) : NULL;
+   if (mxGetNumberOfElements(prhs[1]) != (size_t)n || (w0 && mxGetNumberOfElements(prhs[6]) != (size_t)p))
+      mexErrMsgTxt("y must have size(X,1) and w0 size(X,2) elements");
+
+   plhs[0] = mxCreateDoubleMatrix(p, nLambda, mxREAL);
+   W = mxGetPr(plhs[0]);
+   plhs[1] = mxCreateDoubleMatrix(nLambda > 0 ? 1 : 0, nLambda, mxREAL);
+
+   w      = mxCalloc(p + 1, sizeof(double));
+   wRef   = mxCalloc(p + 1, sizeof(double));
+   g      = mxCalloc(p + 1, sizeof(double));
+   d      = mxCalloc(p + 1, sizeof(double));
+   work   = mxCalloc(n + 1, sizeof(double));
+   G      = mxCalloc(p + 1, sizeof(double *));
+   active = mxCalloc(p + 1, sizeof(int));
+   slot   = mxCalloc(p + 1, sizeof(int));
+   strong = mxCalloc(p + 1, sizeof(int));
+   nIter  = mxCalloc(nLambda + 1, sizeof(int));
+
+   /* Residual r = y - X*w0 and g = X'*r */
+   memcpy(work, y, sizeof(double) * n);
+   for (j = 0; j < p; j++)
+   {  if (w0) w[j] = w0[j];
+      if (w[j] != 0) columnAxpy(&X, j, -w[j], work);
+   }
+   #pragma omp parallel for schedule(static) if ((long)n * p > PARALLEL_MIN)
+   for (j = 0; j < p; j++)
+   {  const double *x = X.pr + (long)j * n;
+      long i;
+      g[j] = columnDot(&X, j, work);
+      d[j] = 0;
+      if (X.sparse)
+         for (i = X.jc[j]; i < (long)X.jc[j+1]; i++) d[j] += X.pr[i] * X.pr[i];
+      else
+         for (i = 0; i < n; i++) d[j] += x[i] * x[i];
+   }
+   memset(work, 0, sizeof(double) * n);
+
+   /* Start with the nonzeros of w0 active */
+   nActive = 0;
+   for (j = 0; j < p; j++)
+   {  slot[j] = -1;
+      wRef[j] = w[j];
+      if (w[j] != 0)
+      {  G[j] = mxMalloc(sizeof(double) * p);
+         gramColumn(&X, j, work, G[j]);
+         slot[j] = nActive;
+         active[nActive++] = j;
+      }
+   }
+
+   /* Previous lambda of the strong rule: the smallest lambda with w = 0 */
+   lambdaPrev = 0;
+   for (j = 0; j < p; j++)
+      if (2*fabs(g[j]) > lambdaPrev) lambdaPrev = 2*fabs(g[j]);
+   if (w0) lambdaPrev = HUGE_VAL;
+
+   for (m = 0; m < nLambda; m++)
+   {  lam = lambda[m];
+
+      /* Strong set */
+      for (j = 0; j < p; j++)
+         strong[j] = slot[j] >= 0 || lam > lambdaPrev || 2*fabs(g[j]) >= 2*lam - lambdaPrev;
+
+      pass = 0;
+      while (1)
+      {  /* Coordinate descent on the active set */
+         for ( ; pass < maxIter; )
+         {  change = 0;
+            for (k = 0; k < nActive; k++)
+            {  j = active[k];
+               if (d[j] + lambda2 <= 0) continue;
+               c = 2*(g[j] + d[j] * w[j]);
+               if (c > lam)       bNew = (c - lam) / (2*(d[j] + lambda2));
+               else if (c < -lam) bNew = (c + lam) / (2*(d[j] + lambda2));
+               else               bNew = 0;
+
+               delta = bNew - w[j];
+               if (delta != 0)
+               {  const double *Gj = G[j];
+                  int a;
+                  for (a = 0; a < nActive; a++) g[active[a]] -= Gj[active[a]] * delta;
+                  w[j] = bNew;
+                  change += fabs(delta);
+               }
+            }
+            pass++;
+            if (change < optTol) break;
+         }
+
+         /* Bring the gradient of the inactive coordinates up to date */
+         #pragma omp parallel for schedule(static) private(k) if ((long)p * nActive > PARALLEL_MIN)
+         for (j = 0; j < p; j++)
+         {  if (slot[j] >= 0) continue;
+            for (k = 0; k < nActive; k++)
+            {  int a = active[k];
+               if (w[a] != wRef[a]) g[j] -= G[a][j] * (w[a] - wRef[a]);
+            }
+         }
+         for (k = 0; k < nActive; k++) wRef[active[k]] = w[active[k]];
+         if (pass >= maxIter) break;
+
+         /* Optimality conditions of the strong set, then of the rest */
+         added = 0;
+         for (j = 0; j < p; j++)
+         {  if (slot[j] < 0 && strong[j] && 2*fabs(g[j]) > lam)
+            {  G[j] = mxMalloc(sizeof(double) * p);
+               gramColumn(&X, j, work, G[j]);
+               slot[j] = nActive;
+               active[nActive++] = j;
+               added++;
+            }
+         }
+         if (added) continue;
+         for (j = 0; j < p; j++)
+         {  if (slot[j] < 0 && !strong[j] && 2*fabs(g[j]) > lam)
+            {  strong[j] = 1;
+               G[j] = mxMalloc(sizeof(double) * p);
+               gramColumn(&X, j, work, G[j]);
+               slot[j] = nActive;
+               active[nActive++] = j;
+               added++;
+            }
+         }
+         if (!added) break;
+      }
+
+      memcpy(W + (long)m * p, w, sizeof(double) * p);
+      nIter[m] = pass;
+      lambdaPrev = lam;
+   }
+
+   for (m = 0; m < nLambda; m++) mxGetPr(plhs[1])[m] = nIter[m];
+
+   for (k = 0; k < nActive; k++) mxFree(G[active[k]]);
+   mxFree(w);
+   mxFree(wRef);
+   mxFree(g);
+   mxFree(d);
+   mxFree(work);
+   mxFree(G);
+   mxFree(active);
+   mxFree(slot);
+   mxFree(strong);
+   mxFree(nIter);
+}
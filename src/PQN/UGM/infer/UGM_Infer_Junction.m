@@ -0,0 +1,35 @@
+function  [nodeBel, edgeBel, logZ] = UGM_Infer_Junction(nodePot, edgePot, edgeStruct, maxStates)
+% Exact inference with a junction tree
+%
+% INPUT
+% nodePot(node,class)
+% edgePot(class,class,edge) where e is referenced by V,E (must be the same
+% between feature engine and inference engine)
+% maxStates - largest clique table allowed (default 2^20)
+%
+% OUTPUT
+% nodeBel(node,class) - marginal beliefs
+% edgeBel(class,class,e) - pairwise beliefs
+% logZ - negative of free energy
+%
+% The cliques come from a greedy min-fill elimination ordering. If the
+% graph is too wide for maxStates, UGM_Infer_LBP is used instead.
+
+if nargin < 4 || isempty(maxStates)
+    maxStates = 2^20;
+end
+
+if edgeStruct.useMex && exist('UGM_Infer_JunctionC','file') == 3
+   [nodeBel,edgeBel,logZ,ok] = UGM_Infer_JunctionC(nodePot,edgePot,int32(edgeStruct.edgeEnds),int32(edgeStruct.nStates),int32(edgeStruct.V),int32(edgeStruct.E),maxStates);
+elseif prod(edgeStruct.nStates) <= maxStates
+   [nodeBel,edgeBel,logZ] = UGM_Infer_Exact(nodePot,edgePot,edgeStruct);
+   ok = 1;
+else
+   ok = 0;
+end
+
+if ~ok
+    warning('UGM_Infer_Junction: cliques larger than maxStates, using loopy belief propagation');
+    [nodeBel,edgeBel,logZ] = UGM_Infer_LBP(nodePot,edgePot,edgeStruct);
+end
+end
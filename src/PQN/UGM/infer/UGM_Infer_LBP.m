@@ -0,0 +1,119 @@
+function  [nodeBel, edgeBel, logZ] = UGM_Infer_LBP(nodePot, edgePot, edgeStruct, damping, tol)
+% Loopy belief propagation
+%
+% INPUT
+% nodePot(node,class)
+% edgePot(class,class,edge) where e is referenced by V,E (must be the same
+% between feature engine and inference engine)
+% damping - weight of the old message in each update (default 0.5)
+% tol - stop when no message changes by more than tol (default 1e-6)
+%
+% OUTPUT
+% nodeBel(node,class) - marginal beliefs
+% edgeBel(class,class,e) - pairwise beliefs
+% logZ - negative of Bethe free energy
+%
+% Runs at most edgeStruct.maxIter rounds. The mex version works in the
+% log domain and updates the messages with the largest residuals first.
+
+if nargin < 4 || isempty(damping)
+    damping = 0.5;
+end
+if nargin < 5 || isempty(tol)
+    tol = 1e-6;
+end
+
+if edgeStruct.useMex && exist('UGM_Infer_LBPC','file') == 3
+   [nodeBel,edgeBel,logZ] = UGM_Infer_LBPC(nodePot,edgePot,int32(edgeStruct.edgeEnds),int32(edgeStruct.nStates),int32(edgeStruct.V),int32(edgeStruct.E),edgeStruct.maxIter,damping,tol);
+else
+   [nodeBel,edgeBel,logZ] = Infer_LBP(nodePot,edgePot,edgeStruct,damping,tol);
+end
+end
+
+function  [nodeBel, edgeBel, logZ] = Infer_LBP(nodePot, edgePot, edgeStruct, damping, tol)
+
+[nNodes,maxState] = size(nodePot);
+nEdges = size(edgePot,3);
+edgeEnds = edgeStruct.edgeEnds;
+V = edgeStruct.V;
+E = edgeStruct.E;
+nStates = edgeStruct.nStates;
+
+% msg(:,e) from edgeEnds(e,1) to edgeEnds(e,2), msg(:,e+nEdges) the other way
+msg = zeros(maxState,nEdges*2);
+for e = 1:nEdges
+    n1 = edgeEnds(e,1);
+    n2 = edgeEnds(e,2);
+    msg(1:nStates(n2),e) = 1/nStates(n2);
+    msg(1:nStates(n1),e+nEdges) = 1/nStates(n1);
+end
+
+for i = 1:edgeStruct.maxIter
+    oldMsg = msg;
+    for e = 1:nEdges
+        n1 = edgeEnds(e,1);
+        n2 = edgeEnds(e,2);
+        ep = edgePot(1:nStates(n1),1:nStates(n2),e);
+
+        % n1 to n2
+        pot = cavity(n1,e,nodePot,oldMsg,edgeStruct);
+        newm = ep'*pot;
+        msg(1:nStates(n2),e) = damping*oldMsg(1:nStates(n2),e) + (1-damping)*newm/sum(newm);
+
+        % n2 to n1
+        pot = cavity(n2,e,nodePot,oldMsg,edgeStruct);
+        newm = ep*pot;
+        msg(1:nStates(n1),e+nEdges) = damping*oldMsg(1:nStates(n1),e+nEdges) + (1-damping)*newm/sum(newm);
+    end
+    if max(abs(msg(:)-oldMsg(:))) < tol
+        break;
+    end
+end
+
+% Beliefs and Bethe free energy
+nodeBel = zeros(size(nodePot));
+edgeBel = zeros(size(edgePot));
+energy = 0;
+entropy = 0;
+for n = 1:nNodes
+    b = cavity(n,0,nodePot,msg,edgeStruct);
+    b = b/sum(b);
+    nodeBel(n,1:nStates(n)) = b';
+    nNbr = V(n+1)-V(n);
+    energy = energy - sum(b.*log0(nodePot(n,1:nStates(n))'));
+    entropy = entropy + (nNbr-1)*sum(b.*log0(b));
+end
+for e = 1:nEdges
+    n1 = edgeEnds(e,1);
+    n2 = edgeEnds(e,2);
+    ep = edgePot(1:nStates(n1),1:nStates(n2),e);
+    b = (cavity(n1,e,nodePot,msg,edgeStruct)*cavity(n2,e,nodePot,msg,edgeStruct)').*ep;
+    b = b/sum(b(:));
+    edgeBel(1:nStates(n1),1:nStates(n2),e) = b;
+    energy = energy - sum(b(:).*log0(ep(:)));
+    entropy = entropy - sum(b(:).*log0(b(:)));
+end
+logZ = entropy - energy;
+end
+
+function pot = cavity(n,skip,nodePot,msg,edgeStruct)
+% Node potential times the messages from all neighbors except along skip
+nEdges = size(edgeStruct.edgeEnds,1);
+nS = edgeStruct.nStates(n);
+pot = nodePot(n,1:nS)';
+for e = edgeStruct.E(edgeStruct.V(n):edgeStruct.V(n+1)-1)'
+    if e ~= skip
+        if edgeStruct.edgeEnds(e,2) == n
+            pot = pot.*msg(1:nS,e);
+        else
+            pot = pot.*msg(1:nS,e+nEdges);
+        end
+    end
+end
+end
+
+function y = log0(x)
+% log with 0*log(0) = 0 once multiplied by a zero belief
+y = log(x);
+y(x == 0) = 0;
+end
@@ -0,0 +1,679 @@
+#include <math.h>
+#include <string.h>
+#include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "UGM_common.h"
+#include "UGM_infer.h"
+
+/* [nodeBel,edgeBel,logZ,ok] = UGM_Infer_JunctionC(nodePot,edgePot,edgeEnds,nStates,V,E,maxStates)
+ *
+ * Exact inference with a junction tree built from a greedy min-fill
+ * elimination ordering (ties broken by clique weight). Clique i holds the
+ * i-th eliminated node v and its neighbors N(v) at elimination time, its
+ * parent is the clique of the first eliminated node of N(v). Messages are
+ * passed in the log domain, leaves to roots and back (Hugin updates), all
+ * cliques of the same height (depth) in parallel.
+ * If a clique table would have more than maxStates entries (or all of them
+ * more than MAX_TOTAL_STATES) nothing is computed and ok is 0. */
+
+#define MAX_TOTAL_STATES 67108864.0
+
+typedef struct
+{
+    double fill, weight;
+    int node, stamp;
+} HeapEntry;
+
+typedef struct
+{
+    int nVars, *vars, parent;
+    int size, sepSize;
+    double *beta, *msg;
+} Clique;
+
+
+/* Lazy binary heap ordered by (fill, weight) */
+static int heapLess(const HeapEntry *a, const HeapEntry *b)
+{
+    return a->fill < b->fill || (a->fill == b->fill && a->weight < b->weight);
+}
+
+static void heapPush(HeapEntry **heapPtr, int *nHeap, int *heapCap, HeapEntry x)
+{
+    HeapEntry *heap;
+    int i = (*nHeap)++, p;
+
+    if(*nHeap > *heapCap)
+    {
+        *heapCap *= 2;
+        *heapPtr = mxRealloc(*heapPtr, *heapCap*sizeof(HeapEntry));
+    }
+    heap = *heapPtr;
+
+    while(i > 0)
+    {
+        p = (i-1)/2;
+        if(!heapLess(&x, &heap[p]))
+            break;
+        heap[i] = heap[p];
+        i = p;
+    }
+    heap[i] = x;
+}
+
+static HeapEntry heapPop(HeapEntry *heap, int *nHeap)
+{
+    HeapEntry top = heap[0], x = heap[--(*nHeap)];
+    int i = 0, c;
+
+    while((c = 2*i+1) < *nHeap)
+    {
+        if(c+1 < *nHeap && heapLess(&heap[c+1], &heap[c]))
+            c++;
+        if(!heapLess(&heap[c], &x))
+            break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    heap[i] = x;
+    return top;
+}
+
+
+/* Dynamic adjacency lists of the graph being eliminated */
+static void addNeighbor(int **adj, int *deg, int *cap, int a, int b)
+{
+    if(deg[a] == cap[a])
+    {
+        cap[a] = 2*cap[a] + 4;
+        adj[a] = mxRealloc(adj[a], cap[a]*sizeof(int));
+    }
+    adj[a][deg[a]++] = b;
+}
+
+static void removeNeighbor(int **adj, int *deg, int a, int b)
+{
+    int k;
+
+    for(k = 0; k < deg[a]; k++)
+    {
+        if(adj[a][k] == b)
+        {
+            adj[a][k] = adj[a][--deg[a]];
+            return;
+        }
+    }
+}
+
+/* Fill edges created and clique table size if v was eliminated; the fill
+   is only counted when the clique is small enough to be used */
+static HeapEntry scoreNode(int **adj, const int *deg, const int *nStates, int *mark, int *stamp,
+        int v, int version, double maxStates)
+{
+    HeapEntry h;
+    int j, k, a;
+
+    h.node = v;
+    h.stamp = version;
+    h.weight = nStates[v];
+    for(j = 0; j < deg[v]; j++)
+        h.weight *= nStates[adj[v][j]];
+
+    if(h.weight > maxStates)
+    {
+        h.fill = 0.5*deg[v]*(deg[v]-1);
+        return h;
+    }
+    h.fill = 0;
+    for(j = 0; j < deg[v]; j++)
+    {
+        a = adj[v][j];
+        (*stamp)++;
+        for(k = 0; k < deg[a]; k++)
+            mark[adj[a][k]] = *stamp;
+        for(k = j+1; k < deg[v]; k++)
+        {
+            if(mark[adj[v][k]] != *stamp)
+                h.fill++;
+        }
+    }
+    return h;
+}
+
+
+/* Visits the configurations of variables A (first fastest) and returns in
+   proj the index of each into the table of variables B, a subset of A */
+static void projectIndices(const int *A, int nA, const int *B, int nB, const int *nStates,
+        int *proj, int *state, int *strideInB)
+{
+    int j, k, stride, ind, size = 1;
+
+    for(j = 0; j < nA; j++)
+    {
+        strideInB[j] = 0;
+        stride = 1;
+        for(k = 0; k < nB; k++)
+        {
+            if(B[k] == A[j])
+            {
+                strideInB[j] = stride;
+                break;
+            }
+            stride *= nStates[B[k]];
+        }
+        state[j] = 0;
+        size *= nStates[A[j]];
+    }
+
+    ind = 0;
+    for(k = 0; k < size; k++)
+    {
+        proj[k] = ind;
+        for(j = 0; j < nA; j++)
+        {
+            if(++state[j] < nStates[A[j]])
+            {
+                ind += strideInB[j];
+                break;
+            }
+            state[j] = 0;
+            ind -= (nStates[A[j]]-1)*strideInB[j];
+        }
+    }
+}
+
+/* log(exp(a)+exp(b)) */
+static double logAdd(double a, double b)
+{
+    double t;
+
+    if(a < b)
+    {
+        t = a;
+        a = b;
+        b = t;
+    }
+    if(b == -HUGE_VAL)
+        return a;
+    return a + log1p(exp(b - a));
+}
+
+/* Scratch space of one thread */
+typedef struct
+{
+    int *proj, *state, *stride;
+    double *marg;
+} Work;
+
+
+/* Passes the message of clique i to its parent: beta_i summed over its
+   eliminated node, which is its fastest variable */
+static void upwardMessage(Clique *cl, int i, const int *nStates)
+{
+    Clique *c = &cl[i];
+    int k, ns = nStates[c->vars[0]];
+
+    for(k = 0; k < c->sepSize; k++)
+        c->msg[k] = logSumExp(c->beta + k*ns, ns);
+}
+
+/* Absorbs a message over variables B of size nB into clique c */
+static void absorb(Clique *c, const double *m, const int *B, int nB, int sign,
+        const int *nStates, Work *w)
+{
+    int k;
+
+    projectIndices(c->vars, c->nVars, B, nB, nStates, w->proj, w->state, w->stride);
+    for(k = 0; k < c->size; k++)
+    {
+        if(c->beta[k] == -HUGE_VAL)
+            continue;
+        if(sign > 0)
+            c->beta[k] += m[w->proj[k]];
+        else if(m[w->proj[k]] > -HUGE_VAL)
+            c->beta[k] -= m[w->proj[k]];
+    }
+}
+
+/* Sums beta of clique c down to variables B */
+static void marginalize(const Clique *c, const int *B, int nB, int sizeB,
+        const int *nStates, double *marg, Work *w)
+{
+    int k;
+
+    for(k = 0; k < sizeB; k++)
+        marg[k] = -HUGE_VAL;
+    projectIndices(c->vars, c->nVars, B, nB, nStates, w->proj, w->state, w->stride);
+    for(k = 0; k < c->size; k++)
+        marg[w->proj[k]] = logAdd(marg[w->proj[k]], c->beta[k]);
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* Variables */
+    mwSize sizeEdgeBel[3];
+    int n, e, i, j, n1, n2, nNodes, nEdges, maxState, nHeap, heapCap, stamp, ok,
+    maxVars, maxSize, nLevels, nThreads, *intWork,
+    *edgeEnds, *nStates, *V, *E, *position, *deg, *cap, *mark, *version,
+    *childStart, *childList, *level, *levelStart, *levelList, *nodeClique, **adj;
+
+    double maxStates, total, logZ,
+    *nodePot, *edgePot, *nodeBel, *edgeBel, *logNodePot, *logEdgePot, *betaPool, *msgPool, *margWork;
+
+    HeapEntry *heap, h;
+    Clique *cl;
+
+    /* Input */
+
+    if(nrhs < 6)
+        mexErrMsgTxt("Usage: UGM_Infer_JunctionC(nodePot,edgePot,edgeEnds,nStates,V,E[,maxStates])");
+
+    nodePot = mxGetPr(prhs[0]);
+    edgePot = mxGetPr(prhs[1]);
+    edgeEnds = (int*)mxGetPr(prhs[2]);
+    nStates = (int*)mxGetPr(prhs[3]);
+    V = (int*)mxGetPr(prhs[4]);
+    E = (int*)mxGetPr(prhs[5]);
+    maxStates = (nrhs > 6 && !mxIsEmpty(prhs[6])) ? mxGetScalar(prhs[6]) : 1048576;
+
+    /* Compute Sizes */
+
+    nNodes = mxGetDimensions(prhs[0])[0];
+    maxState = mxGetDimensions(prhs[0])[1];
+    nEdges = mxGetDimensions(prhs[2])[0];
+
+    decrementEdgeEnds(edgeEnds, nEdges);
+    decrementVector(V, nNodes+1);
+    decrementVector(E, nEdges*2);
+
+    /* Output */
+
+    sizeEdgeBel[0] = maxState;
+    sizeEdgeBel[1] = maxState;
+    sizeEdgeBel[2] = nEdges;
+    plhs[0] = mxCreateNumericArray(2, mxGetDimensions(prhs[0]), mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateNumericArray(3, sizeEdgeBel, mxDOUBLE_CLASS, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, 1, mxREAL);
+    nodeBel = mxGetPr(plhs[0]);
+    edgeBel = mxGetPr(plhs[1]);
+
+    /* Adjacency lists without repeated edges */
+
+    adj = mxCalloc(nNodes + 1, sizeof(int*));
+    deg = mxCalloc(nNodes + 1, sizeof(int));
+    cap = mxCalloc(nNodes + 1, sizeof(int));
+    mark = mxCalloc(nNodes + 1, sizeof(int));
+    version = mxCalloc(nNodes + 1, sizeof(int));
+    position = mxMalloc((nNodes + 1)*sizeof(int));
+    stamp = 0;
+    for(n = 0; n < nNodes; n++)
+    {
+        stamp++;
+        mark[n] = stamp;
+        for(j = V[n]; j < V[n+1]; j++)
+        {
+            e = E[j];
+            n2 = (edgeEnds[e] == n) ? edgeEnds[e + nEdges] : edgeEnds[e];
+            if(mark[n2] != stamp)
+            {
+                mark[n2] = stamp;
+                addNeighbor(adj, deg, cap, n, n2);
+            }
+        }
+    }
+
+    /* Greedy min-fill elimination, recording the cliques */
+
+    heapCap = 2*nNodes + 1;
+    heap = mxMalloc(heapCap*sizeof(HeapEntry));
+    nHeap = 0;
+    for(n = 0; n < nNodes; n++)
+    {
+        position[n] = -1;
+        heapPush(&heap, &nHeap, &heapCap, scoreNode(adj, deg, nStates, mark, &stamp, n, 0, maxStates));
+    }
+
+    cl = mxCalloc(nNodes + 1, sizeof(Clique));
+    total = 0;
+    ok = 1;
+    for(i = 0; i < nNodes; i++)
+    {
+        /* Skip outdated heap entries */
+        do
+        {
+            h = heapPop(heap, &nHeap);
+        } while(position[h.node] >= 0 || h.stamp != version[h.node]);
+        n = h.node;
+        if(h.weight > maxStates || total + h.weight > MAX_TOTAL_STATES)
+        {
+            ok = 0;
+            break;
+        }
+        position[n] = i;
+        total += h.weight;
+
+        cl[i].nVars = deg[n] + 1;
+        cl[i].size = (int)h.weight;
+        cl[i].sepSize = cl[i].size/nStates[n];
+        cl[i].vars = mxMalloc((deg[n] + 1)*sizeof(int));
+        cl[i].vars[0] = n;
+        memcpy(cl[i].vars + 1, adj[n], deg[n]*sizeof(int));
+
+        /* Connect the neighbors and remove n */
+        for(j = 0; j < deg[n]; j++)
+        {
+            int a = adj[n][j], b, l;
+            removeNeighbor(adj, deg, a, n);
+            stamp++;
+            for(l = 0; l < deg[a]; l++)
+                mark[adj[a][l]] = stamp;
+            for(l = j+1; l < deg[n]; l++)
+            {
+                b = adj[n][l];
+                if(mark[b] != stamp)
+                {
+                    addNeighbor(adj, deg, cap, a, b);
+                    addNeighbor(adj, deg, cap, b, a);
+                }
+            }
+        }
+
+        /* Rescore the neighbors and their neighbors */
+        for(j = 0; j < deg[n]; j++)
+        {
+            int a = adj[n][j], l, b;
+            for(l = -1; l < deg[a]; l++)
+            {
+                b = (l < 0) ? a : adj[a][l];
+                version[b]++;
+                heapPush(&heap, &nHeap, &heapCap, scoreNode(adj, deg, nStates, mark, &stamp, b, version[b], maxStates));
+            }
+        }
+        deg[n] = 0;
+    }
+
+    for(n = 0; n < nNodes; n++)
+        mxFree(adj[n]);
+    mxFree(adj);
+    mxFree(deg);
+    mxFree(cap);
+    mxFree(heap);
+
+    if(!ok)
+    {
+        for(j = 0; j < i; j++)
+            mxFree(cl[j].vars);
+        mxFree(cl);
+        mxFree(mark);
+        mxFree(version);
+        mxFree(position);
+        mxGetPr(plhs[2])[0] = mxGetNaN();
+        if(nlhs > 3)
+            plhs[3] = mxCreateDoubleScalar(0);
+        return;
+    }
+
+    /* Junction tree: the parent of clique i is the clique of the first
+       eliminated node of its separator */
+
+    maxVars = 1;
+    maxSize = 1;
+    for(i = 0; i < nNodes; i++)
+    {
+        cl[i].parent = -1;
+        for(j = 1; j < cl[i].nVars; j++)
+        {
+            if(cl[i].parent < 0 || position[cl[i].vars[j]] < cl[i].parent)
+                cl[i].parent = position[cl[i].vars[j]];
+        }
+        if(cl[i].nVars > maxVars)
+            maxVars = cl[i].nVars;
+        if(cl[i].size > maxSize)
+            maxSize = cl[i].size;
+    }
+
+    childStart = mxCalloc(nNodes + 2, sizeof(int));
+    childList = mxMalloc((nNodes + 1)*sizeof(int));
+    for(i = 0; i < nNodes; i++)
+    {
+        if(cl[i].parent >= 0)
+            childStart[cl[i].parent+2]++;
+    }
+    for(i = 0; i < nNodes; i++)
+        childStart[i+2] += childStart[i+1];
+    for(i = 0; i < nNodes; i++)
+    {
+        if(cl[i].parent >= 0)
+            childList[childStart[cl[i].parent+1]++] = i;
+    }
+
+    /* Clique potentials: node potentials to the clique of the node, edge
+       potentials to the clique of the first eliminated end */
+
+    logNodePot = mxMalloc((nNodes*maxState + 1)*sizeof(double));
+    logEdgePot = mxMalloc((maxState*maxState*nEdges + 1)*sizeof(double));
+    makeLogPotentials(nodePot, edgePot, nNodes, nEdges, maxState, logNodePot, logEdgePot);
+
+    betaPool = mxMalloc(((size_t)total + 1)*sizeof(double));
+    msgPool = mxMalloc(((size_t)total + 1)*sizeof(double));
+    total = 0;
+    for(i = 0; i < nNodes; i++)
+    {
+        cl[i].beta = betaPool + (size_t)total;
+        cl[i].msg = msgPool + (size_t)total;
+        total += cl[i].size;
+    }
+
+    nodeClique = mxMalloc((nEdges + 1)*sizeof(int));
+    for(e = 0; e < nEdges; e++)
+    {
+        n1 = edgeEnds[e];
+        n2 = edgeEnds[e + nEdges];
+        nodeClique[e] = (position[n1] < position[n2]) ? position[n1] : position[n2];
+    }
+
+    /* Levels: height for the upward pass, then depth for the downward pass */
+
+    level = mxCalloc(nNodes + 1, sizeof(int));
+    levelStart = mxCalloc(nNodes + 2, sizeof(int));
+    levelList = mxMalloc((nNodes + 1)*sizeof(int));
+
+    /* Projections and marginals of one clique, one buffer per thread */
+    nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    intWork = mxMalloc((size_t)nThreads*(maxSize + 2*maxVars + 3)*sizeof(int));
+    margWork = mxMalloc((size_t)nThreads*(maxSize + 1)*sizeof(double));
+
+#pragma omp parallel num_threads(nThreads)
+    {
+        Work w;
+        int l, c, lev, t = 0;
+        int pairVars[2];
+
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        w.proj = intWork + (size_t)t*(maxSize + 2*maxVars + 3);
+        w.state = w.proj + maxSize + 1;
+        w.stride = w.state + maxVars + 1;
+        w.marg = margWork + (size_t)t*(maxSize + 1);
+
+        /* Initialize the clique tables */
+#pragma omp for schedule(dynamic,16)
+        for(c = 0; c < nNodes; c++)
+        {
+            Clique *q = &cl[c];
+            int v = q->vars[0], ns = nStates[v];
+            for(l = 0; l < q->size; l++)
+                q->beta[l] = logNodePot[v + nNodes*(l % ns)];
+        }
+#pragma omp for schedule(dynamic,64)
+        for(c = 0; c < nNodes; c++)
+        {
+            Clique *q = &cl[c];
+            int ee, a, b, s, k;
+            for(l = V[q->vars[0]]; l < V[q->vars[0]+1]; l++)
+            {
+                ee = E[l];
+                if(nodeClique[ee] != c)
+                    continue;
+                a = edgeEnds[ee];
+                b = edgeEnds[ee + nEdges];
+                /* edgePot(:,:,ee) as a table over (a,b) with a fastest */
+                for(s = 0; s < nStates[b]; s++)
+                {
+                    for(k = 0; k < nStates[a]; k++)
+                        w.marg[k + nStates[a]*s] = logEdgePot[k + maxState*(s + maxState*ee)];
+                }
+                pairVars[0] = a;
+                pairVars[1] = b;
+                absorb(q, w.marg, pairVars, 2, 1, nStates, &w);
+            }
+        }
+
+#pragma omp single
+        {
+            /* Group the cliques by height */
+            for(i = 0; i < nNodes; i++)
+            {
+                if(cl[i].parent >= 0 && level[cl[i].parent] < level[i] + 1)
+                    level[cl[i].parent] = level[i] + 1;
+            }
+            nLevels = 0;
+            for(i = 0; i < nNodes; i++)
+            {
+                levelStart[level[i]+1]++;
+                if(level[i] + 1 > nLevels)
+                    nLevels = level[i] + 1;
+            }
+            for(l = 0; l < nLevels; l++)
+                levelStart[l+1] += levelStart[l];
+            for(i = 0; i < nNodes; i++)
+                levelList[levelStart[level[i]]++] = i;
+            for(l = nLevels; l > 0; l--)
+                levelStart[l] = levelStart[l-1];
+            levelStart[0] = 0;
+        }
+
+        /* Upward pass: each clique of a level collects the messages of its
+           children (lower levels) and sends its own */
+        for(lev = 0; lev < nLevels; lev++)
+        {
+#pragma omp for schedule(dynamic,1)
+            for(l = levelStart[lev]; l < levelStart[lev+1]; l++)
+            {
+                int ch, d;
+                c = levelList[l];
+                for(d = childStart[c]; d < childStart[c+1]; d++)
+                {
+                    ch = childList[d];
+                    absorb(&cl[c], cl[ch].msg, cl[ch].vars + 1, cl[ch].nVars - 1, 1, nStates, &w);
+                }
+                if(cl[c].parent >= 0)
+                    upwardMessage(cl, c, nStates);
+            }
+        }
+
+#pragma omp single
+        {
+            /* Group the cliques by depth */
+            for(i = nNodes-1; i >= 0; i--)
+                level[i] = (cl[i].parent >= 0) ? level[cl[i].parent] + 1 : 0;
+            for(l = 0; l <= nNodes; l++)
+                levelStart[l] = 0;
+            nLevels = 0;
+            for(i = 0; i < nNodes; i++)
+            {
+                levelStart[level[i]+1]++;
+                if(level[i] + 1 > nLevels)
+                    nLevels = level[i] + 1;
+            }
+            for(l = 0; l < nLevels; l++)
+                levelStart[l+1] += levelStart[l];
+            for(i = 0; i < nNodes; i++)
+                levelList[levelStart[level[i]]++] = i;
+            for(l = nLevels; l > 0; l--)
+                levelStart[l] = levelStart[l-1];
+            levelStart[0] = 0;
+        }
+
+        /* Downward pass: beta_c += marginal of the calibrated parent minus
+           the message sent upwards */
+        for(lev = 1; lev < nLevels; lev++)
+        {
+#pragma omp for schedule(dynamic,1)
+            for(l = levelStart[lev]; l < levelStart[lev+1]; l++)
+            {
+                Clique *q;
+                c = levelList[l];
+                q = &cl[c];
+                marginalize(&cl[q->parent], q->vars + 1, q->nVars - 1, q->sepSize, nStates, w.marg, &w);
+                absorb(q, q->msg, q->vars + 1, q->nVars - 1, -1, nStates, &w);
+                absorb(q, w.marg, q->vars + 1, q->nVars - 1, 1, nStates, &w);
+            }
+        }
+
+        /* Node and edge beliefs from the calibrated cliques */
+#pragma omp for schedule(dynamic,16)
+        for(n = 0; n < nNodes; n++)
+        {
+            Clique *q = &cl[position[n]];
+            int s;
+            double z = logSumExp(q->beta, q->size);
+            marginalize(q, &n, 1, nStates[n], nStates, w.marg, &w);
+            for(s = 0; s < nStates[n]; s++)
+                nodeBel[n + nNodes*s] = (z > -HUGE_VAL) ? exp(w.marg[s] - z) : 0;
+        }
+#pragma omp for schedule(dynamic,16)
+        for(e = 0; e < nEdges; e++)
+        {
+            Clique *q = &cl[nodeClique[e]];
+            int a = edgeEnds[e], b = edgeEnds[e + nEdges], s, k;
+            double z = logSumExp(q->beta, q->size);
+            pairVars[0] = a;
+            pairVars[1] = b;
+            marginalize(q, pairVars, 2, nStates[a]*nStates[b], nStates, w.marg, &w);
+            for(s = 0; s < nStates[b]; s++)
+            {
+                for(k = 0; k < nStates[a]; k++)
+                    edgeBel[k + maxState*(s + maxState*e)] = (z > -HUGE_VAL) ? exp(w.marg[k + nStates[a]*s] - z) : 0;
+            }
+        }
+    }
+
+    /* logZ of each connected component at its root */
+    logZ = 0;
+    for(i = 0; i < nNodes; i++)
+    {
+        if(cl[i].parent < 0)
+            logZ += logSumExp(cl[i].beta, cl[i].size);
+    }
+    mxGetPr(plhs[2])[0] = logZ;
+    if(nlhs > 3)
+        plhs[3] = mxCreateDoubleScalar(1);
+
+    /* Free memory */
+    for(i = 0; i < nNodes; i++)
+        mxFree(cl[i].vars);
+    mxFree(cl);
+    mxFree(mark);
+    mxFree(version);
+    mxFree(position);
+    mxFree(logNodePot);
+    mxFree(logEdgePot);
+    mxFree(betaPool);
+    mxFree(msgPool);
+    mxFree(nodeClique);
+    mxFree(childStart);
+    mxFree(childList);
+    mxFree(level);
+    mxFree(levelStart);
+    mxFree(levelList);
+    mxFree(intWork);
+    mxFree(margWork);
+}
@@ -0,0 +1,359 @@
+#include <math.h>
+#include <string.h>
+#include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "UGM_common.h"
+#include "UGM_infer.h"
+
+/* [nodeBel,edgeBel,logZ,nIter] = UGM_Infer_LBPC(nodePot,edgePot,edgeEnds,nStates,V,E,maxIter,damping,tol)
+ *
+ * Damped loopy belief propagation in the log domain with residual
+ * scheduling. Message 2e goes from edgeEnds(e,1) to edgeEnds(e,2), message
+ * 2e+1 the other way. Every round commits the messages whose residual (largest
+ * change of the normalized message) is at least half the largest residual,
+ * then recomputes (in parallel) the messages which depend on them. Stops when
+ * the largest residual drops below tol or after maxIter rounds.
+ * logZ is the negative Bethe free energy. */
+
+#define RESIDUAL_FRACTION 0.5
+
+typedef struct
+{
+    int nNodes, nEdges, maxState;
+    int *edgeEnds, *nStates, *V, *E;
+    double *logNodePot, *logEdgePot;
+} Graph;
+
+
+/* Index of the message arriving at node n along edge e */
+static int incoming(const Graph *g, int e, int n)
+{
+    return (g->edgeEnds[e + g->nEdges] == n) ? 2*e : 2*e+1;
+}
+
+/* Log node potential of n times the messages from all neighbors except
+   along edge 'skip' (-1 to include all) */
+static void computeCavity(const Graph *g, const double *msg, int n, int skip, double *out)
+{
+    int s, Vind, e, m;
+
+    for(s = 0; s < g->nStates[n]; s++)
+        out[s] = g->logNodePot[n + g->nNodes*s];
+    for(Vind = g->V[n]; Vind < g->V[n+1]; Vind++)
+    {
+        e = g->E[Vind];
+        if(e == skip)
+            continue;
+        m = incoming(g, e, n);
+        for(s = 0; s < g->nStates[n]; s++)
+            out[s] += msg[g->maxState*m + s];
+    }
+}
+
+/* Normalized log message m from the current messages msg */
+static void computeMessage(const Graph *g, const double *msg, int m, double *out, double *cavity)
+{
+    int e = m/2, dir = m%2, from, to, s1, s2, maxState = g->maxState;
+    const double *ep = g->logEdgePot + maxState*maxState*e;
+    double z;
+
+    from = g->edgeEnds[e + g->nEdges*dir];
+    to = g->edgeEnds[e + g->nEdges*(1-dir)];
+    computeCavity(g, msg, from, e, cavity);
+
+    /* Sum out the state of 'from' */
+    for(s2 = 0; s2 < g->nStates[to]; s2++)
+    {
+        double mx = -HUGE_VAL, sum = 0, t;
+        for(s1 = 0; s1 < g->nStates[from]; s1++)
+        {
+            t = cavity[s1] + (dir == 0 ? ep[s1 + maxState*s2] : ep[s2 + maxState*s1]);
+            if(t == -HUGE_VAL)
+                continue;
+            if(t > mx)
+            {
+                sum = sum*exp(mx - t) + 1;
+                mx = t;
+            }
+            else
+                sum += exp(t - mx);
+        }
+        out[s2] = (mx > -HUGE_VAL) ? mx + log(sum) : -HUGE_VAL;
+    }
+
+    /* Normalize; an all-zero message (inconsistent potentials) becomes uniform */
+    z = logSumExp(out, g->nStates[to]);
+    for(s2 = 0; s2 < g->nStates[to]; s2++)
+        out[s2] = (z > -HUGE_VAL) ? out[s2] - z : -log((double)g->nStates[to]);
+}
+
+/* Damps the new message towards the old one (in probability), returns the residual */
+static double dampMessage(const double *old, double *cand, int nStates, double damping)
+{
+    int s;
+    double r = 0, d, a, b, z;
+
+    if(damping > 0)
+    {
+        for(s = 0; s < nStates; s++)
+        {
+            a = log(1-damping) + cand[s];
+            b = log(damping) + old[s];
+            if(a < b)
+            {
+                d = a;
+                a = b;
+                b = d;
+            }
+            cand[s] = (a > -HUGE_VAL) ? a + log1p(exp(b - a)) : -HUGE_VAL;
+        }
+        z = logSumExp(cand, nStates);
+        for(s = 0; s < nStates; s++)
+            cand[s] -= z;
+    }
+    for(s = 0; s < nStates; s++)
+    {
+        d = fabs(exp(cand[s]) - exp(old[s]));
+        if(d > r)
+            r = d;
+    }
+    return r;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* Variables */
+    mwSize sizeEdgeBel[3];
+    int n, s, e, m, n2, Vind, nMsg, nDirty, iter, maxIter, nThreads, workSize,
+    *dirty, *mark;
+
+    double damping, tol, rMax, threshold, energy, entropy,
+    *nodePot, *edgePot, *nodeBel, *edgeBel, *msg, *cand, *residual, *work;
+
+    Graph g;
+
+    /* Input */
+
+    if(nrhs < 7)
+        mexErrMsgTxt("Usage: UGM_Infer_LBPC(nodePot,edgePot,edgeEnds,nStates,V,E,maxIter[,damping,tol])");
+
+    nodePot = mxGetPr(prhs[0]);
+    edgePot = mxGetPr(prhs[1]);
+    g.edgeEnds = (int*)mxGetPr(prhs[2]);
+    g.nStates = (int*)mxGetPr(prhs[3]);
+    g.V = (int*)mxGetPr(prhs[4]);
+    g.E = (int*)mxGetPr(prhs[5]);
+    maxIter = (int)mxGetScalar(prhs[6]);
+    damping = (nrhs > 7 && !mxIsEmpty(prhs[7])) ? mxGetScalar(prhs[7]) : 0.5;
+    tol = (nrhs > 8 && !mxIsEmpty(prhs[8])) ? mxGetScalar(prhs[8]) : 1e-6;
+    if(damping < 0 || damping >= 1)
+        mexErrMsgTxt("damping must be in [0,1)");
+
+    /* Compute Sizes */
+
+    g.nNodes = mxGetDimensions(prhs[0])[0];
+    g.maxState = mxGetDimensions(prhs[0])[1];
+    g.nEdges = mxGetDimensions(prhs[2])[0];
+    nMsg = 2*g.nEdges;
+
+    decrementEdgeEnds(g.edgeEnds, g.nEdges);
+    decrementVector(g.V, g.nNodes+1);
+    decrementVector(g.E, nMsg);
+
+    /* Output */
+
+    sizeEdgeBel[0] = g.maxState;
+    sizeEdgeBel[1] = g.maxState;
+    sizeEdgeBel[2] = g.nEdges;
+    plhs[0] = mxCreateNumericArray(2, mxGetDimensions(prhs[0]), mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateNumericArray(3, sizeEdgeBel, mxDOUBLE_CLASS, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(1, 1, mxREAL);
+    nodeBel = mxGetPr(plhs[0]);
+    edgeBel = mxGetPr(plhs[1]);
+
+    /* Initialize: uniform messages, all of them to be computed */
+
+    g.logNodePot = mxMalloc((g.nNodes*g.maxState + 1)*sizeof(double));
+    g.logEdgePot = mxMalloc((g.maxState*g.maxState*g.nEdges + 1)*sizeof(double));
+    makeLogPotentials(nodePot, edgePot, g.nNodes, g.nEdges, g.maxState, g.logNodePot, g.logEdgePot);
+
+    msg = mxMalloc((g.maxState*nMsg + 1)*sizeof(double));
+    cand = mxMalloc((g.maxState*nMsg + 1)*sizeof(double));
+    residual = mxCalloc(nMsg + 1, sizeof(double));
+    dirty = mxMalloc((nMsg + 1)*sizeof(int));
+    mark = mxCalloc(nMsg + 1, sizeof(int));
+
+    /* Cavities and beliefs of one edge, one buffer per thread */
+    nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    workSize = 2*g.maxState*g.maxState + 2*g.maxState + 4;
+    work = mxMalloc((size_t)nThreads*workSize*sizeof(double));
+
+    for(m = 0; m < nMsg; m++)
+    {
+        n2 = g.edgeEnds[m/2 + g.nEdges*(1-m%2)];
+        for(s = 0; s < g.nStates[n2]; s++)
+            msg[g.maxState*m + s] = -log((double)g.nStates[n2]);
+        dirty[m] = m;
+    }
+    nDirty = nMsg;
+
+    /* Rounds of residual belief propagation */
+
+    for(iter = 0; iter <= maxIter; iter++)
+    {
+        /* New messages and residuals where an input message changed */
+#pragma omp parallel num_threads(nThreads)
+        {
+            double *cavity = work;
+            int k, mm;
+#ifdef _OPENMP
+            cavity += (size_t)omp_get_thread_num()*workSize;
+#endif
+#pragma omp for schedule(dynamic,64)
+            for(k = 0; k < nDirty; k++)
+            {
+                mm = dirty[k];
+                computeMessage(&g, msg, mm, cand + g.maxState*mm, cavity);
+                residual[mm] = dampMessage(msg + g.maxState*mm, cand + g.maxState*mm,
+                        g.nStates[g.edgeEnds[mm/2 + g.nEdges*(1-mm%2)]], damping);
+            }
+        }
+
+        rMax = 0;
+        for(m = 0; m < nMsg; m++)
+        {
+            if(residual[m] > rMax)
+                rMax = residual[m];
+        }
+        if(rMax < tol || iter == maxIter)
+            break;
+
+        /* Commit the messages with the largest residuals and collect the
+           messages which depend on them */
+        threshold = RESIDUAL_FRACTION*rMax;
+        if(threshold < tol)
+            threshold = tol;
+        nDirty = 0;
+        for(m = 0; m < nMsg; m++)
+        {
+            if(residual[m] < threshold)
+                continue;
+            e = m/2;
+            n2 = g.edgeEnds[e + g.nEdges*(1-m%2)];
+            memcpy(msg + g.maxState*m, cand + g.maxState*m, g.nStates[n2]*sizeof(double));
+            residual[m] = 0;
+            /* a damped message has only moved part of the way */
+            if(damping > 0 && mark[m] != iter+1)
+            {
+                mark[m] = iter+1;
+                dirty[nDirty++] = m;
+            }
+            for(Vind = g.V[n2]; Vind < g.V[n2+1]; Vind++)
+            {
+                int e2 = g.E[Vind], m2;
+                if(e2 == e)
+                    continue;
+                /* message sent by n2 along e2 */
+                m2 = (g.edgeEnds[e2] == n2) ? 2*e2 : 2*e2+1;
+                if(mark[m2] != iter+1)
+                {
+                    mark[m2] = iter+1;
+                    dirty[nDirty++] = m2;
+                }
+            }
+        }
+    }
+
+    /* Node beliefs and their Bethe free energy terms */
+
+    energy = 0;
+    entropy = 0;
+#pragma omp parallel num_threads(nThreads) private(n,s) reduction(+:energy,entropy)
+    {
+        double *bel = work, z;
+#ifdef _OPENMP
+        bel += (size_t)omp_get_thread_num()*workSize;
+#endif
+#pragma omp for schedule(dynamic,64)
+        for(n = 0; n < g.nNodes; n++)
+        {
+            computeCavity(&g, msg, n, -1, bel);
+            z = logSumExp(bel, g.nStates[n]);
+            for(s = 0; s < g.nStates[n]; s++)
+            {
+                bel[s] = (z > -HUGE_VAL) ? bel[s] - z : -HUGE_VAL;
+                nodeBel[n + g.nNodes*s] = exp(bel[s]);
+                if(bel[s] > -HUGE_VAL)
+                    energy -= exp(bel[s])*g.logNodePot[n + g.nNodes*s];
+            }
+            entropy += (g.V[n+1] - g.V[n] - 1)*negEntropy(bel, g.nStates[n]);
+        }
+    }
+
+    /* Edge beliefs */
+
+#pragma omp parallel num_threads(nThreads) private(e) reduction(+:energy,entropy)
+    {
+        int maxState = g.maxState;
+        double *bel = work, *lp, *c1, *c2;
+#ifdef _OPENMP
+        bel += (size_t)omp_get_thread_num()*workSize;
+#endif
+        lp = bel + maxState*maxState + 1;
+        c1 = lp + maxState*maxState + 1;
+        c2 = c1 + maxState + 1;
+#pragma omp for schedule(dynamic,64)
+        for(e = 0; e < g.nEdges; e++)
+        {
+            int s1, s2, k, n1 = g.edgeEnds[e], n2 = g.edgeEnds[e + g.nEdges];
+            const double *ep = g.logEdgePot + maxState*maxState*e;
+            double z;
+
+            computeCavity(&g, msg, n1, e, c1);
+            computeCavity(&g, msg, n2, e, c2);
+            k = 0;
+            for(s2 = 0; s2 < g.nStates[n2]; s2++)
+            {
+                for(s1 = 0; s1 < g.nStates[n1]; s1++)
+                {
+                    lp[k] = ep[s1 + maxState*s2];
+                    bel[k] = c1[s1] + c2[s2] + lp[k];
+                    k++;
+                }
+            }
+            z = logSumExp(bel, k);
+            k = 0;
+            for(s2 = 0; s2 < g.nStates[n2]; s2++)
+            {
+                for(s1 = 0; s1 < g.nStates[n1]; s1++)
+                {
+                    bel[k] = (z > -HUGE_VAL) ? bel[k] - z : -HUGE_VAL;
+                    edgeBel[s1 + maxState*(s2 + maxState*e)] = exp(bel[k]);
+                    k++;
+                }
+            }
+            energy -= expectedLog(bel, lp, k);
+            entropy -= negEntropy(bel, k);
+        }
+    }
+
+    mxGetPr(plhs[2])[0] = entropy - energy;
+    if(nlhs > 3)
+        plhs[3] = mxCreateDoubleScalar(iter);
+
+    /* Free memory */
+    mxFree(g.logNodePot);
+    mxFree(g.logEdgePot);
+    mxFree(msg);
+    mxFree(cand);
+    mxFree(residual);
+    mxFree(dirty);
+    mxFree(mark);
+    mxFree(work);
+}
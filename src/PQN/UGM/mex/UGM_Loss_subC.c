@@ -1,64 +1,94 @@
-#include <math.h>
-#include "mex.h"
-#include "UGM_common.h"
-
-void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
-{
-    /* Variables */
-    int i,n,s,e,*y,*edgeEnds,outputSize[2],
-    nNodes,maxState,nInstances,nEdges;
-    
-    double *nodePot,*edgePot,*fsub;
-    
-    /* Input */
-    y = mxGetPr(prhs[0]);
-    nodePot = mxGetPr(prhs[1]);
-    edgePot = mxGetPr(prhs[2]);
-    edgeEnds = mxGetPr(prhs[3]);
-    
-    /* Compute Sizes */
-    nInstances = mxGetDimensions(prhs[0])[0];
-    nNodes = mxGetDimensions(prhs[1])[0];
-    maxState = mxGetDimensions(prhs[1])[1];
-    nEdges = mxGetDimensions(prhs[3])[0];
-    decrementEdgeEnds(edgeEnds,nEdges);
-    
-    /* Output */
-    outputSize[0] = 1;
-    outputSize[1] = 1;
-    plhs[0] = mxCreateNumericArray(2,outputSize,mxDOUBLE_CLASS,mxREAL);
-    fsub = mxGetPr(plhs[0]);
-    
-    /* Decrement y */
-    for(i = 0; i < nInstances; i++)
-    {
-        for(n = 0; n < nNodes; n++)
-        {
-            y[i + nInstances*n]--;
-        }
-    }
-    
-    fsub[0] = 0;
-    
-    /* Reference into nodePot like this: nodePot[n+nNodes*(s+maxState*i)] */
-    /* Reference into edgePot like this: edgePot[s1+maxState*(s2+maxState*(e+nEdges*i))] */
-    
-    /* Update based on Node Potentials of Training Labels */
-    for(i = 0; i < nInstances; i++)
-    {
-        for(n = 0; n < nNodes; n++)
-        {
-            fsub[0] -= log(nodePot[n+nNodes*(y[i+nInstances*n]+maxState*i)]);
-        }
-    }
-    
-    /* Update based on Edge Potentials of Training Labels */
-    for(i = 0; i < nInstances; i++)
-    {
-        for(e = 0; e < nEdges; e++)
-        {
-            fsub[0] -= log(edgePot[y[i+nInstances*edgeEnds[e]]+maxState*(y[i+nInstances*edgeEnds[e+nEdges]]+maxState*(e+nEdges*i))]);
-        }
-    }
-
-}
+#include <math.h>
+#include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "UGM_common.h"
+
+/* Negative log of the unnormalized potentials of the training labels, with
+   potentials given per instance. The instances are split over the threads;
+   the potentials of an instance are multiplied with the exponent kept apart
+   (frexp), so there is one log per instance instead of one per factor. The
+   sums of the threads are added in thread order, so the result does not
+   change from call to call. */
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* Variables */
+    int i,t,*y,*edgeEnds,
+    nNodes,maxState,nInstances,nEdges,nThreads;
+    
+    double *nodePot,*edgePot,*fsub,*myF;
+    
+    /* Input */
+    y = (int*)mxGetPr(prhs[0]);
+    nodePot = mxGetPr(prhs[1]);
+    edgePot = mxGetPr(prhs[2]);
+    edgeEnds = (int*)mxGetPr(prhs[3]);
+    
+    /* Compute Sizes */
+    nInstances = mxGetDimensions(prhs[0])[0];
+    nNodes = mxGetDimensions(prhs[1])[0];
+    maxState = mxGetDimensions(prhs[1])[1];
+    nEdges = mxGetDimensions(prhs[3])[0];
+    decrementEdgeEnds(edgeEnds,nEdges);
+    
+    /* Output */
+    plhs[0] = mxCreateDoubleMatrix(1,1,mxREAL);
+    fsub = mxGetPr(plhs[0]);
+    
+    /* Decrement y */
+    decrementVector(y,nInstances*nNodes);
+    
+    /* Reference into nodePot like this: nodePot[n+nNodes*(s+maxState*i)] */
+    /* Reference into edgePot like this: edgePot[s1+maxState*(s2+maxState*(e+nEdges*i))] */
+    
+    nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    myF = mxCalloc(nThreads,sizeof(double));
+    
+#pragma omp parallel num_threads(nThreads) private(i,t)
+    {
+        double f = 0;
+        
+#pragma omp for schedule(static)
+        for(i = 0; i < nInstances; i++)
+        {
+            int n, e, ex, exponent = 0;
+            double pot = 1;
+            const double *np = nodePot + (size_t)nNodes*maxState*i;
+            const double *ep = edgePot + (size_t)maxState*maxState*nEdges*i;
+            
+            /* Node Potentials of Training Labels */
+            for(n = 0; n < nNodes; n++)
+            {
+                pot *= np[n+nNodes*y[i+nInstances*n]];
+                pot = frexp(pot,&ex);
+                exponent += ex;
+            }
+            
+            /* Edge Potentials of Training Labels */
+            for(e = 0; e < nEdges; e++)
+            {
+                pot *= ep[y[i+nInstances*edgeEnds[e]]+maxState*(y[i+nInstances*edgeEnds[e+nEdges]]+maxState*e)];
+                pot = frexp(pot,&ex);
+                exponent += ex;
+            }
+            
+            f -= log(pot) + exponent*M_LN2;
+        }
+        
+        t = 0;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        myF[t] = f;
+    }
+    
+    fsub[0] = 0;
+    for(t = 0; t < nThreads; t++)
+        fsub[0] += myF[t];
+    mxFree(myF);
+}
@@ -1,64 +1,93 @@
 #include <math.h>
+#include <stdlib.h>
 #include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "UGM_common.h"
 
+/* Negative log of the unnormalized potentials of the training labels, with
+   potentials shared by all instances. The instances are split over the
+   threads, which count how often each node state and edge state pair is
+   observed; the logs are only taken once per potential. The counts of the
+   threads are summed in thread order after the parallel region. */
+
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 {
     /* Variables */
-    int i,n,s,e,*y,*edgeEnds,outputSize[2],
-    nNodes,maxState,nInstances,nEdges;
+    int i,n,s,e,t,*y,*edgeEnds,
+    nNodes,maxState,nInstances,nEdges,nNodeCounts,nCounts,nThreads;
     
-    double *nodePot,*edgePot,*fsub;
+    double *nodePot,*edgePot,*fsub,*counts,*myCounts;
     
     /* Input */
-    y = mxGetPr(prhs[0]);
+    y = (int*)mxGetPr(prhs[0]);
     nodePot = mxGetPr(prhs[1]);
     edgePot = mxGetPr(prhs[2]);
-    edgeEnds = mxGetPr(prhs[3]);
+    edgeEnds = (int*)mxGetPr(prhs[3]);
     
     /* Compute Sizes */
     nInstances = mxGetDimensions(prhs[0])[0];
     nNodes = mxGetDimensions(prhs[1])[0];
     maxState = mxGetDimensions(prhs[1])[1];
     nEdges = mxGetDimensions(prhs[3])[0];
+    nNodeCounts = nNodes*maxState;
+    nCounts = nNodeCounts + maxState*maxState*nEdges;
     decrementEdgeEnds(edgeEnds,nEdges);
     
     /* Output */
-    outputSize[0] = 1;
-    outputSize[1] = 1;
-    plhs[0] = mxCreateNumericArray(2,outputSize,mxDOUBLE_CLASS,mxREAL);
+    plhs[0] = mxCreateDoubleMatrix(1,1,mxREAL);
     fsub = mxGetPr(plhs[0]);
     
     /* Decrement y */
-    for(i = 0; i < nInstances; i++)
+    decrementVector(y,nInstances*nNodes);
+    
+    /* Reference into nodePot like this: nodePot[n+nNodes*s] */
+    /* Reference into edgePot like this: edgePot[s1+maxState*(s2+maxState*e)] */
+    
+    /* Count the Training Labels, nodes first and then edges */
+    counts = mxCalloc(nCounts+1,sizeof(double));
+    nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    myCounts = mxCalloc((size_t)nThreads*(nCounts+1),sizeof(double));
+#pragma omp parallel num_threads(nThreads) private(i,n,e,t)
     {
-        for(n = 0; n < nNodes; n++)
+        double *c;
+        
+        t = 0;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        c = myCounts + (size_t)t*(nCounts+1);
+        
+#pragma omp for schedule(static)
+        for(i = 0; i < nInstances; i++)
         {
-            y[i + nInstances*n]--;
+            for(n = 0; n < nNodes; n++)
+                c[n+nNodes*y[i+nInstances*n]] += 1;
+            for(e = 0; e < nEdges; e++)
+                c[nNodeCounts+y[i+nInstances*edgeEnds[e]]+maxState*(y[i+nInstances*edgeEnds[e+nEdges]]+maxState*e)] += 1;
         }
     }
+    for(t = 0; t < nThreads; t++)
+    {
+        for(s = 0; s < nCounts; s++)
+            counts[s] += myCounts[s + (size_t)t*(nCounts+1)];
+    }
+    mxFree(myCounts);
     
     fsub[0] = 0;
-    
-    /* Reference into nodePot like this: nodePot[n+nNodes*(s+maxState*i)] */
-    /* Reference into edgePot like this: edgePot[s1+maxState*(s2+maxState*(e+nEdges*i))] */
-    
-    /* Update based on Node Potentials of Training Labels */
-    for(i = 0; i < nInstances; i++)
+    for(s = 0; s < nNodeCounts; s++)
     {
-        for(n = 0; n < nNodes; n++)
-        {
-            fsub[0] -= log(nodePot[n+nNodes*y[i+nInstances*n]]);
-        }
+        if(counts[s] > 0)
+            fsub[0] -= counts[s]*log(nodePot[s]);
     }
-    
-    /* Update based on Edge Potentials of Training Labels */
-    for(i = 0; i < nInstances; i++)
+    for(s = 0; s < nCounts-nNodeCounts; s++)
     {
-        for(e = 0; e < nEdges; e++)
-        {
-            fsub[0] -= log(edgePot[y[i+nInstances*edgeEnds[e]]+maxState*(y[i+nInstances*edgeEnds[e+nEdges]]+maxState*e)]);
-        }
+        if(counts[nNodeCounts+s] > 0)
+            fsub[0] -= counts[nNodeCounts+s]*log(edgePot[s]);
     }
-
+    mxFree(counts);
 }
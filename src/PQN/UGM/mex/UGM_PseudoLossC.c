@@ -1,252 +1,311 @@
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "UGM_common.h"
- 
- 
+#include "UGM_infer.h"
+
+/* f = UGM_PseudoLossC(gw,gv,w,v,X,Xedge,y,nodePot,edgePot,edgeEnds,V,E,nStates,tieNodes,tieEdges,ising)
+ *
+ * Negative log pseudo-likelihood, gw and gv are updated in place.
+ * Instances are split over the threads, each thread accumulates its own
+ * objective and gradient and they are summed in thread order at the end. The features of a block of
+ * instances are first copied instance-major (X(i,:,n) contiguous) so the
+ * gradient updates run over contiguous memory.
+ * The conditional of a node is computed as a product of potentials and
+ * recomputed from log potentials when the product (or the probability of
+ * the observed state) leaves the range of doubles. */
+
+#define INSTANCE_BLOCK 32
+#define POT_MIN 1e-280
+#define POT_MAX 1e280
+
+
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 {
    /* Variables */
-    int i, n, n1, n2, p, e, s, s1, s2, sInd, edgeInd, 
-    nInstances,nNodeFeatures,nEdgeFeatures,maxState,nNodes,nEdges,
-    *y, *edgeEnds, *V, *E, *nStates, tieNodes,tieEdges, ising, sizF[2], 
-    y_neigh, neigh;
-    
-    double *f, *gw, *gv, *w, *v, *X, *Xedge, *nodePot, *edgePot,
-    *pot, Z, observed, expected;
-    
+    int i, n, e, t,
+    nInstances,nNodeFeatures,nEdgeFeatures,maxState,nNodes,nEdges,nBlocks,nThreads,
+    *y, *edgeEnds, *V, *E, *nStates, tieNodes,tieEdges, ising;
+
+    size_t k, nGw, nGv, nXb, nXeb, nYb;
+
+    double *f, *gw, *gv, *X, *Xedge, *nodePot, *edgePot,
+    *potAll, *gwAll, *gvAll, *xbAll, *xebAll, *fAll;
+
+    int *ybAll;
+
     /* Input */
     gw = mxGetPr(prhs[0]);
     gv = mxGetPr(prhs[1]);
-    w = mxGetPr(prhs[2]);
-    v = mxGetPr(prhs[3]);
     X = mxGetPr(prhs[4]);
     Xedge = mxGetPr(prhs[5]);
-    y = mxGetPr(prhs[6]);
+    y = (int*)mxGetPr(prhs[6]);
     nodePot = mxGetPr(prhs[7]);
     edgePot = mxGetPr(prhs[8]);
-    edgeEnds = mxGetPr(prhs[9]);
-    V = mxGetPr(prhs[10]);
-    E = mxGetPr(prhs[11]);
-    nStates = mxGetPr(prhs[12]);
+    edgeEnds = (int*)mxGetPr(prhs[9]);
+    V = (int*)mxGetPr(prhs[10]);
+    E = (int*)mxGetPr(prhs[11]);
+    nStates = (int*)mxGetPr(prhs[12]);
     tieNodes = mxGetScalar(prhs[13]);
     tieEdges = mxGetScalar(prhs[14]);
     ising = mxGetScalar(prhs[15]);
-    
+
     /* Compute Sizes */
     nInstances = mxGetDimensions(prhs[4])[0];
     nNodeFeatures = mxGetDimensions(prhs[4])[1];
-    nNodes = mxGetDimensions(prhs[4])[2];
+    nNodes = mxGetNumberOfDimensions(prhs[4]) > 2 ? mxGetDimensions(prhs[4])[2] : 1;
     nEdgeFeatures = mxGetDimensions(prhs[5])[1];
     nEdges = mxGetDimensions(prhs[9])[0];
+    nGw = mxGetNumberOfElements(prhs[0]);
+    nGv = mxGetNumberOfElements(prhs[1]);
     maxState = getMaxState(nStates,nNodes);
+    nBlocks = (nInstances + INSTANCE_BLOCK - 1)/INSTANCE_BLOCK;
     decrementEdgeEnds(edgeEnds,nEdges);
-    for(i = 0; i < nInstances; i++)
-    {
-        for(n = 0; n < nNodes; n++)
-        {
-            y[i + nInstances*n]--;
-        }
-    }
-    for(n = 0; n <= nNodes; n++)
-    {
-        V[n]--;
-    }
-    for(e = 0; e < nEdges*2; e++)
-    {
-        E[e]--;
-    }
-    
-    /* Allocate */
-    pot = mxCalloc(maxState,sizeof(double));
-    
+    decrementVector(y,nInstances*nNodes);
+    decrementVector(V,nNodes+1);
+    decrementVector(E,nEdges*2);
+
     /* Output */
-    sizF[0] = 1;
-    sizF[1] = 1;
-    plhs[0] = mxCreateNumericArray(2,sizF,mxDOUBLE_CLASS,mxREAL);
+    plhs[0] = mxCreateDoubleMatrix(1,1,mxREAL);
     f = mxGetPr(plhs[0]);
-    *f = 0;
-    
-    for(i = 0; i < nInstances; i++)
+
+    /* Work space of the threads, one slice per thread */
+    nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    nXb = (size_t)INSTANCE_BLOCK*nNodeFeatures*nNodes + 1;
+    nXeb = (size_t)INSTANCE_BLOCK*nEdgeFeatures*nEdges + 1;
+    nYb = (size_t)INSTANCE_BLOCK*nNodes + 1;
+    potAll = mxMalloc(nThreads*(maxState + 1)*sizeof(double));
+    gwAll = mxCalloc(nThreads*(nGw + 1), sizeof(double));
+    gvAll = mxCalloc(nThreads*(nGv + 1), sizeof(double));
+    xbAll = mxMalloc(nThreads*nXb*sizeof(double));
+    xebAll = mxMalloc(nThreads*nXeb*sizeof(double));
+    ybAll = mxMalloc(nThreads*nYb*sizeof(int));
+    fAll = mxCalloc(nThreads, sizeof(double));
+
+#pragma omp parallel num_threads(nThreads) private(i,n,e,t)
     {
-        for(n = 0; n < nNodes; n++)
+        int b, ii, i0, nb, p, s, s1, s2, sInd, edgeInd, n1, n2, neigh, y_n, y_neigh;
+        double Z, potMax, observed, expected, d, *x, *xe, fTotal = 0;
+        double *pot, *myGw, *myGv, *xb, *xeb;
+        int *yb;
+
+        t = 0;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        pot = potAll + t*(maxState + 1);
+        myGw = gwAll + t*(nGw + 1);
+        myGv = gvAll + t*(nGv + 1);
+        xb = xbAll + t*nXb;
+        xeb = xebAll + t*nXeb;
+        yb = ybAll + t*nYb;
+
+#pragma omp for schedule(static)
+        for(b = 0; b < nBlocks; b++)
         {
-         
-            /* Compute NodePot for all States */
-            for(s = 0; s < nStates[n]; s++)
-            {
-                pot[s] = nodePot[n + nNodes*(s + maxState*i)];
-            }
+            i0 = b*INSTANCE_BLOCK;
+            nb = (i0 + INSTANCE_BLOCK < nInstances) ? INSTANCE_BLOCK : nInstances - i0;
 
-            /* Add EdgePot for each state with neighbors fixed */
-            for(edgeInd = V[n]; edgeInd < V[n+1]; edgeInd++)
+            /* Copy the block instance-major */
+            for(n = 0; n < nNodes; n++)
             {
-                e = E[edgeInd];
-                n1 = edgeEnds[e];
-                n2 = edgeEnds[e+nEdges];
-                if(n == edgeEnds[e])
-                {
-                    for(s = 0; s < nStates[n]; s++)
-                    {
-                        pot[s] *= edgePot[s + maxState*(y[i + nInstances*n2] + maxState*(e + nEdges*i))];
-                    }
-                }
-                else
+                for(p = 0; p < nNodeFeatures; p++)
                 {
-                    for(s = 0; s < nStates[n]; s++)
-                    {
-                        pot[s] *= edgePot[y[i + nInstances*n1] + maxState*(s + maxState*(e + nEdges*i))];
-                    }
+                    const double *src = X + i0 + (size_t)nInstances*(p + nNodeFeatures*n);
+                    for(ii = 0; ii < nb; ii++)
+                        xb[p + nNodeFeatures*(n + (size_t)nNodes*ii)] = src[ii];
                 }
+                for(ii = 0; ii < nb; ii++)
+                    yb[n + nNodes*ii] = y[i0 + ii + nInstances*n];
             }
-           
-            /* Update Objective */
-            Z = 0;
-            for(s = 0; s < nStates[n]; s++)
-            {
-                Z += pot[s];
-            }
-            *f = *f - log(pot[y[i + nInstances*n]]) + log(Z);
-            
-            /* Node Beliefs */
-            for(s = 0; s < nStates[n]; s++)
+            for(e = 0; e < nEdges; e++)
             {
-                pot[s] = pot[s]/Z;
-            }
-            
-            /* Update Gradient of Node Weights */
-            for(s = 0; s < nStates[n]-1; s++)
-            {
-                if(s == y[i + nInstances*n])
+                for(p = 0; p < nEdgeFeatures; p++)
                 {
-                    observed = 1;
-                }
-                else
-                {
-                    observed = 0;
-                }
-                expected = pot[s];
-                
-                for(p = 0; p < nNodeFeatures; p++)
-                {
-                    if (tieNodes)
-                    {
-                        gw[p + nNodeFeatures*s] -= (observed - expected)*X[i+nInstances*(p+nNodeFeatures*n)];
-                    }
-                    else
-                    {
-                        gw[p + nNodeFeatures*(s + (maxState-1)*n)] -= (observed - expected)*X[i+nInstances*(p+nNodeFeatures*n)];
-                    }
+                    const double *src = Xedge + i0 + (size_t)nInstances*(p + nEdgeFeatures*e);
+                    for(ii = 0; ii < nb; ii++)
+                        xeb[p + nEdgeFeatures*(e + (size_t)nEdges*ii)] = src[ii];
                 }
             }
-            
-            
-            /* Update Gradient of Edge Weights */
-            for(edgeInd = V[n]; edgeInd < V[n+1]; edgeInd++)
+
+            for(ii = 0; ii < nb; ii++)
             {
-                e = E[edgeInd];
-                n1 = edgeEnds[e];
-                n2 = edgeEnds[e+nEdges];
-                
-                if (ising)
+                const int *yi = yb + nNodes*ii;
+                const double *np, *ep;
+                i = i0 + ii;
+                np = nodePot + (size_t)nNodes*maxState*i;
+                ep = edgePot + (size_t)maxState*maxState*nEdges*i;
+
+                for(n = 0; n < nNodes; n++)
                 {
-                    if(y[i + nInstances*n1] == y[i + nInstances*n2])
-                    {
-                        observed = 1;
-                    }
-                    else
-                    {
-                        observed = 0;
-                    }
-                    
-                    if(n == n1)
+                    y_n = yi[n];
+
+                    /* Compute NodePot for all States, times the EdgePot of
+                       each neighbor at its observed state */
+                    for(s = 0; s < nStates[n]; s++)
+                        pot[s] = np[n + nNodes*s];
+                    for(edgeInd = V[n]; edgeInd < V[n+1]; edgeInd++)
                     {
-                        y_neigh = y[i + nInstances*n2];
+                        e = E[edgeInd];
+                        n1 = edgeEnds[e];
+                        n2 = edgeEnds[e+nEdges];
+                        if(n == n1)
+                        {
+                            const double *col = ep + maxState*(yi[n2] + maxState*e);
+                            for(s = 0; s < nStates[n]; s++)
+                                pot[s] *= col[s];
+                        }
+                        else
+                        {
+                            const double *row = ep + yi[n1] + maxState*maxState*e;
+                            for(s = 0; s < nStates[n]; s++)
+                                pot[s] *= row[maxState*s];
+                        }
                     }
-                    else
+
+                    potMax = 0;
+                    for(s = 0; s < nStates[n]; s++)
                     {
-                        y_neigh = y[i + nInstances*n1];
+                        if(pot[s] > potMax)
+                            potMax = pot[s];
                     }
-                    
-                    if(y_neigh < nStates[n])
+                    if(!(potMax < POT_MAX && pot[y_n] > POT_MIN))
                     {
-                        expected = pot[y_neigh];
+                        /* Redo in the log domain, scaled by the largest term */
+                        for(s = 0; s < nStates[n]; s++)
+                            pot[s] = logPot(np[n + nNodes*s]);
+                        for(edgeInd = V[n]; edgeInd < V[n+1]; edgeInd++)
+                        {
+                            e = E[edgeInd];
+                            n1 = edgeEnds[e];
+                            n2 = edgeEnds[e+nEdges];
+                            for(s = 0; s < nStates[n]; s++)
+                            {
+                                if(n == n1)
+                                    pot[s] += logPot(ep[s + maxState*(yi[n2] + maxState*e)]);
+                                else
+                                    pot[s] += logPot(ep[yi[n1] + maxState*(s + maxState*e)]);
+                            }
+                        }
+                        Z = logSumExp(pot,nStates[n]);
+                        fTotal += Z - pot[y_n];
+                        for(s = 0; s < nStates[n]; s++)
+                            pot[s] = exp(pot[s] - Z);
                     }
                     else
                     {
-                        expected = 0;
+                        /* Update Objective */
+                        Z = 0;
+                        for(s = 0; s < nStates[n]; s++)
+                            Z += pot[s];
+                        fTotal += log(Z/pot[y_n]);
+
+                        /* Node Beliefs */
+                        for(s = 0; s < nStates[n]; s++)
+                            pot[s] /= Z;
                     }
-                    
-                    for (p = 0; p < nEdgeFeatures; p++)
+
+                    /* Update Gradient of Node Weights */
+                    x = xb + nNodeFeatures*(n + (size_t)nNodes*ii);
+                    for(s = 0; s < nStates[n]-1; s++)
                     {
-                        if (tieEdges)
+                        observed = (s == y_n) ? 1 : 0;
+                        expected = pot[s];
+                        d = observed - expected;
+                        if(tieNodes)
                         {
-                            gv[p] -= (observed-expected)*Xedge[i + nInstances*(p + nEdgeFeatures*e)];
+                            double *g = myGw + nNodeFeatures*s;
+                            for(p = 0; p < nNodeFeatures; p++)
+                                g[p] -= d*x[p];
                         }
                         else
                         {
-                            gv[p+nEdgeFeatures*e] -= (observed-expected)*Xedge[i + nInstances*(p + nEdgeFeatures*e)];
+                            double *g = myGw + nNodeFeatures*(s + (maxState-1)*n);
+                            for(p = 0; p < nNodeFeatures; p++)
+                                g[p] -= d*x[p];
                         }
                     }
-                    
-                }
-                else /* (~ising) */
-                {
-                    for(s = 0; s < nStates[n]; s++)
+
+                    /* Update Gradient of Edge Weights */
+                    for(edgeInd = V[n]; edgeInd < V[n+1]; edgeInd++)
                     {
-                        if (n == n1)
-                        {
-                            neigh = n2;
-                        }
-                        else
-                        {
-                            neigh = n1;
-                        }
-                        
-                        if(s == nStates[n]-1 && y[i + nInstances*neigh] == nStates[neigh]-1)
-                        {
-                            continue;
-                        }
-                        
-                        if (s == y[i + nInstances*n])
-                        {
-                            observed = 1;
-                        }
-                        else
-                        {
-                            observed = 0;
-                        }
-                        expected = pot[s];
-                        
-                        if (n == n1)
-                        {
-                            s1 = s;
-                            s2 = y[i + nInstances*neigh];
-                        }
-                        else
+                        e = E[edgeInd];
+                        n1 = edgeEnds[e];
+                        n2 = edgeEnds[e+nEdges];
+                        neigh = (n == n1) ? n2 : n1;
+                        y_neigh = yi[neigh];
+                        xe = xeb + nEdgeFeatures*(e + (size_t)nEdges*ii);
+
+                        if (ising)
                         {
-                            s1 = y[i + nInstances*neigh];
-                            s2 = s;
+                            double *g = tieEdges ? myGv : myGv + nEdgeFeatures*e;
+                            observed = (yi[n1] == yi[n2]) ? 1 : 0;
+                            expected = (y_neigh < nStates[n]) ? pot[y_neigh] : 0;
+                            d = observed - expected;
+                            for (p = 0; p < nEdgeFeatures; p++)
+                                g[p] -= d*xe[p];
                         }
-                        sInd = s1+s2*maxState;
-                        
-                        for(p = 0; p < nEdgeFeatures; p++)
+                        else /* (~ising) */
                         {
-                            if (tieEdges)
+                            for(s = 0; s < nStates[n]; s++)
                             {
-                                gv[p + nEdgeFeatures*sInd] -= (observed-expected)*Xedge[i + nInstances*(p + nEdgeFeatures*e)];
-                            }
-                            else
-                            {
-                                gv[p + nEdgeFeatures*(sInd + (maxState*maxState-1)*e)] -= (observed-expected)*Xedge[i + nInstances*(p + nEdgeFeatures*e)];
+                                double *g;
+                                if(s == nStates[n]-1 && y_neigh == nStates[neigh]-1)
+                                    continue;
+
+                                observed = (s == y_n) ? 1 : 0;
+                                expected = pot[s];
+                                d = observed - expected;
+                                if (n == n1)
+                                {
+                                    s1 = s;
+                                    s2 = y_neigh;
+                                }
+                                else
+                                {
+                                    s1 = y_neigh;
+                                    s2 = s;
+                                }
+                                sInd = s1+s2*maxState;
+                                if (tieEdges)
+                                    g = myGv + nEdgeFeatures*sInd;
+                                else
+                                    g = myGv + nEdgeFeatures*(sInd + (maxState*maxState-1)*e);
+                                for(p = 0; p < nEdgeFeatures; p++)
+                                    g[p] -= d*xe[p];
                             }
                         }
                     }
                 }
-                
-                
             }
         }
+
+        fAll[t] = fTotal;
+    }
+
+    /* Sum the objectives and gradients of the threads in a fixed order */
+    *f = 0;
+    for(t = 0; t < nThreads; t++)
+    {
+        *f += fAll[t];
+        for(k = 0; k < nGw; k++)
+            gw[k] += gwAll[k + t*(nGw + 1)];
+        for(k = 0; k < nGv; k++)
+            gv[k] += gvAll[k + t*(nGv + 1)];
     }
-    
-    mxFree(pot);
-}
\ No newline at end of file
+
+    mxFree(potAll);
+    mxFree(gwAll);
+    mxFree(gvAll);
+    mxFree(xbAll);
+    mxFree(xebAll);
+    mxFree(ybAll);
+    mxFree(fAll);
+}
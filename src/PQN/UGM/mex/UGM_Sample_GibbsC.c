@@ -1,135 +1,253 @@
 #include <math.h>
+#include <stdlib.h>
 #include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "UGM_common.h"
 
+/* samples = UGM_Sample_GibbsC(nodePot,edgePot,edgeEnds,nStates,V,E,maxIter,burnIn,y,thin,seed)
+ *
+ * Chromatic Gibbs sampling: the nodes are greedily colored so that no two
+ * neighbors share a color, and all nodes of a color are resampled in
+ * parallel. Every column of y (nNodes by nChains) starts an independent
+ * chain; the chains of a node are stored next to each other. After burnIn
+ * sweeps every thin-th sweep is recorded, samples is nNodes by maxIter by
+ * nChains.
+ * The uniforms come from a counter-based generator (splitmix64 of the
+ * position of the draw), so the samples only depend on seed and not on the
+ * number of threads. */
+
+#define CHAIN_BLOCK 16
+
+typedef unsigned long long uint64;
+
+
+/* Uniform in [0,1) for draw 'counter' of the stream 'seed' */
+static double uniform(uint64 seed, uint64 counter)
+{
+    uint64 z = seed + (counter + 1)*0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    return (z >> 11)*(1.0/9007199254740992.0);
+}
+
+/* Greedy coloring in node order, returns the number of colors; the nodes
+   of color c are order[colorStart[c]..colorStart[c+1]-1] */
+static int colorGraph(int nNodes, int nEdges, int *edgeEnds, int *V, int *E,
+        int *color, int *order, int *colorStart)
+{
+    int n, c, e, Vind, nColors = 0, *used;
+
+    used = mxMalloc((nNodes + 2)*sizeof(int));
+    for(n = 0; n <= nNodes; n++)
+    {
+        used[n] = -1;
+        color[n] = -1;
+    }
+    for(n = 0; n < nNodes; n++)
+    {
+        for(Vind = V[n]; Vind < V[n+1]; Vind++)
+        {
+            e = E[Vind];
+            c = (edgeEnds[e] == n) ? color[edgeEnds[e+nEdges]] : color[edgeEnds[e]];
+            if(c >= 0)
+                used[c] = n;
+        }
+        for(c = 0; used[c] == n; c++);
+        color[n] = c;
+        if(c+1 > nColors)
+            nColors = c+1;
+    }
+
+    for(c = 0; c <= nColors; c++)
+        colorStart[c] = 0;
+    for(n = 0; n < nNodes; n++)
+        colorStart[color[n]+1]++;
+    for(c = 0; c < nColors; c++)
+        colorStart[c+1] += colorStart[c];
+    for(n = 0; n < nNodes; n++)
+        order[colorStart[color[n]]++] = n;
+    for(c = nColors; c > 0; c--)
+        colorStart[c] = colorStart[c-1];
+    colorStart[0] = 0;
+
+    mxFree(used);
+    return nColors;
+}
+
 
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 {
    /* Variables */
-    int i,n,s,e,n1,n2,Vind,maxIter,burnIn,
-    nNodes, nEdges, maxState, sizeS[2],
-    *edgeEnds, *nStates, *V, *E,*y;
-    
-    double *pot,z,U,u,
-    *nodePot, *edgePot,*S;
-    
+    int i, n, c, k, maxIter, burnIn, thin, nSweeps, nChains, nBlocks, nColors,
+    nNodes, nEdges, maxState, nThreads, potSize,
+    *edgeEnds, *nStates, *V, *E, *y0, *y, *color, *order, *colorStart;
+
+    mwSize sizeS[3];
+
+    double *nodePot, *edgePot, *S, *potAll;
+
+    uint64 seed;
+
    /* Input */
-    
+
+    if(nrhs < 9)
+        mexErrMsgTxt("Usage: UGM_Sample_GibbsC(nodePot,edgePot,edgeEnds,nStates,V,E,maxIter,burnIn,y[,thin,seed])");
+
     nodePot = mxGetPr(prhs[0]);
     edgePot = mxGetPr(prhs[1]);
-    edgeEnds = mxGetPr(prhs[2]);
-    nStates = mxGetPr(prhs[3]);
-    V = mxGetPr(prhs[4]);
-    E = mxGetPr(prhs[5]);
-    maxIter = mxGetPr(prhs[6])[0];
-    burnIn = mxGetPr(prhs[7])[0];
-    y = mxGetPr(prhs[8]);
-    
+    edgeEnds = (int*)mxGetPr(prhs[2]);
+    nStates = (int*)mxGetPr(prhs[3]);
+    V = (int*)mxGetPr(prhs[4]);
+    E = (int*)mxGetPr(prhs[5]);
+    maxIter = (int)mxGetScalar(prhs[6]);
+    burnIn = (int)mxGetScalar(prhs[7]);
+    y0 = (int*)mxGetPr(prhs[8]);
+    thin = (nrhs > 9 && !mxIsEmpty(prhs[9])) ? (int)mxGetScalar(prhs[9]) : 1;
+    if(nrhs > 10 && !mxIsEmpty(prhs[10]))
+        seed = (uint64)mxGetScalar(prhs[10]);
+    else
+        seed = ((uint64)rand() << 32) ^ (uint64)rand();
+    if(thin < 1)
+        mexErrMsgTxt("thin must be at least 1");
+
    /* Compute Sizes */
-    
+
     nNodes = mxGetDimensions(prhs[0])[0];
     maxState = mxGetDimensions(prhs[0])[1];
     nEdges = mxGetDimensions(prhs[2])[0];
+    nChains = mxGetNumberOfElements(prhs[8])/nNodes;
+    nBlocks = (nChains + CHAIN_BLOCK - 1)/CHAIN_BLOCK;
+    nSweeps = burnIn + maxIter*thin;
     decrementEdgeEnds(edgeEnds,nEdges);
     decrementVector(V,nNodes+1);
     decrementVector(E,nEdges*2);
-    decrementVector(y,nNodes);
 
-    
    /* Output */
-    pot = mxCalloc(maxState,sizeof(double));
+
     sizeS[0] = nNodes;
     sizeS[1] = maxIter;
-    plhs[0] = mxCreateNumericArray(2,sizeS,mxDOUBLE_CLASS,mxREAL);
+    sizeS[2] = nChains;
+    plhs[0] = mxCreateNumericArray(3,sizeS,mxDOUBLE_CLASS,mxREAL);
     S = mxGetPr(plhs[0]);
-    
-   /* Initialize to States with highest node potentials*/
-   /* for(n = 0; n < nNodes; n++)
+
+   /* States of all chains, chain index fastest */
+
+    y = mxMalloc((nNodes*nChains + 1)*sizeof(int));
+    for(n = 0; n < nNodes; n++)
     {
-        u = -1;
-        U = 0;
-        for(s = 0; s < nStates[n]; s++)
-        {
-            if(nodePot[n+nNodes*s] > u)
-            {
-                u = nodePot[n+nNodes*s];
-                U = s;
-            }
-        }
-        y[n] = U;
+        for(c = 0; c < nChains; c++)
+            y[c + nChains*n] = y0[n + nNodes*c] - 1;
     }
-    */
-    
-    for(i = 0; i < burnIn+maxIter; i++)
+
+    color = mxMalloc((nNodes + 1)*sizeof(int));
+    order = mxMalloc((nNodes + 1)*sizeof(int));
+    colorStart = mxMalloc((nNodes + 2)*sizeof(int));
+    nColors = colorGraph(nNodes,nEdges,edgeEnds,V,E,color,order,colorStart);
+
+   /* Potentials of one block of chains, one buffer per thread */
+
+    nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    potSize = CHAIN_BLOCK*maxState + 1;
+    potAll = mxMalloc(nThreads*potSize*sizeof(double));
+
+#pragma omp parallel num_threads(nThreads) private(i,k)
     {
+        double *pot = potAll;
+#ifdef _OPENMP
+        pot += omp_get_thread_num()*potSize;
+#endif
 
-        for(n = 0; n < nNodes; n++)
+        for(i = 0; i < nSweeps; i++)
         {
-            /* Compute Node Potential */
-            for(s = 0; s < nStates[n]; s++)
+            for(k = 0; k < nColors; k++)
             {
-                pot[s] = nodePot[n + nNodes*s];
-            }
-            
-           /* Iterate over Neighbors */
-            for(Vind = V[n]; Vind < V[n+1]; Vind++)
-            {
-                e = E[Vind];
-                n1 = edgeEnds[e];
-                n2 = edgeEnds[e+nEdges];
-                 
-                /* Multiply Edge Potentials */
-                if(n == n1)
-                {
-                   for(s = 0; s < nStates[n]; s++)
-                   {
-                        pot[s] *= edgePot[s+maxState*(y[n2] + maxState*e)];
-                   }
-                    
-                }
-                else
+                int j, nJobs = (colorStart[k+1] - colorStart[k])*nBlocks;
+
+#pragma omp for schedule(static)
+                for(j = 0; j < nJobs; j++)
                 {
-                    for(s = 0; s < nStates[n]; s++)
+                    int n = order[colorStart[k] + j/nBlocks], n1, n2, e, s, Vind, ch,
+                    c0 = (j%nBlocks)*CHAIN_BLOCK,
+                    c1 = (c0 + CHAIN_BLOCK < nChains) ? c0 + CHAIN_BLOCK : nChains;
+                    double z, u, U;
+
+                    /* Compute Node Potential */
+                    for(ch = c0; ch < c1; ch++)
                     {
-                        pot[s] *= edgePot[y[n1]+maxState*(s + maxState*e)];
+                        for(s = 0; s < nStates[n]; s++)
+                            pot[(ch-c0)*maxState + s] = nodePot[n + nNodes*s];
+                    }
+
+                    /* Multiply Edge Potentials of the Neighbors */
+                    for(Vind = V[n]; Vind < V[n+1]; Vind++)
+                    {
+                        e = E[Vind];
+                        n1 = edgeEnds[e];
+                        n2 = edgeEnds[e+nEdges];
+                        if(n == n1)
+                        {
+                            for(ch = c0; ch < c1; ch++)
+                            {
+                                const double *ep = edgePot + maxState*(y[ch + nChains*n2] + maxState*e);
+                                for(s = 0; s < nStates[n]; s++)
+                                    pot[(ch-c0)*maxState + s] *= ep[s];
+                            }
+                        }
+                        else
+                        {
+                            for(ch = c0; ch < c1; ch++)
+                            {
+                                const double *ep = edgePot + y[ch + nChains*n1] + maxState*maxState*e;
+                                for(s = 0; s < nStates[n]; s++)
+                                    pot[(ch-c0)*maxState + s] *= ep[maxState*s];
+                            }
+                        }
+                    }
+
+                    /* Sample Discrete States */
+                    for(ch = c0; ch < c1; ch++)
+                    {
+                        double *p = pot + (ch-c0)*maxState;
+                        z = 0;
+                        for(s = 0; s < nStates[n]; s++)
+                            z += p[s];
+                        U = z*uniform(seed, ((uint64)i*nNodes + n)*nChains + ch);
+                        u = 0;
+                        for(s = 0; s < nStates[n]-1; s++)
+                        {
+                            u += p[s];
+                            if(u > U)
+                                break;
+                        }
+                        y[ch + nChains*n] = s;
                     }
                 }
-                
             }
-            
-            /* Normalize */
-            z = 0;
-            for(s = 0; s < nStates[n]; s++)
-                z = z + pot[s];
-            for(s = 0; s < nStates[n]; s++)
-                pot[s] /= z;
-            
-            /* Display */
-            for(s = 0; s < nStates[n]; s++)
-            
-            /* Sample Discrete State */
-            U = rand()/((double)RAND_MAX + 1);
-            u = 0;
-            for(s = 0; s < nStates[n]; s++)
+
+            /* Record Sample */
+            if(i >= burnIn && (i-burnIn+1) % thin == 0)
             {
-                u += pot[s];
-                if(u > U)
+                int j, m = (i-burnIn)/thin;
+#pragma omp for schedule(static)
+                for(j = 0; j < nNodes*nChains; j++)
                 {
-                    break;
+                    int ch = j/nNodes, nn = j%nNodes;
+                    S[nn + nNodes*(m + maxIter*ch)] = y[ch + nChains*nn]+1;
                 }
             }
-            y[n] = s;
-        }
-        
-        if(i >= burnIn)
-        {        /* Record Sample */
-            for(n = 0; n < nNodes; n++)
-            {
-                S[n + nNodes*(i-burnIn)] = y[n]+1;
-            }
         }
     }
-    
+
    /* Free memory */
-    mxFree(pot);
+    mxFree(potAll);
+    mxFree(y);
+    mxFree(color);
+    mxFree(order);
+    mxFree(colorStart);
 }
@@ -0,0 +1,71 @@
+/* Log-domain helpers shared by UGM_Infer_LBPC, UGM_Infer_JunctionC and UGM_PseudoLossC,
+   inline so that files using only some of them build without unused-function warnings */
+
+#include <math.h>
+#include <stdlib.h>
+
+
+/* log of a potential, -inf for a zero potential */
+static __inline double logPot(double p)
+{
+    return (p > 0) ? log(p) : -HUGE_VAL;
+}
+
+/* log(sum(exp(x))) over x[0..n-1] */
+static __inline double logSumExp(const double *x, int n)
+{
+    int s;
+    double m = -HUGE_VAL, z = 0;
+
+    for(s = 0; s < n; s++)
+    {
+        if(x[s] > m)
+            m = x[s];
+    }
+    if(m == -HUGE_VAL)
+        return m;
+    for(s = 0; s < n; s++)
+        z += exp(x[s] - m);
+    return m + log(z);
+}
+
+/* sum(p.*log(p)) of a normalized distribution given as log(p), 0*log(0) = 0 */
+static __inline double negEntropy(const double *logp, int n)
+{
+    int s;
+    double h = 0;
+
+    for(s = 0; s < n; s++)
+    {
+        if(logp[s] > -HUGE_VAL)
+            h += exp(logp[s])*logp[s];
+    }
+    return h;
+}
+
+/* sum(p.*logq), with 0*log(q) = 0 */
+static __inline double expectedLog(const double *logp, const double *logq, int n)
+{
+    int s;
+    double u = 0;
+
+    for(s = 0; s < n; s++)
+    {
+        if(logp[s] > -HUGE_VAL)
+            u += exp(logp[s])*logq[s];
+    }
+    return u;
+}
+
+/* Log potentials in the layout of nodePot(node,state) and
+   edgePot(state1,state2,edge) */
+static __inline void makeLogPotentials(const double *nodePot, const double *edgePot,
+        int nNodes, int nEdges, int maxState, double *logNodePot, double *logEdgePot)
+{
+    int i;
+
+    for(i = 0; i < nNodes*maxState; i++)
+        logNodePot[i] = logPot(nodePot[i]);
+    for(i = 0; i < maxState*maxState*nEdges; i++)
+        logEdgePot[i] = logPot(edgePot[i]);
+}
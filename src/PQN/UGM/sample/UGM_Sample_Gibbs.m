@@ -1,20 +1,39 @@
-function [samples] = UGM_Sample_Gibbs(nodePot,edgePot,edgeStruct,burnIn,y)
+function [samples] = UGM_Sample_Gibbs(nodePot,edgePot,edgeStruct,burnIn,y,thin,nChains)
 % Single Site Gibbs Sampling
+%
+% y(node,chain) - initial states, one column per chain (default: states
+%   with the highest node potential, repeated nChains times)
+% thin - keep every thin-th sweep after the burnIn sweeps (default 1)
+% nChains - number of independent chains when y is not given (default 1)
+%
+% samples(node,sample,chain) - edgeStruct.maxIter samples of each chain
+%
+% The mex version resamples all nodes of a graph coloring in parallel.
 
-if nargin < 5
+if nargin < 7 || isempty(nChains)
+    nChains = 1;
+end
+if nargin < 6 || isempty(thin)
+    thin = 1;
+end
+if nargin < 5 || isempty(y)
 % Initialize
 [junk y] = max(nodePot,[],2);
+y = repmat(y,[1 nChains]);
 end
 
-if edgeStruct.useMex
-    samples = UGM_Sample_GibbsC(nodePot,edgePot,int32(edgeStruct.edgeEnds),int32(edgeStruct.nStates),int32(edgeStruct.V),int32(edgeStruct.E),edgeStruct.maxIter,burnIn,int32(y));
+if edgeStruct.useMex && exist('UGM_Sample_GibbsC','file') == 3
+    samples = UGM_Sample_GibbsC(nodePot,edgePot,int32(edgeStruct.edgeEnds),int32(edgeStruct.nStates),int32(edgeStruct.V),int32(edgeStruct.E),edgeStruct.maxIter,burnIn,int32(y),thin,floor(rand*2^32));
 else
-    samples = Sample_Gibbs(nodePot,edgePot,edgeStruct,burnIn,y);
+    samples = zeros(size(nodePot,1),edgeStruct.maxIter,size(y,2));
+    for c = 1:size(y,2)
+        samples(:,:,c) = Sample_Gibbs(nodePot,edgePot,edgeStruct,burnIn,y(:,c),thin);
+    end
 end
 
 end
 
-function [samples] = Sample_Gibbs(nodePot,edgePot,edgeStruct,burnIn,y)
+function [samples] = Sample_Gibbs(nodePot,edgePot,edgeStruct,burnIn,y,thin)
 [nNodes,maxStates] = size(nodePot);
 nEdges = size(edgePot,3);
 edgeEnds = edgeStruct.edgeEnds;
@@ -25,7 +44,7 @@ maxIter = edgeStruct.maxIter;
 
 samples = zeros(nNodes,0);
 
-for i = 1:burnIn+maxIter
+for i = 1:burnIn+maxIter*thin
     for n = 1:nNodes
 
         % Compute Node Potential
@@ -51,8 +70,8 @@ for i = 1:burnIn+maxIter
         y(n) = sampleDiscrete(pot./sum(pot));
     end
     
-    if i > burnIn
-        samples(:,i-burnIn) = y;
+    if i > burnIn && mod(i-burnIn,thin) == 0
+        samples(:,(i-burnIn)/thin) = y;
     end
 end
 end
\ No newline at end of file
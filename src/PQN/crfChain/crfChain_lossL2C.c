@@ -1,356 +1,317 @@
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /* See crfChain_loss.m for details! */
 /* This function may not exit gracefully on bad input! */
-#define submat_value(mat, i, j) mat.value_start[((i)-1) + ((j)-1)*mat.numRows]
-#define submat_pointer(mat, i, j) &submat_value(mat, i, j)
-#define submat_value3(mat, i, j, k) mat.value_start[((i)-1) + mat.numRows*(((j)-1) + ((k)-1)*mat.numColumns)]
-#define submat_pointer3(mat, i, j, k) &submat_value(mat, i, j, k)
 
-typedef struct SubMatrixType
+/* [nll,g] = crfChain_lossL2C(wv,X,y,nStates,nFeatures,featureStart,sentences,maxSentenceLength,lambda)
+ *
+ * Sentences are processed in parallel, each thread accumulating its own
+ * objective and gradient; they are summed in thread order at the end.
+ * Forward-backward runs in the log domain: alpha and beta are stored as
+ * logs and each step multiplies exp(alpha - max(alpha)) with the (scaled)
+ * transition potentials, so there are only O(nStates) exp/log calls per
+ * word. The nonzero features of every word are gathered once into a list
+ * of parameter indices, and the node weights are used transposed (all
+ * states of a parameter next to each other). */
+
+/* log of sum_i exp(a[i]) */
+static double logSumExp(const double *a, int n)
 {
-    double *value_start;
-    unsigned int numRows;
-    unsigned int numColumns;
-    unsigned int numMatrices;
-} SubMatrix;
+    double m = a[0], z = 0;
+    int i;
+    for (i = 1; i < n; ++i) {
+        if (a[i] > m)
+            m = a[i];
+    }
+    if (m == -HUGE_VAL)
+        return m;
+    for (i = 0; i < n; ++i)
+        z += exp(a[i] - m);
+    return m + log(z);
+}
 
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 {
-    double *wv, *nFeatures, *np, *ep, *Z, lambda;
-    unsigned int nStates, nFeaturesTotal, maxSentenceLength;
-    SubMatrix w, v, v_start, v_end, gw, gv, gv_start, gv_end, sentences, y, X, featureStart;
+    double *wv, *X, *y, *featureStart, *sentences, *g, lambda;
+    int nStates, nFeaturesTotal, nFeatureTypes, nWords, nSentences, maxSentenceLength, nParams;
     double f = 0;
-    
+
     wv = mxGetPr(prhs[0]);
-    
-    X.value_start =  mxGetPr(prhs[1]);
-    X.numRows = mxGetM(prhs[1]);
-    X.numColumns = mxGetN(prhs[1]);
-    
-    y.value_start = mxGetPr(prhs[2]);
-    y.numRows = mxGetM(prhs[2]);
-    y.numColumns = mxGetN(prhs[2]);
-    
+    X = mxGetPr(prhs[1]);
+    nWords = mxGetM(prhs[1]);
+    y = mxGetPr(prhs[2]);
     nStates = mxGetScalar(prhs[3]);
-    nFeatures = mxGetPr(prhs[4]);
-    
-    featureStart.value_start = mxGetPr(prhs[5]);
-    featureStart.numRows = mxGetM(prhs[5]);
-    featureStart.numColumns = mxGetN(prhs[5]);
-    
-    sentences.value_start = mxGetPr(prhs[6]);
-    sentences.numRows = mxGetM(prhs[6]);
-    sentences.numColumns = mxGetN(prhs[6]);
-    
-    maxSentenceLength = mxGetScalar(prhs[7]);
-    
+    nFeatureTypes = mxGetN(prhs[4]);
+    featureStart = mxGetPr(prhs[5]);
+    sentences = mxGetPr(prhs[6]);
+    nSentences = mxGetM(prhs[6]);
     lambda = mxGetScalar(prhs[8]);
-    
+
     /*nFeaturesTotal = featureStart(end)-1;*/
-    nFeaturesTotal = submat_value(featureStart, 1, featureStart.numColumns) - 1;
-    int nSentences = mxGetM(prhs[6]);
-    
-    /*Set up the submatrices for node and edge parameters*/
-    w.value_start = wv;
-    w.numRows = nFeaturesTotal;
-    w.numColumns = nStates;
-    
-    v_start.value_start = wv + nFeaturesTotal*nStates;
-    v_start.numRows = nStates;
-    v_start.numColumns = 1;
-    
-    v_end.value_start = wv + nFeaturesTotal*nStates + nStates;
-    v_end.numRows = nStates;
-    v_end.numColumns = 1;
-    
-    v.value_start = wv + nFeaturesTotal*nStates + 2*nStates;
-    v.numRows = nStates;
-    v.numColumns = nStates;
-    
-    mxArray *g = mxCreateDoubleMatrix(mxGetM(prhs[0]),mxGetN(prhs[0]),mxREAL);
-    /*mxArray *g = prhs[7];*/
-    
-    gw.value_start = mxGetPr(g);
-    gw.numRows = nFeaturesTotal;
-    gw.numColumns = nStates;
-    
-    gv_start.value_start = mxGetPr(g) + nFeaturesTotal*nStates;
-    gv_start.numRows = nStates;
-    gv_start.numColumns = 1;
-    
-    gv_end.value_start = gv_start.value_start + nStates;
-    gv_end.numRows = nStates;
-    gv_end.numColumns = 1;
-    
-    gv.value_start = gv_end.value_start + nStates;
-    gv.numRows = nStates;
-    gv.numColumns = nStates;
-    
-    int i,j, s, n, k, feat, state, state1, state2;
-    SubMatrix nodePot, edgePot, nodeBel, edgeBel, alpha, beta;
-    nodePot.value_start = mxCalloc(maxSentenceLength*nStates,sizeof(double));
-    edgePot.value_start = mxCalloc(nStates*nStates,sizeof(double));
-        nodeBel.value_start = mxCalloc(maxSentenceLength*nStates,sizeof(double));
-        edgeBel.value_start = mxCalloc(nStates*nStates*(maxSentenceLength-1),sizeof(double));
-        alpha.value_start = mxCalloc(maxSentenceLength*nStates, sizeof(double));
-        beta.value_start  = mxCalloc(maxSentenceLength*nStates, sizeof(double));
-        Z = mxCalloc(maxSentenceLength,sizeof(double));
-    for (s = 1; s <= nSentences; ++s) {
-        int nNodes = submat_value(sentences, s, 2) - submat_value(sentences, s, 1) + 1;
-        
-        SubMatrix y_s;
-        y_s.value_start = submat_pointer(y, (long)submat_value(sentences, s, 1), 1);
-        y_s.numRows = submat_value(sentences, s, 2) - submat_value(sentences, s, 1) + 1;
-        y_s.numColumns = 1;
-        
-        /*******************************************************************************/
-        /* Make nodePot/edgePot */
-        
-        nodePot.numRows = nNodes;
-        nodePot.numColumns = nStates;
-        
-        edgePot.numRows = v.numRows;
-        edgePot.numColumns = v.numColumns;
-        
-        for (n = 1; n <= nNodes; ++n) {
-            double features[X.numColumns];
-            int k;
-            for (k = 1; k <= X.numColumns; ++k) {
-                features[k-1] = submat_value(X, (long)submat_value(sentences, s, 1)+(long)n-(long)1, (long)k);
-            }
-            
-            
-            int state;
-            for (state = 1; state <= nStates; ++state) {
-                double pot = 0;
-                int f;
-                for (f = 1; f <= mxGetN(prhs[4]); ++f) {
-                    if (features[f-1] != 0) {
-                        int featureParam = submat_value(featureStart, 1, f) + features[f-1] - 1;
-                        pot += w.value_start[featureParam+nFeaturesTotal*(state-1)-1];
-                    }
-                }
-                submat_value(nodePot, n, state) = pot;
-            }
-        }
-        
-        for (k = 1; k <= nodePot.numColumns; ++k) {
-            submat_value(nodePot, 1, k) += submat_value(v_start, k, 1);
-        }
-        
-        for (k = 1; k <= nodePot.numColumns; ++k) {
-            submat_value(nodePot, nodePot.numRows, k) += submat_value(v_end, k, 1);
-        }
-        
-        for (k = 0; k < nodePot.numRows*nodePot.numColumns; ++k) {
-            nodePot.value_start[k] = exp(nodePot.value_start[k]);
-        }
-        
-        for (k = 0; k < edgePot.numRows*edgePot.numColumns; ++k) {
-            edgePot.value_start[k] = exp(v.value_start[k]);
-        }
-        
-        
-            
-        /*******************************************************************************/
-        
-        /*******************************************************************************/
-        /* Infer */
-        
-        nodeBel.numRows = nodePot.numRows;
-        nodeBel.numColumns = nodePot.numColumns;
-        
-        edgeBel.numRows = nStates;
-        edgeBel.numColumns = nStates;
-        edgeBel.numMatrices = nNodes - 1;
-        
-        alpha.numRows = nNodes;
-        alpha.numColumns = nStates;
-        
-        beta.numRows = nNodes;
-        beta.numColumns = nStates;
-        for (n=0; n< nNodes*nStates;n++)
-            beta.value_start[n] = 0;
-        
-        for (n=0; n < nNodes;n++)
-        Z[n]=0;;
-        
-        for (i = 1; i <= alpha.numColumns; ++i) {
-            submat_value(alpha, 1, i) = submat_value(nodePot, 1, i);
-        }
-        
-        for (i = 1; i <= alpha.numColumns; ++i) {
-            Z[0] += submat_value(alpha, 1, i);
+    nFeaturesTotal = featureStart[mxGetN(prhs[5])-1] - 1;
+    nParams = nFeaturesTotal*nStates + 2*nStates + nStates*nStates;
+
+    /* Sentence lengths, maxSentenceLength is only a hint */
+    int s, n, i, j, k;
+    maxSentenceLength = 1;
+    for (s = 0; s < nSentences; ++s) {
+        n = sentences[s + nSentences] - sentences[s] + 1;
+        if (n > maxSentenceLength)
+            maxSentenceLength = n;
+    }
+
+    /* Parameter indices of the nonzero features of each word */
+    int *wordStart = mxCalloc(nWords+1, sizeof(int));
+    for (n = 0; n < nWords; ++n) {
+        wordStart[n+1] = wordStart[n];
+        for (k = 0; k < nFeatureTypes; ++k) {
+            if (X[n + nWords*k] != 0)
+                wordStart[n+1]++;
         }
-        
-        for (i = 1; i <= alpha.numColumns; ++i) {
-            submat_value(alpha, 1, i) /= Z[0];
+    }
+    int *wordParams = mxCalloc(wordStart[nWords]+1, sizeof(int));
+#pragma omp parallel for private(k) schedule(static)
+    for (n = 0; n < nWords; ++n) {
+        int *p = wordParams + wordStart[n];
+        for (k = 0; k < nFeatureTypes; ++k) {
+            if (X[n + nWords*k] != 0)
+                *p++ = featureStart[k] + X[n + nWords*k] - 2;
         }
-        
-        for (n = 2; n <= nNodes; ++n) {
-            double tmp[edgePot.numColumns];
-            for (i = 0; i < edgePot.numColumns; ++i) {
-                tmp[i] = 0;
-            }
-            for (i = 1; i <= alpha.numColumns; ++i) {
-                for (j = 1; j <= nStates; ++j) {
-                    tmp[j-1] += submat_value(alpha, n-1, i)*submat_value(edgePot, i, j);
+    }
+
+    /* Node weights transposed: wT[param*nStates + state] */
+    double *wT = mxCalloc((size_t)nFeaturesTotal*nStates+1, sizeof(double));
+#pragma omp parallel for private(k) schedule(static)
+    for (j = 0; j < nFeaturesTotal; ++j) {
+        for (k = 0; k < nStates; ++k)
+            wT[k + nStates*j] = wv[j + nFeaturesTotal*k];
+    }
+    const double *v_start = wv + nFeaturesTotal*nStates;
+    const double *v_end = v_start + nStates;
+    const double *v = v_end + nStates;
+
+    /* Transition potentials exp(v - vMax), so they cannot overflow */
+    double vMax = -HUGE_VAL;
+    for (k = 0; k < nStates*nStates; ++k) {
+        if (v[k] > vMax)
+            vMax = v[k];
+    }
+    double *edgePot = mxCalloc(nStates*nStates, sizeof(double));
+    for (k = 0; k < nStates*nStates; ++k)
+        edgePot[k] = exp(v[k] - vMax);
+
+    /* Gradient of the log-likelihood, node part transposed like wT */
+    double *gwT = mxCalloc((size_t)nFeaturesTotal*nStates+1, sizeof(double));
+    double *gvAll = mxCalloc(2*nStates + nStates*nStates, sizeof(double));
+
+    /* Work space of the threads, one slice per thread */
+    int nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    size_t nGwT = (size_t)nFeaturesTotal*nStates + 1, nGv = 2*nStates + nStates*nStates;
+    size_t nWork = 3*(size_t)maxSentenceLength*nStates + 3*nStates;
+    double *gwTAll = mxCalloc(nThreads*nGwT, sizeof(double));
+    double *gvThreads = mxCalloc(nThreads*nGv, sizeof(double));
+    double *workAll = mxMalloc(nThreads*nWork*sizeof(double));
+    double *fAll = mxCalloc(nThreads, sizeof(double));
+    size_t q;
+    int t;
+
+#pragma omp parallel num_threads(nThreads) private(s, n, i, j, k, t)
+    {
+        int S = nStates, L = maxSentenceLength;
+        double myF = 0;
+        t = 0;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        double *myGwT = gwTAll + t*nGwT;
+        double *myGv = gvThreads + t*nGv;
+        double *myGv_start = myGv, *myGv_end = myGv + S, *myGvTrans = myGv + 2*S;
+        double *logNodePot = workAll + t*nWork;
+        double *alpha = logNodePot + (size_t)L*S;
+        double *beta = alpha + (size_t)L*S;
+        double *a = beta + (size_t)L*S;
+        double *b = a + S;
+        double *tmp = b + S;
+
+#pragma omp for schedule(static)
+        for (s = 0; s < nSentences; ++s) {
+            int first = sentences[s] - 1;
+            int nNodes = sentences[s + nSentences] - sentences[s] + 1;
+            const double *y_s = y + first;
+            double logZ, m, mb, sum;
+
+            /*******************************************************************************/
+            /* Make log nodePot */
+            for (n = 0; n < nNodes; ++n) {
+                double *lnp = logNodePot + S*n;
+                for (k = 0; k < S; ++k)
+                    lnp[k] = 0;
+                for (j = wordStart[first+n]; j < wordStart[first+n+1]; ++j) {
+                    const double *wp = wT + (size_t)S*wordParams[j];
+                    for (k = 0; k < S; ++k)
+                        lnp[k] += wp[k];
                 }
             }
-            
-            for (i = 1; i <= alpha.numColumns; ++i) {
-                submat_value(alpha, n, i) = submat_value(nodePot, n, i)*tmp[i-1];
-            }
-            
-            for (i = 1; i <= alpha.numColumns; ++i) {
-                Z[n-1] += submat_value(alpha, n, i);
+            for (k = 0; k < S; ++k) {
+                logNodePot[k] += v_start[k];
+                logNodePot[S*(nNodes-1) + k] += v_end[k];
             }
-            
-            for (i = 1; i <= alpha.numColumns; ++i) {
-                submat_value(alpha, n, i) /= Z[n-1];
-            }
-        }
-        
-        for (i = 1; i<= nStates; ++i) {
-            submat_value(beta, nNodes, i) = 1;
-        }
-        
-        for (n = nNodes - 1; n >= 1; --n) {
-            for (j = 1; j <= nodePot.numColumns; ++j) {
-                for (i = 1; i <= nStates; ++i) {
-                    submat_value(beta, n, i) += submat_value(nodePot, n+1, j)*submat_value(edgePot, i, j)*submat_value(beta, n+1, j);
+
+            /*******************************************************************************/
+            /* Infer */
+
+            /* alpha(n,j) = lnp(n,j) + log sum_i exp(alpha(n-1,i) + v(i,j)) */
+            for (k = 0; k < S; ++k)
+                alpha[k] = logNodePot[k];
+            for (n = 1; n < nNodes; ++n) {
+                const double *ap = alpha + S*(n-1);
+                m = ap[0];
+                for (i = 1; i < S; ++i) {
+                    if (ap[i] > m)
+                        m = ap[i];
                 }
-            }
-            
-            double tmp = 0;
-            for (i = 1; i <= beta.numColumns; ++i) {
-                tmp += submat_value(beta, n, i);
-            }
-            for (i = 1; i <= beta.numColumns; ++i) {
-                submat_value(beta, n, i) /= tmp;
-            }
-        }
-        
-        for (n = 1; n <= nNodes; ++n) {
-            double tmp[alpha.numColumns];
-            for (i = 0; i < alpha.numColumns; ++i) {
-                tmp[i] = 0;
-            }
-            
-            double sumTmp = 0;
-            for (i = 1; i <= alpha.numColumns; ++i) {
-                tmp[i-1] += submat_value(alpha, n, i)*submat_value(beta, n, i);
-                sumTmp += tmp[i-1];
-            }
-            
-            for (i = 1; i <= alpha.numColumns; ++i) {
-                submat_value(nodeBel, n, i) = tmp[i-1]/sumTmp;
-            }
-        }
-        
-        for (n = 1; n <= nNodes-1; ++n) {
-            double sum = 0;
-            for (i = 1; i <= nStates; ++i) {
-                for (j = 1; j <= nStates; ++j) {
-                    submat_value3(edgeBel, i, j, n) = submat_value(alpha, n, i)*submat_value(nodePot, n+1, j)*submat_value(beta, n+1, j)*submat_value(edgePot, i, j);
-                    sum += submat_value3(edgeBel, i, j, n);
+                for (i = 0; i < S; ++i)
+                    a[i] = exp(ap[i] - m);
+                for (j = 0; j < S; ++j)
+                    tmp[j] = 0;
+                for (j = 0; j < S; ++j) {
+                    const double *ep = edgePot + S*j;
+                    for (i = 0; i < S; ++i)
+                        tmp[j] += a[i]*ep[i];
                 }
+                for (j = 0; j < S; ++j)
+                    alpha[S*n + j] = logNodePot[S*n + j] + m + vMax + log(tmp[j]);
             }
-            
-            for (i = 1; i <= nStates; ++i) {
-                for (j = 1; j <= nStates; ++j) {
-                    submat_value3(edgeBel, i, j, n) /= sum;
+            logZ = logSumExp(alpha + S*(nNodes-1), S);
+
+            /* beta(n,i) = log sum_j exp(v(i,j) + lnp(n+1,j) + beta(n+1,j)) */
+            for (k = 0; k < S; ++k)
+                beta[S*(nNodes-1) + k] = 0;
+            for (n = nNodes-2; n >= 0; --n) {
+                const double *bp = beta + S*(n+1), *lnp = logNodePot + S*(n+1);
+                m = bp[0] + lnp[0];
+                for (j = 1; j < S; ++j) {
+                    if (bp[j] + lnp[j] > m)
+                        m = bp[j] + lnp[j];
                 }
+                for (j = 0; j < S; ++j)
+                    b[j] = exp(bp[j] + lnp[j] - m);
+                for (i = 0; i < S; ++i)
+                    tmp[i] = 0;
+                for (j = 0; j < S; ++j) {
+                    const double *ep = edgePot + S*j;
+                    for (i = 0; i < S; ++i)
+                        tmp[i] += ep[i]*b[j];
+                }
+                for (i = 0; i < S; ++i)
+                    beta[S*n + i] = m + vMax + log(tmp[i]);
             }
-        }
-        
-        double logZ = 0;
-        
-        for (i = 0; i < nNodes; ++i) {
-            logZ += log(Z[i]);
-        }
-        
-        /*******************************************************************************/
-        
-        for (n = 1; n <= nNodes; ++n) {
-            f += log(submat_value(nodePot, n, (long)submat_value(y_s, n, 1)));
-        }
-        
-        for (n = 1; n <= nNodes - 1; ++n) {
-            f += log(submat_value(edgePot, (long)submat_value(y_s, n, 1), (long)submat_value(y_s, n+1, 1)));
-        }
-        
-        f -= logZ;
-        
-        /*Update gradient of node features*/
-        for (n = 1; n <= nNodes; ++n) {
-            double features[X.numColumns];
-            int k;
-            for (k = 1; k <= X.numColumns; ++k) {
-                features[k-1] = submat_value(X, (long)submat_value(sentences, s, 1)+(long)n-(long)1, (long)k);
-            }
-            
-            for (feat = 1; feat <= mxGetN(prhs[4]); ++feat) {
-                if (features[feat-1] != 0) {
-                    int featureParam = submat_value(featureStart, 1, feat) + features[feat-1] - 1;
-                    for (state = 1; state <= nStates; ++state) {
-                        int O = (state == submat_value(y_s, n, 1));
-                        double E = submat_value(nodeBel, n, state);
-                        submat_value(gw, featureParam, state) += O - E;
-                    }
+
+            /*******************************************************************************/
+
+            /* Log-potential of the training labels minus logZ */
+            for (n = 0; n < nNodes; ++n)
+                myF += logNodePot[S*n + (int)y_s[n] - 1];
+            for (n = 0; n < nNodes-1; ++n)
+                myF += v[(int)y_s[n] - 1 + S*((int)y_s[n+1] - 1)];
+            myF -= logZ;
+
+            /* Update gradient of node features with O - E, E = nodeBel */
+            for (n = 0; n < nNodes; ++n) {
+                for (k = 0; k < S; ++k)
+                    tmp[k] = (k == (int)y_s[n] - 1) - exp(alpha[S*n + k] + beta[S*n + k] - logZ);
+                for (j = wordStart[first+n]; j < wordStart[first+n+1]; ++j) {
+                    double *gp = myGwT + (size_t)S*wordParams[j];
+                    for (k = 0; k < S; ++k)
+                        gp[k] += tmp[k];
+                }
+                if (n == 0) {
+                    for (k = 0; k < S; ++k)
+                        myGv_start[k] += tmp[k];
+                }
+                if (n == nNodes-1) {
+                    for (k = 0; k < S; ++k)
+                        myGv_end[k] += tmp[k];
                 }
             }
-        }
-        
-        /*Update gradient of BoS and EoS transitions*/
-        for (state = 1; state <= nStates; ++state) {
-            int O = (state == submat_value(y_s, 1, 1));
-            double E = submat_value(nodeBel, 1, state);
-            submat_value(gv_start, state, 1) += O - E;
-            
-            O = (state == submat_value(y_s, y_s.numRows, 1));
-            E = submat_value(nodeBel, nodeBel.numRows, state);
-            submat_value(gv_end, state, 1) += O - E;
-        }
-        
-        /*GOOD TO HERE*/
-        /*Update gradient of transitions*/
-        for (n = 1; n <= nNodes - 1; ++n) {
-            for (state1 = 1; state1 <= nStates; ++state1) {
-                for (state2 = 1; state2 <= nStates; ++state2) {
-                    int O = ((state1 == submat_value(y_s, n, 1)) && (state2 == submat_value(y_s, n+1, 1)));
-                    double E = edgeBel.value_start[(state1-1) + edgeBel.numRows*((state2-1) + edgeBel.numColumns*(n-1))];
-                    submat_value(gv, state1, state2) += O - E;
+
+            /* Update gradient of transitions, edgeBel(i,j) =
+               exp(alpha(n,i) + v(i,j) + lnp(n+1,j) + beta(n+1,j) - logZ) */
+            for (n = 0; n < nNodes-1; ++n) {
+                const double *ap = alpha + S*n, *bp = beta + S*(n+1), *lnp = logNodePot + S*(n+1);
+                m = ap[0];
+                for (i = 1; i < S; ++i) {
+                    if (ap[i] > m)
+                        m = ap[i];
+                }
+                mb = bp[0] + lnp[0];
+                for (j = 1; j < S; ++j) {
+                    if (bp[j] + lnp[j] > mb)
+                        mb = bp[j] + lnp[j];
+                }
+                sum = exp(m + mb + vMax - logZ);
+                for (i = 0; i < S; ++i)
+                    a[i] = exp(ap[i] - m)*sum;
+                for (j = 0; j < S; ++j)
+                    b[j] = exp(bp[j] + lnp[j] - mb);
+                for (j = 0; j < S; ++j) {
+                    const double *ep = edgePot + S*j;
+                    double *gp = myGvTrans + S*j;
+                    for (i = 0; i < S; ++i)
+                        gp[i] -= a[i]*ep[i]*b[j];
                 }
+                myGvTrans[(int)y_s[n] - 1 + S*((int)y_s[n+1] - 1)] += 1;
             }
         }
+
+        fAll[t] = myF;
+    }
+
+    /* Sum the objectives and gradients of the threads in a fixed order */
+    for (t = 0; t < nThreads; ++t) {
+        f += fAll[t];
+        for (q = 0; q < (size_t)nFeaturesTotal*nStates; ++q)
+            gwT[q] += gwTAll[q + t*nGwT];
+        for (q = 0; q < nGv; ++q)
+            gvAll[q] += gvThreads[q + t*nGv];
     }
-    double* temp = mxGetPr(g);
-    for (n = 1; n <= mxGetM(g); ++n) {
-        *temp *= -1;
-        temp += 1;
+    mxFree(gwTAll);
+    mxFree(gvThreads);
+    mxFree(workAll);
+    mxFree(fAll);
+
+    /* Negate, untranspose and add the L2-penalty to Objective and Gradient */
+    plhs[1] = mxCreateDoubleMatrix(mxGetM(prhs[0]),mxGetN(prhs[0]),mxREAL);
+    g = mxGetPr(plhs[1]);
+    for (j = 0; j < nFeaturesTotal; ++j) {
+        for (k = 0; k < nStates; ++k)
+            g[j + nFeaturesTotal*k] = -gwT[k + nStates*j];
     }
-    
-    /* Add L2-penalty to Objective and Gradient*/
+    for (k = 0; k < 2*nStates + nStates*nStates; ++k)
+        g[nFeaturesTotal*nStates + k] = -gvAll[k];
+
     double sumSquared = 0;
-    temp = mxGetPr(g);
-    for(i = 0; i < nFeaturesTotal*nStates + 2*nStates + nStates*nStates;i++)
-    {
+    for (i = 0; i < nParams; i++) {
         sumSquared += wv[i]*wv[i];
-        temp[i] += lambda*wv[i];
+        g[i] += lambda*wv[i];
     }
     f = f - (lambda/2)*sumSquared;
-    
+
     plhs[0] = mxCreateDoubleScalar(-f);
-    plhs[1] = g;
-    
-        mxFree(nodePot.value_start);
-        mxFree(edgePot.value_start);
-        mxFree(nodeBel.value_start);
-        mxFree(edgeBel.value_start);
-        mxFree(alpha.value_start);
-        mxFree(beta.value_start);
-        mxFree(Z);
+
+    mxFree(wordStart);
+    mxFree(wordParams);
+    mxFree(wT);
+    mxFree(edgePot);
+    mxFree(gwT);
+    mxFree(gvAll);
 }
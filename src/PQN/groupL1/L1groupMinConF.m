@@ -37,9 +37,19 @@ if normType == 2
             [wAlpha,f,fEvals] = minConF_Pen(wrapFunObj,wAlpha,funCon,options);
         case 'spg'
             [groupStart,groupPtr] = groupl1_makeGroupPointers(groups);
-            funProj = @(w)auxGroupL2Project(w,nVars,groupStart,groupPtr);
-            %funProj = @(w)auxGroupL2Proj(w,groups);
-            wAlpha = minConF_SPG(wrapFunObj,wAlpha,funProj,options);
+            [numDiff,curvilinear] = myProcessOptions(options,'numDiff',0,'curvilinear',0);
+            if exist('L1groupSPGC') == 3 && ~numDiff && ~curvilinear
+                % Compiled SPG with the projection fused into the step
+                [verbose,maxIter,suffDec,interp,memory,useSpectral,feasibleInit,testOpt,bbType] = ...
+                    myProcessOptions(options,'verbose',2,'maxIter',500,'suffDec',1e-4,'interp',2,...
+                    'memory',10,'useSpectral',1,'feasibleInit',0,'testOpt',1,'bbType',1);
+                params = [verbose optTol maxIter suffDec interp memory useSpectral feasibleInit testOpt bbType];
+                [wAlpha,f] = L1groupSPGC(funObj,wAlpha,groupStart,groupPtr,lambda,params);
+            else
+                funProj = @(w)auxGroupL2Project(w,nVars,groupStart,groupPtr);
+                %funProj = @(w)auxGroupL2Proj(w,groups);
+                wAlpha = minConF_SPG(wrapFunObj,wAlpha,funProj,options);
+            end
         case 'sop'
             [groupStart,groupPtr] = groupl1_makeGroupPointers(groups);
             funProj = @(w)auxGroupL2Project(w,nVars,groupStart,groupPtr);
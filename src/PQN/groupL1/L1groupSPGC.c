@@ -0,0 +1,416 @@
+/* L1groupSPGC.c
+
+   [wAlpha,f,funEvals,projects] = L1groupSPGC(funObj,wAlpha,groupStart,groupPtr,lambda,params)
+
+   minConF_SPG applied to the auxiliary variable formulation of the
+   group-L1 problem used by L1groupMinConF (normType 2, mode 'spg'):
+      min funObj(w) + sum(lambda.*alpha)  s.t.  norm(w(group g)) <= alpha(g)
+   where wAlpha = [w;alpha]. funObj is the loss alone (a function handle,
+   called through feval with w); the alpha part of the objective and
+   gradient (auxGroupLoss.m) is added here.
+
+   groupStart/groupPtr (int32) come from groupl1_makeGroupPointers,
+   lambda is a scalar or has one entry per group. params is
+      [verbose optTol maxIter suffDec interp memory useSpectral
+       feasibleInit testOpt bbType]
+   with the meaning and defaults of minConF_SPG (curvilinear steps and
+   numerical derivatives are not supported). interp 1 always uses
+   quadratic interpolation, interp 2 uses the cubic on the function
+   values and directional derivatives and falls back to the quadratic.
+
+   The spectral step, the projection of x - alpha*g and the search
+   direction are done in one pass over the groups (auxGroupL2Project.m),
+   split over the threads.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Use threads for the projections above this number of groups */
+#define PARALLEL_GROUPS 256
+
+
+typedef struct
+{  const int    *groupStart, *groupPtr;
+   const double *lambda;
+   int           nVars, nGroups, nLambda;
+} Groups;
+
+
+/* ----------------------------------------------------------------------- */
+static int isLegal(double v)
+/* ----------------------------------------------------------------------- */
+{  return !mxIsNaN(v) && !mxIsInf(v);
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double projectStep(const Groups *G, const double *x, const double *g,
+                          double alpha, double *d)
+/* ----------------------------------------------------------------------- */
+/* d = P(x - alpha*g) - x, P is the projection onto norm(w(g)) <= alpha(g)
+   of every group (ungrouped variables are free). Returns sum(abs(d)). */
+{  int    t, nThreads = 1, nVars = G->nVars;
+   double sumAbs = 0, *partial;
+
+   /* One partial sum per thread, added in thread order */
+#ifdef _OPENMP
+   if (nVars > 16*PARALLEL_GROUPS || G->nGroups > PARALLEL_GROUPS)
+      nThreads = omp_get_max_threads();
+#endif
+   partial = mxCalloc(nThreads, sizeof(double));
+
+   #pragma omp parallel num_threads(nThreads) private(t)
+   {  int    i, j;
+      double s = 0;
+
+      #pragma omp for schedule(static)
+      for (j = 0; j < nVars; j++)
+      {  d[j] = -alpha * g[j];
+         s += fabs(d[j]);
+      }
+
+      #pragma omp for schedule(static)
+      for (i = 0; i < G->nGroups; i++)
+      {  int    k, k0 = G->groupStart[i] - 1, k1 = G->groupStart[i+1] - 1;
+         double nw = 0, a, avg, scale;
+
+         /* Norm of the group after the gradient step */
+         for (k = k0; k < k1; k++)
+         {  j = G->groupPtr[k] - 1;
+            nw += (x[j] + d[j]) * (x[j] + d[j]);
+         }
+         nw = sqrt(nw);
+         a = x[nVars+i] - alpha * g[nVars+i];
+
+         /* projectAux of auxGroupL2Project.m */
+         scale = 1;
+         if (nw > a)
+         {  avg = (nw + a) / 2;
+            if (avg < 0) { scale = 0; a = 0; }
+            else         { scale = avg / nw; a = avg; }
+         }
+         for (k = k0; k < k1; k++)
+         {  j = G->groupPtr[k] - 1;
+            s -= fabs(d[j]);
+            d[j] = (x[j] + d[j]) * scale - x[j];
+            s += fabs(d[j]);
+         }
+         d[nVars+i] = a - x[nVars+i];
+         s += fabs(d[nVars+i]);
+      }
+
+      t = 0;
+#ifdef _OPENMP
+      t = omp_get_thread_num();
+#endif
+      partial[t] = s;
+   }
+
+   for (t = 0; t < nThreads; t++)
+      sumAbs += partial[t];
+   mxFree(partial);
+   return sumAbs;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double evaluate(const mxArray *funObj, const Groups *G, const double *x, double *g)
+/* ----------------------------------------------------------------------- */
+/* f = funObj(w) + sum(lambda.*alpha), g = [gradient of funObj; lambda] */
+{  mxArray *rhs[2], *lhs[2];
+   double   f;
+   int      i;
+
+   rhs[0] = (mxArray *)funObj;
+   rhs[1] = mxCreateDoubleMatrix(G->nVars, 1, mxREAL);
+   memcpy(mxGetPr(rhs[1]), x, sizeof(double) * G->nVars);
+   mexCallMATLAB(2, lhs, 2, rhs, "feval");
+   mxDestroyArray(rhs[1]);
+
+   if (mxGetNumberOfElements(lhs[1]) != (mwSize)G->nVars)
+      mexErrMsgTxt("funObj must return a gradient with one entry per variable");
+   f = mxGetScalar(lhs[0]);
+   memcpy(g, mxGetPr(lhs[1]), sizeof(double) * G->nVars);
+   mxDestroyArray(lhs[0]);
+   mxDestroyArray(lhs[1]);
+
+   for (i = 0; i < G->nGroups; i++)
+   {  double l = G->lambda[G->nLambda > 1 ? i : 0];
+      f += l * x[G->nVars+i];
+      g[G->nVars+i] = l;
+   }
+   return f;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double dot(const double *a, const double *b, int n)
+/* ----------------------------------------------------------------------- */
+{  double s = 0;
+   int    i;
+
+   for (i = 0; i < n; i++) s += a[i] * b[i];
+   return s;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double interpolate(double f, double gtd, double t, double fNew, double gtdNew, int cubic)
+/* ----------------------------------------------------------------------- */
+/* Minimizer on [0,t] of the cubic through (0,f,gtd),(t,fNew,gtdNew) as in
+   polyinterp, or of the quadratic through (0,f,gtd),(t,fNew) */
+{  double d1, d2, s;
+
+   if (cubic)
+   {  d1 = gtd + gtdNew - 3 * (f - fNew) / (0 - t);
+      d2 = d1 * d1 - gtd * gtdNew;
+      if (d2 < 0) return t / 2;
+      d2 = sqrt(d2);
+      s = t - t * ((gtdNew + d2 - d1) / (gtdNew - gtd + 2 * d2));
+   }
+   else
+   {  d1 = fNew - f - gtd * t;
+      if (d1 <= 0) return t / 2;
+      s = -gtd * t * t / (2 * d1);
+   }
+   if (!isLegal(s)) return t / 2;
+   return (s < 0) ? 0 : (s > t ? t : s);
+}
+
+
+/* ----------------------------------------------------------------------- */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+/* ----------------------------------------------------------------------- */
+{  Groups         G;
+   const mxArray *funObj;
+   const double  *params;
+   double         optTol, suffDec, f, fOld, fNew, fRef, gtd, t, temp, alpha,
+                  optCond = 0, sumAbsD, *x, *xOld, *xNew, *g, *gOld, *gNew, *d, *oldF;
+   int            verbose, maxIter, interp, memory, useSpectral, feasibleInit, testOpt,
+                  bbType, nTotal, funEvals, projects, iter, lineSearchIters, j, nParams;
+
+   if (nrhs < 5)
+      mexErrMsgTxt("Usage: [wAlpha,f,funEvals,projects] = L1groupSPGC(funObj,wAlpha,groupStart,groupPtr,lambda[,params])");
+   if (mxGetClassID(prhs[2]) != mxINT32_CLASS || mxGetClassID(prhs[3]) != mxINT32_CLASS)
+      mexErrMsgTxt("groupStart and groupPtr must be int32 (groupl1_makeGroupPointers)");
+
+   /* Extract parameters */
+   funObj       = prhs[0];
+   nTotal       = mxGetNumberOfElements(prhs[1]);
+   G.groupStart = (int *)mxGetData(prhs[2]);
+   G.groupPtr   = (int *)mxGetData(prhs[3]);
+   G.nGroups    = mxGetNumberOfElements(prhs[2]) - 1;
+   G.nVars      = nTotal - G.nGroups;
+   G.lambda     = mxGetPr(prhs[4]);
+   G.nLambda    = mxGetNumberOfElements(prhs[4]);
+   if (G.nGroups < 0 || G.nVars < 0 || (G.nLambda != 1 && G.nLambda != G.nGroups))
+      mexErrMsgTxt("wAlpha must be [w;alpha] and lambda a scalar or one value per group");
+
+   params  = (nrhs > 5) ? mxGetPr(prhs[5]) : NULL;
+   nParams = (nrhs > 5) ? mxGetNumberOfElements(prhs[5]) : 0;
+   verbose      = nParams > 0 ? (int)params[0] : 2;
+   optTol       = nParams > 1 ? params[1] : 1e-6;
+   maxIter      = nParams > 2 ? (int)params[2] : 500;
+   suffDec      = nParams > 3 ? params[3] : 1e-4;
+   interp       = nParams > 4 ? (int)params[4] : 2;
+   memory       = nParams > 5 ? (int)params[5] : 10;
+   useSpectral  = nParams > 6 ? (int)params[6] : 1;
+   feasibleInit = nParams > 7 ? (int)params[7] : 0;
+   testOpt      = nParams > 8 ? (int)params[8] : 1;
+   bbType       = nParams > 9 ? (int)params[9] : 1;
+   if (memory < 1) memory = 1;
+
+   plhs[0] = mxCreateDoubleMatrix(nTotal, 1, mxREAL);
+   x = mxGetPr(plhs[0]);
+   memcpy(x, mxGetPr(prhs[1]), sizeof(double) * nTotal);
+
+   xOld = mxCalloc(nTotal + 1, sizeof(double));
+   xNew = mxCalloc(nTotal + 1, sizeof(double));
+   g    = mxCalloc(nTotal + 1, sizeof(double));
+   gOld = mxCalloc(nTotal + 1, sizeof(double));
+   gNew = mxCalloc(nTotal + 1, sizeof(double));
+   d    = mxCalloc(nTotal + 1, sizeof(double));
+   oldF = mxCalloc(memory, sizeof(double));
+
+   /* Output Log */
+   if (verbose >= 2)
+   {  if (testOpt)
+         mexPrintf("%10s %10s %10s %15s %15s %15s\n","Iteration","FunEvals","Projections","Step Length","Function Val","Opt Cond");
+      else
+         mexPrintf("%10s %10s %10s %15s %15s\n","Iteration","FunEvals","Projections","Step Length","Function Val");
+   }
+
+   /* Evaluate Initial Point */
+   if (!feasibleInit)
+   {  memset(gNew, 0, sizeof(double) * nTotal);
+      projectStep(&G, x, gNew, 0, d);
+      for (j = 0; j < nTotal; j++) x[j] += d[j];
+   }
+   f = evaluate(funObj, &G, x, g);
+   projects = 1;
+   funEvals = 1;
+
+   /* Optionally check optimality */
+   iter = 1;
+   if (testOpt)
+   {  projects++;
+      if (projectStep(&G, x, g, 1, d) < optTol)
+      {  if (verbose >= 1)
+            mexPrintf("First-Order Optimality Conditions Below optTol at Initial Point\n");
+         iter = 0;
+      }
+   }
+
+   while (iter > 0 && funEvals <= maxIter)
+   {  /* Compute Step Direction */
+      if (iter == 1 || !useSpectral)
+         alpha = 1;
+      else
+      {  double sy = 0, ss = 0, yy = 0;
+         for (j = 0; j < nTotal; j++)
+         {  double s = x[j] - xOld[j], y = g[j] - gOld[j];
+            sy += s * y; ss += s * s; yy += y * y;
+         }
+         alpha = (bbType == 1) ? ss / sy : sy / yy;
+         if (!(alpha > 1e-10 && alpha <= 1e10))
+            alpha = 1;
+      }
+      fOld = f;
+      memcpy(xOld, x, sizeof(double) * nTotal);
+      memcpy(gOld, g, sizeof(double) * nTotal);
+
+      /* Compute Projected Step */
+      sumAbsD = projectStep(&G, x, g, alpha, d);
+      projects++;
+
+      /* Check that Progress can be made along the direction */
+      gtd = dot(g, d, nTotal);
+      if (gtd > -optTol)
+      {  if (verbose >= 1)
+            mexPrintf("Directional Derivative below optTol\n");
+         break;
+      }
+
+      /* Select Initial Guess to step length */
+      if (iter == 1)
+      {  double sumAbsG = 0;
+         for (j = 0; j < nTotal; j++) sumAbsG += fabs(g[j]);
+         t = (1 < 1 / sumAbsG) ? 1 : 1 / sumAbsG;
+      }
+      else
+         t = 1;
+
+      /* Compute reference function for non-monotone condition */
+      if (iter <= memory)
+      {  if (iter == 1)
+            for (j = 0; j < memory; j++) oldF[j] = -HUGE_VAL;
+         oldF[iter-1] = f;
+      }
+      else
+      {  memmove(oldF, oldF + 1, sizeof(double) * (memory - 1));
+         oldF[memory-1] = f;
+      }
+      fRef = oldF[0];
+      for (j = 1; j < memory; j++)
+         if (oldF[j] > fRef) fRef = oldF[j];
+
+      /* Evaluate the Objective and Gradient at the Initial Step */
+      for (j = 0; j < nTotal; j++) xNew[j] = x[j] + t * d[j];
+      fNew = evaluate(funObj, &G, xNew, gNew);
+      funEvals++;
+
+      /* Backtracking Line Search */
+      lineSearchIters = 1;
+      while (fNew > fRef + suffDec * t * gtd || !isLegal(fNew))
+      {  temp = t;
+         if (interp == 0 || !isLegal(fNew))
+            t = t / 2;
+         else
+         {  double gtdNew = dot(gNew, d, nTotal);
+            t = interpolate(f, gtd, t, fNew, gtdNew, interp == 2 && isLegal(gtdNew));
+         }
+
+         /* Adjust if change is too small */
+         if (t < temp * 1e-3)
+            t = temp * 1e-3;
+         else if (t > temp * 0.6)
+            t = temp * 0.6;
+
+         /* Check whether step has become too small */
+         if (t * sumAbsD < optTol || t == 0)
+         {  if (verbose == 3)
+               mexPrintf("Line Search failed\n");
+            t = 0;
+            fNew = f;
+            memcpy(xNew, x, sizeof(double) * nTotal);
+            memcpy(gNew, g, sizeof(double) * nTotal);
+            break;
+         }
+
+         /* Evaluate New Point */
+         for (j = 0; j < nTotal; j++) xNew[j] = x[j] + t * d[j];
+         fNew = evaluate(funObj, &G, xNew, gNew);
+         funEvals++;
+         lineSearchIters++;
+      }
+
+      /* Take Step */
+      memcpy(x, xNew, sizeof(double) * nTotal);
+      memcpy(g, gNew, sizeof(double) * nTotal);
+      f = fNew;
+
+      if (testOpt)
+      {  optCond = projectStep(&G, x, g, 1, d);
+         projects++;
+      }
+
+      /* Output Log */
+      if (verbose >= 2)
+      {  if (testOpt)
+            mexPrintf("%10d %10d %10d %15.5e %15.5e %15.5e\n",iter,funEvals,projects,t,f,optCond);
+         else
+            mexPrintf("%10d %10d %10d %15.5e %15.5e\n",iter,funEvals,projects,t,f);
+      }
+
+      /* Check optimality */
+      if (testOpt && optCond < optTol)
+      {  if (verbose >= 1)
+            mexPrintf("First-Order Optimality Conditions Below optTol\n");
+         break;
+      }
+      if (t * sumAbsD < optTol)
+      {  if (verbose >= 1)
+            mexPrintf("Step size below optTol\n");
+         break;
+      }
+      if (fabs(f - fOld) < optTol)
+      {  if (verbose >= 1)
+            mexPrintf("Function value changing by less than optTol\n");
+         break;
+      }
+      if (funEvals > maxIter)
+      {  if (verbose >= 1)
+            mexPrintf("Function Evaluations exceeds maxIter\n");
+         break;
+      }
+      iter++;
+   }
+
+   if (nlhs > 1) plhs[1] = mxCreateDoubleScalar(f);
+   if (nlhs > 2) plhs[2] = mxCreateDoubleScalar(funEvals);
+   if (nlhs > 3) plhs[3] = mxCreateDoubleScalar(projects);
+
+   mxFree(xOld);
+   mxFree(xNew);
+   mxFree(g);
+   mxFree(gOld);
+   mxFree(gNew);
+   mxFree(d);
+   mxFree(oldF);
+}
@@ -5,6 +5,16 @@ function [nll,g,H,T] = LogisticLoss(w,X,y)
 
 [n,p] = size(X);
 
+if nargout <= 2 && exist('linearLossC') == 3 && ~issparse(X) && isreal(X) && isa(X,'double') && isreal(w)
+    % Fused compiled version
+    if nargout > 1
+        [nll,g] = linearLossC('logistic',w,X,double(y));
+    else
+        nll = linearLossC('logistic',w,X,double(y));
+    end
+    return;
+end
+
 Xw = X*w;
 yXw = y.*Xw;
 
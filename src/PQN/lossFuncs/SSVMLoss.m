@@ -5,6 +5,16 @@ function [f,g,H] = SSVMLoss(w,X,y)
 
 [n,p] = size(X);
 
+if nargout <= 2 && exist('linearLossC') == 3 && ~issparse(X) && isreal(X) && isa(X,'double') && isreal(w)
+    % Fused compiled version
+    if nargout > 1
+        [f,g] = linearLossC('ssvm',w,X,double(y));
+    else
+        f = linearLossC('ssvm',w,X,double(y));
+    end
+    return;
+end
+
 err = 1-y.*(X*w);
 viol = find(err>=0);
 f = sum(err(viol).^2);
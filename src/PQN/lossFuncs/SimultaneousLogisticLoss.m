@@ -6,6 +6,16 @@ function [nll,g] = LogisticLoss(W,X,Y)
 [n,p] = size(X);
 nTasks = size(Y,2);
 
+if exist('linearLossC') == 3 && ~issparse(X) && isreal(X) && isa(X,'double') && isreal(W)
+    % Fused compiled version, all tasks in one pass over X
+    if nargout > 1
+        [nll,g] = linearLossC('simLogistic',W(:),X,double(Y));
+    else
+        nll = linearLossC('simLogistic',W(:),X,double(Y));
+    end
+    return;
+end
+
 W = reshape(W,p,nTasks);
 
 g = zeros(p,nTasks);
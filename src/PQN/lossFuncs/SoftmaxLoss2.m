@@ -7,6 +7,17 @@ function [nll,g,H] = SoftmaxLoss2(w,X,y,k)
 %   to avoid overparameterization
 
 [n,p] = size(X);
+
+if nargout <= 2 && exist('linearLossC') == 3 && ~issparse(X) && isreal(X) && isa(X,'double') && isreal(w)
+    % Fused compiled version
+    if nargout > 1
+        [nll,g] = linearLossC('softmax',w(:),X,double(y));
+    else
+        nll = linearLossC('softmax',w(:),X,double(y));
+    end
+    return;
+end
+
 w = reshape(w,[p k-1]);
 w(:,k) = zeros(p,1);
 
@@ -4,7 +4,14 @@ function [f,g,H,T] = SquaredError(w,X,y)
 % y(instance,1)
 
 
-if nargout < 3
+if nargout < 3 && exist('linearLossC') == 3 && ~issparse(X) && isreal(X) && isa(X,'double') && isreal(w)
+    % Fused compiled version, one pass over X
+    if nargout > 1
+        [f,g] = linearLossC('squared',w,X,double(y));
+    else
+        f = linearLossC('squared',w,X,double(y));
+    end
+elseif nargout < 3
     % Use 2 matrix-vector products with X
     Xw = X*w;
     res = Xw-y;
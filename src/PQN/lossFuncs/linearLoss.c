@@ -0,0 +1,274 @@
+#include <math.h>
+#include <string.h>
+#include "mex.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "linearLoss.h"
+
+/* Kernel of linearLossC.c, shared with minFuncC.c
+ *
+ * A block of rows of X is read once for X*W (and X*V), the per-row loss
+ * and its derivatives are formed, and the same block is used for
+ * X'*residual (and X'*(D.*(X*V))) while it is still in cache.
+ * The rows are split into a fixed number of chunks that are processed
+ * in parallel; the sums of the chunks are added in chunk order, so the
+ * result does not depend on the number of threads. */
+
+#define ROW_BLOCK 128
+#define MAX_CHUNKS 32
+
+/* log(1+exp(z)) without overflow */
+static double log1pexp(double z)
+{
+    if(z > 0)
+        return z + log1p(exp(-z));
+    return log1p(exp(z));
+}
+
+
+/* Loss of row i, its derivative r with respect to the nOut linear
+   predictions xw, and the Hessian (with respect to xw) times xv in q */
+static double rowLoss(int type, int nOut, const double *xw, double y, const double *Y,
+        int n, int i, double *r, const double *xv, double *q)
+{
+    int c;
+    double f = 0, z, s, m, Z;
+
+    switch(type)
+    {
+        case LOGISTIC:
+        case SIM_LOGISTIC:
+            for(c = 0; c < nOut; c++)
+            {
+                double yc = (type == LOGISTIC) ? y : Y[i + (size_t)n*c];
+                z = yc*xw[c];
+                f += log1pexp(-z);
+                /* s = 1/(1+exp(z)) */
+                s = (z > 0) ? exp(-z)/(1 + exp(-z)) : 1/(1 + exp(z));
+                r[c] = -yc*s;
+                if(q)
+                    q[c] = s*(1 - s)*xv[c];
+            }
+            break;
+
+        case SOFTMAX:
+            /* Classes 1..nOut have weights, class nOut+1 has xw = 0 */
+            m = 0;
+            for(c = 0; c < nOut; c++)
+            {
+                if(xw[c] > m)
+                    m = xw[c];
+            }
+            Z = exp(-m);
+            for(c = 0; c < nOut; c++)
+            {
+                r[c] = exp(xw[c] - m);
+                Z += r[c];
+            }
+            f = m + log(Z);
+            c = (int)y - 1;
+            if(c < nOut)
+                f -= xw[c];
+            s = 0;
+            for(c = 0; c < nOut; c++)
+            {
+                r[c] /= Z;
+                s += r[c]*(xv ? xv[c] : 0);
+            }
+            if(q)
+            {
+                for(c = 0; c < nOut; c++)
+                    q[c] = r[c]*(xv[c] - s);
+            }
+            c = (int)y - 1;
+            if(c < nOut)
+                r[c] -= 1;
+            break;
+
+        case SQUARED:
+            z = xw[0] - y;
+            f = z*z;
+            r[0] = 2*z;
+            if(q)
+                q[0] = 2*xv[0];
+            break;
+
+        case SSVM:
+            z = 1 - y*xw[0];
+            if(z >= 0)
+            {
+                f = z*z;
+                r[0] = -2*z*y;
+                if(q)
+                    q[0] = 2*xv[0];
+            }
+            else
+            {
+                r[0] = 0;
+                if(q)
+                    q[0] = 0;
+            }
+            break;
+    }
+    return f;
+}
+
+
+int linearLossType(const char *name)
+{
+    if(strcmp(name,"logistic") == 0)
+        return LOGISTIC;
+    if(strcmp(name,"softmax") == 0)
+        return SOFTMAX;
+    if(strcmp(name,"squared") == 0)
+        return SQUARED;
+    if(strcmp(name,"simLogistic") == 0)
+        return SIM_LOGISTIC;
+    if(strcmp(name,"ssvm") == 0)
+        return SSVM;
+    return -1;
+}
+
+
+int linearLossLabelsValid(int type, const double *y, int n, int nOut)
+{
+    int i;
+
+    if(type != SOFTMAX)
+        return 1;
+    for(i = 0; i < n; i++)
+    {
+        /* also false for NaN */
+        if(!(y[i] >= 1 && y[i] <= nOut + 1 && y[i] == floor(y[i])))
+            return 0;
+    }
+    return 1;
+}
+
+
+double linearLoss(int type, const double *w, size_t nW, const double *X, int n, int p,
+        const double *y, const double *v, double *g, double *Hv)
+{
+    int nOut = nW/p, nBlocks, nChunks, chunk, nThreads, doGrad = g != NULL, doHv = Hv != NULL;
+    size_t blockSize = (size_t)ROW_BLOCK*nOut;
+    double *fChunk, *gChunk, *hChunk, *work, f;
+
+    nBlocks = (n + ROW_BLOCK - 1)/ROW_BLOCK;
+    nChunks = nBlocks < MAX_CHUNKS ? nBlocks : MAX_CHUNKS;
+    if(nChunks < 1)
+        nChunks = 1;
+
+    if(g)
+        memset(g,0,nW*sizeof(double));
+    if(Hv)
+        memset(Hv,0,nW*sizeof(double));
+
+    fChunk = mxCalloc(nChunks,sizeof(double));
+    gChunk = doGrad ? mxCalloc((size_t)nChunks*nW,sizeof(double)) : NULL;
+    hChunk = doHv ? mxCalloc((size_t)nChunks*nW,sizeof(double)) : NULL;
+
+    /* xw, xv, r and q of one block of rows, one slice per thread */
+    nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    work = mxMalloc(((size_t)nThreads*4*blockSize + 1)*sizeof(double));
+
+#pragma omp parallel for schedule(static,1) num_threads(nThreads)
+    for(chunk = 0; chunk < nChunks; chunk++)
+    {
+        int b, i, j, c, i0, nb, t = 0,
+        b0 = (int)((long)nBlocks*chunk/nChunks), b1 = (int)((long)nBlocks*(chunk+1)/nChunks);
+        double *xw, *xv, *r, *q;
+        double *myG = doGrad ? gChunk + (size_t)chunk*nW : NULL;
+        double *myH = doHv ? hChunk + (size_t)chunk*nW : NULL;
+        double myF = 0;
+
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+#endif
+        xw = work + (size_t)t*4*blockSize;
+        r = xw + blockSize;
+        xv = doHv ? r + blockSize : NULL;
+        q = doHv ? r + 2*blockSize : NULL;
+
+        for(b = b0; b < b1; b++)
+        {
+            i0 = b*ROW_BLOCK;
+            nb = (i0 + ROW_BLOCK < n) ? ROW_BLOCK : n - i0;
+
+            /* xw(i,c) = X(i,:)*W(:,c), row-major within the block */
+            memset(xw,0,(size_t)nb*nOut*sizeof(double));
+            if(xv)
+                memset(xv,0,(size_t)nb*nOut*sizeof(double));
+            for(j = 0; j < p; j++)
+            {
+                const double *x = X + i0 + (size_t)n*j;
+                for(c = 0; c < nOut; c++)
+                {
+                    double wjc = w[j + (size_t)p*c];
+                    if(wjc != 0)
+                    {
+                        for(i = 0; i < nb; i++)
+                            xw[c + nOut*i] += x[i]*wjc;
+                    }
+                    if(xv && v[j + (size_t)p*c] != 0)
+                    {
+                        double vjc = v[j + (size_t)p*c];
+                        for(i = 0; i < nb; i++)
+                            xv[c + nOut*i] += x[i]*vjc;
+                    }
+                }
+            }
+
+            /* Loss and derivatives of the rows */
+            for(i = 0; i < nb; i++)
+                myF += rowLoss(type,nOut,xw + nOut*i,y[type == SIM_LOGISTIC ? 0 : i0+i],
+                        y,n,i0+i,r + nOut*i,xv ? xv + nOut*i : NULL,q ? q + nOut*i : NULL);
+
+            /* g(:,c) += X(block,:)'*r(:,c), Hv(:,c) += X(block,:)'*q(:,c) */
+            if(myG)
+            {
+                for(j = 0; j < p; j++)
+                {
+                    const double *x = X + i0 + (size_t)n*j;
+                    for(c = 0; c < nOut; c++)
+                    {
+                        double sg = 0, sh = 0;
+                        for(i = 0; i < nb; i++)
+                            sg += x[i]*r[c + nOut*i];
+                        myG[j + (size_t)p*c] += sg;
+                        if(myH)
+                        {
+                            for(i = 0; i < nb; i++)
+                                sh += x[i]*q[c + nOut*i];
+                            myH[j + (size_t)p*c] += sh;
+                        }
+                    }
+                }
+            }
+        }
+        fChunk[chunk] = myF;
+    }
+
+    /* Sum the chunks in order */
+    f = 0;
+    for(chunk = 0; chunk < nChunks; chunk++)
+    {
+        size_t k;
+        f += fChunk[chunk];
+        for(k = 0; doGrad && k < nW; k++)
+            g[k] += gChunk[(size_t)chunk*nW + k];
+        for(k = 0; doHv && k < nW; k++)
+            Hv[k] += hChunk[(size_t)chunk*nW + k];
+    }
+
+    mxFree(fChunk);
+    mxFree(work);
+    if(gChunk)
+        mxFree(gChunk);
+    if(hChunk)
+        mxFree(hChunk);
+    return f;
+}
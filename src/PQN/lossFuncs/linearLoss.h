@@ -0,0 +1,23 @@
+#ifndef LINEARLOSS_H
+#define LINEARLOSS_H
+
+#include <stddef.h>
+
+/* Losses that only depend on X through X*W, see linearLoss.c */
+enum {LOGISTIC, SOFTMAX, SQUARED, SIM_LOGISTIC, SSVM};
+
+/* Type of a loss name ('logistic', 'softmax', 'squared', 'simLogistic',
+   'ssvm'), -1 if unknown */
+int linearLossType(const char *name);
+
+/* 1 if the n labels y are valid for the loss with nOut outputs: softmax
+   needs integer classes 1..nOut+1, the other losses take any y */
+int linearLossLabelsValid(int type, const double *y, int n, int nOut);
+
+/* Loss of the nW = p*nOut weights w on the dense n-by-p X and labels y;
+   the gradient is written to g unless it is NULL, and the Hessian times v
+   to Hv if both g and Hv are given. The sizes are not checked. */
+double linearLoss(int type, const double *w, size_t nW, const double *X, int n, int p,
+        const double *y, const double *v, double *g, double *Hv);
+
+#endif
@@ -0,0 +1,77 @@
+#include <string.h>
+#include "mex.h"
+#include "linearLoss.h"
+
+/* [f,g,Hv] = linearLossC(type,w,X,y,v)
+ *
+ * Loss, gradient and (optionally) Hessian-vector product of the losses
+ * in lossFuncs that only depend on X through X*W, with X dense:
+ *     'logistic'     LogisticLoss(w,X,y)
+ *     'softmax'      SoftmaxLoss2(w,X,y,k), k-1 = numel(w)/size(X,2)
+ *     'squared'      SquaredError(w,X,y)
+ *     'simLogistic'  SimultaneousLogisticLoss(W,X,Y)
+ *     'ssvm'         SSVMLoss(w,X,y)
+ * The fused row-blocked kernel is in linearLoss.c. */
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* Variables */
+    int n, p, nOut, type;
+    size_t nW;
+    char typeName[16];
+    double *w, *X, *y, *v, *g, *Hv, f;
+
+    /* Input */
+    if(nrhs < 4)
+        mexErrMsgTxt("Usage: [f,g,Hv] = linearLossC(type,w,X,y[,v])");
+    if(mxIsSparse(prhs[2]) || mxIsComplex(prhs[2]) || !mxIsDouble(prhs[2]))
+        mexErrMsgTxt("X must be a full real double matrix");
+    if(!mxIsDouble(prhs[1]) || !mxIsDouble(prhs[3]) || (nrhs > 4 && !mxIsDouble(prhs[4])))
+        mexErrMsgTxt("w, y and v must be double");
+    mxGetString(prhs[0],typeName,sizeof(typeName));
+    type = linearLossType(typeName);
+    if(type < 0)
+        mexErrMsgTxt("Unknown loss type");
+
+    w = mxGetPr(prhs[1]);
+    X = mxGetPr(prhs[2]);
+    y = mxGetPr(prhs[3]);
+    n = mxGetM(prhs[2]);
+    p = mxGetN(prhs[2]);
+    nW = mxGetNumberOfElements(prhs[1]);
+    v = NULL;
+    if(nlhs > 2)
+    {
+        if(nrhs < 5 || mxGetNumberOfElements(prhs[4]) != nW)
+            mexErrMsgTxt("Hv needs a vector v of the size of w");
+        v = mxGetPr(prhs[4]);
+    }
+
+    /* Compute Sizes */
+    if(p == 0 || nW % p != 0)
+        mexErrMsgTxt("numel(w) must be a multiple of size(X,2)");
+    nOut = nW/p;
+    if((type == LOGISTIC || type == SQUARED || type == SSVM) && nOut != 1)
+        mexErrMsgTxt("w must have size(X,2) elements");
+    if(mxGetNumberOfElements(prhs[3]) != (size_t)n*(type == SIM_LOGISTIC ? nOut : 1))
+        mexErrMsgTxt("y does not match X and w");
+    if(!linearLossLabelsValid(type,y,n,nOut))
+        mexErrMsgTxt("softmax labels y must be integers in 1..k");
+
+    /* Output */
+    g = Hv = NULL;
+    if(nlhs > 1)
+    {
+        plhs[1] = mxCreateDoubleMatrix(nW,1,mxREAL);
+        g = mxGetPr(plhs[1]);
+    }
+    if(nlhs > 2)
+    {
+        plhs[2] = mxCreateDoubleMatrix(nW,1,mxREAL);
+        Hv = mxGetPr(plhs[2]);
+    }
+
+    f = linearLoss(type,w,nW,X,n,p,y,v,g,Hv);
+    plhs[0] = mxCreateDoubleScalar(f);
+}
@@ -3,15 +3,65 @@ mex minFunc/lbfgsC.c
 fprintf('Compiling UGM files...\n');
 mex -IUGM/mex UGM/mex/UGM_makeNodePotentialsC.c
 mex -IUGM/mex UGM/mex/UGM_makeEdgePotentialsC.c
-mex -IUGM/mex UGM/mex/UGM_PseudoLossC.c
 mex -IUGM/mex UGM/mex/UGM_Infer_ExactC.c
-mex -IUGM/mex UGM/mex/UGM_Loss_subC.c
 mex -IUGM/mex UGM/mex/UGM_updateGradientC.c
-mex -IUGM/mex UGM/mex/UGM_Sample_GibbsC.c
-mex -IUGM/mex UGM/mex/UGM_MRFLoss_subC.c
+if (isunix) % Linux / MacOS, losses, inference engines and sampler run in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -IUGM/mex UGM/mex/UGM_PseudoLossC.c
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -IUGM/mex UGM/mex/UGM_Loss_subC.c
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -IUGM/mex UGM/mex/UGM_MRFLoss_subC.c
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -IUGM/mex UGM/mex/UGM_Sample_GibbsC.c
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -IUGM/mex UGM/mex/UGM_Infer_LBPC.c
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -IUGM/mex UGM/mex/UGM_Infer_JunctionC.c
+else
+    mex -IUGM/mex UGM/mex/UGM_PseudoLossC.c
+    mex -IUGM/mex UGM/mex/UGM_Loss_subC.c
+    mex -IUGM/mex UGM/mex/UGM_MRFLoss_subC.c
+    mex -IUGM/mex UGM/mex/UGM_Sample_GibbsC.c
+    mex -IUGM/mex UGM/mex/UGM_Infer_LBPC.c
+    mex -IUGM/mex UGM/mex/UGM_Infer_JunctionC.c
+end
 fprintf('Compiling projection files...\n');
 mex project/projectRandom2C.c
-mex -Iproject project/projectBlockL1.c project/oneProjectorCore.c project/heap.c
-mex -Iproject project/projectBlockL2.c
+if (isunix) % Linux / MacOS, blocks projected in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -Iproject project/projectBlockL1.c project/oneProjectorCore.c
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -Iproject project/projectBlockL2.c
+else
+    mex -Iproject project/projectBlockL1.c project/oneProjectorCore.c
+    mex -Iproject project/projectBlockL2.c
+end
+if (isunix) % Linux / MacOS, components solved in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" GGM/L1precisionBCDC.c
+else
+    mex GGM/L1precisionBCDC.c
+end
+if (isunix) % Linux / MacOS, gradient updates in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" L1General/LassoShootingC.c
+else
+    mex L1General/LassoShootingC.c
+end
+if (isunix) % Linux / MacOS, groups projected in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" groupL1/L1groupSPGC.c
+else
+    mex groupL1/L1groupSPGC.c
+end
+if (isunix) % Linux / MacOS, rows in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -IlossFuncs lossFuncs/linearLossC.c lossFuncs/linearLoss.c
+else
+    mex -IlossFuncs lossFuncs/linearLossC.c lossFuncs/linearLoss.c
+end
+if (isunix) % Linux / MacOS, blocks projected in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -Iproject DuchiEtAl_UAI2008/projGradCovselC.c project/oneProjectorCore.c
+else
+    mex -Iproject DuchiEtAl_UAI2008/projGradCovselC.c project/oneProjectorCore.c
+end
+if (isunix) % Linux / MacOS, compiled losses evaluated in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" -IlossFuncs minFunc/minFuncC.c lossFuncs/linearLoss.c
+else
+    mex -IlossFuncs minFunc/minFuncC.c lossFuncs/linearLoss.c
+end
 fprintf('Compiling CRF files (requires a good compilier)...\n\n');
-mex crfChain/crfChain_lossL2C.c
\ No newline at end of file
+if (isunix) % Linux / MacOS, sentences in parallel
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" crfChain/crfChain_lossL2C.c
+else
+    mex crfChain/crfChain_lossL2C.c
+end
\ No newline at end of file
@@ -95,6 +95,8 @@ function [x,f,exitflag,output] = minFunc(funObj,x0,options,varargin)
 %       to get very accurate values (default: 0, objective function must support complex inputs)
 %   DerivativeCheck - if 'on', computes derivatives numerically at initial
 %   point and compares to user-supplied derivative (default: 'off')
+%   State - output.state of a previous run, warm starts the L-BFGS memory
+%       (also the 'pnewton0' preconditioner) and the 'bb' step (minFuncC only)
 %
 % Method-specific input options:
 %   newton:
@@ -163,6 +165,7 @@ function [x,f,exitflag,output] = minFunc(funObj,x0,options,varargin)
 %   message - exit message
 %   trace.funccount - function evaluations after each iteration
 %   trace.fval - function value after each iteration
+%   state - L-BFGS memory and 'bb' step for options.State (minFuncC only)
 %
 % Author: Mark Schmidt (2006)
 % Web: http://www.cs.ubc.ca/~schmidtm
@@ -208,6 +211,49 @@ NEWTON0 = 7;
 NEWTON = 8;
 TENSOR = 9;
 
+% Use the compiled driver for the methods and line searches it implements
+if useMex && exist('minFuncC') == 3 && any(method == [SD BB CG LBFGS NEWTON0]) && ...
+        ~numDiff && ~debug && ~doPlot && isempty(outputFcn) && ~strcmp(DerivativeCheck,'on') && ...
+        LS < 6 && ~Damped && bbType <= 2 && isempty(precFunc) && isa(x0,'double') && isreal(x0) && ~issparse(x0) && ...
+        (method ~= NEWTON0 || (cgSolve <= 1 && (~isempty(HvFunc) || ~useComplex)))
+    funC = funObj;
+    args = varargin;
+    if isa(funObj,'function_handle') && numel(varargin) >= 2 && ~issparse(varargin{1}) && ...
+            isreal(varargin{1}) && isa(varargin{1},'double')
+        % Losses of linearLossC are evaluated without calling back into Matlab
+        X = varargin{1};
+        switch func2str(funObj)
+            case 'LogisticLoss'
+                funC = 'logistic';
+            case 'SquaredError'
+                funC = 'squared';
+            case 'SSVMLoss'
+                funC = 'ssvm';
+            case 'SimultaneousLogisticLoss'
+                funC = 'simLogistic';
+            case 'SoftmaxLoss2'
+                if numel(varargin) >= 3 && numel(x0) == size(X,2)*(varargin{3}-1)
+                    funC = 'softmax';
+                end
+        end
+        if ischar(funC)
+            args = {X,double(varargin{2})};
+        end
+    end
+    state = [];
+    if isstruct(options) && isfield(options,'State')
+        state = options.State;
+    end
+    params = [method verbose verboseI maxFunEvals maxIter tolFun tolX corrections ...
+        c1 c2 LS_init LS Fref cgUpdate bbType cgSolve useNegCurv];
+    if nargout > 3
+        [x,f,exitflag,output] = minFuncC(funC,x0,params,state,HvFunc,args{:});
+    else
+        [x,f,exitflag] = minFuncC(funC,x0,params,state,HvFunc,args{:});
+    end
+    return;
+end
+
 % Initialize
 p = length(x0);
 d = zeros(p,1);
@@ -0,0 +1,1294 @@
+#include <math.h>
+#include <string.h>
+#include "mex.h"
+#include "linearLoss.h"
+
+/* [x,f,exitflag,output] = minFuncC(funObj,x0,params,state,HvFunc,varargin)
+ *
+ * The descent loop of minFunc.m for the methods 'sd', 'bb', 'cg', 'lbfgs'
+ * and 'newton0'/'pnewton0', with the line searches of ArmijoBacktrack.m
+ * (LS = 0,1,2) and WolfeLineSearch.m (LS = 3,4,5) and the interpolation
+ * of polyinterp.m, so the iterates are those of minFunc.m.
+ *
+ * funObj is a function handle called as [f,g] = funObj(x,varargin{:}), or
+ * the name of a loss of linearLoss.c ('logistic', 'softmax', 'squared',
+ * 'simLogistic', 'ssvm') with varargin = {X,y}, which is evaluated
+ * without calling back into MATLAB (and gives exact Hessian-vector
+ * products for 'newton0').
+ *
+ * params = [method verbose verboseI maxFunEvals maxIter tolFun tolX corrections
+ *           c1 c2 LS_init LS Fref cgUpdate bbType cgSolve useNegCurv]
+ * with the values of minFunc_processInputOptions.m. HvFunc ([] if none) is
+ * called as HvFunc(v,x,varargin{:}), otherwise Hessian-vector products
+ * of a function handle are finite differences of the gradient.
+ *
+ * state ([] for a cold start) is output.state of a previous call: the
+ * L-BFGS memory (also the 'pnewton0' preconditioner) and the last
+ * Barzilai-Borwein step, so a related problem is restarted with its
+ * curvature information. */
+
+enum {SD = 0, BB = 2, CG = 3, LBFGS = 5, NEWTON0 = 7};
+
+/* Maximum number of iterations of the Wolfe line search */
+#define MAX_LS 25
+
+/* Unknown value of a point in polyinterp */
+#define UNKNOWN mxGetNaN()
+
+
+typedef struct
+{
+    int type;                   /* Loss of linearLoss.c, -1 for a MATLAB function */
+    const double *X, *y;
+    int n, p;
+    const mxArray *fun, *HvFun; /* MATLAB function handles, HvFun may be NULL */
+    const mxArray **args;
+    int nArgs;
+    int nVars;
+    mwSize nDims;
+    const mwSize *dims;         /* Shape of x */
+    double *work, *work2;       /* nVars each */
+} Objective;
+
+typedef struct
+{
+    int nVars, m, k, start;     /* Capacity, number of pairs, oldest pair */
+    double *S, *Y, *ro, *alpha, Hdiag;
+} Memory;
+
+
+static double dot(const double *a, const double *b, int n)
+{
+    double s = 0;
+    int i;
+    for(i = 0; i < n; i++)
+        s += a[i]*b[i];
+    return s;
+}
+
+static double sumAbs(const double *a, int n)
+{
+    double s = 0;
+    int i;
+    for(i = 0; i < n; i++)
+        s += fabs(a[i]);
+    return s;
+}
+
+/* No NaN or Inf, as isLegal.m */
+static int isLegal(const double *a, int n)
+{
+    int i;
+    for(i = 0; i < n; i++)
+    {
+        if(mxIsNaN(a[i]) || mxIsInf(a[i]))
+            return 0;
+    }
+    return 1;
+}
+
+
+/* f(x), and the gradient in g */
+static double evalObjective(Objective *obj, const double *x, double *g)
+{
+    mxArray **in, *out[2];
+    double f;
+    int i;
+
+    if(obj->type >= 0)
+        return linearLoss(obj->type,x,obj->nVars,obj->X,obj->n,obj->p,obj->y,NULL,g,NULL);
+
+    in = mxMalloc((obj->nArgs + 2)*sizeof(mxArray *));
+    in[0] = (mxArray *)obj->fun;
+    in[1] = mxCreateNumericArray(obj->nDims,obj->dims,mxDOUBLE_CLASS,mxREAL);
+    memcpy(mxGetPr(in[1]),x,obj->nVars*sizeof(double));
+    for(i = 0; i < obj->nArgs; i++)
+        in[i+2] = (mxArray *)obj->args[i];
+    mexCallMATLAB(2,out,obj->nArgs + 2,in,"feval");
+    if(!mxIsDouble(out[1]) || mxGetNumberOfElements(out[1]) != (size_t)obj->nVars)
+        mexErrMsgTxt("funObj must return a double gradient with numel(x) elements");
+
+    /* Complex values are not legal */
+    f = mxIsComplex(out[0]) ? mxGetNaN() : mxGetScalar(out[0]);
+    memcpy(g,mxGetPr(out[1]),obj->nVars*sizeof(double));
+    if(mxIsComplex(out[1]))
+        g[0] = mxGetNaN();
+
+    mxDestroyArray(in[1]);
+    mxDestroyArray(out[0]);
+    mxDestroyArray(out[1]);
+    mxFree(in);
+    return f;
+}
+
+
+/* Hv = Hessian at x (with gradient g) times v, as autoHv.m if there is
+   no Hessian-vector function */
+static void hessVec(Objective *obj, const double *x, const double *g, const double *v, double *Hv)
+{
+    mxArray **in, *out[1];
+    double mu;
+    int i;
+
+    if(obj->type >= 0)
+    {
+        linearLoss(obj->type,x,obj->nVars,obj->X,obj->n,obj->p,obj->y,v,obj->work,Hv);
+        return;
+    }
+
+    if(obj->HvFun)
+    {
+        in = mxMalloc((obj->nArgs + 3)*sizeof(mxArray *));
+        in[0] = (mxArray *)obj->HvFun;
+        in[1] = mxCreateNumericArray(obj->nDims,obj->dims,mxDOUBLE_CLASS,mxREAL);
+        in[2] = mxCreateNumericArray(obj->nDims,obj->dims,mxDOUBLE_CLASS,mxREAL);
+        memcpy(mxGetPr(in[1]),v,obj->nVars*sizeof(double));
+        memcpy(mxGetPr(in[2]),x,obj->nVars*sizeof(double));
+        for(i = 0; i < obj->nArgs; i++)
+            in[i+3] = (mxArray *)obj->args[i];
+        mexCallMATLAB(1,out,obj->nArgs + 3,in,"feval");
+        if(!mxIsDouble(out[0]) || mxGetNumberOfElements(out[0]) != (size_t)obj->nVars)
+            mexErrMsgTxt("HvFunc must return a double vector with numel(x) elements");
+        memcpy(Hv,mxGetPr(out[0]),obj->nVars*sizeof(double));
+        mxDestroyArray(in[1]);
+        mxDestroyArray(in[2]);
+        mxDestroyArray(out[0]);
+        mxFree(in);
+        return;
+    }
+
+    mu = 2*sqrt(1e-12)*(1 + sqrt(dot(x,x,obj->nVars)))/sqrt(dot(v,v,obj->nVars));
+    for(i = 0; i < obj->nVars; i++)
+        obj->work[i] = x[i] + mu*v[i];
+    evalObjective(obj,obj->work,obj->work2);
+    for(i = 0; i < obj->nVars; i++)
+        Hv[i] = (obj->work2[i] - g[i])/mu;
+}
+
+
+/* lbfgsUpdate.m: add the pair (s,y) if y'*s > 1e-10, dropping the oldest */
+static void lbfgsUpdate(Memory *mem, const double *y, const double *s)
+{
+    int slot, n = mem->nVars;
+    double ys = dot(y,s,n);
+
+    if(ys <= 1e-10)
+        return;
+    if(mem->k < mem->m)
+        slot = (mem->start + mem->k++) % mem->m;
+    else
+    {
+        slot = mem->start;
+        mem->start = (mem->start + 1) % mem->m;
+    }
+    memcpy(mem->S + (size_t)n*slot,s,n*sizeof(double));
+    memcpy(mem->Y + (size_t)n*slot,y,n*sizeof(double));
+    mem->ro[slot] = 1/ys;
+    mem->Hdiag = ys/dot(y,y,n);
+}
+
+
+/* r = H*v with the L-BFGS inverse Hessian approximation, as lbfgsC.c */
+static void lbfgsMultiply(Memory *mem, const double *v, double *r)
+{
+    int i, j, c, n = mem->nVars;
+    double beta;
+
+    memcpy(r,v,n*sizeof(double));
+    for(j = mem->k-1; j >= 0; j--)
+    {
+        c = (mem->start + j) % mem->m;
+        mem->alpha[c] = mem->ro[c]*dot(mem->S + (size_t)n*c,r,n);
+        for(i = 0; i < n; i++)
+            r[i] -= mem->alpha[c]*mem->Y[i + (size_t)n*c];
+    }
+    for(i = 0; i < n; i++)
+        r[i] *= mem->Hdiag;
+    for(j = 0; j < mem->k; j++)
+    {
+        c = (mem->start + j) % mem->m;
+        beta = mem->ro[c]*dot(mem->Y + (size_t)n*c,r,n);
+        for(i = 0; i < n; i++)
+            r[i] += mem->S[i + (size_t)n*c]*(mem->alpha[c] - beta);
+    }
+}
+
+
+/* Roots of c[0]*x^deg + ... + c[deg] for deg <= 2, returns their number */
+static int realRoots(const double *c, int deg, double *r)
+{
+    double disc, q;
+
+    while(deg > 0 && c[0] == 0)
+    {
+        c++;
+        deg--;
+    }
+    if(deg == 1)
+    {
+        r[0] = -c[1]/c[0];
+        return 1;
+    }
+    if(deg == 2)
+    {
+        disc = c[1]*c[1] - 4*c[0]*c[2];
+        if(disc < 0)
+            return 0;
+        q = -0.5*(c[1] + (c[1] >= 0 ? sqrt(disc) : -sqrt(disc)));
+        if(q == 0)
+        {
+            r[0] = r[1] = 0;
+            return 2;
+        }
+        r[0] = q/c[0];
+        r[1] = c[2]/q;
+        return 2;
+    }
+    return 0;
+}
+
+
+/* polyinterp.m: minimum of the polynomial through the points (x,f,g),
+   NaN for an unknown f or g, within [xminBound,xmaxBound] (the range of
+   the points if hasBounds is 0) */
+static double polyinterp(int nPoints, const double *x, const double *f, const double *g,
+        int hasBounds, double xminBound, double xmaxBound)
+{
+    double A[4][5], params[4], dParams[3], cp[8], xmin, xmax, minPos, fBest, fCP, d1, d2, t, piv;
+    int i, j, k, order, nRows, nCP, lo, hi, best;
+
+    order = -1;
+    for(i = 0; i < nPoints; i++)
+        order += !mxIsNaN(f[i]) + !mxIsNaN(g[i]);
+
+    /* Cubic interpolation of 2 points with function and derivative values */
+    if(nPoints == 2 && order == 3 && !hasBounds)
+    {
+        lo = x[1] < x[0];
+        hi = 1 - lo;
+        d1 = g[lo] + g[hi] - 3*(f[lo] - f[hi])/(x[lo] - x[hi]);
+        d2 = d1*d1 - g[lo]*g[hi];
+        if(d2 >= 0)
+        {
+            d2 = sqrt(d2);
+            t = x[hi] - (x[hi] - x[lo])*((g[hi] + d2 - d1)/(g[hi] - g[lo] + 2*d2));
+            return fmin(fmax(t,x[lo]),x[hi]);
+        }
+        return (x[0] + x[1])/2;
+    }
+
+    xmin = xmax = x[0];
+    for(i = 1; i < nPoints; i++)
+    {
+        xmin = fmin(xmin,x[i]);
+        xmax = fmax(xmax,x[i]);
+    }
+    if(!hasBounds)
+    {
+        xminBound = xmin;
+        xmaxBound = xmax;
+    }
+    minPos = (xminBound + xmaxBound)/2;
+    if(order < 1 || order > 3)
+        return minPos;
+
+    /* Constraints based on the function values, then on the derivatives */
+    nRows = 0;
+    for(i = 0; i < nPoints; i++)
+    {
+        if(!mxIsNaN(f[i]))
+        {
+            for(j = 0; j <= order; j++)
+                A[nRows][j] = pow(x[i],order-j);
+            A[nRows++][order+1] = f[i];
+        }
+    }
+    for(i = 0; i < nPoints; i++)
+    {
+        if(!mxIsNaN(g[i]))
+        {
+            for(j = 0; j <= order; j++)
+                A[nRows][j] = (j < order) ? (order-j)*pow(x[i],order-j-1) : 0;
+            A[nRows++][order+1] = g[i];
+        }
+    }
+
+    /* params = A\b by elimination with partial pivoting */
+    for(k = 0; k <= order; k++)
+    {
+        best = k;
+        for(i = k+1; i <= order; i++)
+        {
+            if(fabs(A[i][k]) > fabs(A[best][k]))
+                best = i;
+        }
+        if(A[best][k] == 0)
+            return minPos;
+        for(j = 0; j <= order+1; j++)
+        {
+            t = A[k][j];
+            A[k][j] = A[best][j];
+            A[best][j] = t;
+        }
+        for(i = k+1; i <= order; i++)
+        {
+            piv = A[i][k]/A[k][k];
+            for(j = k; j <= order+1; j++)
+                A[i][j] -= piv*A[k][j];
+        }
+    }
+    for(k = order; k >= 0; k--)
+    {
+        t = A[k][order+1];
+        for(j = k+1; j <= order; j++)
+            t -= A[k][j]*params[j];
+        params[k] = t/A[k][k];
+    }
+
+    /* Critical points: the bounds, the points and the roots of the derivative */
+    for(i = 0; i < order; i++)
+        dParams[i] = params[i]*(order-i);
+    nCP = 0;
+    cp[nCP++] = xminBound;
+    cp[nCP++] = xmaxBound;
+    for(i = 0; i < nPoints; i++)
+        cp[nCP++] = x[i];
+    if(isLegal(dParams,order))
+        nCP += realRoots(dParams,order-1,cp + nCP);
+
+    fBest = mxGetInf();
+    for(i = 0; i < nCP; i++)
+    {
+        if(cp[i] >= xminBound && cp[i] <= xmaxBound)
+        {
+            fCP = 0;
+            for(j = 0; j <= order; j++)
+                fCP = fCP*cp[i] + params[j];
+            if(fCP < fBest)
+            {
+                minPos = cp[i];
+                fBest = fCP;
+            }
+        }
+    }
+    return minPos;
+}
+
+
+/* polyinterp of two points with (f,g) known for both */
+static double interp2(double x0, double f0, double g0, double x1, double f1, double g1,
+        int hasBounds, double lo, double hi)
+{
+    double x[2], f[2], g[2];
+    x[0] = x0; f[0] = f0; g[0] = g0;
+    x[1] = x1; f[1] = f1; g[1] = g1;
+    return polyinterp(2,x,f,g,hasBounds,lo,hi);
+}
+
+
+/* mixedExtrap of WolfeLineSearch.m */
+static double mixedExtrap(double x0, double f0, double g0, double x1, double f1, double g1,
+        double minStep, double maxStep)
+{
+    double alpha_c = interp2(x0,f0,g0,x1,f1,g1,1,minStep,maxStep);
+    double alpha_s = interp2(x0,f0,g0,x1,UNKNOWN,g1,1,minStep,maxStep);
+    if(alpha_c > minStep && fabs(alpha_c - x1) < fabs(alpha_s - x1))
+        return alpha_c;
+    return alpha_s;
+}
+
+
+/* mixedInterp of WolfeLineSearch.m, point T is the last one evaluated */
+static double mixedInterp(const double *bracket, const double *bracketF, const double *bracketGtd,
+        int Tpos, double oldLOval, double oldLOFval, double oldLOgtd)
+{
+    int nonTpos = 1 - Tpos;
+    double gtdT = bracketGtd[Tpos], xT = bracket[Tpos], fT = bracketF[Tpos];
+    double bmin = fmin(bracket[0],bracket[1]), bmax = fmax(bracket[0],bracket[1]);
+    double alpha_c, alpha_q, alpha_s, t;
+
+    if(fT > oldLOFval)
+    {
+        alpha_c = interp2(oldLOval,oldLOFval,oldLOgtd,xT,fT,gtdT,0,0,0);
+        alpha_q = interp2(oldLOval,oldLOFval,oldLOgtd,xT,fT,UNKNOWN,0,0,0);
+        if(fabs(alpha_c - oldLOval) < fabs(alpha_q - oldLOval))
+            return alpha_c;
+        return (alpha_q + alpha_c)/2;
+    }
+    else if(gtdT*oldLOgtd < 0)
+    {
+        alpha_c = interp2(oldLOval,oldLOFval,oldLOgtd,xT,fT,gtdT,0,0,0);
+        alpha_s = interp2(oldLOval,oldLOFval,oldLOgtd,xT,UNKNOWN,gtdT,0,0,0);
+        if(fabs(alpha_c - xT) >= fabs(alpha_s - xT))
+            return alpha_c;
+        return alpha_s;
+    }
+    else if(fabs(gtdT) <= fabs(oldLOgtd))
+    {
+        alpha_c = interp2(oldLOval,oldLOFval,oldLOgtd,xT,fT,gtdT,1,bmin,bmax);
+        alpha_s = interp2(oldLOval,UNKNOWN,oldLOgtd,xT,fT,gtdT,1,bmin,bmax);
+        if(alpha_c > bmin && alpha_c < bmax && fabs(alpha_c - xT) < fabs(alpha_s - xT))
+            t = alpha_c;
+        else
+            t = alpha_s;
+        if(xT > oldLOval)
+            return fmin(xT + 0.66*(bracket[nonTpos] - xT),t);
+        return fmax(xT + 0.66*(bracket[nonTpos] - xT),t);
+    }
+    return interp2(bracket[nonTpos],bracketF[nonTpos],bracketGtd[nonTpos],xT,fT,gtdT,0,0,0);
+}
+
+
+/* ArmijoBacktrack.m, x_new is x + t*d; returns the number of evaluations */
+static int armijoBacktrack(Objective *obj, const double *x, double *t, const double *d, double f,
+        double fr, const double *g, double gtd, double c1, int LS, double tolX,
+        double *x_new, double *f_new, double *g_new)
+{
+    int i, n = obj->nVars, funEvals;
+    double temp, t_prev = 0, f_prev = 0, px[3], pf[3], pg[3];
+
+    for(i = 0; i < n; i++)
+        x_new[i] = x[i] + *t*d[i];
+    *f_new = evalObjective(obj,x_new,g_new);
+    funEvals = 1;
+
+    while(*f_new > fr + c1*(*t)*gtd || !isLegal(f_new,1))
+    {
+        temp = *t;
+        if(LS == 0 || !isLegal(f_new,1))
+            *t = 0.5*(*t);
+        else if(LS == 2 && isLegal(g_new,n))
+            *t = interp2(0,f,gtd,*t,*f_new,dot(g_new,d,n),0,0,0);
+        else if(funEvals < 2 || !isLegal(&f_prev,1))
+            *t = interp2(0,f,gtd,*t,*f_new,UNKNOWN,0,0,0);
+        else
+        {
+            px[0] = 0; pf[0] = f; pg[0] = gtd;
+            px[1] = *t; pf[1] = *f_new; pg[1] = UNKNOWN;
+            px[2] = t_prev; pf[2] = f_prev; pg[2] = UNKNOWN;
+            *t = polyinterp(3,px,pf,pg,0,0,0);
+        }
+
+        /* Adjust if change in t is too small/large */
+        if(*t < temp*1e-3)
+            *t = temp*1e-3;
+        else if(*t > temp*0.6)
+            *t = temp*0.6;
+
+        f_prev = *f_new;
+        t_prev = temp;
+        for(i = 0; i < n; i++)
+            x_new[i] = x[i] + *t*d[i];
+        *f_new = evalObjective(obj,x_new,g_new);
+        funEvals++;
+
+        /* Check whether step size has become too small */
+        if(fabs(*t)*sumAbs(d,n) <= tolX)
+        {
+            *t = 0;
+            *f_new = f;
+            memcpy(g_new,g,n*sizeof(double));
+            memcpy(x_new,x,n*sizeof(double));
+            break;
+        }
+    }
+    return funEvals;
+}
+
+
+/* WolfeLineSearch.m; the step is returned in t, f(x+t*d) in f_new and the
+   gradient in g_new; xt and the bracket gradients are workspace. Returns
+   the number of evaluations. */
+static int wolfeLineSearch(Objective *obj, const double *x, double *t, const double *d, double f,
+        const double *g, double gtd, double c1, double c2, int LS, double tolX,
+        double *f_new, double *g_new, double *xt, double *g_prev, double **bracketG)
+{
+    int i, n = obj->nVars, funEvals, LSiter, done, nBracket, legal_new, legal_prev;
+    int LOpos, HIpos, Tpos, LOposRemoved, insufProgress, bracketLegal[2];
+    double gtd_new, t_prev, f_prev, gtd_prev, temp, minStep, maxStep, f_LO, bmin, bmax;
+    double bracket[2], bracketF[2], bracketGtd[2], oldLOval = 0, oldLOFval = 0, oldLOgtd = 0;
+
+    /* Evaluate the Objective and Gradient at the Initial Step */
+    for(i = 0; i < n; i++)
+        xt[i] = x[i] + *t*d[i];
+    *f_new = evalObjective(obj,xt,g_new);
+    funEvals = 1;
+    gtd_new = dot(g_new,d,n);
+
+    /* Bracket an Interval containing a point satisfying the Wolfe criteria */
+    LSiter = 0;
+    t_prev = 0;
+    f_prev = f;
+    memcpy(g_prev,g,n*sizeof(double));
+    legal_prev = isLegal(g,n);
+    gtd_prev = gtd;
+    done = 0;
+    nBracket = 0;
+
+    while(LSiter < MAX_LS)
+    {
+        legal_new = isLegal(g_new,n);
+        if(!isLegal(f_new,1) || !legal_new)
+        {
+            /* Extrapolated into illegal region, switching to Armijo line-search */
+            *t = (*t + t_prev)/2;
+            LS = LS - 2 < 2 ? LS - 2 : 2;
+            return funEvals + armijoBacktrack(obj,x,t,d,f,f,g,gtd,c1,LS > 0 ? LS : 0,tolX,
+                    xt,f_new,g_new);
+        }
+
+        if(*f_new > f + c1*(*t)*gtd || (LSiter > 1 && *f_new >= f_prev) || gtd_new >= 0
+                || fabs(gtd_new) <= -c2*gtd)
+        {
+            if(!(*f_new > f + c1*(*t)*gtd || (LSiter > 1 && *f_new >= f_prev))
+                    && fabs(gtd_new) <= -c2*gtd)
+            {
+                nBracket = 1;
+                bracket[0] = *t;
+                bracketF[0] = *f_new;
+                bracketGtd[0] = gtd_new;
+                bracketLegal[0] = legal_new;
+                memcpy(bracketG[0],g_new,n*sizeof(double));
+                done = 1;
+            }
+            else
+            {
+                nBracket = 2;
+                bracket[0] = t_prev; bracket[1] = *t;
+                bracketF[0] = f_prev; bracketF[1] = *f_new;
+                bracketGtd[0] = gtd_prev; bracketGtd[1] = gtd_new;
+                bracketLegal[0] = legal_prev; bracketLegal[1] = legal_new;
+                memcpy(bracketG[0],g_prev,n*sizeof(double));
+                memcpy(bracketG[1],g_new,n*sizeof(double));
+            }
+            break;
+        }
+
+        temp = t_prev;
+        t_prev = *t;
+        minStep = *t + 0.01*(*t - temp);
+        maxStep = *t*10;
+        if(LS == 3)
+            *t = maxStep;
+        else if(LS == 4)
+            *t = interp2(temp,f_prev,gtd_prev,*t,*f_new,gtd_new,1,minStep,maxStep);
+        else
+            *t = mixedExtrap(temp,f_prev,gtd_prev,*t,*f_new,gtd_new,minStep,maxStep);
+
+        f_prev = *f_new;
+        memcpy(g_prev,g_new,n*sizeof(double));
+        legal_prev = legal_new;
+        gtd_prev = gtd_new;
+        for(i = 0; i < n; i++)
+            xt[i] = x[i] + *t*d[i];
+        *f_new = evalObjective(obj,xt,g_new);
+        funEvals++;
+        gtd_new = dot(g_new,d,n);
+        LSiter++;
+    }
+
+    if(LSiter == MAX_LS)
+    {
+        nBracket = 2;
+        bracket[0] = 0; bracket[1] = *t;
+        bracketF[0] = f; bracketF[1] = *f_new;
+        bracketGtd[0] = gtd; bracketGtd[1] = gtd_new;
+        bracketLegal[0] = isLegal(g,n); bracketLegal[1] = isLegal(g_new,n);
+        memcpy(bracketG[0],g,n*sizeof(double));
+        memcpy(bracketG[1],g_new,n*sizeof(double));
+    }
+
+    /* Zoom Phase: refine the bracket until we find a point satisfying the criteria */
+    insufProgress = 0;
+    Tpos = 1;
+    LOposRemoved = 0;
+    while(!done && LSiter < MAX_LS)
+    {
+        /* Find High and Low Points in bracket */
+        LOpos = bracketF[1] < bracketF[0];
+        HIpos = 1 - LOpos;
+        f_LO = bracketF[LOpos];
+        bmin = fmin(bracket[0],bracket[1]);
+        bmax = fmax(bracket[0],bracket[1]);
+
+        /* Compute new trial value */
+        if(LS == 3 || !isLegal(bracketF,2) || !bracketLegal[0] || !bracketLegal[1])
+            *t = (bracket[0] + bracket[1])/2;
+        else if(LS == 4)
+            *t = interp2(bracket[0],bracketF[0],bracketGtd[0],bracket[1],bracketF[1],bracketGtd[1],0,0,0);
+        else
+        {
+            if(LOposRemoved == 0)
+            {
+                oldLOval = bracket[1-Tpos];
+                oldLOFval = bracketF[1-Tpos];
+                oldLOgtd = bracketGtd[1-Tpos];
+            }
+            *t = mixedInterp(bracket,bracketF,bracketGtd,Tpos,oldLOval,oldLOFval,oldLOgtd);
+        }
+
+        /* Test that we are making sufficient progress */
+        if(fmin(bmax - *t,*t - bmin)/(bmax - bmin) < 0.1)
+        {
+            if(insufProgress || *t >= bmax || *t <= bmin)
+            {
+                if(fabs(*t - bmax) < fabs(*t - bmin))
+                    *t = bmax - 0.1*(bmax - bmin);
+                else
+                    *t = bmin + 0.1*(bmax - bmin);
+                insufProgress = 0;
+            }
+            else
+                insufProgress = 1;
+        }
+        else
+            insufProgress = 0;
+
+        /* Evaluate new point */
+        for(i = 0; i < n; i++)
+            xt[i] = x[i] + *t*d[i];
+        *f_new = evalObjective(obj,xt,g_new);
+        funEvals++;
+        gtd_new = dot(g_new,d,n);
+        legal_new = isLegal(g_new,n);
+        LSiter++;
+
+        if(*f_new > f + c1*(*t)*gtd || *f_new >= f_LO)
+        {
+            /* Armijo condition not satisfied or not lower than lowest point */
+            bracket[HIpos] = *t;
+            bracketF[HIpos] = *f_new;
+            bracketGtd[HIpos] = gtd_new;
+            bracketLegal[HIpos] = legal_new;
+            memcpy(bracketG[HIpos],g_new,n*sizeof(double));
+            Tpos = HIpos;
+        }
+        else
+        {
+            if(fabs(gtd_new) <= -c2*gtd)
+                done = 1;
+            else if(gtd_new*(bracket[HIpos] - bracket[LOpos]) >= 0)
+            {
+                /* Old HI becomes new LO */
+                bracket[HIpos] = bracket[LOpos];
+                bracketF[HIpos] = bracketF[LOpos];
+                bracketGtd[HIpos] = bracketGtd[LOpos];
+                bracketLegal[HIpos] = bracketLegal[LOpos];
+                memcpy(bracketG[HIpos],bracketG[LOpos],n*sizeof(double));
+                if(LS == 5)
+                {
+                    LOposRemoved = 1;
+                    oldLOval = bracket[LOpos];
+                    oldLOFval = bracketF[LOpos];
+                    oldLOgtd = bracketGtd[LOpos];
+                }
+            }
+            /* New point becomes new LO */
+            bracket[LOpos] = *t;
+            bracketF[LOpos] = *f_new;
+            bracketGtd[LOpos] = gtd_new;
+            bracketLegal[LOpos] = legal_new;
+            memcpy(bracketG[LOpos],g_new,n*sizeof(double));
+            Tpos = LOpos;
+        }
+
+        if(!done && fabs((bracket[0] - bracket[1])*gtd_new) < tolX)
+            break;
+    }
+
+    LOpos = (nBracket == 2 && bracketF[1] < bracketF[0]);
+    *t = bracket[LOpos];
+    *f_new = bracketF[LOpos];
+    memcpy(g_new,bracketG[LOpos],n*sizeof(double));
+    return funEvals;
+}
+
+
+/* Conjugate gradient for H*d = -g with Hessian-vector products, stopping
+   at residual optTol, after maxIter iterations or on non-positive
+   curvature; a direction of negative curvature is returned in negCurv
+   (and *hasNegCurv set) if useNegCurv. Returns the number of iterations. */
+static int conjGrad(Objective *obj, const double *x, const double *g, double optTol, int maxIter,
+        Memory *prec, int useNegCurv, double *d, double *negCurv, int *hasNegCurv,
+        double *r, double *y, double *p, double *Ap)
+{
+    int i, k, done, n = obj->nVars;
+    double ry, ry_old, pAp, alpha, beta, res;
+
+    *hasNegCurv = 0;
+    memset(d,0,n*sizeof(double));
+    memcpy(r,g,n*sizeof(double));
+    if(prec)
+        lbfgsMultiply(prec,r,y);
+    else
+        memcpy(y,r,n*sizeof(double));
+    ry = dot(r,y,n);
+    for(i = 0; i < n; i++)
+        p[i] = -y[i];
+    k = 0;
+    res = sqrt(dot(r,r,n));
+    done = 0;
+
+    while(res > optTol && k < maxIter && !done)
+    {
+        hessVec(obj,x,g,p,Ap);
+        pAp = dot(p,Ap,n);
+
+        /* Check for negative curvature */
+        if(pAp <= 1e-16)
+        {
+            if(useNegCurv && pAp < 0)
+            {
+                memcpy(negCurv,p,n*sizeof(double));
+                *hasNegCurv = 1;
+                return k;
+            }
+            if(k == 0)
+                done = 1;
+            else
+                break;
+        }
+
+        alpha = ry/pAp;
+        for(i = 0; i < n; i++)
+        {
+            d[i] += alpha*p[i];
+            r[i] += alpha*Ap[i];
+        }
+        if(prec)
+            lbfgsMultiply(prec,r,y);
+        else
+            memcpy(y,r,n*sizeof(double));
+        ry_old = ry;
+        ry = dot(r,y,n);
+        beta = ry/ry_old;
+        for(i = 0; i < n; i++)
+            p[i] = -y[i] + beta*p[i];
+        k++;
+        res = sqrt(dot(r,r,n));
+    }
+    return k;
+}
+
+
+static mxArray *columnVector(const double *v, int n)
+{
+    mxArray *a = mxCreateDoubleMatrix(n,1,mxREAL);
+    memcpy(mxGetPr(a),v,n*sizeof(double));
+    return a;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* Variables */
+    Objective obj;
+    Memory mem;
+    const double *params;
+    const char *msg;
+    char funName[16];
+    int nVars, method, verbose, verboseI, maxFunEvals, maxIter, corrections, LS_init, LS, Fref;
+    int cgUpdate, bbType, cgSolve, useNegCurv, funEvals, exitflag, iter, i, j, k, nTrace, warm;
+    int cgIter, hasNegCurv, cgMaxIter;
+    double tolFun, tolX, c1, c2, f, f_old, fr, t, gtd, gtd_old, beta, alpha, myF_old, nrm, gnorm;
+    double *x, *g, *d, *g_old, *xt, *g_new, *g_prev, *bracketG[2], *s, *yv, *old_fvals;
+    double *cgR, *cgY, *cgP, *cgAp, *traceF, *traceCount;
+    mxArray *output, *trace, *state;
+    const char *outputFields[] = {"iterations","funcCount","algorithm","firstorderopt","message","trace","state"};
+    const char *traceFields[] = {"fval","funcCount"};
+    const char *stateFields[] = {"S","Y","Hdiag","alpha"};
+
+    /* Input */
+    if(nrhs < 3)
+        mexErrMsgTxt("Usage: [x,f,exitflag,output] = minFuncC(funObj,x0,params[,state,HvFunc,varargin])");
+    if(!mxIsDouble(prhs[1]) || mxIsComplex(prhs[1]) || mxIsSparse(prhs[1]))
+        mexErrMsgTxt("x0 must be a full real double array");
+    if(mxGetNumberOfElements(prhs[2]) < 17)
+        mexErrMsgTxt("params must have 17 elements");
+    params = mxGetPr(prhs[2]);
+    method = (int)params[0];
+    verbose = (int)params[1];
+    verboseI = (int)params[2];
+    maxFunEvals = (int)params[3];
+    maxIter = (int)params[4];
+    tolFun = params[5];
+    tolX = params[6];
+    corrections = params[7] >= 1 ? (int)params[7] : 1;
+    c1 = params[8];
+    c2 = params[9];
+    LS_init = (int)params[10];
+    LS = (int)params[11];
+    Fref = params[12] >= 1 ? (int)params[12] : 1;
+    cgUpdate = (int)params[13];
+    bbType = (int)params[14];
+    cgSolve = (int)params[15];
+    useNegCurv = (int)params[16];
+    if(method != SD && method != BB && method != CG && method != LBFGS && method != NEWTON0)
+        mexErrMsgTxt("method must be sd, bb, cg, lbfgs or newton0");
+    if(LS < 0 || LS > 5)
+        mexErrMsgTxt("LS must be 0..5");
+
+    nVars = mxGetNumberOfElements(prhs[1]);
+    obj.nVars = nVars;
+    obj.nDims = mxGetNumberOfDimensions(prhs[1]);
+    obj.dims = mxGetDimensions(prhs[1]);
+    obj.fun = prhs[0];
+    obj.HvFun = (nrhs > 4 && !mxIsEmpty(prhs[4])) ? prhs[4] : NULL;
+    obj.args = prhs + 5;
+    obj.nArgs = nrhs > 5 ? nrhs - 5 : 0;
+    obj.type = -1;
+    obj.X = obj.y = NULL;
+    obj.n = obj.p = 0;
+    if(mxIsChar(prhs[0]))
+    {
+        /* Compiled loss, varargin = {X,y} */
+        mxGetString(prhs[0],funName,sizeof(funName));
+        obj.type = linearLossType(funName);
+        if(obj.type < 0)
+            mexErrMsgTxt("Unknown loss type");
+        if(obj.nArgs < 2 || mxIsSparse(prhs[5]) || mxIsComplex(prhs[5]) || !mxIsDouble(prhs[5]) || !mxIsDouble(prhs[6]))
+            mexErrMsgTxt("A compiled loss needs a full real double X and a double y");
+        obj.X = mxGetPr(prhs[5]);
+        obj.y = mxGetPr(prhs[6]);
+        obj.n = mxGetM(prhs[5]);
+        obj.p = mxGetN(prhs[5]);
+        if(obj.p == 0 || nVars % obj.p != 0)
+            mexErrMsgTxt("numel(x0) must be a multiple of size(X,2)");
+        if((obj.type == LOGISTIC || obj.type == SQUARED || obj.type == SSVM) && nVars != obj.p)
+            mexErrMsgTxt("x0 must have size(X,2) elements");
+        if(mxGetNumberOfElements(prhs[6]) != (size_t)obj.n*(obj.type == SIM_LOGISTIC ? nVars/obj.p : 1))
+            mexErrMsgTxt("y does not match X and x0");
+        if(!linearLossLabelsValid(obj.type,obj.y,obj.n,nVars/obj.p))
+            mexErrMsgTxt("softmax labels y must be integers in 1..k");
+    }
+    else if(!mxIsClass(prhs[0],"function_handle"))
+        mexErrMsgTxt("funObj must be a function handle or the name of a compiled loss");
+
+    x = mxCalloc(nVars,sizeof(double));
+    g = mxCalloc(nVars,sizeof(double));
+    d = mxCalloc(nVars,sizeof(double));
+    g_old = mxCalloc(nVars,sizeof(double));
+    xt = mxCalloc(nVars,sizeof(double));
+    g_new = mxCalloc(nVars,sizeof(double));
+    g_prev = mxCalloc(nVars,sizeof(double));
+    bracketG[0] = mxCalloc(nVars,sizeof(double));
+    bracketG[1] = mxCalloc(nVars,sizeof(double));
+    s = mxCalloc(nVars,sizeof(double));
+    yv = mxCalloc(nVars,sizeof(double));
+    obj.work = mxCalloc(nVars,sizeof(double));
+    obj.work2 = mxCalloc(nVars,sizeof(double));
+    old_fvals = mxCalloc(Fref,sizeof(double));
+    cgR = cgY = cgP = cgAp = NULL;
+    if(method == NEWTON0)
+    {
+        cgR = mxCalloc(nVars,sizeof(double));
+        cgY = mxCalloc(nVars,sizeof(double));
+        cgP = mxCalloc(nVars,sizeof(double));
+        cgAp = mxCalloc(nVars,sizeof(double));
+    }
+    traceF = mxCalloc(maxIter + 1,sizeof(double));
+    traceCount = mxCalloc(maxIter + 1,sizeof(double));
+
+    /* L-BFGS memory and BB step, from the state of a previous call if its size fits */
+    mem.nVars = nVars;
+    mem.m = corrections;
+    mem.k = mem.start = 0;
+    mem.Hdiag = 1;
+    mem.S = mxCalloc((size_t)nVars*corrections,sizeof(double));
+    mem.Y = mxCalloc((size_t)nVars*corrections,sizeof(double));
+    mem.ro = mxCalloc(corrections,sizeof(double));
+    mem.alpha = mxCalloc(corrections,sizeof(double));
+    alpha = 1;
+    warm = 0;
+    if(nrhs > 3 && mxIsStruct(prhs[3]))
+    {
+        const mxArray *S = mxGetField(prhs[3],0,"S"), *Y = mxGetField(prhs[3],0,"Y");
+        const mxArray *H = mxGetField(prhs[3],0,"Hdiag"), *A = mxGetField(prhs[3],0,"alpha");
+        if(S && Y && H && A && mxIsDouble(S) && mxIsDouble(Y) && mxGetM(S) == (size_t)nVars
+                && mxGetM(Y) == (size_t)nVars && mxGetN(S) == mxGetN(Y))
+        {
+            k = mxGetN(S);
+            for(j = (k > corrections ? k - corrections : 0); j < k; j++)
+                lbfgsUpdate(&mem,mxGetPr(Y) + (size_t)nVars*j,mxGetPr(S) + (size_t)nVars*j);
+            mem.Hdiag = mxGetScalar(H);
+            alpha = mxGetScalar(A);
+            warm = 1;
+        }
+    }
+
+    /* Evaluate Initial Point */
+    memcpy(x,mxGetPr(prhs[1]),nVars*sizeof(double));
+    f = evalObjective(&obj,x,g);
+    funEvals = 1;
+
+    /* Output Log */
+    if(verboseI)
+        mexPrintf("%10s %10s %15s %15s %15s\n","Iteration","FunEvals","Step Length","Function Val","Opt Cond");
+
+    /* Initialize Trace */
+    nTrace = 0;
+    traceF[nTrace] = f;
+    traceCount[nTrace++] = funEvals;
+
+    t = 1;
+    f_old = gtd_old = myF_old = 0;
+    exitflag = 0;
+    iter = 0;
+    msg = "Exceeded Maximum Number of Iterations";
+
+    /* Check optimality of initial point */
+    if(sumAbs(g,nVars) <= tolFun)
+    {
+        exitflag = 1;
+        msg = "Optimality Condition below TolFun";
+        maxIter = 0;
+    }
+
+    /* Perform up to a maximum of 'maxIter' descent steps */
+    for(i = 1; i <= maxIter; i++)
+    {
+        iter = i;
+
+        /* ****************** COMPUTE DESCENT DIRECTION ***************** */
+        switch(method)
+        {
+            case SD:
+                for(j = 0; j < nVars; j++)
+                    d[j] = -g[j];
+                break;
+
+            case BB:
+                if(i > 1)
+                {
+                    double sy, ss, yy, alphaConic;
+                    for(j = 0; j < nVars; j++)
+                    {
+                        yv[j] = g[j] - g_old[j];
+                        s[j] = t*d[j];
+                    }
+                    sy = dot(s,yv,nVars);
+                    if(bbType == 0)
+                    {
+                        yy = dot(yv,yv,nVars);
+                        alpha = sy/yy;
+                    }
+                    else
+                        alpha = dot(s,s,nVars)/sy;
+                    if(alpha <= 1e-10 || alpha > 1e10)
+                        alpha = 1;
+                    if(bbType == 2)
+                    {
+                        /* Conic Interpolation ('Modified BB') */
+                        ss = dot(s,s,nVars);
+                        alphaConic = ss/(6*(myF_old - f) + 4*dot(g,s,nVars) + 2*dot(g_old,s,nVars));
+                        if(alphaConic > .001*alpha && alphaConic < 1000*alpha)
+                            alpha = alphaConic;
+                    }
+                }
+                for(j = 0; j < nVars; j++)
+                    d[j] = (i > 1 || warm) ? -alpha*g[j] : -g[j];
+                memcpy(g_old,g,nVars*sizeof(double));
+                myF_old = f;
+                break;
+
+            case CG:
+                if(i == 1)
+                {
+                    for(j = 0; j < nVars; j++)
+                        d[j] = -g[j];
+                }
+                else
+                {
+                    double gtgo = dot(g,g_old,nVars), gotgo = dot(g_old,g_old,nVars), gg = dot(g,g,nVars);
+                    double beta_FR, beta_PR;
+                    if(cgUpdate == 0)
+                        beta = gg/gotgo;                    /* Fletcher-Reeves */
+                    else if(cgUpdate == 1)
+                        beta = (gg - gtgo)/gotgo;           /* Polak-Ribiere */
+                    else if(cgUpdate == 2)
+                    {
+                        /* Hestenes-Stiefel */
+                        double den = 0;
+                        for(j = 0; j < nVars; j++)
+                            den += (g[j] - g_old[j])*d[j];
+                        beta = (gg - gtgo)/den;
+                    }
+                    else
+                    {
+                        /* Gilbert-Nocedal */
+                        beta_FR = (gg - gtgo)/gotgo;
+                        beta_PR = (gg - gtgo)/gotgo;
+                        beta = fmax(-beta_FR,fmin(beta_PR,beta_FR));
+                    }
+                    for(j = 0; j < nVars; j++)
+                        d[j] = -g[j] + beta*d[j];
+
+                    /* Restart if not a direction of sufficient descent */
+                    if(dot(g,d,nVars) > -tolX)
+                    {
+                        for(j = 0; j < nVars; j++)
+                            d[j] = -g[j];
+                    }
+                }
+                memcpy(g_old,g,nVars*sizeof(double));
+                break;
+
+            case LBFGS:
+                if(i > 1)
+                {
+                    for(j = 0; j < nVars; j++)
+                    {
+                        yv[j] = g[j] - g_old[j];
+                        s[j] = t*d[j];
+                    }
+                    lbfgsUpdate(&mem,yv,s);
+                }
+                if(i > 1 || warm)
+                {
+                    for(j = 0; j < nVars; j++)
+                        yv[j] = -g[j];
+                    lbfgsMultiply(&mem,yv,d);
+                }
+                else
+                {
+                    for(j = 0; j < nVars; j++)
+                        d[j] = -g[j];
+                }
+                memcpy(g_old,g,nVars*sizeof(double));
+                break;
+
+            case NEWTON0:
+                cgMaxIter = nVars < maxFunEvals - funEvals ? nVars : maxFunEvals - funEvals;
+                gnorm = sqrt(dot(g,g,nVars));
+                /* L-BFGS preconditioner for 'pnewton0' */
+                if(cgSolve == 1 && i > 1)
+                {
+                    for(j = 0; j < nVars; j++)
+                    {
+                        yv[j] = g[j] - g_old[j];
+                        s[j] = t*d[j];
+                    }
+                    lbfgsUpdate(&mem,yv,s);
+                }
+                cgIter = conjGrad(&obj,x,g,fmin(0.5,sqrt(gnorm))*gnorm,cgMaxIter,
+                        (cgSolve == 1 && (i > 1 || warm)) ? &mem : NULL,useNegCurv,
+                        d,s,&hasNegCurv,cgR,cgY,cgP,cgAp);
+                memcpy(g_old,g,nVars*sizeof(double));
+                funEvals += cgIter;
+                if(hasNegCurv)
+                {
+                    mexPrintf("Using negative curvature direction\n");
+                    nrm = sqrt(dot(s,s,nVars))*sumAbs(g,nVars);
+                    for(j = 0; j < nVars; j++)
+                        d[j] = s[j]/nrm;
+                }
+                break;
+        }
+
+        if(!isLegal(d,nVars))
+        {
+            mexPrintf("Step direction is illegal!\n");
+            exitflag = -1;
+            msg = "Step direction is illegal";
+            break;
+        }
+
+        /* ****************** COMPUTE STEP LENGTH ************************ */
+
+        /* Directional Derivative */
+        gtd = dot(g,d,nVars);
+
+        /* Check that progress can be made along direction */
+        if(gtd > -tolX)
+        {
+            exitflag = 2;
+            msg = "Directional Derivative below TolX";
+            break;
+        }
+
+        /* Select Initial Guess */
+        if(i == 1)
+        {
+            if(method < NEWTON0 && !(warm && (method == LBFGS || method == BB)))
+                t = fmin(1,1/sumAbs(g,nVars));
+            else
+                t = 1;
+        }
+        else
+        {
+            if(LS_init == 0)
+                t = 1;
+            else if(LS_init == 1)
+                t = t*fmin(2,gtd_old/gtd);
+            else if(LS_init == 2)
+                t = fmin(1,2*(f - f_old)/gtd);
+            else if(LS_init == 3)
+                t = fmin(1,t*2);
+            else if(LS_init == 4)
+            {
+                /* Scaled step length if possible */
+                double dHd;
+                hessVec(&obj,x,g,d,yv);
+                dHd = dot(d,yv,nVars);
+                funEvals++;
+                if(dHd > 0)
+                    t = -gtd/dHd;
+                else
+                    t = fmin(1,2*(f - f_old)/gtd);
+            }
+            if(t <= 0)
+                t = 1;
+        }
+        f_old = f;
+        gtd_old = gtd;
+
+        /* Compute reference fr if using non-monotone objective */
+        if(Fref == 1)
+            fr = f;
+        else
+        {
+            if(i == 1)
+            {
+                for(j = 0; j < Fref; j++)
+                    old_fvals[j] = -mxGetInf();
+            }
+            if(i <= Fref)
+                old_fvals[i-1] = f;
+            else
+            {
+                memmove(old_fvals,old_fvals + 1,(Fref-1)*sizeof(double));
+                old_fvals[Fref-1] = f;
+            }
+            fr = old_fvals[0];
+            for(j = 1; j < Fref; j++)
+                fr = fmax(fr,old_fvals[j]);
+        }
+
+        /* Line Search */
+        if(LS < 3)
+        {
+            funEvals += armijoBacktrack(&obj,x,&t,d,f,fr,g,gtd,c1,LS,tolX,xt,&f,g_new);
+            memcpy(x,xt,nVars*sizeof(double));
+        }
+        else
+        {
+            funEvals += wolfeLineSearch(&obj,x,&t,d,f,g,gtd,c1,c2,LS,tolX,&f,g_new,xt,g_prev,bracketG);
+            for(j = 0; j < nVars; j++)
+                x[j] += t*d[j];
+        }
+        memcpy(g,g_new,nVars*sizeof(double));
+
+        /* Output iteration information */
+        if(verboseI)
+            mexPrintf("%10d %10d %15.5e %15.5e %15.5e\n",i,funEvals,t,f,sumAbs(g,nVars));
+
+        /* Update Trace */
+        traceF[nTrace] = f;
+        traceCount[nTrace++] = funEvals;
+
+        /* Check Optimality Condition */
+        if(sumAbs(g,nVars) <= tolFun)
+        {
+            exitflag = 1;
+            msg = "Optimality Condition below TolFun";
+            break;
+        }
+
+        /* Check for lack of progress */
+        if(fabs(t)*sumAbs(d,nVars) <= tolX)
+        {
+            exitflag = 2;
+            msg = "Step Size below TolX";
+            break;
+        }
+        if(fabs(f - f_old) < tolX)
+        {
+            exitflag = 2;
+            msg = "Function Value changing by less than TolX";
+            break;
+        }
+
+        /* Check for going over iteration/evaluation limit */
+        if(funEvals > maxFunEvals)
+        {
+            exitflag = 0;
+            msg = "Exceeded Maximum Number of Function Evaluations";
+            break;
+        }
+        if(i == maxIter)
+        {
+            exitflag = 0;
+            msg = "Exceeded Maximum Number of Iterations";
+            break;
+        }
+    }
+
+    if(verbose)
+        mexPrintf("%s\n",msg);
+
+    /* Output */
+    plhs[0] = mxCreateNumericArray(obj.nDims,obj.dims,mxDOUBLE_CLASS,mxREAL);
+    memcpy(mxGetPr(plhs[0]),x,nVars*sizeof(double));
+    if(nlhs > 1)
+        plhs[1] = mxCreateDoubleScalar(f);
+    if(nlhs > 2)
+        plhs[2] = mxCreateDoubleScalar(exitflag);
+    if(nlhs > 3)
+    {
+        /* State: the L-BFGS pairs oldest first, Hdiag and the BB step */
+        state = mxCreateStructMatrix(1,1,4,stateFields);
+        mxSetField(state,0,"S",mxCreateDoubleMatrix(nVars,mem.k,mxREAL));
+        mxSetField(state,0,"Y",mxCreateDoubleMatrix(nVars,mem.k,mxREAL));
+        for(j = 0; j < mem.k; j++)
+        {
+            k = (mem.start + j) % mem.m;
+            memcpy(mxGetPr(mxGetField(state,0,"S")) + (size_t)nVars*j,mem.S + (size_t)nVars*k,nVars*sizeof(double));
+            memcpy(mxGetPr(mxGetField(state,0,"Y")) + (size_t)nVars*j,mem.Y + (size_t)nVars*k,nVars*sizeof(double));
+        }
+        mxSetField(state,0,"Hdiag",mxCreateDoubleScalar(mem.Hdiag));
+        mxSetField(state,0,"alpha",mxCreateDoubleScalar(alpha));
+
+        trace = mxCreateStructMatrix(1,1,2,traceFields);
+        mxSetField(trace,0,"fval",columnVector(traceF,nTrace));
+        mxSetField(trace,0,"funcCount",columnVector(traceCount,nTrace));
+
+        output = mxCreateStructMatrix(1,1,7,outputFields);
+        mxSetField(output,0,"iterations",mxCreateDoubleScalar(iter));
+        mxSetField(output,0,"funcCount",mxCreateDoubleScalar(funEvals));
+        mxSetField(output,0,"algorithm",mxCreateDoubleScalar(method));
+        mxSetField(output,0,"firstorderopt",mxCreateDoubleScalar(sumAbs(g,nVars)));
+        mxSetField(output,0,"message",mxCreateString(msg));
+        mxSetField(output,0,"trace",trace);
+        mxSetField(output,0,"state",state);
+        plhs[3] = output;
+    }
+
+    /* Free Memory */
+    mxFree(x);
+    mxFree(g);
+    mxFree(d);
+    mxFree(g_old);
+    mxFree(xt);
+    mxFree(g_new);
+    mxFree(g_prev);
+    mxFree(bracketG[0]);
+    mxFree(bracketG[1]);
+    mxFree(s);
+    mxFree(yv);
+    mxFree(obj.work);
+    mxFree(obj.work2);
+    mxFree(old_fvals);
+    if(method == NEWTON0)
+    {
+        mxFree(cgR);
+        mxFree(cgY);
+        mxFree(cgP);
+        mxFree(cgAp);
+    }
+    mxFree(traceF);
+    mxFree(traceCount);
+    mxFree(mem.S);
+    mxFree(mem.Y);
+    mxFree(mem.ro);
+    mxFree(mem.alpha);
+}
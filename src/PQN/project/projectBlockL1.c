@@ -6,6 +6,10 @@
    ASSUMPTION: nIndices is a column vector
    WARNING: Transformation is done in-place!
    WARNING: No parameter checking is done!
+
+   The block columns below the diagonal are projected in parallel; the
+   blocks above the diagonal are then filled in by a tiled transpose of
+   the ones below, which avoids walking the matrix with stride s.
 */
 
 #include <string.h>
@@ -14,6 +18,30 @@
 #include "oneProjectorCore.h"
 #include "mex.h"
 
+/* Tile size of the transposed copy */
+#define TILE 32
+
+
+/* ----------------------------------------------------------------------- */
+static void copyTransposed(double *W, int s, int offsetM, int offsetN, int r, int c)
+/* ----------------------------------------------------------------------- */
+/* Copies the r-by-c block at (offsetN, offsetM) transposed into the
+   c-by-r block at (offsetM, offsetN) of the s-by-s matrix W. */
+{  int p, q, p0, q0, p1, q1;
+   double *src = W + offsetN + (long)offsetM * s;   /* r-by-c, below diagonal */
+   double *dst = W + offsetM + (long)offsetN * s;   /* c-by-r, above diagonal */
+
+   for (q0 = 0; q0 < c; q0 += TILE)
+   {  q1 = (q0 + TILE < c) ? q0 + TILE : c;
+      for (p0 = 0; p0 < r; p0 += TILE)
+      {  p1 = (p0 + TILE < r) ? p0 + TILE : r;
+         for (p = p0; p < p1; p++)
+            for (q = q0; q < q1; q++)
+               dst[q + (long)p * s] = src[p + (long)q * s];
+      }
+   }
+}
+
 
 /* ----------------------------------------------------------------------- */
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -24,13 +52,10 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
    double        *nIndicesPtr;
    const mxArray *lambda;
    double        *lambdaPtr;
-   double        *scratchX = NULL, *scratchP = NULL;
 
-   double        *src, *dst, tau, v;
+   int           *offset;
+   int            i,j,m,n,s,failed = 0;
 
-   int            i,j,m,n,p,q,r,s,offsetM,offsetN;
-   unsigned int   dims[2];
-   
 
    /* Extract parameters */
    matrixW     = (mxArray *)prhs[0];
@@ -40,112 +65,94 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
    lambda      = prhs[2];
    lambdaPtr   = mxGetPr(lambda);
 
+   m = mxGetM(nIndices);
+   s = mxGetM(matrixW);     /* Stride: number of rows in W */
+
+   /* Offsets of the blocks */
+   offset = mxMalloc(sizeof(int) * (m + 1));
+   offset[0] = 0;
+   for (i = 0; i < m; i++) offset[i+1] = offset[i] + (int)nIndicesPtr[i];
+
    /* Determine maximum number of elements in a single group */
-   /* and allocate memory for scratch buffer */
    n = 0;
-   for (i = 0; i < mxGetM(nIndices); i++)
+   for (i = 0; i < m; i++)
    {  if (nIndicesPtr[i] > n)  n = nIndicesPtr[i];
    }
-   scratchX = malloc(sizeof(double) * n * n);
-   scratchP = malloc(sizeof(double) * n * n);
-   if ((scratchX == NULL) || (scratchP == NULL))
-   {  if (scratchX != NULL) free(scratchX);
-      if (scratchP != NULL) free(scratchP);
+
+   /* Process the blocks on and below the diagonal, (i,j) with i >= j */
+   #pragma omp parallel private(i)
+   {  /* Scratch buffers of every thread */
+      double *scratchX = malloc(sizeof(double) * ((long)n * n + 1));
+      double *scratchP = malloc(sizeof(double) * ((long)n * n + 1));
+      if ((scratchX == NULL) || (scratchP == NULL))
+      {
+         #pragma omp atomic write
+         failed = 1;
+      }
+
+      #pragma omp for schedule(dynamic)
+      for (j = 0; j < m; j++)
+      {  if ((scratchX == NULL) || (scratchP == NULL)) continue;
+         for (i = j; i < m; i++)
+         {  int     p, q, r, c;
+            double *src, *dst, tau, v;
+
+            src = matrixWPtr + offset[i] + (long)offset[j] * s;
+            tau = lambdaPtr[i+j*m];
+            r   = offset[i+1] - offset[i];   /* Number of rows in current block */
+            c   = offset[j+1] - offset[j];
+
+            if (i == j)
+            {  /* Deal with diagonal blocks */
+               for (q = 0; q < c; q++, src += s)
+               {  for (p = 0; p < r; p++)
+                  {  v = src[p];
+                     if (v < -tau) src[p] = -tau;
+                     else if (v > tau) src[p] = tau;
+                  }
+               }
+            }
+            else
+            {  /* Copy block without signs */
+               dst = scratchX;
+               for (q = 0; q < c; q++)
+               {  for (p = 0; p < r; p++) *dst++ = fabs(src[p + (long)q * s]);
+               }
+
+               /* Do projection */
+               memcpy((void *)scratchP,(void *)scratchX,sizeof(double)*r*c);
+               projectI(scratchP, scratchX, tau, r*c);
+
+               /* Copy back with signs */
+               dst = scratchP;
+               for (q = 0; q < c; q++)
+               {  for (p = 0; p < r; p++, dst++)
+                  {  v = src[p + (long)q * s];
+                     src[p + (long)q * s] = (v < 0) ? -(*dst) : *dst;
+                  }
+               }
+            }
+         }
+      }
+
+      /* Free memory */
+      free(scratchX);
+      free(scratchP);
+   }
+   if (failed)
+   {  mxFree(offset);
       mexErrMsgTxt("Cannot allocate memory for scratch");
    }
 
-   /* Process non-diagonal blocks */
-   m = mxGetM(nIndices);
-   n = mxGetM(nIndices);
-   s = mxGetM(matrixW);     /* Stride: number of rows in W */
-   offsetN = 0;
-   for (j = 0; j < n; j++)
-   {   offsetM = 0;
-       for(i = 0; i < m; i++)
-       {   /* Set indicex */
-           src  = matrixWPtr + offsetM + offsetN * s;
-           dst  = scratchX;
-           tau  = lambdaPtr[i+j*m];
-
-           /* Deal with diagonal blocks */
-           if (i == j)
-           {
-              r = nIndicesPtr[i]; /* Number of rows in current block */
-              for (q = 0; q < nIndicesPtr[j]; q++)
-              {  for (p = 0; p < r; p++)
-                 {  v = *src;
-                    if (v < 0)
-                    {  if (v < -tau) *src = -tau;
-                    }
-                    else
-                    {  if (v > tau) *src = tau;
-                    }
-
-                    src ++;
-                 }
-                 src = src + s - r;
-              }
-           }
-           else if (i > j)
-           { 
-              /* Number of rows in current block */
-              r = nIndicesPtr[i];
-
-              /* Copy block without signs */
-              for (q = 0; q < nIndicesPtr[j]; q++)
-              {  for (p = 0; p < r; p++)
-                 {  *dst = fabs(*src);
-                    dst ++; src ++;
-                 }
-                 src = src + s - r;
-              }
-
-              /* Do projection */
-              memcpy((void *)scratchP,(void *)scratchX,sizeof(double)*nIndicesPtr[j]*r);
-              projectI(scratchP,scratchX, tau,nIndicesPtr[j]*r);
-
-              /* Copy back with signs */
-              src  = scratchP;
-              dst  = matrixWPtr + offsetM + offsetN * s;
-              for (q = 0; q < nIndicesPtr[j]; q++)
-              {  for (p = 0; p < r; p++)
-                 {  v = *dst;
-                    if (v < 0)
-                         *dst = (*src) * -1;
-                    else *dst = (*src);
-                    dst ++; src ++;
-                 }
-                 dst = dst + s - r;
-              }
-           }
-           else /* Copy result from symmetric block */
-           {   
-              /* Number of rows in current block */
-              r = nIndicesPtr[i];
-
-              /* Copy block in transpose*/
-              src = matrixWPtr + offsetM * s + offsetN;
-              dst = matrixWPtr + offsetM + offsetN * s;
-              for (q = 0; q < nIndicesPtr[j]; q++)
-              {  for (p = 0; p < r; p++)
-                 {  *dst = *src;
-                    dst ++; src += s;
-                 }
-                 dst = dst + s - r;
-                 src = src + 1 - r*s;
-              }
-           }
-
-           offsetM = offsetM + nIndicesPtr[i];
-       }
-       offsetN = offsetN + nIndicesPtr[j];
+   /* Copy result from symmetric blocks */
+   #pragma omp parallel for schedule(dynamic) private(i)
+   for (j = 1; j < m; j++)
+   {  for (i = 0; i < j; i++)
+         copyTransposed(matrixWPtr, s, offset[i], offset[j],
+                        offset[j+1] - offset[j], offset[i+1] - offset[i]);
    }
 
-
-   /* Free memory */
-   free(scratchX);
-   free(scratchP);
+   mxFree(offset);
 
    return ;
 }
-
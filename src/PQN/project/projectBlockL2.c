@@ -1,19 +1,46 @@
-/* projectBlockL1.c
+/* projectBlockL2.c
    $Id$
 
-   W = projectBlockL1(W, nIndices, lambda)
+   W = projectBlockL2(W, nIndices, lambda)
 
    ASSUMPTION: nIndices is a column vector
    WARNING: Transformation is done in-place!
    WARNING: No parameter checking is done!
+
+   The block columns below the diagonal are projected in parallel; the
+   blocks above the diagonal are then filled in by a tiled transpose of
+   the ones below, which avoids walking the matrix with stride s.
 */
 
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
-#include "oneProjectorCore.h"
 #include "mex.h"
 
+/* Tile size of the transposed copy */
+#define TILE 32
+
+
+/* ----------------------------------------------------------------------- */
+static void copyTransposed(double *W, int s, int offsetM, int offsetN, int r, int c)
+/* ----------------------------------------------------------------------- */
+/* Copies the r-by-c block at (offsetN, offsetM) transposed into the
+   c-by-r block at (offsetM, offsetN) of the s-by-s matrix W. */
+{  int p, q, p0, q0, p1, q1;
+   double *src = W + offsetN + (long)offsetM * s;   /* r-by-c, below diagonal */
+   double *dst = W + offsetM + (long)offsetN * s;   /* c-by-r, above diagonal */
+
+   for (q0 = 0; q0 < c; q0 += TILE)
+   {  q1 = (q0 + TILE < c) ? q0 + TILE : c;
+      for (p0 = 0; p0 < r; p0 += TILE)
+      {  p1 = (p0 + TILE < r) ? p0 + TILE : r;
+         for (p = p0; p < p1; p++)
+            for (q = q0; q < q1; q++)
+               dst[q + (long)p * s] = src[p + (long)q * s];
+      }
+   }
+}
+
 
 /* ----------------------------------------------------------------------- */
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -25,11 +52,9 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
    const mxArray *lambda;
    double        *lambdaPtr;
 
-   double        *src, *dst, tau, v, w;
+   int           *offset;
+   int            i,j,m,s;
 
-   int            i,j,m,n,p,q,r,s,offsetM,offsetN;
-   unsigned int   dims[2];
-   
 
    /* Extract parameters */
    matrixW     = (mxArray *)prhs[0];
@@ -39,90 +64,66 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
    lambda      = prhs[2];
    lambdaPtr   = mxGetPr(lambda);
 
-   /* Process non-diagonal blocks */
    m = mxGetM(nIndices);
-   n = mxGetM(nIndices);
    s = mxGetM(matrixW);     /* Stride: number of rows in W */
-   offsetN = 0;
-   for (j = 0; j < n; j++)
-   {   offsetM = 0;
-       for(i = 0; i < m; i++)
-       {   /* Set indicex */
-           src  = matrixWPtr + offsetM + offsetN * s;
-           tau  = lambdaPtr[i+j*m];
-
-           /* Deal with diagonal blocks */
-           if (i == j)
-           {
-              r = nIndicesPtr[i]; /* Number of rows in current block */
-              for (q = 0; q < nIndicesPtr[j]; q++)
-              {  for (p = 0; p < r; p++)
-                 {  v = *src;
-                    if (v < 0)
-                    {  if (v < -tau) *src = -tau;
-                    }
-                    else
-                    {  if (v > tau) *src = tau;
-                    }
-
-                    src ++;
-                 }
-                 src = src + s - r;
-              }
-           }
-           else if (i > j)
-           { 
-              /* Number of rows in current block */
-              r = nIndicesPtr[i];
-
-              /* Compute norm */
-              v = 0;
-              for (q = 0; q < nIndicesPtr[j]; q++)
-              {  for (p = 0; p < r; p++)
-                 {  w = *src;
-                    v = v + w * w;                    
-                    src ++;
-                 }
-                 src = src + s - r;
-              }
-              v = sqrt(v);
-
-              /* Scale entries if needed */
-              src = matrixWPtr + offsetM + offsetN * s;
-              if (v > tau)
-              {  v = tau / v;
-                 for (q = 0; q < nIndicesPtr[j]; q++)
-                 {  for (p = 0; p < r; p++)
-                    {  *src *= v;
-                       src ++;
-                    }
-                    src = src + s - r;
-                 }
-              }
-           }
-           else /* Copy result from symmetric block */
-           {   
-              /* Number of rows in current block */
-              r = nIndicesPtr[i];
-
-              /* Copy block in transpose*/
-              src = matrixWPtr + offsetM * s + offsetN;
-              dst = matrixWPtr + offsetM + offsetN * s;
-              for (q = 0; q < nIndicesPtr[j]; q++)
-              {  for (p = 0; p < r; p++)
-                 {  *dst = *src;
-                    dst ++; src += s;
-                 }
-                 dst = dst + s - r;
-                 src = src + 1 - r*s;
-              }
-           }
-
-           offsetM = offsetM + nIndicesPtr[i];
-       }
-       offsetN = offsetN + nIndicesPtr[j];
+
+   /* Offsets of the blocks */
+   offset = mxMalloc(sizeof(int) * (m + 1));
+   offset[0] = 0;
+   for (i = 0; i < m; i++) offset[i+1] = offset[i] + (int)nIndicesPtr[i];
+
+   /* Process the blocks on and below the diagonal, (i,j) with i >= j */
+   #pragma omp parallel for schedule(dynamic) private(i)
+   for (j = 0; j < m; j++)
+   {  for (i = j; i < m; i++)
+      {  int     p, q, r, c;
+         double *src, tau, v;
+
+         src = matrixWPtr + offset[i] + (long)offset[j] * s;
+         tau = lambdaPtr[i+j*m];
+         r   = offset[i+1] - offset[i];   /* Number of rows in current block */
+         c   = offset[j+1] - offset[j];
+
+         if (i == j)
+         {  /* Deal with diagonal blocks */
+            for (q = 0; q < c; q++, src += s)
+            {  for (p = 0; p < r; p++)
+               {  v = src[p];
+                  if (v < -tau) src[p] = -tau;
+                  else if (v > tau) src[p] = tau;
+               }
+            }
+         }
+         else
+         {  /* Compute norm */
+            v = 0;
+            for (q = 0; q < c; q++)
+            {  const double *col = src + (long)q * s;
+               #pragma omp simd reduction(+:v)
+               for (p = 0; p < r; p++) v = v + col[p] * col[p];
+            }
+            v = sqrt(v);
+
+            /* Scale entries if needed */
+            if (v > tau)
+            {  v = tau / v;
+               for (q = 0; q < c; q++)
+                  for (p = 0; p < r; p++)
+                     src[p + (long)q * s] *= v;
+            }
+         }
+      }
+   }
+
+   /* Copy result from symmetric blocks */
+   #pragma omp parallel for schedule(dynamic) private(i)
+   for (j = 1; j < m; j++)
+   {  for (i = 0; i < j; i++)
+         copyTransposed(matrixWPtr, s, offset[i], offset[j],
+                        offset[j+1] - offset[j], offset[i+1] - offset[i]);
    }
 
+   mxFree(offset);
+
    return ;
 }
-
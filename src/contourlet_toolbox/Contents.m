@@ -9,6 +9,10 @@
 %Main functions: Contourlets pyramidal directional filter bank
 % PDFBDEC    Pyramidal Directional Filter Bank (or Contourlet) Decomposition
 % PDFBREC    Pyramid Directional Filterbank Reconstruction
+% PDFBDEC_VEC  PDFB decomposition straight into the vector form of PDFB2VEC
+% PDFBREC_VEC  PDFB reconstruction from the vector form of PDFB2VEC
+% PDFBDECC   Mex file used in PDFBDEC_VEC (ladder filters)
+% PDFBRECC   Mex file used in PDFBREC_VEC (ladder filters)
 % 
 %Retrieve filters by names  
 % PFILTERS   Generate filters for the Laplacian pyramid
@@ -6,5 +6,5 @@ cFilesStr = dir('*.c');
 cFilenames = {cFilesStr.name};
 
 for ii = 1:length(cFilenames)
-    mex(cFilenames{ii});
+    mex('CFLAGS=$CFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', cFilenames{ii});
 end
\ No newline at end of file
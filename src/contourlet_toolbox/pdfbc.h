@@ -0,0 +1,795 @@
+/* Pyramidal directional filter bank with ladder directional filters,
+ * shared by pdfbdecc.c and pdfbrecc.c
+ *
+ * Computes the same coefficients as PDFBDEC / PDFBREC with the ladder
+ * ('pkva*') directional filters, stored in the vector layout of PDFB2VEC:
+ *
+ *	- the Laplacian pyramid only evaluates the samples kept by the
+ *	  downsampling and only the taps which hit the nonzero samples of
+ *	  the upsampled image (polyphase filtering);
+ *	- the quincunx and parallelogram polyphase components (QPDEC, PPDEC),
+ *	  the resampling of BACKSAMP and the final reordering of the subbands
+ *	  are evaluated as single index maps into their destination, no
+ *	  resampled intermediate copy is made;
+ *	- the separable ladder filters (SEFILTER2) run as column updates
+ *	  the compiler vectorizes;
+ *	- the subbands of every directional level are processed in parallel.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ */
+
+#ifndef _PDFBC_H_
+#define _PDFBC_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* extension modes of EXTEND2 */
+#define EXT_PER		0
+#define EXT_QPER_COL	1
+
+/* two-channel splits of the DFB: quincunx '1r' and '2c' (QPDEC),
+ * parallelogram types 1 to 4 (PPDEC) */
+#define PP_Q1R		0
+#define PP_Q2C		1
+#define PP_P1		2
+#define PP_P2		3
+#define PP_P3		4
+#define PP_P4		5
+
+/* filters of one transform */
+typedef struct {
+    const double *h, *g;	/* pyramid filters (PFILTERS) */
+    int lh, lg;
+    double *f;			/* ladder filter (LDFILTER), odd taps negated */
+    int lf;
+} pdfb_filters;
+
+
+static int
+pmod(int a, int m)
+{
+    a %= m;
+    return (a < 0) ? a + m : a;
+}
+
+
+/* y = sefilter2(x, f, f, extmod, [shift, shift]) of a virtual m x n image.
+ *
+ * up = 2:	the image is dup(x, [2, 2]), x is (m/2) x (n/2)
+ * down = 2:	only y(1:2:end, 1:2:end) is computed, y is (m/2) x (n/2)
+ *
+ * The columns are filtered first, from a padded copy of each column, then
+ * the rows as weighted sums of whole columns. Returns 0, or -1 if out of
+ * memory. */
+static int
+sefilter2c(double *y, const double *x, int m, int n, const double *f, int lf,
+	   int shift, int extmod, int up, int down)
+{
+    int rows_out = m / down, cols_out = n / down;
+    int xm = m / up, xn = n / up;
+    int ru = (lf - 1) / 2 + shift;	/* extension above / left */
+    int cx2 = (n + 1) / 2;		/* round(n / 2) of 'qper_col' */
+    int failed = 0;
+    double *t;
+    int sc, b;
+
+    t = (double *) malloc(((size_t) rows_out * xn + 1) * sizeof(double));
+    if (t == NULL)
+	return -1;
+
+    /* Column pass: t(:, sc) = filtered column sc of x, for the rows kept */
+#pragma omp parallel if ((size_t) m * xn > 65536)
+    {
+	double *buf = (double *) malloc((m + lf) * sizeof(double));
+
+	if (buf == NULL)
+	{
+#pragma omp atomic write
+	    failed = 1;
+	}
+
+#pragma omp for schedule(static)
+	for (sc = 0; sc < xn; sc++)
+	{
+	    double *tc = t + (size_t) sc * rows_out;
+	    int c = sc * up, e, i, k, a;
+
+	    if (buf == NULL)
+		continue;
+
+	    /* buf[e] = extended column at row e - ru */
+	    for (e = 0; e < m + lf - 1; e++)
+	    {
+		i = e - ru;
+		if ((i >= 0) && (i < m))
+		    buf[e] = (up == 1) ? x[i + (size_t) c * xm] :
+			((i & 1) ? 0 : x[i / 2 + (size_t) sc * xm]);
+		else if (extmod == EXT_QPER_COL)
+		    buf[e] = x[pmod(i, m) + (size_t) ((c + cx2) % n) * m];
+		else
+		{
+		    i = pmod(i, m);
+		    buf[e] = (up == 1) ? x[i + (size_t) c * xm] :
+			((i & 1) ? 0 : x[i / 2 + (size_t) sc * xm]);
+		}
+	    }
+
+	    for (a = 0; a < rows_out; a++)
+		tc[a] = 0;
+
+	    for (k = 0; k < lf; k++)
+	    {
+		const double *src = buf + (lf - 1 - k);
+		double fk = f[k];
+
+		if (down == 2)
+		{
+#pragma omp simd
+		    for (a = 0; a < rows_out; a++)
+			tc[a] += fk * src[2 * a];
+		}
+		else if (up == 2)
+		{
+		    /* only the even rows of the upsampled column are nonzero */
+		    for (a = (lf - 1 - k - ru) & 1; a < rows_out; a += 2)
+			tc[a] += fk * src[a];
+		}
+		else
+		{
+#pragma omp simd
+		    for (a = 0; a < rows_out; a++)
+			tc[a] += fk * src[a];
+		}
+	    }
+	}
+
+	free(buf);
+    }
+
+    if (failed)
+    {
+	free(t);
+	return -1;
+    }
+
+    /* Row pass: y(:, b) = sum over the taps of the (periodic) columns of t */
+#pragma omp parallel for schedule(static) if ((size_t) rows_out * cols_out > 65536)
+    for (b = 0; b < cols_out; b++)
+    {
+	double *yc = y + (size_t) b * rows_out;
+	int k, a, vc;
+
+	for (a = 0; a < rows_out; a++)
+	    yc[a] = 0;
+
+	for (k = 0; k < lf; k++)
+	{
+	    const double *src;
+	    double fk = f[k];
+
+	    vc = pmod(b * down + lf - 1 - k - ru, n);
+	    /* zero column of the upsampled image */
+	    if ((up == 2) && (vc & 1))
+		continue;
+	    src = t + (size_t) (vc / up) * rows_out;
+
+#pragma omp simd
+	    for (a = 0; a < rows_out; a++)
+		yc[a] += fk * src[a];
+	}
+    }
+
+    free(t);
+    return 0;
+}
+
+
+/* Size of the two polyphase components of an m x n image */
+static void
+polyphase_size(int type, int m, int n, int *pm, int *pn)
+{
+    if ((type == PP_Q1R) || (type == PP_P1) || (type == PP_P2))
+    {
+	*pm = m / 2;
+	*pn = n;
+    }
+    else
+    {
+	*pm = m;
+	*pn = n / 2;
+    }
+}
+
+
+/* Position (i, j) in the m x n image of sample (a, b) of polyphase
+ * component 'phase', i.e. QPDEC ('1r', '2c') and PPDEC (1 to 4) with
+ * their resamplings folded into one index map */
+static void
+polyphase_index(int type, int phase, int a, int b, int m, int n, int *i, int *j)
+{
+    switch (type)
+    {
+    case PP_Q1R:	/* Q1 = R2 * D1 * R3 */
+	*j = pmod(b + a + phase, n);
+	*i = pmod(2 * a + phase - *j, m);
+	break;
+
+    case PP_Q2C:	/* Q2 = R4 * D2 * R1 */
+	*i = pmod(a + b + phase, m);
+	*j = pmod(2 * b + phase - *i, n);
+	break;
+
+    case PP_P1:		/* P1 = D1 * R3 */
+	*i = 2 * a + phase;
+	*j = pmod(b + a + phase, n);
+	break;
+
+    case PP_P2:		/* P2 = D1 * R4 */
+	*i = 2 * a + phase;
+	*j = pmod(b - a, n);
+	break;
+
+    case PP_P3:		/* P3 = D2 * R1 */
+	*i = pmod(a + b + phase, m);
+	*j = 2 * b + phase;
+	break;
+
+    default:		/* P4 = D2 * R2 */
+	*i = pmod(a - b, m);
+	*j = 2 * b + phase;
+	break;
+    }
+}
+
+
+/* FBDEC_L: one ladder two-channel split of the m x n image x into y0
+ * and y1. tmp holds m * n / 2 doubles. */
+static int
+ladder_dec(double *y0, double *y1, const double *x, int m, int n, int type,
+	   const pdfb_filters *flt, double *tmp)
+{
+    int extmod = (type == PP_Q1R) ? EXT_QPER_COL : EXT_PER;
+    int pm, pn, a, b, i, j;
+    size_t k, np;
+
+    polyphase_size(type, m, n, &pm, &pn);
+    np = (size_t) pm * pn;
+
+    for (b = 0; b < pn; b++)
+	for (a = 0; a < pm; a++)
+	{
+	    polyphase_index(type, 0, a, b, m, n, &i, &j);
+	    y0[a + (size_t) b * pm] = x[i + (size_t) j * m];
+	    polyphase_index(type, 1, a, b, m, n, &i, &j);
+	    y1[a + (size_t) b * pm] = x[i + (size_t) j * m];
+	}
+
+    /* y0 = (p0 - sefilter2(p1, f, f, extmod, [1, 1])) / sqrt(2) */
+    if (sefilter2c(tmp, y1, pm, pn, flt->f, flt->lf, 1, extmod, 1, 1))
+	return -1;
+    for (k = 0; k < np; k++)
+	y0[k] = (1 / sqrt(2)) * (y0[k] - tmp[k]);
+
+    /* y1 = -sqrt(2) * p1 - sefilter2(y0, f, f, extmod) */
+    if (sefilter2c(tmp, y0, pm, pn, flt->f, flt->lf, 0, extmod, 1, 1))
+	return -1;
+    for (k = 0; k < np; k++)
+	y1[k] = (-sqrt(2) * y1[k]) - tmp[k];
+
+    return 0;
+}
+
+
+/* FBREC_L: merges y0 and y1 (overwritten) into the m x n image x */
+static int
+ladder_rec(double *x, double *y0, double *y1, int m, int n, int type,
+	   const pdfb_filters *flt, double *tmp)
+{
+    int extmod = (type == PP_Q1R) ? EXT_QPER_COL : EXT_PER;
+    int pm, pn, a, b, i, j;
+    size_t k, np;
+
+    polyphase_size(type, m, n, &pm, &pn);
+    np = (size_t) pm * pn;
+
+    /* p1 = -(y1 + sefilter2(y0, f, f, extmod)) / sqrt(2) */
+    if (sefilter2c(tmp, y0, pm, pn, flt->f, flt->lf, 0, extmod, 1, 1))
+	return -1;
+    for (k = 0; k < np; k++)
+	y1[k] = (-1 / sqrt(2)) * (y1[k] + tmp[k]);
+
+    /* p0 = sqrt(2) * y0 + sefilter2(p1, f, f, extmod, [1, 1]) */
+    if (sefilter2c(tmp, y1, pm, pn, flt->f, flt->lf, 1, extmod, 1, 1))
+	return -1;
+    for (k = 0; k < np; k++)
+	y0[k] = sqrt(2) * y0[k] + tmp[k];
+
+    for (b = 0; b < pn; b++)
+	for (a = 0; a < pm; a++)
+	{
+	    polyphase_index(type, 0, a, b, m, n, &i, &j);
+	    x[i + (size_t) j * m] = y0[a + (size_t) b * pm];
+	    polyphase_index(type, 1, a, b, m, n, &i, &j);
+	    x[i + (size_t) j * m] = y1[a + (size_t) b * pm];
+	}
+
+    return 0;
+}
+
+
+/* Split of parent k (0-based) at level l (1-based) of an n-level DFB,
+ * as in DFBDEC_L */
+static int
+dfb_split_type(int l, int k)
+{
+    if (l == 1)
+	return PP_Q1R;
+    if (l == 2)
+	return PP_Q2C;
+    if (k < (1 << (l - 2)))
+	return PP_P1 + k % 2;
+    return PP_P3 + k % 2;
+}
+
+
+/* Sizes of the 2^n subbands of the DFB of an m x n image, in the order
+ * before the final flip of DFBDEC_L. Returns -1 if a split meets an odd
+ * size. */
+static int
+dfb_sizes(int m, int n, int nlev, int *rows, int *cols)
+{
+    int l, k, pm, pn;
+
+    rows[0] = m;
+    cols[0] = n;
+    for (l = 1; l <= nlev; l++)
+    {
+	for (k = (1 << (l - 1)) - 1; k >= 0; k--)
+	{
+	    int type = dfb_split_type(l, k);
+
+	    if ((((type == PP_Q1R) || (type == PP_P1) || (type == PP_P2)) && (rows[k] % 2)) ||
+		(((type == PP_Q2C) || (type == PP_P3) || (type == PP_P4)) && (cols[k] % 2)))
+		return -1;
+	    polyphase_size(type, rows[k], cols[k], &pm, &pn);
+	    rows[2 * k] = rows[2 * k + 1] = pm;
+	    cols[2 * k] = cols[2 * k + 1] = pn;
+	}
+    }
+    return 0;
+}
+
+
+/* Position in subband t (m x n, order before the flip) of sample (i, j)
+ * of the backsampled subband (BACKSAMP) */
+static void
+backsamp_index(int nlev, int t, int i, int j, int m, int n, int *si, int *sj)
+{
+    int half = 1 << (nlev - 1), shift;
+
+    if (nlev == 1)
+    {
+	/* resamp(y, 4), then resamp(., 1) of the odd and even columns */
+	*si = pmod(i + j / 2, m);
+	*sj = pmod(j - *si, n);
+    }
+    else if (nlev == 2)
+    {
+	*si = i;
+	*sj = j;
+    }
+    else if (t < half)
+    {
+	shift = 2 * (t / 2 + 1) - ((1 << (nlev - 2)) + 1);
+	*si = i;
+	*sj = pmod(j + shift * i, n);
+    }
+    else
+    {
+	shift = 2 * ((t - half) / 2 + 1) - ((1 << (nlev - 2)) + 1);
+	*si = pmod(i + shift * j, m);
+	*sj = j;
+    }
+}
+
+
+/* Index before the flip of DFBDEC_L of the output subband d */
+static int
+dfb_flip(int nlev, int d)
+{
+    int half = 1 << (nlev - 1);
+
+    return (d < half) ? d : 3 * half - 1 - d;
+}
+
+
+/* Runs one level of the DFB tree over all its subbands in parallel: the
+ * 2^(l-1) parents in src (size S each) are split into the 2^l children in
+ * dst (decomposition) or merged back (reconstruction, dst holds the
+ * children and src receives the parents). */
+static int
+dfb_level(double *src, double *dst, int l, const int *rows, const int *cols,
+	  size_t S, int reconstruct, const pdfb_filters *flt)
+{
+    int nparent = 1 << (l - 1), failed = 0, k;
+
+#pragma omp parallel if (nparent > 1)
+    {
+	double *tmp = (double *) malloc((S / 2 + 1) * sizeof(double));
+
+	if (tmp == NULL)
+	{
+#pragma omp atomic write
+	    failed = 1;
+	}
+
+#pragma omp for schedule(dynamic)
+	for (k = 0; k < nparent; k++)
+	{
+	    /* DFBDEC_L stores the lowpass child second from level 2 on */
+	    double *y0 = dst + (2 * k + (l > 1)) * (S / 2);
+	    double *y1 = dst + (2 * k + (l == 1)) * (S / 2);
+	    int type = dfb_split_type(l, k), err;
+
+	    if (tmp == NULL)
+		continue;
+
+	    if (reconstruct)
+		err = ladder_rec(src + k * S, y0, y1, rows[k], cols[k], type, flt, tmp);
+	    else
+		err = ladder_dec(y0, y1, src + k * S, rows[k], cols[k], type, flt, tmp);
+	    if (err)
+	    {
+#pragma omp atomic write
+		failed = 1;
+	    }
+	}
+
+	free(tmp);
+    }
+
+    return failed ? -1 : 0;
+}
+
+
+/* DFBDEC_L of the m x n image x with nlev levels, the 2^nlev subbands are
+ * written one after the other to c. buf0 and buf1 hold m * n doubles. */
+static int
+dfbdecc(double *c, const double *x, int m, int n, int nlev,
+	const pdfb_filters *flt, double *buf0, double *buf1)
+{
+    size_t N = (size_t) m * n, S;
+    int *rows, *cols, l, d, nsub = 1 << nlev;
+    double *src, *dst;
+
+    if (nlev == 0)
+    {
+	memcpy(c, x, N * sizeof(double));
+	return 0;
+    }
+
+    rows = (int *) malloc((2 * nsub + 1) * sizeof(int));
+    cols = rows + nsub;
+    if (rows == NULL)
+	return -1;
+
+    /* x is only read by the first level */
+    src = (double *) x;
+    dst = buf0;
+    for (l = 1; l <= nlev; l++)
+    {
+	S = N >> (l - 1);
+	dfb_sizes(m, n, l - 1, rows, cols);
+	if (dfb_level(src, dst, l, rows, cols, S, 0, flt))
+	{
+	    free(rows);
+	    return -1;
+	}
+	src = dst;
+	dst = (src == buf0) ? buf1 : buf0;
+    }
+
+    /* backsampling and flip, straight into the coefficient vector */
+    dfb_sizes(m, n, nlev, rows, cols);
+    S = N >> nlev;
+#pragma omp parallel for schedule(dynamic)
+    for (d = 0; d < nsub; d++)
+    {
+	int t = dfb_flip(nlev, d), i, j, si, sj;
+	int sm = rows[t], sn = cols[t];
+	const double *y = src + t * S;
+	double *cd = c + d * S;
+
+	for (j = 0; j < sn; j++)
+	    for (i = 0; i < sm; i++)
+	    {
+		backsamp_index(nlev, t, i, j, sm, sn, &si, &sj);
+		cd[i + (size_t) j * sm] = y[si + (size_t) sj * sm];
+	    }
+    }
+
+    free(rows);
+    return 0;
+}
+
+
+/* DFBREC_L: the m x n image x from the 2^nlev subbands in c */
+static int
+dfbrecc(double *x, const double *c, int m, int n, int nlev,
+	const pdfb_filters *flt, double *buf0, double *buf1)
+{
+    size_t N = (size_t) m * n, S;
+    int *rows, *cols, l, d, nsub = 1 << nlev;
+    double *src, *dst;
+
+    if (nlev == 0)
+    {
+	memcpy(x, c, N * sizeof(double));
+	return 0;
+    }
+
+    rows = (int *) malloc((2 * nsub + 1) * sizeof(int));
+    cols = rows + nsub;
+    if (rows == NULL)
+	return -1;
+
+    /* undo the flip and the backsampling (REBACKSAMP) */
+    dfb_sizes(m, n, nlev, rows, cols);
+    S = N >> nlev;
+    dst = buf0;
+#pragma omp parallel for schedule(dynamic)
+    for (d = 0; d < nsub; d++)
+    {
+	int t = dfb_flip(nlev, d), i, j, si, sj;
+	int sm = rows[t], sn = cols[t];
+	double *y = dst + t * S;
+	const double *cd = c + d * S;
+
+	for (j = 0; j < sn; j++)
+	    for (i = 0; i < sm; i++)
+	    {
+		backsamp_index(nlev, t, i, j, sm, sn, &si, &sj);
+		y[si + (size_t) sj * sm] = cd[i + (size_t) j * sm];
+	    }
+    }
+
+    src = buf1;
+    for (l = nlev; l >= 1; l--)
+    {
+	S = N >> (l - 1);
+	/* the last merge writes the image */
+	if (l == 1)
+	    src = x;
+	dfb_sizes(m, n, l - 1, rows, cols);
+	if (dfb_level(src, dst, l, rows, cols, S, 1, flt))
+	{
+	    free(rows);
+	    return -1;
+	}
+	dst = src;
+	src = (dst == buf0) ? buf1 : buf0;
+    }
+
+    free(rows);
+    return 0;
+}
+
+
+/* Number of coefficients of the PDFB of an m x n image with the levels
+ * nlevs[0..L-1] (coarsest first), and the rows of the structure matrix s
+ * of PDFB2VEC (nrows x 4, column major), if s is not NULL. Returns -1 if
+ * the image size does not allow the decomposition. */
+static int
+pdfb_layout(int m, int n, const int *nlevs, int L, double *s, int nrows, size_t *nc)
+{
+    int *rows, *cols, p, d, r = 0, maxsub = 1;
+
+    for (p = 0; p < L; p++)
+	if ((1 << nlevs[p]) > maxsub)
+	    maxsub = 1 << nlevs[p];
+
+    rows = (int *) malloc((2 * maxsub + 1) * sizeof(int));
+    cols = rows + maxsub;
+    if (rows == NULL)
+	return -1;
+
+    for (p = 0; p < L; p++)
+	if (((m >> p) % 2) || ((n >> p) % 2))
+	{
+	    free(rows);
+	    return -1;
+	}
+
+    *nc = (size_t) (m >> L) * (n >> L);
+    if (s)
+    {
+	s[0] = 1;
+	s[nrows] = 1;
+	s[2 * nrows] = m >> L;
+	s[3 * nrows] = n >> L;
+    }
+    r = 1;
+
+    for (p = 0; p < L; p++)
+    {
+	int pm = m >> (L - 1 - p), pn = n >> (L - 1 - p);
+
+	if (dfb_sizes(pm, pn, nlevs[p], rows, cols))
+	{
+	    free(rows);
+	    return -1;
+	}
+	for (d = 0; d < (1 << nlevs[p]); d++)
+	{
+	    int t = (nlevs[p] > 0) ? dfb_flip(nlevs[p], d) : 0;
+
+	    if (s)
+	    {
+		s[r] = p + 2;
+		s[r + nrows] = d + 1;
+		s[r + 2 * nrows] = rows[t];
+		s[r + 3 * nrows] = cols[t];
+	    }
+	    r++;
+	}
+	*nc += (size_t) pm * pn;
+    }
+
+    free(rows);
+    return 0;
+}
+
+
+/* LPDEC: coarse image lo ((m/2) x (n/2)) and difference d (m x n) of x */
+static int
+lpdecc(double *lo, double *d, const double *x, int m, int n, const pdfb_filters *flt)
+{
+    size_t k;
+
+    if (sefilter2c(lo, x, m, n, flt->h, flt->lh, 0, EXT_PER, 1, 2))
+	return -1;
+    if (sefilter2c(d, lo, m, n, flt->g, flt->lg, (flt->lg + 1) % 2, EXT_PER, 2, 1))
+	return -1;
+    for (k = 0; k < (size_t) m * n; k++)
+	d[k] = x[k] - d[k];
+    return 0;
+}
+
+
+/* LPREC: x (m x n) from the coarse image lo and the difference d, lo and
+ * d are overwritten */
+static int
+lprecc(double *x, double *lo, double *d, int m, int n, const pdfb_filters *flt)
+{
+    size_t k, nlo = (size_t) (m / 2) * (n / 2);
+
+    if (sefilter2c(x, d, m, n, flt->h, flt->lh, 0, EXT_PER, 1, 2))
+	return -1;
+    for (k = 0; k < nlo; k++)
+	lo[k] = lo[k] - x[k];
+    if (sefilter2c(x, lo, m, n, flt->g, flt->lg, (flt->lg + 1) % 2, EXT_PER, 2, 1))
+	return -1;
+    for (k = 0; k < (size_t) m * n; k++)
+	x[k] = x[k] + d[k];
+    return 0;
+}
+
+
+/* PDFBDEC followed by PDFB2VEC: the coefficients of the m x n image x go
+ * to c, laid out by pdfb_layout() */
+static int
+pdfbdecc(double *c, const double *x, int m, int n, const int *nlevs, int L,
+	 const pdfb_filters *flt)
+{
+    size_t N = (size_t) m * n, pos;
+    double *lo0 = NULL, *lo1 = NULL, *d, *buf0, *buf1;
+    const double *xc = x;
+    int p, err = 0;
+
+    if (L == 0)
+    {
+	memcpy(c, x, N * sizeof(double));
+	return 0;
+    }
+
+    d = (double *) malloc(3 * N * sizeof(double));
+    lo0 = (double *) malloc((N / 4 + 1) * sizeof(double));
+    lo1 = (double *) malloc((N / 16 + 1) * sizeof(double));
+    if ((d == NULL) || (lo0 == NULL) || (lo1 == NULL))
+    {
+	free(d);
+	free(lo0);
+	free(lo1);
+	return -1;
+    }
+    buf0 = d + N;
+    buf1 = d + 2 * N;
+
+    /* offset of the finest level: the lowpass image and the coarser
+     * levels come before it */
+    pos = (size_t) (m >> L) * (n >> L);
+    for (p = 0; p < L - 1; p++)
+	pos += (size_t) (m >> (L - 1 - p)) * (n >> (L - 1 - p));
+
+    for (p = L - 1; p >= 0; p--)
+    {
+	int pm = m >> (L - 1 - p), pn = n >> (L - 1 - p);
+	double *lo = ((L - 1 - p) % 2) ? lo1 : lo0;
+
+	err = lpdecc(lo, d, xc, pm, pn, flt) ||
+	    dfbdecc(c + pos, d, pm, pn, nlevs[p], flt, buf0, buf1);
+	if (err)
+	    break;
+
+	xc = lo;
+	if (p > 0)
+	    pos -= (size_t) (pm / 2) * (pn / 2);
+    }
+
+    if (!err)
+	memcpy(c, xc, (size_t) (m >> L) * (n >> L) * sizeof(double));
+
+    free(d);
+    free(lo0);
+    free(lo1);
+    return err ? -1 : 0;
+}
+
+
+/* VEC2PDFB followed by PDFBREC: the m x n image x from the coefficients c */
+static int
+pdfbrecc(double *x, const double *c, int m, int n, const int *nlevs, int L,
+	 const pdfb_filters *flt)
+{
+    size_t N = (size_t) m * n, pos;
+    double *lo, *d, *buf0, *buf1;
+    int p, err = 0;
+
+    if (L == 0)
+    {
+	memcpy(x, c, N * sizeof(double));
+	return 0;
+    }
+
+    d = (double *) malloc(3 * N * sizeof(double));
+    lo = (double *) malloc((N / 4 + 1) * sizeof(double));
+    if ((d == NULL) || (lo == NULL))
+    {
+	free(d);
+	free(lo);
+	return -1;
+    }
+    buf0 = d + N;
+    buf1 = d + 2 * N;
+
+    pos = (size_t) (m >> L) * (n >> L);
+    memcpy(lo, c, pos * sizeof(double));
+
+    for (p = 0; p < L; p++)
+    {
+	int pm = m >> (L - 1 - p), pn = n >> (L - 1 - p);
+	/* the finest level is reconstructed in x, the others in buf1 */
+	double *xp = (p == L - 1) ? x : buf1;
+
+	err = dfbrecc(d, c + pos, pm, pn, nlevs[p], flt, buf0, buf1) ||
+	    lprecc(xp, lo, d, pm, pn, flt);
+	if (err)
+	    break;
+
+	if (p < L - 1)
+	    memcpy(lo, xp, (size_t) pm * pn * sizeof(double));
+	pos += (size_t) pm * pn;
+    }
+
+    free(d);
+    free(lo);
+    return err ? -1 : 0;
+}
+
+#endif
@@ -0,0 +1,31 @@
+function [c, s] = pdfbdec_vec(x, pfilt, dfilt, nlevs)
+% PDFBDEC_VEC   PDFB decomposition straight into the vector form of PDFB2VEC
+%
+%       [c, s] = pdfbdec_vec(x, pfilt, dfilt, nlevs)
+%
+% Same result as [c, s] = pdfb2vec(pdfbdec(x, pfilt, dfilt, nlevs)). For
+% the ladder directional filters ('pkva', 'pkva6', 'pkva8', 'pkva12') with
+% nlevs > 0 the compiled PDFBDECC is used when it is available, otherwise
+% the MATLAB implementation.
+%
+% See also:	PDFBREC_VEC, PDFBDECC, PDFBDEC, PDFB2VEC
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if is_native(dfilt, nlevs)
+    [h, g] = pfilters(pfilt);
+    [c, s] = pdfbdecc(double(x), h, g, ldfilter(dfilt), nlevs);
+else
+    [c, s] = pdfb2vec(pdfbdec(x, pfilt, dfilt, nlevs));
+end
+
+
+function tf = is_native(dfilt, nlevs)
+tf = ischar(dfilt) && any(strcmp(dfilt, {'pkva', 'pkva6', 'pkva8', 'pkva12'})) && ...
+    ~isempty(nlevs) && all(nlevs > 0) && (exist('pdfbdecc', 'file') == 3);
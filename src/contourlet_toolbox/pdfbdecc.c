@@ -0,0 +1,91 @@
+/* Contourlet (PDFB) decomposition with ladder directional filters
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ */
+
+#include "mex.h"
+#include "pdfbc.h"
+
+/*
+  function [c, s] = pdfbdecc(x, h, g, f, nlevs)
+  % PDFBDECC	Mex file used in PDFBDEC_VEC
+  %
+  %	[c, s] = pdfbdecc(x, h, g, f, nlevs)
+  %
+  % Input:
+  %	x:	input image
+  %	h, g:	pyramid filters, [h, g] = pfilters(pfilt)
+  %	f:	ladder filter of the DFB, f = ldfilter(dfilt)
+  %	nlevs:	vector of positive numbers of directional levels, as in PDFBDEC
+  %
+  % Output:
+  %	c, s:	same as [c, s] = pdfb2vec(pdfbdec(x, pfilt, dfilt, nlevs))
+*/
+void
+mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    pdfb_filters flt;
+    double *nl, *s;
+    int *nlevs, L, m, n, k, nrows, err;
+    size_t nc;
+
+    /* Parse input */
+    if (nrhs != 5)
+	mexErrMsgTxt("PDFBDECC needs five inputs: x, h, g, f and nlevs.");
+    if (nlhs > 2)
+	mexErrMsgTxt("Too many output arguments.");
+
+    for (k = 0; k < 4; k++)
+	if (!mxIsDouble(prhs[k]) || mxIsComplex(prhs[k]) || mxIsSparse(prhs[k]) ||
+	    (mxGetNumberOfDimensions(prhs[k]) > 2))
+	    mexErrMsgTxt("The image and the filters must be real double matrices.");
+
+    m = (int) mxGetM(prhs[0]);
+    n = (int) mxGetN(prhs[0]);
+
+    flt.h = mxGetPr(prhs[1]);
+    flt.lh = (int) mxGetNumberOfElements(prhs[1]);
+    flt.g = mxGetPr(prhs[2]);
+    flt.lg = (int) mxGetNumberOfElements(prhs[2]);
+    flt.lf = (int) mxGetNumberOfElements(prhs[3]);
+    if ((flt.lh < 1) || (flt.lg < 1) || (flt.lf < 1))
+	mexErrMsgTxt("The filters must not be empty.");
+
+    L = (int) mxGetNumberOfElements(prhs[4]);
+    nl = mxGetPr(prhs[4]);
+    nlevs = (int *) mxMalloc((L + 1) * sizeof(int));
+    nrows = 1;
+    for (k = 0; k < L; k++)
+    {
+	if ((nl[k] != floor(nl[k])) || (nl[k] < 1) || (nl[k] > 16))
+	    mexErrMsgTxt("The numbers of directional levels must be positive integers (use PDFBDEC for wavelet levels).");
+	nlevs[k] = (int) nl[k];
+	nrows += 1 << nlevs[k];
+    }
+
+    if ((m < 1) || (n < 1) || pdfb_layout(m, n, nlevs, L, NULL, nrows, &nc))
+	mexErrMsgTxt("The image size does not allow this decomposition.");
+
+    /* FBDEC_L uses the ladder filter with its odd taps negated */
+    flt.f = (double *) mxMalloc(flt.lf * sizeof(double));
+    for (k = 0; k < flt.lf; k++)
+	flt.f[k] = (k % 2) ? mxGetPr(prhs[3])[k] : -mxGetPr(prhs[3])[k];
+
+    /* Create output, padded to an even length as in PDFB2VEC */
+    plhs[0] = mxCreateDoubleMatrix(nc + (nc % 2), 1, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(nrows, 4, mxREAL);
+    s = mxGetPr(plhs[1]);
+    pdfb_layout(m, n, nlevs, L, s, nrows, &nc);
+
+    err = pdfbdecc(mxGetPr(plhs[0]), mxGetPr(prhs[0]), m, n, nlevs, L, &flt);
+
+    mxFree(flt.f);
+    mxFree(nlevs);
+
+    if (err)
+	mexErrMsgTxt("Out of memory.");
+}
@@ -0,0 +1,41 @@
+function x = pdfbrec_vec(c, s, pfilt, dfilt)
+% PDFBREC_VEC   PDFB reconstruction from the vector form of PDFB2VEC
+%
+%       x = pdfbrec_vec(c, s, pfilt, dfilt)
+%
+% Same result as x = pdfbrec(vec2pdfb(c, s), pfilt, dfilt). For the ladder
+% directional filters ('pkva', 'pkva6', 'pkva8', 'pkva12') and a DFB on
+% every pyramid level the compiled PDFBRECC is used when it is available,
+% otherwise the MATLAB implementation.
+%
+% See also:	PDFBDEC_VEC, PDFBRECC, PDFBREC, VEC2PDFB
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if is_native(s, dfilt)
+    [h, g] = pfilters(pfilt);
+    x = pdfbrecc(double(c), s, h, g, ldfilter(dfilt));
+else
+    x = pdfbrec(vec2pdfb(c, s), pfilt, dfilt);
+end
+
+
+function tf = is_native(s, dfilt)
+tf = ischar(dfilt) && any(strcmp(dfilt, {'pkva', 'pkva6', 'pkva8', 'pkva12'})) && ...
+    (exist('pdfbrecc', 'file') == 3);
+if tf
+    % the wavelet (0 level DFB) layers are not supported natively
+    for l = 2:s(end, 1)
+        nd = sum(s(:, 1) == l);
+        if (nd < 2) || (bitand(nd, nd - 1) ~= 0)
+            tf = false;
+            return;
+        end
+    end
+end
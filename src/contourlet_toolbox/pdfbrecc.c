@@ -0,0 +1,105 @@
+/* Contourlet (PDFB) reconstruction with ladder directional filters
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ */
+
+#include "mex.h"
+#include "pdfbc.h"
+
+/*
+  function x = pdfbrecc(c, s, h, g, f)
+  % PDFBRECC	Mex file used in PDFBREC_VEC
+  %
+  %	x = pdfbrecc(c, s, h, g, f)
+  %
+  % Input:
+  %	c, s:	coefficients in the vector form of PDFB2VEC
+  %	h, g:	pyramid filters, [h, g] = pfilters(pfilt)
+  %	f:	ladder filter of the DFB, f = ldfilter(dfilt)
+  %
+  % Output:
+  %	x:	same as pdfbrec(vec2pdfb(c, s), pfilt, dfilt)
+*/
+void
+mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    pdfb_filters flt;
+    double *s, *s2;
+    int *nlevs, L, m, n, k, r, nrows, nd, err;
+    size_t nc = 0;
+
+    /* Parse input */
+    if (nrhs != 5)
+	mexErrMsgTxt("PDFBRECC needs five inputs: c, s, h, g and f.");
+    if (nlhs > 1)
+	mexErrMsgTxt("Too many output arguments.");
+
+    for (k = 0; k < 5; k++)
+	if (!mxIsDouble(prhs[k]) || mxIsComplex(prhs[k]) || mxIsSparse(prhs[k]) ||
+	    (mxGetNumberOfDimensions(prhs[k]) > 2))
+	    mexErrMsgTxt("The coefficients, the structure and the filters must be real double matrices.");
+
+    flt.h = mxGetPr(prhs[2]);
+    flt.lh = (int) mxGetNumberOfElements(prhs[2]);
+    flt.g = mxGetPr(prhs[3]);
+    flt.lg = (int) mxGetNumberOfElements(prhs[3]);
+    flt.lf = (int) mxGetNumberOfElements(prhs[4]);
+    if ((flt.lh < 1) || (flt.lg < 1) || (flt.lf < 1))
+	mexErrMsgTxt("The filters must not be empty.");
+
+    /* Levels from the structure: s(:, 1) is the layer of every subband */
+    s = mxGetPr(prhs[1]);
+    nrows = (int) mxGetM(prhs[1]);
+    if ((nrows < 1) || (mxGetN(prhs[1]) != 4))
+	mexErrMsgTxt("The structure s must have four columns.");
+
+    L = (int) s[nrows - 1] - 1;
+    if (L < 0)
+	mexErrMsgTxt("Invalid structure s.");
+    nlevs = (int *) mxMalloc((L + 1) * sizeof(int));
+    r = 1;
+    for (k = 0; k < L; k++)
+    {
+	for (nd = 0; (r < nrows) && (s[r] == k + 2); r++)
+	    nd++;
+	for (nlevs[k] = 0; (1 << nlevs[k]) < nd; nlevs[k]++)
+	    ;
+	if ((nd < 2) || ((1 << nlevs[k]) != nd))
+	    mexErrMsgTxt("The number of subbands of every level must be a power of two (use PDFBREC for wavelet levels).");
+    }
+
+    m = (int) s[2 * nrows] << L;
+    n = (int) s[3 * nrows] << L;
+
+    /* the structure has to match the one of the decomposition */
+    s2 = (double *) mxMalloc(4 * nrows * sizeof(double));
+    if ((r != nrows) || (m < 1) || (n < 1) || pdfb_layout(m, n, nlevs, L, s2, nrows, &nc))
+	mexErrMsgTxt("Invalid structure s.");
+    for (k = 0; k < 4 * nrows; k++)
+	if (s[k] != s2[k])
+	    mexErrMsgTxt("Invalid structure s.");
+    mxFree(s2);
+
+    if (mxGetNumberOfElements(prhs[0]) < nc)
+	mexErrMsgTxt("The coefficient vector is too short for the structure s.");
+
+    /* FBREC_L uses the ladder filter with its odd taps negated */
+    flt.f = (double *) mxMalloc(flt.lf * sizeof(double));
+    for (k = 0; k < flt.lf; k++)
+	flt.f[k] = (k % 2) ? mxGetPr(prhs[4])[k] : -mxGetPr(prhs[4])[k];
+
+    /* Create output */
+    plhs[0] = mxCreateDoubleMatrix(m, n, mxREAL);
+
+    err = pdfbrecc(mxGetPr(plhs[0]), mxGetPr(prhs[0]), m, n, nlevs, L, &flt);
+
+    mxFree(flt.f);
+    mxFree(nlevs);
+
+    if (err)
+	mexErrMsgTxt("Out of memory.");
+}
@@ -19,7 +19,7 @@ function y = wrapper_pdfb(x, s, pfilt, dfilt, nlevs, nz, nx, mode)
 % output arguments
 % X             inverse transformed image in the form of vector
 %
-% See also:	PDFBDEC, PDFBREC, VEC2PDFB, PDFB2VEC
+% See also:	PDFBDEC_VEC, PDFBREC_VEC, PDFBDEC, PDFBREC, VEC2PDFB, PDFB2VEC
 %
 %
 % This matlab source file is free for use in academic research.
@@ -31,13 +31,11 @@ function y = wrapper_pdfb(x, s, pfilt, dfilt, nlevs, nz, nx, mode)
 
 
 if (mode == 1) % inverse Contourlet transform
-    x = vec2pdfb(x, s);
-    y = pdfbrec(x, pfilt, dfilt);
+    y = pdfbrec_vec(x, s, pfilt, dfilt);
     y = y(:);
 elseif (mode == 2) % Contourlet transform
     x = reshape(x, nz, nx);
-    y = pdfbdec(x, pfilt, dfilt, nlevs);
-    y = pdfb2vec(y);
+    y = pdfbdec_vec(x, pfilt, dfilt, nlevs);
 else
     error('Wrong mode!');
 end
\ No newline at end of file
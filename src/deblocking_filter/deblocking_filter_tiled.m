@@ -0,0 +1,28 @@
+function out = deblocking_filter_tiled(in, deblocking_label, options)
+
+% Same result as deblocking_filter, evaluated by deblocking_filter_tiled_mex in overlapping tiles:
+% every tile goes through all the filtering stages on its own halo region, the tiles are processed
+% in parallel and no full-size intermediate matrix is allocated.
+%
+% options.tileSize   - side of the square output tiles (default 256)
+% options.outputFile - if set, the output is written to this file (r x c doubles, column major)
+%                      through a memory mapping, and a memmapfile of it is returned
+
+if ~exist('options', 'var')
+    options = struct();
+end
+
+tile_size = 256;
+if isfield(options, 'tileSize')
+    tile_size = options.tileSize;
+end
+
+if isfield(options, 'outputFile') && ~isempty(options.outputFile)
+    [r, c] = size(in);
+    deblocking_filter_tiled_mex(in, deblocking_label, tile_size, options.outputFile);
+    out = memmapfile(options.outputFile, 'Format', {'double', [r, c], 'x'}, 'Writable', false);
+else
+    out = deblocking_filter_tiled_mex(in, deblocking_label, tile_size);
+end
+
+end
\ No newline at end of file
@@ -0,0 +1,436 @@
+
+//Tiled deblocking pipeline: out = deblocking_filter_tiled_mex(in, deblocking_label, tile_size, output_file)
+//
+//Evaluates the same result as deblocking_filter.m without building the extended image or any of the
+//full-size intermediate matrices. The output is cut into tile_size x tile_size tiles (default 256) which
+//are processed in parallel; every tile runs all the stages on its own halo region:
+//  uniform kernel inpainting (h = 1.7)       on the tile +- (HALF_KERNEL + STEERING_HALF + 1)
+//  image gradients                           on the tile +- (HALF_KERNEL + STEERING_HALF)
+//  steering parameters (9 x 9 window)        on the tile +- HALF_KERNEL
+//  steered kernel inpainting, h from label   on the tile
+//All the values are evaluated with the rules of the extended image in its own coordinates, so a halo
+//which is clipped at the image border gives the same result as the full-size evaluation.
+//
+//If output_file is given, the output (r x c doubles, column major) is written to that file through a
+//memory mapping instead of being returned.
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <mex.h>
+#include "../Inpainting/steering_kernel.h"
+#include "../Kernel Steering Parameters/steering_tensor.h"
+
+//parameters of deblocking_filter.m
+#define IMAGE_EXT_LEN 9
+#define FILTER_SIZE 1.7
+#define STEERING_HALF 4                 //(image_ext_len - 1)/2, window of estimate_steering_parameters
+#define MIN_SIGMA 0.1
+#define H_SMOOTH_HALF 2                 //high_pass_filter_data(h, 1): gaussian of length 5
+
+#define DEFAULT_TILE_SIZE 256
+
+//label state of a pixel: zero, nonzero but not positive, positive
+#define LABEL_ZERO 0
+#define LABEL_NONZERO 1
+#define LABEL_POSITIVE 2
+
+double evaluate_ksize(double h);
+int row_map(int i, int r);
+int col_map(int j, int c);
+int label_ext_positive(const unsigned char *label_code, int r, int c, int i, int j);
+int deblock_tile(double *output, const double *input, const unsigned char *label_code, int r, int c, int a0, int a1, int b0, int b1, int half_kernel_size, const double *h_weights, double *work, kernel_coef *coef, double *V, double *A);
+
+void *map_output_file(const char *file_name, size_t bytes);
+void unmap_output_file(void *data, size_t bytes);
+
+
+//Initialize mex functions
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]){
+    
+    const mwSize *dims;
+    double *input, *output;
+    unsigned char *label_code;
+    char *output_file = NULL;
+    
+    double h_weights[2*H_SMOOTH_HALF + 1], weight_sum;
+    int rows, cols, tile_size, tiles_i, tiles_j, tile, half_kernel_size, halo, local_size;
+    int failed = 0, mapped = 0;
+    mwSize k;
+    
+    if ((nrhs < 2) || (nrhs > 4))
+        mexErrMsgTxt("Usage: out = deblocking_filter_tiled_mex(in, deblocking_label, tile_size, output_file)");
+    
+    if (!mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]) || mxIsSparse(prhs[0]) || (mxGetNumberOfDimensions(prhs[0]) > 2))
+        mexErrMsgTxt("The input image has to be a real double matrix.");
+    
+    dims = mxGetDimensions(prhs[0]);
+    rows = (int)dims[0];
+    cols = (int)dims[1];
+    
+    //the symmetric and periodic extensions of deblocking_filter.m need this many rows and columns
+    if ((rows < IMAGE_EXT_LEN + 1) || (cols < IMAGE_EXT_LEN))
+        mexErrMsgTxt("The input image has to have at least 10 rows and 9 columns.");
+    
+    if ((mxGetM(prhs[1]) != (mwSize)rows) || (mxGetN(prhs[1]) != (mwSize)cols) || mxIsSparse(prhs[1]) || !(mxIsDouble(prhs[1]) || mxIsLogical(prhs[1])))
+        mexErrMsgTxt("The deblocking label has to be a double or logical matrix of the size of the input image.");
+    
+    tile_size = DEFAULT_TILE_SIZE;
+    if ((nrhs > 2) && !mxIsEmpty(prhs[2]))
+        tile_size = (int)mxGetScalar(prhs[2]);
+    if (tile_size < 1)
+        mexErrMsgTxt("The tile size has to be positive.");
+    
+    if ((nrhs > 3) && !mxIsEmpty(prhs[3])){
+        if (!mxIsChar(prhs[3]))
+            mexErrMsgTxt("The output file name has to be a string.");
+        output_file = mxArrayToString(prhs[3]);
+    }
+    
+    input = mxGetPr(prhs[0]);
+    
+    //only the zero / nonzero / positive state of the label is used
+    label_code = ( unsigned char* )mxMalloc( (size_t)rows*cols*sizeof( unsigned char ) );
+    if (mxIsLogical(prhs[1])){
+        mxLogical *label = mxGetLogicals(prhs[1]);
+        for(k=0; k<(mwSize)rows*cols; k++)
+            label_code[k] = label[k] ? LABEL_POSITIVE : LABEL_ZERO;
+    }
+    else{
+        double *label = mxGetPr(prhs[1]);
+        for(k=0; k<(mwSize)rows*cols; k++)
+            label_code[k] = (label[k] > 0) ? LABEL_POSITIVE : ((label[k] != 0) ? LABEL_NONZERO : LABEL_ZERO);
+    }
+    
+    //vertical gaussian smoothing of the second h map, normalized as in high_pass_filter_data.m
+    weight_sum = 0;
+    for(k=0; k<2*H_SMOOTH_HALF + 1; k++){
+        double x = (double)k - H_SMOOTH_HALF;
+        h_weights[k] = exp(-(x*x)/2);
+        weight_sum = weight_sum + h_weights[k];
+    }
+    for(k=0; k<2*H_SMOOTH_HALF + 1; k++)
+        h_weights[k] = h_weights[k]/weight_sum;
+    
+    //the smoothed h map never exceeds FILTER_SIZE, so both inpainting stages use at most this kernel
+    half_kernel_size = (int)(evaluate_ksize(FILTER_SIZE)-1)/2;
+    halo = 2*half_kernel_size + STEERING_HALF + 1;
+    local_size = (tile_size + 2*halo)*(tile_size + 2*halo);
+    
+    if (output_file != NULL){
+        output = ( double* )map_output_file(output_file, (size_t)rows*cols*sizeof( double ));
+        mxFree(output_file);
+        if (output == NULL){
+            mxFree(label_code);
+            mexErrMsgTxt("Cannot create the memory mapped output file.");
+        }
+        mapped = 1;
+        plhs[0] = mxCreateDoubleMatrix(0, 0, mxREAL);
+    }
+    else{
+        plhs[0] = mxCreateDoubleMatrix(rows, cols, mxREAL);
+        output = mxGetPr(plhs[0]);
+    }
+    
+    tiles_i = (rows + tile_size - 1)/tile_size;
+    tiles_j = (cols + tile_size - 1)/tile_size;
+    
+    init_exp_lut();
+    
+    #pragma omp parallel
+    {
+        //in_ext, out_tmp, gx, gy, C00, C01, C11 of the halo region
+        double *work = ( double* )malloc( 7*(size_t)local_size*sizeof( double ) );
+        kernel_coef *coef = ( kernel_coef* )malloc( (size_t)local_size*sizeof( kernel_coef ) );
+        double *V = ( double* )malloc( CHANNELS*TILE_SIZE*(TILE_SIZE + 2*STEERING_HALF)*sizeof( double ) );
+        double *A = ( double* )malloc( TENSOR_SIZE*TILE_SIZE*sizeof( double ) );
+        
+        if ((work == NULL) || (coef == NULL) || (V == NULL) || (A == NULL)){
+            #pragma omp atomic write
+            failed = 1;
+        }
+        
+        #pragma omp for schedule(dynamic)
+        for(tile = 0; tile < tiles_i*tiles_j; tile++){
+            
+            int a0 = (tile % tiles_i)*tile_size;
+            int b0 = (tile / tiles_i)*tile_size;
+            int a1 = (a0 + tile_size < rows) ? a0 + tile_size : rows;
+            int b1 = (b0 + tile_size < cols) ? b0 + tile_size : cols;
+            
+            if ((work == NULL) || (coef == NULL) || (V == NULL) || (A == NULL))
+                continue;
+            
+            deblock_tile(output, input, label_code, rows, cols, a0, a1, b0, b1, half_kernel_size, h_weights, work, coef, V, A);
+        }
+        
+        free(work);
+        free(coef);
+        free(V);
+        free(A);
+    }
+    
+    mxFree(label_code);
+    
+    if (mapped)
+        unmap_output_file(output, (size_t)rows*cols*sizeof( double ));
+    
+    if (failed)
+        mexErrMsgTxt("Cannot allocate memory for the tile buffers.");
+    
+}
+
+
+//evaluate_ksize.m for a single pixel
+double evaluate_ksize(double h)
+{
+    double max_distance_to_pixel = 61;
+    double ksize = h*8;
+    
+    if (ksize > max_distance_to_pixel*2+1)
+        ksize = max_distance_to_pixel*2+1;
+    
+    //round() of C99 rounds halfway cases away from zero, as matlab does
+    return round((ksize - 3)/2)*2 + 3;
+}
+
+
+//row of the input image at row i of the extended image (symmetric extension)
+int row_map(int i, int r)
+{
+    if (i < IMAGE_EXT_LEN)
+        return IMAGE_EXT_LEN - i;
+    if (i >= r + IMAGE_EXT_LEN)
+        return r - 2 - (i - r - IMAGE_EXT_LEN);
+    return i - IMAGE_EXT_LEN;
+}
+
+
+//column of the input image at column j of the extended image (periodic extension)
+int col_map(int j, int c)
+{
+    if (j < IMAGE_EXT_LEN)
+        return c - IMAGE_EXT_LEN + j;
+    if (j >= c + IMAGE_EXT_LEN)
+        return j - c - IMAGE_EXT_LEN;
+    return j - IMAGE_EXT_LEN;
+}
+
+
+//deblocking_label > 0 after the label has been grown by one pixel in each direction and extended
+int label_ext_positive(const unsigned char *label_code, int r, int c, int i, int j)
+{
+    int ii = row_map(i, r);
+    int jj = col_map(j, c);
+    const unsigned char *p = label_code + ii + (size_t)jj*r;
+    
+    if (p[0] == LABEL_POSITIVE)
+        return 1;
+    //the neighbours of nonzero label pixels are set to 1
+    if (((ii > 0) && p[-1]) || ((ii < r-1) && p[1]) || ((jj > 0) && p[-r]) || ((jj < c-1) && p[r]))
+        return 1;
+    return 0;
+}
+
+
+//all the stages of deblocking_filter.m for the output pixels [a0, a1) x [b0, b1). The halo region is
+//addressed in extended image coordinates [gi0, gi1) x [gj0, gj1), stored in local column major arrays
+int deblock_tile(double *output, const double *input, const unsigned char *label_code, int r, int c, int a0, int a1, int b0, int b1, int half_kernel_size, const double *h_weights, double *work, kernel_coef *coef, double *V, double *A)
+{
+    int rows_ext = r + 2*IMAGE_EXT_LEN;
+    int cols_ext = c + 2*IMAGE_EXT_LEN;
+    
+    //the tile and its halo region in extended image coordinates
+    int ti0 = a0 + IMAGE_EXT_LEN, ti1 = a1 + IMAGE_EXT_LEN;
+    int tj0 = b0 + IMAGE_EXT_LEN, tj1 = b1 + IMAGE_EXT_LEN;
+    int halo = 2*half_kernel_size + STEERING_HALF + 1;
+    int gi0 = (ti0 - halo > 0) ? ti0 - halo : 0;
+    int gi1 = (ti1 + halo < rows_ext) ? ti1 + halo : rows_ext;
+    int gj0 = (tj0 - halo > 0) ? tj0 - halo : 0;
+    int gj1 = (tj1 + halo < cols_ext) ? tj1 + halo : cols_ext;
+    int lr = gi1 - gi0, lc = gj1 - gj0;
+    
+    double *in_ext = work, *out_tmp = work + lr*lc, *gx = work + 2*lr*lc, *gy = work + 3*lr*lc;
+    double *C00 = work + 4*lr*lc, *C01 = work + 5*lr*lc, *C11 = work + 6*lr*lc;
+    
+    int i, j, k, gi, gj, ext;
+    int i0, i1, j0, j1, si, sj, ei, ej;
+    
+    //extended input of the halo region
+    for(j=0; j<lc; j++){
+        const double *column = input + (size_t)col_map(gj0 + j, c)*r;
+        for(i=0; i<lr; i++)
+            in_ext[i + j*lr] = column[row_map(gi0 + i, r)];
+    }
+    
+    //uniform kernel inpainting with identity covariances, outside the extension only
+    for(k=0; k<lr*lc; k++)
+        set_kernel_coef(&coef[k], in_ext[k], 1, 1, 0, 1);
+    
+    ext = half_kernel_size + STEERING_HALF + 1;
+    for(gj = ((tj0-ext > gj0) ? tj0-ext : gj0); gj < ((tj1+ext < gj1) ? tj1+ext : gj1); gj++){
+        for(gi = ((ti0-ext > gi0) ? ti0-ext : gi0); gi < ((ti1+ext < gi1) ? ti1+ext : gi1); gi++){
+            i = gi - gi0;
+            j = gj - gj0;
+            if ((gi >= IMAGE_EXT_LEN) && (gi < rows_ext - IMAGE_EXT_LEN) && (gj >= IMAGE_EXT_LEN) && (gj < cols_ext - IMAGE_EXT_LEN))
+                steering_kernel_average(coef, lr, lc, i, j, half_kernel_size, FILTER_SIZE, &out_tmp[i + j*lr]);
+            else
+                out_tmp[i + j*lr] = in_ext[i + j*lr];
+        }
+    }
+    
+    //gradients as matlab's gradient(): central differences, one-sided at the image border
+    ext = half_kernel_size + STEERING_HALF;
+    i0 = (ti0-ext > gi0) ? ti0-ext : gi0;
+    i1 = (ti1+ext < gi1) ? ti1+ext : gi1;
+    j0 = (tj0-ext > gj0) ? tj0-ext : gj0;
+    j1 = (tj1+ext < gj1) ? tj1+ext : gj1;
+    for(gj = j0; gj < j1; gj++){
+        for(gi = i0; gi < i1; gi++){
+            k = (gi - gi0) + (gj - gj0)*lr;
+            
+            if (cols_ext < 2)
+                gx[k] = 0;
+            else if (gj == 0)
+                gx[k] = out_tmp[k + lr] - out_tmp[k];
+            else if (gj == cols_ext-1)
+                gx[k] = out_tmp[k] - out_tmp[k - lr];
+            else
+                gx[k] = (out_tmp[k + lr] - out_tmp[k - lr])/2;
+            
+            if (gi == 0)
+                gy[k] = out_tmp[k + 1] - out_tmp[k];
+            else if (gi == rows_ext-1)
+                gy[k] = out_tmp[k] - out_tmp[k - 1];
+            else
+                gy[k] = (out_tmp[k + 1] - out_tmp[k - 1])/2;
+        }
+    }
+    
+    //steering parameters: identity unless the whole window lies inside the extended image
+    ext = half_kernel_size;
+    i0 = (ti0-ext > gi0) ? ti0-ext : gi0;
+    i1 = (ti1+ext < gi1) ? ti1+ext : gi1;
+    j0 = (tj0-ext > gj0) ? tj0-ext : gj0;
+    j1 = (tj1+ext < gj1) ? tj1+ext : gj1;
+    for(gj = j0; gj < j1; gj++){
+        for(gi = i0; gi < i1; gi++){
+            k = (gi - gi0) + (gj - gj0)*lr;
+            C00[k] = 1;
+            C01[k] = 0;
+            C11[k] = 1;
+        }
+    }
+    
+    si = (i0 > STEERING_HALF) ? i0 : STEERING_HALF;
+    sj = (j0 > STEERING_HALF) ? j0 : STEERING_HALF;
+    ei = (i1 < rows_ext - STEERING_HALF) ? i1 : rows_ext - STEERING_HALF;
+    ej = (j1 < cols_ext - STEERING_HALF) ? j1 : cols_ext - STEERING_HALF;
+    for(gj = sj; gj < ej; gj += TILE_SIZE){
+        for(gi = si; gi < ei; gi += TILE_SIZE){
+            estimate_steering_tile(C00, C01, C11, NULL, NULL, NULL, gy, gx, NULL, NULL, MIN_SIGMA, STEERING_HALF, lr,
+                    gi - gi0, ((gi + TILE_SIZE < ei) ? gi + TILE_SIZE : ei) - gi0,
+                    gj - gj0, ((gj + TILE_SIZE < ej) ? gj + TILE_SIZE : ej) - gj0, V, A);
+        }
+    }
+    
+    //steered kernel inpainting of the tile, the samples around it carry their own steering parameters
+    for(gj = j0; gj < j1; gj++){
+        for(gi = i0; gi < i1; gi++){
+            k = (gi - gi0) + (gj - gj0)*lr;
+            set_kernel_coef(&coef[k], in_ext[k], 1, C00[k], C01[k], C11[k]);
+        }
+    }
+    
+    for(gj = tj0; gj < tj1; gj++){
+        for(gi = ti0; gi < ti1; gi++){
+            double h = 0;
+            
+            //h map: FILTER_SIZE on the label, smoothed along the rows with a symmetric extension at the border
+            for(k = -H_SMOOTH_HALF; k <= H_SMOOTH_HALF; k++){
+                int ii = gi + k;
+                if (ii < 0)
+                    ii = -ii;
+                if (ii >= rows_ext)
+                    ii = 2*(rows_ext-1) - ii;
+                if (label_ext_positive(label_code, r, c, ii, gj))
+                    h = h + h_weights[k + H_SMOOTH_HALF]*FILTER_SIZE;
+            }
+            
+            i = gi - gi0;
+            j = gj - gj0;
+            if (h > 0.2)
+                steering_kernel_average(coef, lr, lc, i, j, (int)(evaluate_ksize(h)-1)/2, h, &output[(gi - IMAGE_EXT_LEN) + (size_t)(gj - IMAGE_EXT_LEN)*r]);
+            else
+                output[(gi - IMAGE_EXT_LEN) + (size_t)(gj - IMAGE_EXT_LEN)*r] = in_ext[i + j*lr];
+        }
+    }
+    
+    return 0;
+}
+
+
+//creates the file and maps it for writing, unmap_output_file() releases it
+void *map_output_file(const char *file_name, size_t bytes)
+{
+#ifdef _WIN32
+    HANDLE file, mapping;
+    void *data;
+    
+    file = CreateFileA(file_name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)bytes >> 32), (DWORD)(bytes & 0xFFFFFFFF), NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+        return NULL;
+    data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, bytes);
+    //the view keeps the mapping object alive until UnmapViewOfFile()
+    CloseHandle(mapping);
+    return data;
+#else
+    int fd;
+    void *data;
+    
+    fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return NULL;
+    if (ftruncate(fd, (off_t)bytes) != 0){
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+    return data;
+#endif
+}
+
+
+void unmap_output_file(void *data, size_t bytes)
+{
+#ifdef _WIN32
+    (void)bytes;
+    FlushViewOfFile(data, 0);
+    UnmapViewOfFile(data);
+#else
+    msync(data, bytes, MS_SYNC);
+    munmap(data, bytes);
+#endif
+}
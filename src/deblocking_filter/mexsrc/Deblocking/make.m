@@ -0,0 +1,5 @@
+close all;
+clear;
+clc;
+
+mex CFLAGS='\$CFLAGS -std=c99 -fopenmp' LDFLAGS='\$LDFLAGS -fopenmp' deblocking_filter_tiled_mex.c;
\ No newline at end of file
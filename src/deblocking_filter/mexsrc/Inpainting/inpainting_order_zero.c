@@ -9,6 +9,7 @@
 
 #include <mex.h>
 #include "matrix_toolbox_ag.h"
+#include "steering_kernel.h"
 
 FILE *f1;
 
@@ -19,7 +20,7 @@ int find_minimum(double *input, double *input_minimum_value, int r, int c);
 double abs_value(double input);
 
 //int identity(double *input, int r, int c);
-int create_exponential_kernel(double *output, double *C00, double *C01, double *C11, double h, double *input_map, int rows, int cols, int i, int j, int half_ksize);
+int create_kernel_coefficients(kernel_coef *coef, double *input, double *input_map, double *C00, double *C01, double *C11, int rows, int cols);
 double square_val(double input);
 int find_maximum_vector(double *minimum, double *input, int samples);
 
@@ -91,135 +92,43 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]){
 int L2_regression(double *output, double *input, double *h, double *kernel_size_mat, int rows, int cols, double *input_map, double *C00, double *C01, double *C11, int ext, double *output_label)
 {
     
-    
     //loop variables
-    int i,j, k=0;
-    int ii;
-    int k_W = 0;
-    
-    //loop variables in the window
-    int i_win, j_win;
-    
-	//int ind_i, ind_j;
-
-    //int number_of_samples = kernel_size*kernel_size;
-    int number_of_samples;
-    
-    int half_kernel_size;
-    int original_half_kernel_size;
-    
-    double *W;
-    double *W_kernel;
-    double *z;
-    
-    //define covariance matrix array
-    double cov_mat[4] = {1, 0, 0, 1};
-    double *x_vec;
-    double *y_vec;
-    double h_val;
-    double threshold = 1.0e-5;
-    double weight_threshold;
-
-    int y_length;
-    int x_length;
-    int stop_here;
-    int max_number_of_samples = (int)square_val(61);
-    int min_number_of_samples;
-    double sum_weight;
-
-    W = ( double* )malloc( max_number_of_samples*sizeof( double) );
-    W_kernel = ( double* )malloc( max_number_of_samples*sizeof( double) );
-    z = ( double* )malloc( max_number_of_samples*sizeof( double) );
-    
-    
-    x_vec = ( double* )malloc( max_number_of_samples*sizeof( double) );
-    y_vec = ( double* )malloc( max_number_of_samples*sizeof( double) );
-    
-    
-    //matrix_init_ones(W, number_of_samples, 1);
-    //evaluate the weighting matrix based on Gaussian Kernel
-    //loop through each pixel
-    //matrix_initialize_vector(x_vec, -half_kernel_size, half_kernel_size);
+    int i;
     
-    //scan ordering of pixels
-    //matrix_initialize_vector(y_vec, half_kernel_size, -half_kernel_size);
+    int min_number_of_samples = 5;
     
-	//f1 = fopen("z.txt", "w");
+    kernel_coef *coef;
     
-	//value ext specifies the extensions which are applied to the input image. no filtering is applied in the extended 
-	
     //initialize the output_label
     //this matrix contains values which are deemed to be unreliable to the selection of h parameter
     matrix_init_ones(output_label, rows, cols);
     
+    //the steering parameters of every pixel are evaluated once, instead of once per window they fall in
+    coef = ( kernel_coef* )malloc( (size_t)rows*cols*sizeof( kernel_coef ) );
+    if (coef == NULL)
+        mexErrMsgTxt("Cannot allocate memory for the kernel coefficients.");
+    
+    create_kernel_coefficients(coef, input, input_map, C00, C01, C11, rows, cols);
+    init_exp_lut();
+    
+	//value ext specifies the extensions which are applied to the input image. no filtering is applied in the extended 
+	//rows are independent and processed in parallel
+    #pragma omp parallel for schedule(dynamic)
     for(i=ext; i< (rows-ext); i++){
+        
+        int j;
+        int half_kernel_size, number_of_samples;
+        
         for(j=ext; j<(cols-ext); j++){
-    
-            
             
-            
-	//		mexPrintf("%d %d.\n", 
-    //             i, j);
-
-			//fprintf(f1, "%d, %d \n", i, j);
-	
-			
-			original_half_kernel_size = (int)(kernel_size_mat[i + j*rows]-1)/2;
-    
-			if ((i ==  249) & (j == 50))
-                 stop_here = 1;
-
-            //if ( (h[i+j*rows] > 0.8) && (input[i+j*rows] >= 0) ){
-            if ( (h[i+j*rows] > 0.2)){    						
-				//mexPrintf("%d %d.\n", i, j);
-
-                h_val = h[i+j*rows];
-				
-                half_kernel_size = original_half_kernel_size;
+            if ( (h[i+j*rows] > 0.2)){
                 
-				min_number_of_samples = 5;
-				number_of_samples = 0;
-
-                                          
-				create_exponential_kernel(W_kernel, C00, C01, C11, h_val, input_map, rows, cols, i, j, half_kernel_size);
-
-                //create z vector
-                k_W = 0;
-                k = 0;
-                
-                //evaluate number_of_samples
-                //also find minimum distance to the nearest point
-
-                sum_weight = 0;
-                for(i_win= i-half_kernel_size; i_win <= i+half_kernel_size; i_win++){
-					if((i_win >= 0) && (i_win < rows)){
-						for(j_win= j-half_kernel_size; j_win <= j+half_kernel_size; j_win++){
-							if((j_win >= 0) && (j_win < cols)){
-								if (input_map[i_win+j_win*rows] == 1){
-									if (W_kernel[k_W] > threshold){
-										z[k] = input[i_win+j_win*rows];
-										W[k] = W_kernel[k_W];
-										sum_weight = sum_weight + W[k];
-                                        k++;
-									}
-									k_W++;
-								}
-							}
-						}
-					}
-                }
-                
-                number_of_samples = k;
+                half_kernel_size = (int)(kernel_size_mat[i + j*rows]-1)/2;
+                number_of_samples = steering_kernel_average(coef, rows, cols, i, j, half_kernel_size, h[i+j*rows], &output[i+j*rows]);
                 
                 if (number_of_samples < min_number_of_samples)
                     output_label[i+j*rows] = 0;
                 
-                output[i+j*rows] = 0;
-                for(ii = 0; ii < number_of_samples; ii++){
-                    output[i+j*rows] = output[i+j*rows] + W[ii]*z[ii];
-                }
-                output[i+j*rows] = output[i+j*rows]/(sum_weight);
-                
             }
             else{
                 output[i+j*rows] = input[i+j*rows];
@@ -228,11 +137,7 @@ int L2_regression(double *output, double *input, double *h, double *kernel_size_
         }
     }
     
-	free(x_vec);
-    free(y_vec);
-    free(W);
-    free(W_kernel);
-    free(z);
+    free(coef);
     
     return 0;
     
@@ -275,34 +180,20 @@ double square_val(double input){
 }
 
 
-int create_exponential_kernel(double *output, double *C00, double *C01, double *C11, double h, double *input_map, int rows, int cols, int i, int j, int half_ksize)
+//the part of the steering kernel which only depends on the sample pixel (steering_kernel.h)
+int create_kernel_coefficients(kernel_coef *coef, double *input, double *input_map, double *C00, double *C01, double *C11, int rows, int cols)
 {
-	int ii,jj,k = 0;
-    
-    double cov_mat[4];
-	double cov_det;
-
-
-	for(ii= -half_ksize; ii <= half_ksize; ii++){          
-		for(jj = -half_ksize; jj <= half_ksize; jj++){
-			//check the label to see, whether this pixel is located in the label
-			if (((i + ii) >= 0) && ((i + ii) < rows) && ((j+jj) >= 0) && ((j+jj) < cols)){
-                
-                cov_mat[0] = C00[(i+ii) +(j+jj)*rows];
-                cov_mat[1] = C01[(i+ii) +(j+jj)*rows];
-                cov_mat[2] = C01[(i+ii) +(j+jj)*rows];
-                cov_mat[3] = C11[(i+ii) +(j+jj)*rows];
-                
-                cov_det = cov_mat[0]*cov_mat[3] - cov_mat[1]*cov_mat[2];
-                
-                if (input_map[ (i+ii) +(j+jj)*rows] == 1){
-                    output[k] = 100*(1/(2*3.142*square_val(h)))* pow(cov_det, -0.5) * exp(-(1/cov_det)*(square_val(jj)*cov_mat[3] - 2*(ii)*(jj)*cov_mat[1] + square_val(ii)*cov_mat[0])/(2*square_val(h)));
-                    //output[k] = exp(-(1/cov_det)*(square_val(jj)*cov_mat[3] - 2*(ii)*(-jj)*cov_mat[1] + square_val(ii)*cov_mat[0])/(2*square_val(h)));
-                    k++;
-                }
-			}
-		}        
-	}
+    int j;
+    
+    #pragma omp parallel for
+    for(j=0; j<cols; j++){
+        int i, k;
+        for(i=0; i<rows; i++){
+            k = i + j*rows;
+            set_kernel_coef(&coef[k], input[k], input_map[k], C00[k], C01[k], C11[k]);
+        }
+    }
+    return 0;
 }
 
 int create_reweighted_kernel(double *W_reweighted, double *z, int number_of_samples, double *X, double *s){
@@ -357,4 +248,4 @@ int absolute_value(double *input){
 	if (*input < 0)
 		*input = -*input;
 
-}
\ No newline at end of file
+}
\ No newline at end of file
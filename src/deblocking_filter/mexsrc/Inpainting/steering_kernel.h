@@ -0,0 +1,117 @@
+//Steering kernel regression of order zero, shared by inpainting_order_zero.c and the tiled
+//deblocking pipeline (deblocking_filter_tiled_mex.c).
+//
+//The kernel weight of a sample at offset (ii, jj) from the pixel being filled is
+//100/(2*pi*h^2) * det(C)^(-1/2) * exp(-(jj^2*C11 - 2*ii*jj*C01 + ii^2*C00)/(det(C)*2*h^2))
+//with C the steering covariance at the sample. The part which only depends on the sample
+//pixel is evaluated once per pixel (kernel_coef), exp(-t) is read from a lookup table.
+
+#ifndef STEERING_KERNEL_H
+#define STEERING_KERNEL_H
+
+#include <math.h>
+
+
+//per pixel part of the steering kernel
+typedef struct {
+    double z;                   //sample value
+    double s;                   //det(C)^(-1/2), 0 if the pixel is not used
+    double c00, c01, c11;       //C/det(C)
+} kernel_coef;
+
+
+//s = 0 marks pixels which are not used: outside the map, or with a degenerate covariance,
+//for which the original weight is never above the threshold
+static void set_kernel_coef(kernel_coef *coef, double z, double map, double C00, double C01, double C11)
+{
+    double cov_det = C00*C11 - C01*C01;
+
+    coef->z = z;
+    if ((map == 1) && (cov_det > 0) && (cov_det < HUGE_VAL)){
+        coef->s = 1/sqrt(cov_det);
+        coef->c00 = C00/cov_det;
+        coef->c01 = C01/cov_det;
+        coef->c11 = C11/cov_det;
+    }
+    else{
+        coef->s = 0;
+        coef->c00 = coef->c01 = coef->c11 = 0;
+    }
+}
+
+
+//lookup table of exp(-t) on [0, EXP_LUT_RANGE), EXP_LUT_STEPS entries per unit, linearly
+//interpolated (relative error below 1e-7); other arguments fall back to exp().
+//init_exp_lut() has to be called before any parallel region using the table.
+#define EXP_LUT_RANGE 32
+#define EXP_LUT_STEPS 1024
+static double exp_lut[EXP_LUT_RANGE*EXP_LUT_STEPS + 2];
+static int exp_lut_ready = 0;
+
+static void init_exp_lut(void)
+{
+    int k;
+
+    if (exp_lut_ready)
+        return;
+    for(k=0; k<=EXP_LUT_RANGE*EXP_LUT_STEPS+1; k++)
+        exp_lut[k] = exp(-(double)k/EXP_LUT_STEPS);
+    exp_lut_ready = 1;
+}
+
+
+static double exp_lut_eval(double t)
+{
+    double x;
+    int k;
+
+    if ((t >= 0) && (t < EXP_LUT_RANGE)){
+        x = t*EXP_LUT_STEPS;
+        k = (int)x;
+        return exp_lut[k] + (x-k)*(exp_lut[k+1]-exp_lut[k]);
+    }
+    return exp(-t);
+}
+
+
+//kernel weighted average of the samples of the (2*half_kernel_size+1)^2 window around (i, j),
+//clipped to the rows-by-cols array coef; samples with a weight below 1e-5 are dropped.
+//Returns the number of samples used.
+static int steering_kernel_average(const kernel_coef *coef, int rows, int cols, int i, int j, int half_kernel_size, double h_val, double *output)
+{
+    double threshold = 1.0e-5;
+    double kernel_scale = 100*(1/(2*3.142*(h_val*h_val)));
+    double inv_2h2 = 1/(2*(h_val*h_val));
+    double sum_weight = 0, sum_value = 0, w, t;
+    int number_of_samples = 0;
+    int i_win, j_win, i_lo, i_hi, j_lo, j_hi;
+    const kernel_coef *p;
+
+    //clip the window to the image once, so the samples need no bounds checks
+    i_lo = (i - half_kernel_size < 0) ? -i : -half_kernel_size;
+    i_hi = (i + half_kernel_size >= rows) ? rows-1-i : half_kernel_size;
+    j_lo = (j - half_kernel_size < 0) ? -j : -half_kernel_size;
+    j_hi = (j + half_kernel_size >= cols) ? cols-1-j : half_kernel_size;
+
+    for(j_win = j_lo; j_win <= j_hi; j_win++){
+        p = coef + (i + (j+j_win)*rows);
+        for(i_win = i_lo; i_win <= i_hi; i_win++){
+            //pixels outside the map have a zero scale
+            if (p[i_win].s == 0)
+                continue;
+            t = ((j_win*j_win)*p[i_win].c11 - 2*i_win*j_win*p[i_win].c01 + (i_win*i_win)*p[i_win].c00)*inv_2h2;
+            w = kernel_scale*p[i_win].s*exp_lut_eval(t);
+            if (w > threshold){
+                sum_value = sum_value + w*p[i_win].z;
+                sum_weight = sum_weight + w;
+                number_of_samples++;
+            }
+        }
+    }
+
+    *output = sum_value/(sum_weight);
+    return number_of_samples;
+}
+
+
+#endif
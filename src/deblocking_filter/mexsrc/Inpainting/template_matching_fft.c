@@ -0,0 +1,507 @@
+//Template matching surfaces of the deblocking / inpainting toolkit, computed with FFTs.
+//
+//[ssd, ncc, count] = template_matching_fft(input, input_label, template, template_label, ...
+//                        feature_location_x, feature_location_y, window_size_x, window_size_y, ...
+//                        search_size_x, search_size_y)
+//
+//For every feature point k at (1-based) row feature_location_y(k) and column
+//feature_location_x(k), the (2*window_size_y+1)-by-(2*window_size_x+1) window of input is
+//compared with the template shifted by (dy, dx) = (-search_size_y..search_size_y,
+//-search_size_x..search_size_x), i.e. input(y, x) with template(y + dy, x + dx) as
+//template_matching.c does for dy = shift_y, over the pixels with input_label == 1 and
+//template_label == 1 (pixels outside the image count as unlabelled):
+//    ssd(dy + search_size_y + 1, dx + search_size_x + 1, k)    sum of squared differences
+//    ncc(...)                                                  zero-mean normalized cross-correlation (NaN if undefined)
+//    count(...)                                                number of compared pixels
+//
+//All shifts are evaluated at once: the masked sums are six cross-correlations of the
+//window with the search region, computed from three forward and three inverse complex
+//FFTs (two real fields packed per transform). Feature points are processed in parallel.
+//
+//[cost, number_of_predictions_per_feature_point, unreliable_template, ncc] = template_matching_fft(input, input_x, input_y, input_label, ...
+//                        template, template_x, template_y, template_label, ext_length, ...
+//                        feature_location_x, feature_location_y, shift_y, window_size_x, window_size_y, alpha)
+//
+//Same arguments and outputs as template_matching.c (0-based feature locations), except that
+//shift_y may hold several shifts: the outputs are numel(shift_y)-by-numel(feature_location_x),
+//one row per shift, all taken from one FFT surface per feature point. cost is the masked sum
+//of squared differences (template_matching returns the L1 cost, which is not a correlation).
+//input_x, input_y, template_x, template_y, ext_length and alpha do not enter these outputs.
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <mex.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+typedef struct {
+    int n;
+    int *rev;           //bit reversal permutation
+    double *cs, *sn;    //twiddle factors cos/sin(2*pi*k/n), k < n/2
+} fft_plan;
+
+int next_power_of_two(int n);
+int fft_plan_init(fft_plan *p, int n);
+void fft_plan_free(fft_plan *p);
+void fft_1d(const fft_plan *p, double *re, double *im, int inverse);
+void fft_2d(const fft_plan *py, const fft_plan *px, double *re, double *im, double *buf_re, double *buf_im, int inverse);
+
+int template_matching_fft(double *ssd, double *ncc, double *count, double *input, double *input_label, double *template, double *template_label, double *feature_location_x, double *feature_location_y, int number_of_feature_points, int window_size_x, int window_size_y, int search_size_x, int search_size_y, int rows, int cols);
+int template_matching_shifts(double *cost, double *number_of_predictions_per_feature_point, double *unreliable_template, double *ncc, double *input, double *input_label, double *template, double *template_label, double *feature_location_x, double *feature_location_y, int number_of_feature_points, double *shift_y, int number_of_shifts, int window_size_x, int window_size_y, int rows, int cols);
+void template_matching_gateway(int nlhs, mxArray *plhs[], const mxArray *prhs[]);
+
+
+//Initialize mex functions
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]){
+
+    double *input, *input_label, *template, *template_label;
+    double *feature_location_x, *feature_location_y;
+    double *ssd, *ncc, *count;
+
+    int rows, cols, number_of_feature_points;
+    int window_size_x, window_size_y, search_size_x, search_size_y;
+    mwSize out_dims[3];
+
+    //template_matching.c argument list
+    if (nrhs == 15){
+        template_matching_gateway(nlhs, plhs, prhs);
+        return;
+    }
+    if (nrhs != 10)
+        mexErrMsgTxt("Ten input arguments (or the fifteen of template_matching) required.");
+    if (nlhs > 3)
+        mexErrMsgTxt("Too many output arguments.");
+
+    rows = (int)mxGetM(prhs[0]);
+    cols = (int)mxGetN(prhs[0]);
+    if ((mxGetM(prhs[1]) != mxGetM(prhs[0])) || (mxGetN(prhs[1]) != mxGetN(prhs[0])) || (mxGetM(prhs[2]) != mxGetM(prhs[0])) || (mxGetN(prhs[2]) != mxGetN(prhs[0])) || (mxGetM(prhs[3]) != mxGetM(prhs[0])) || (mxGetN(prhs[3]) != mxGetN(prhs[0])))
+        mexErrMsgTxt("input, input_label, template and template_label should have the same size.");
+    if (mxGetNumberOfElements(prhs[4]) != mxGetNumberOfElements(prhs[5]))
+        mexErrMsgTxt("feature_location_x and feature_location_y should have the same number of elements.");
+
+    //Initialize input into pointer
+    input = mxGetPr(prhs[0]);
+    input_label = mxGetPr(prhs[1]);
+    template = mxGetPr(prhs[2]);
+    template_label = mxGetPr(prhs[3]);
+
+    feature_location_x = mxGetPr(prhs[4]);
+    feature_location_y = mxGetPr(prhs[5]);
+    number_of_feature_points = (int)mxGetNumberOfElements(prhs[4]);
+
+    window_size_x = (int)(*mxGetPr(prhs[6]));
+    window_size_y = (int)(*mxGetPr(prhs[7]));
+    search_size_x = (int)(*mxGetPr(prhs[8]));
+    search_size_y = (int)(*mxGetPr(prhs[9]));
+    if ((window_size_x < 0) || (window_size_y < 0) || (search_size_x < 0) || (search_size_y < 0))
+        mexErrMsgTxt("Window and search sizes should be non-negative.");
+
+    //Initialize outputs
+    out_dims[0] = 2*search_size_y + 1;
+    out_dims[1] = 2*search_size_x + 1;
+    out_dims[2] = number_of_feature_points;
+    plhs[0] = mxCreateNumericArray(3, out_dims, mxDOUBLE_CLASS, mxREAL);
+    plhs[1] = mxCreateNumericArray(3, out_dims, mxDOUBLE_CLASS, mxREAL);
+    plhs[2] = mxCreateNumericArray(3, out_dims, mxDOUBLE_CLASS, mxREAL);
+    ssd = mxGetPr(plhs[0]);
+    ncc = mxGetPr(plhs[1]);
+    count = mxGetPr(plhs[2]);
+
+    if (template_matching_fft(ssd, ncc, count, input, input_label, template, template_label, feature_location_x, feature_location_y, number_of_feature_points, window_size_x, window_size_y, search_size_x, search_size_y, rows, cols) != 0)
+        mexErrMsgTxt("Cannot allocate memory for the FFT buffers.");
+}
+
+
+void template_matching_gateway(int nlhs, mxArray *plhs[], const mxArray *prhs[]){
+
+    double *input, *input_label, *template, *template_label;
+    double *feature_location_x, *feature_location_y, *shift_y;
+    double *cost, *number_of_predictions_per_feature_point, *unreliable_template, *ncc;
+
+    int rows, cols, number_of_feature_points, number_of_shifts;
+    int window_size_x, window_size_y;
+
+    if (nlhs > 4)
+        mexErrMsgTxt("Too many output arguments.");
+
+    rows = (int)mxGetM(prhs[0]);
+    cols = (int)mxGetN(prhs[0]);
+    if ((mxGetM(prhs[3]) != mxGetM(prhs[0])) || (mxGetN(prhs[3]) != mxGetN(prhs[0])) || (mxGetM(prhs[4]) != mxGetM(prhs[0])) || (mxGetN(prhs[4]) != mxGetN(prhs[0])) || (mxGetM(prhs[7]) != mxGetM(prhs[0])) || (mxGetN(prhs[7]) != mxGetN(prhs[0])))
+        mexErrMsgTxt("input, input_label, template and template_label should have the same size.");
+    if (mxGetNumberOfElements(prhs[9]) != mxGetNumberOfElements(prhs[10]))
+        mexErrMsgTxt("feature_location_x and feature_location_y should have the same number of elements.");
+
+    //Initialize input into pointer; the gradient images, ext_length and alpha are not used
+    input = mxGetPr(prhs[0]);
+    input_label = mxGetPr(prhs[3]);
+    template = mxGetPr(prhs[4]);
+    template_label = mxGetPr(prhs[7]);
+
+    feature_location_x = mxGetPr(prhs[9]);
+    feature_location_y = mxGetPr(prhs[10]);
+    number_of_feature_points = (int)mxGetNumberOfElements(prhs[9]);
+
+    shift_y = mxGetPr(prhs[11]);
+    number_of_shifts = (int)mxGetNumberOfElements(prhs[11]);
+
+    window_size_x = (int)(*mxGetPr(prhs[12]));
+    window_size_y = (int)(*mxGetPr(prhs[13]));
+    if ((window_size_x < 0) || (window_size_y < 0))
+        mexErrMsgTxt("Window sizes should be non-negative.");
+
+    //Initialize outputs, one row per shift
+    plhs[0] = mxCreateDoubleMatrix(number_of_shifts, number_of_feature_points, mxREAL);
+    plhs[1] = mxCreateDoubleMatrix(number_of_shifts, number_of_feature_points, mxREAL);
+    plhs[2] = mxCreateDoubleMatrix(number_of_shifts, number_of_feature_points, mxREAL);
+    plhs[3] = mxCreateDoubleMatrix(number_of_shifts, number_of_feature_points, mxREAL);
+    cost = mxGetPr(plhs[0]);
+    number_of_predictions_per_feature_point = mxGetPr(plhs[1]);
+    unreliable_template = mxGetPr(plhs[2]);
+    ncc = mxGetPr(plhs[3]);
+
+    if (template_matching_shifts(cost, number_of_predictions_per_feature_point, unreliable_template, ncc, input, input_label, template, template_label, feature_location_x, feature_location_y, number_of_feature_points, shift_y, number_of_shifts, window_size_x, window_size_y, rows, cols) != 0)
+        mexErrMsgTxt("Cannot allocate memory for the FFT buffers.");
+}
+
+
+//template_matching.c outputs for the shifts shift_y[s], read off the FFT surfaces of a
+//(2*max|shift_y|+1)-by-1 search; the feature locations are 0-based as in template_matching.c
+int template_matching_shifts(double *cost, double *number_of_predictions_per_feature_point, double *unreliable_template, double *ncc, double *input, double *input_label, double *template, double *template_label, double *feature_location_x, double *feature_location_y, int number_of_feature_points, double *shift_y, int number_of_shifts, int window_size_x, int window_size_y, int rows, int cols)
+{
+
+    //this specifies that 40% of the pixels in the original input have to be non-zero
+    int min_number_of_non_zero_pixels = (int)((window_size_x*2) * (window_size_y*2) * 0.4);
+    int search_size_y = 0, sy, iter, s;
+    double *location_x, *location_y, *ssd_surface, *ncc_surface, *count_surface;
+
+    for(s=0; s<number_of_shifts; s++){
+        if (abs((int)shift_y[s]) > search_size_y)
+            search_size_y = abs((int)shift_y[s]);
+    }
+    sy = 2*search_size_y + 1;
+
+    location_x = (double*)malloc((size_t)number_of_feature_points*sizeof(double));
+    location_y = (double*)malloc((size_t)number_of_feature_points*sizeof(double));
+    ssd_surface = (double*)malloc((size_t)sy*number_of_feature_points*sizeof(double));
+    ncc_surface = (double*)malloc((size_t)sy*number_of_feature_points*sizeof(double));
+    count_surface = (double*)malloc((size_t)sy*number_of_feature_points*sizeof(double));
+    if ((location_x == NULL) || (location_y == NULL) || (ssd_surface == NULL) || (ncc_surface == NULL) || (count_surface == NULL)){
+        free(location_x); free(location_y); free(ssd_surface); free(ncc_surface); free(count_surface);
+        return 1;
+    }
+
+    //template_matching_fft takes 1-based locations
+    for(iter=0; iter<number_of_feature_points; iter++){
+        location_x[iter] = (int)feature_location_x[iter] + 1;
+        location_y[iter] = (int)feature_location_y[iter] + 1;
+    }
+
+    if (template_matching_fft(ssd_surface, ncc_surface, count_surface, input, input_label, template, template_label, location_x, location_y, number_of_feature_points, window_size_x, window_size_y, 0, search_size_y, rows, cols) != 0){
+        free(location_x); free(location_y); free(ssd_surface); free(ncc_surface); free(count_surface);
+        return 1;
+    }
+
+    #pragma omp parallel for private(s)
+    for(iter=0; iter<number_of_feature_points; iter++){
+
+        int x_ind, y_ind, non_zero_pixels = 0;
+        int x0 = (int)feature_location_x[iter], y0 = (int)feature_location_y[iter];
+
+        //calculate number of non-zero pixels
+        for(x_ind = x0 - window_size_x; x_ind <= x0 + window_size_x; x_ind++){
+            if ((x_ind < 0) || (x_ind >= cols))
+                continue;
+            for(y_ind = y0 - window_size_y; y_ind <= y0 + window_size_y; y_ind++){
+                if ((y_ind >= 0) && (y_ind < rows) && (input_label[y_ind + x_ind*rows] == 1) && (input[y_ind + x_ind*rows] > 0))
+                    non_zero_pixels++;
+            }
+        }
+
+        for(s=0; s<number_of_shifts; s++){
+            size_t k = (size_t)((int)shift_y[s] + search_size_y) + (size_t)iter*sy;
+            size_t out = (size_t)s + (size_t)iter*number_of_shifts;
+            int pixel_ind = (int)count_surface[k];
+
+            cost[out] = ssd_surface[k];
+            ncc[out] = ncc_surface[k];
+            number_of_predictions_per_feature_point[out] = pixel_ind - 1;
+            unreliable_template[out] = ((non_zero_pixels > min_number_of_non_zero_pixels) && (pixel_ind >= min_number_of_non_zero_pixels)) ? 0 : 1;
+        }
+    }
+
+    free(location_x);
+    free(location_y);
+    free(ssd_surface);
+    free(ncc_surface);
+    free(count_surface);
+
+    return 0;
+}
+
+
+int template_matching_fft(double *ssd, double *ncc, double *count, double *input, double *input_label, double *template, double *template_label, double *feature_location_x, double *feature_location_y, int number_of_feature_points, int window_size_x, int window_size_y, int search_size_x, int search_size_y, int rows, int cols)
+{
+
+    //window and search region sizes
+    int h = 2*window_size_y + 1, w = 2*window_size_x + 1;
+    int H = h + 2*search_size_y, W = w + 2*search_size_x;
+    int sy = 2*search_size_y + 1, sx = 2*search_size_x + 1;
+    //the correlations at the shifts 0..2*search_size never wrap around if the FFT covers the region
+    int Ny = next_power_of_two(H), Nx = next_power_of_two(W);
+    int N = Ny*Nx;
+    int iter, failed = 0;
+
+    fft_plan py, px;
+
+    memset(&py, 0, sizeof(fft_plan));
+    memset(&px, 0, sizeof(fft_plan));
+    if (!fft_plan_init(&py, Ny) || !fft_plan_init(&px, Nx)){
+        fft_plan_free(&py);
+        fft_plan_free(&px);
+        return 1;
+    }
+
+    #pragma omp parallel
+    {
+        //three packed forward transforms (za, zb, zc) and three packed products (w1, w2, w3)
+        double *buf = (double*)malloc((size_t)(12*N + 2*(Ny > Nx ? Ny : Nx))*sizeof(double));
+        double *za_re = buf, *za_im = buf + N, *zb_re = buf + 2*N, *zb_im = buf + 3*N, *zc_re = buf + 4*N, *zc_im = buf + 5*N;
+        double *w1_re = buf + 6*N, *w1_im = buf + 7*N, *w2_re = buf + 8*N, *w2_im = buf + 9*N, *w3_re = buf + 10*N, *w3_im = buf + 11*N;
+        double *line_re = buf + 12*N, *line_im = line_re + (Ny > Nx ? Ny : Nx);
+
+        if (buf == NULL){
+            #pragma omp atomic write
+            failed = 1;
+        }
+
+        #pragma omp for schedule(dynamic)
+        for(iter = 0; iter<number_of_feature_points; iter++){
+
+            int x0, y0, i, j, k, ky, kx, mk;
+            double scale = 1.0/N;
+            double *out_ssd = ssd + (size_t)iter*sy*sx, *out_ncc = ncc + (size_t)iter*sy*sx, *out_count = count + (size_t)iter*sy*sx;
+
+            if (buf == NULL)
+                continue;
+
+            //0-based centre of the window
+            y0 = (int)feature_location_y[iter] - 1;
+            x0 = (int)feature_location_x[iter] - 1;
+
+            memset(buf, 0, (size_t)6*N*sizeof(double));
+
+            //window fields: za = m_i + i*m_i*I, zb = m_i*I^2 + i*m_t (the template mask goes with the region)
+            for(j=0; j<w; j++){
+                int x = x0 - window_size_x + j;
+                if ((x < 0) || (x >= cols))
+                    continue;
+                for(i=0; i<h; i++){
+                    int y = y0 - window_size_y + i;
+                    double v;
+                    if ((y < 0) || (y >= rows) || (input_label[y + x*rows] != 1))
+                        continue;
+                    v = input[y + x*rows];
+                    za_re[i + j*Ny] = 1;
+                    za_im[i + j*Ny] = v;
+                    zb_re[i + j*Ny] = v*v;
+                }
+            }
+            //search region fields: zb_im = m_t, zc = m_t*T + i*m_t*T^2
+            for(j=0; j<W; j++){
+                int x = x0 - window_size_x - search_size_x + j;
+                if ((x < 0) || (x >= cols))
+                    continue;
+                for(i=0; i<H; i++){
+                    int y = y0 - window_size_y - search_size_y + i;
+                    double v;
+                    if ((y < 0) || (y >= rows) || (template_label[y + x*rows] != 1))
+                        continue;
+                    v = template[y + x*rows];
+                    zb_im[i + j*Ny] = 1;
+                    zc_re[i + j*Ny] = v;
+                    zc_im[i + j*Ny] = v*v;
+                }
+            }
+
+            fft_2d(&py, &px, za_re, za_im, line_re, line_im, 0);
+            fft_2d(&py, &px, zb_re, zb_im, line_re, line_im, 0);
+            fft_2d(&py, &px, zc_re, zc_im, line_re, line_im, 0);
+
+            //unpack the spectra of the six real fields, F(a + i*b)[k] = A[k] + i*B[k] with
+            //A[k] = (Z[k] + conj(Z[-k]))/2, B[k] = (Z[k] - conj(Z[-k]))/(2i), and form the products
+            //conj(P)*R of the six correlations, packed two by two
+            for(kx=0; kx<Nx; kx++){
+                for(ky=0; ky<Ny; ky++){
+                    double p1r, p1i, p2r, p2i, p3r, p3i, r1r, r1i, r2r, r2i, r3r, r3i;
+                    double ar, ai, br, bi;
+                    k = ky + kx*Ny;
+                    mk = ((Ny - ky) & (Ny - 1)) + ((Nx - kx) & (Nx - 1))*Ny;
+
+                    p1r = 0.5*(za_re[k] + za_re[mk]);  p1i = 0.5*(za_im[k] - za_im[mk]);
+                    p2r = 0.5*(za_im[k] + za_im[mk]);  p2i = -0.5*(za_re[k] - za_re[mk]);
+                    p3r = 0.5*(zb_re[k] + zb_re[mk]);  p3i = 0.5*(zb_im[k] - zb_im[mk]);
+                    r1r = 0.5*(zb_im[k] + zb_im[mk]);  r1i = -0.5*(zb_re[k] - zb_re[mk]);
+                    r2r = 0.5*(zc_re[k] + zc_re[mk]);  r2i = 0.5*(zc_im[k] - zc_im[mk]);
+                    r3r = 0.5*(zc_im[k] + zc_im[mk]);  r3i = -0.5*(zc_re[k] - zc_re[mk]);
+
+                    //w1 = conj(P1)*R1 + i*conj(P1)*R2 -> count, sum of T
+                    ar = p1r*r1r + p1i*r1i;  ai = p1r*r1i - p1i*r1r;
+                    br = p1r*r2r + p1i*r2i;  bi = p1r*r2i - p1i*r2r;
+                    w1_re[k] = ar - bi;  w1_im[k] = ai + br;
+                    //w2 = conj(P1)*R3 + i*conj(P2)*R1 -> sum of T^2, sum of I
+                    ar = p1r*r3r + p1i*r3i;  ai = p1r*r3i - p1i*r3r;
+                    br = p2r*r1r + p2i*r1i;  bi = p2r*r1i - p2i*r1r;
+                    w2_re[k] = ar - bi;  w2_im[k] = ai + br;
+                    //w3 = conj(P2)*R2 + i*conj(P3)*R1 -> sum of I*T, sum of I^2
+                    ar = p2r*r2r + p2i*r2i;  ai = p2r*r2i - p2i*r2r;
+                    br = p3r*r1r + p3i*r1i;  bi = p3r*r1i - p3i*r1r;
+                    w3_re[k] = ar - bi;  w3_im[k] = ai + br;
+                }
+            }
+
+            fft_2d(&py, &px, w1_re, w1_im, line_re, line_im, 1);
+            fft_2d(&py, &px, w2_re, w2_im, line_re, line_im, 1);
+            fft_2d(&py, &px, w3_re, w3_im, line_re, line_im, 1);
+
+            for(j=0; j<sx; j++){
+                for(i=0; i<sy; i++){
+                    double n, s_t, s_tt, s_i, s_it, s_ii, var_i, var_t, v;
+                    k = i + j*Ny;
+                    n = floor(w1_re[k]*scale + 0.5);
+                    s_t = w1_im[k]*scale;
+                    s_tt = w2_re[k]*scale;
+                    s_i = w2_im[k]*scale;
+                    s_it = w3_re[k]*scale;
+                    s_ii = w3_im[k]*scale;
+
+                    v = s_ii - 2*s_it + s_tt;
+                    out_ssd[i + j*sy] = (n > 0 && v > 0) ? v : 0;
+                    out_count[i + j*sy] = n;
+
+                    out_ncc[i + j*sy] = mxGetNaN();
+                    if (n > 1){
+                        var_i = s_ii - s_i*s_i/n;
+                        var_t = s_tt - s_t*s_t/n;
+                        if ((var_i > 1e-12*s_ii) && (var_t > 1e-12*s_tt)){
+                            v = (s_it - s_i*s_t/n)/sqrt(var_i*var_t);
+                            out_ncc[i + j*sy] = (v > 1) ? 1 : ((v < -1) ? -1 : v);
+                        }
+                    }
+                }
+            }
+        }
+
+        free(buf);
+    }
+
+    fft_plan_free(&py);
+    fft_plan_free(&px);
+
+    return failed;
+}
+
+
+int next_power_of_two(int n)
+{
+    int m = 1;
+    while (m < n)
+        m <<= 1;
+    return m;
+}
+
+
+int fft_plan_init(fft_plan *p, int n)
+{
+    int k, bits = 0, b;
+
+    p->n = n;
+    p->rev = (int*)malloc(n*sizeof(int));
+    p->cs = (double*)malloc((n/2 + 1)*sizeof(double));
+    p->sn = (double*)malloc((n/2 + 1)*sizeof(double));
+    if ((p->rev == NULL) || (p->cs == NULL) || (p->sn == NULL))
+        return 0;
+
+    while ((1 << bits) < n)
+        bits++;
+    for(k=0; k<n; k++){
+        p->rev[k] = 0;
+        for(b=0; b<bits; b++){
+            if (k & (1 << b))
+                p->rev[k] |= 1 << (bits - 1 - b);
+        }
+    }
+    for(k=0; k<n/2; k++){
+        p->cs[k] = cos(2*M_PI*k/n);
+        p->sn[k] = sin(2*M_PI*k/n);
+    }
+    return 1;
+}
+
+
+void fft_plan_free(fft_plan *p)
+{
+    free(p->rev);
+    free(p->cs);
+    free(p->sn);
+}
+
+
+//in-place radix-2 FFT of a contiguous sequence of p->n values, exp(-2*pi*i*k*n/N) forward,
+//exp(+...) without scaling for the inverse
+void fft_1d(const fft_plan *p, double *re, double *im, int inverse)
+{
+    int n = p->n, i, j, len, half, step, k;
+    double sign = inverse ? 1 : -1;
+
+    for(i=0; i<n; i++){
+        j = p->rev[i];
+        if (j > i){
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for(len=2; len<=n; len<<=1){
+        half = len >> 1;
+        step = n/len;
+        for(i=0; i<n; i+=len){
+            for(k=0; k<half; k++){
+                double c = p->cs[k*step], s = sign*p->sn[k*step];
+                double ur = re[i+k], ui = im[i+k];
+                double vr = re[i+k+half]*c - im[i+k+half]*s;
+                double vi = re[i+k+half]*s + im[i+k+half]*c;
+                re[i+k] = ur + vr;
+                im[i+k] = ui + vi;
+                re[i+k+half] = ur - vr;
+                im[i+k+half] = ui - vi;
+            }
+        }
+    }
+}
+
+
+//2-D FFT of a column-major py->n-by-px->n array; the rows are transformed through the line buffers
+void fft_2d(const fft_plan *py, const fft_plan *px, double *re, double *im, double *buf_re, double *buf_im, int inverse)
+{
+    int Ny = py->n, Nx = px->n, i, j;
+
+    for(j=0; j<Nx; j++)
+        fft_1d(py, re + j*Ny, im + j*Ny, inverse);
+    for(i=0; i<Ny; i++){
+        for(j=0; j<Nx; j++){
+            buf_re[j] = re[i + j*Ny];
+            buf_im[j] = im[i + j*Ny];
+        }
+        fft_1d(px, buf_re, buf_im, inverse);
+        for(j=0; j<Nx; j++){
+            re[i + j*Ny] = buf_re[j];
+            im[i + j*Ny] = buf_im[j];
+        }
+    }
+}
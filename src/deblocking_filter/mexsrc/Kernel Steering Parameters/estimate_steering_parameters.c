@@ -10,6 +10,7 @@
 
 #include <mex.h>
 #include "matrix_toolbox_ag.h"
+#include "steering_tensor.h"
 
 FILE *f1;
 
@@ -20,7 +21,7 @@ int find_minimum(double *input, double *input_minimum_value, int r, int c);
 double abs_value(double input);
 
 //int identity(double *input, int r, int c);
-//int create_exponential_kernel(double *output, double *cov_mat, double h, double *input_map, int rows, int cols, int i, int j, int half_ksize);
+//int create_exponential_kernel(double *output, double *cov_mat, double h, double *input_map, int rows, int i, int j, int half_ksize);
 double square_val(double input);
 int find_maximum_vector(double *minimum, double *input, int samples);
 
@@ -76,55 +77,10 @@ int	estimate_steering_parameters(double *C00, double *C01, double *C11, double *
     
     
     //loop variables
-    int i,j, k=0;
-    
-    //coefficients used to evaluate the eigenvalues of the matrix
-    double a, b,c,d;
- 
-    //loop variables in the window
-    int i_win, j_win;
-    
-    //int number_of_samples = kernel_size*kernel_size;
-    int number_of_samples;
+    int i, j, tile;
     
     int half_kernel_size;
-    
-    double *S;
-    double *S_transpose;
-    double A[4];
-    
-    double eig_1[2];
-    double eig_2[2];
-    double lam_1;
-    double lam_2;
-    double norm;
-    double theta;
-    double epsilon = 1.0;
-    double epsilon_2 = 0.05;
-    double sigma_1;
-    double sigma_2;
-    //double min_sigma = 0.7;
-    //double min_sigma;
-    double max_sigma;
-    double R_theta[4];  
-	double R_theta_transpose[4];
-    double cov_mat[4];
-    double lambda_mat[4];
-    double buffer[4];
-    double buffer_2[4];
-	double mean_value;
-    double gamma;
-    
-    int stop_here;
-    int max_number_of_samples = (int)square_val(51);
-    
-    //evaluate scaling factor
-    double scaling_factor;
-    
-    max_sigma = 1/min_sigma;
-    
-    S = ( double* )malloc( max_number_of_samples*2*sizeof( double) );
-    S_transpose = ( double* )malloc( 2*max_number_of_samples*sizeof( double) );
+    int tiles_i, tiles_j;
     
     half_kernel_size = (win_size-1)/2;
     
@@ -139,194 +95,38 @@ int	estimate_steering_parameters(double *C00, double *C01, double *C11, double *
         }
     }
     
-    for(i=half_kernel_size; i< (rows-half_kernel_size); i++){
-        for(j=half_kernel_size; j<(cols-half_kernel_size); j++){
+    //only the pixels whose whole window lies inside the image are estimated
+    if ((rows - 2*half_kernel_size <= 0) || (cols - 2*half_kernel_size <= 0))
+        return 0;
+    
+    tiles_i = (rows - 2*half_kernel_size + TILE_SIZE - 1)/TILE_SIZE;
+    tiles_j = (cols - 2*half_kernel_size + TILE_SIZE - 1)/TILE_SIZE;
+    
+    #pragma omp parallel
+    {
+        //column sums of the tile (TILE_SIZE rows by TILE_SIZE + 2*half_kernel_size columns) and the structure tensors of one tile row
+        int width = TILE_SIZE + 2*half_kernel_size;
+        double *V = ( double* )malloc( CHANNELS*TILE_SIZE*width*sizeof( double) );
+        double *A = ( double* )malloc( TENSOR_SIZE*TILE_SIZE*sizeof( double) );
+        
+        #pragma omp for schedule(dynamic)
+        for(tile = 0; tile < tiles_i*tiles_j; tile++){
             
-            if (pixels_to_be_estimated[i+j*rows] == 1){
-                
-                if ((i ==  135) & (j == 177))
-                    stop_here = 1;
-                
-                //create S matrix
-                k = 0;
-                
-                for(i_win= i-half_kernel_size; i_win <= i+half_kernel_size; i_win++){
-                    for(j_win= j-half_kernel_size; j_win <= j+half_kernel_size; j_win++){
-                        if (input_map[i_win+j_win*rows] == 1){
-                            if (abs_value(input_x[i_win+j_win*rows]) + abs_value(input_y[i_win+j_win*rows]) > 2)
-                            {
-                                S[0 + k*2] = input_x[i_win+j_win*rows];
-                                S[1 + k*2] = input_y[i_win+j_win*rows];
-                                k++;
-                            }
-                        }
-                    }
-                }
-                
-                number_of_samples = k;
-                
-                //evaluate mean of S_x and S_y and then subtract this value from each row
-                /*
-                mean_value = 0;
-                for(k = 0; k <number_of_samples; k++){
-                    mean_value = mean_value + S[0 + k*2];
-                }
-                mean_value = mean_value/number_of_samples;
-                for(k = 0; k <number_of_samples; k++){
-                    S[0 + k*2] = S[0 + k*2] - mean_value;
-                }
-                
-                mean_value = 0;
-                for(k = 0; k <number_of_samples; k++){
-                    mean_value = mean_value + S[1 + k*2];
-                }
-                mean_value = mean_value/number_of_samples;
-                for(k = 0; k <number_of_samples; k++){
-                    S[1 + k*2] = S[1 + k*2] - mean_value;
-                }
-                */
-                
-                matrix_transpose(S_transpose, S, 2, number_of_samples);
-                matrix_multiplication(A, S, S_transpose, 2, number_of_samples, number_of_samples, 2);
-                
-                //evaluate the eigenvalues and eigenvectors of the matrix A
-                a = A[0];
-                b = A[1];
-                c = A[3];
-                
-                
-                //if the determinant is greater than zero
-                if ((a*c - square_val(b)) > 0) {
-                    d = sqrt(square_val(a+c) - 4*(a*c - square_val(b)));
-                    
-                    lam_1 = (a+c-d)/2;
-                    lam_2 = (a+c+d)/2;
-                    
-                    if (abs(b) > 0){
-                        eig_1[0] = -b;
-                        eig_1[1] = (a-lam_1);
-                    }
-                    else
-                    {
-                        eig_1[0] = 1;
-                        eig_1[1] = 0;
-                    }
-                        
-                    norm = square_val(eig_1[0])+square_val(eig_1[1]);
-                    eig_1[0] = eig_1[0]/sqrt(norm);
-                    eig_1[1] = eig_1[1]/sqrt(norm);
-                    
-                    if (abs(b)>0){
-                        eig_2[0] = -b;
-                        eig_2[1] = (a-lam_2);
-                    }
-                    else
-                    {
-                        eig_2[0] = 0;
-                        eig_2[0] = 1;
-                    }
-                        
-                    
-                    norm = square_val(eig_2[0])+square_val(eig_2[1]);
-                    eig_2[0] = eig_2[0]/sqrt(norm);
-                    eig_2[1] = eig_2[1]/sqrt(norm);
-                    
-                    theta = atan(eig_1[1]/eig_1[0]);
-                    
-                    sigma_2 = (lam_1 + epsilon)/(lam_2 + epsilon);
-                    if (sigma_2 < min_sigma)
-                        sigma_2 = min_sigma;
-                    if (sigma_2 > max_sigma)
-                        sigma_2 = max_sigma;
-                    
-                    sigma_1 = 1/sigma_2;
-                    
-                    //sigma_1_mat[i + j*rows] = sqrt(lam_1/number_of_samples);
-                    //sigma_2_mat[i + j*rows] =  sqrt(lam_2/number_of_samples);
-
-                    //scaling_factor = sqrt(((lam_1*lam_2 + 1)));
-                    //scaling_factor = (1/scaling_factor)*100;
-                   
-                    //scaling_factor = (sigma_1_mat[i + j*rows] - sigma_2_mat[i + j*rows] + epsilon_2)/(sigma_1_mat[i + j*rows] + sigma_2_mat[i + j*rows] + epsilon_2);
-                    
-                    scaling_factor = 1;
-                    //scaling_factor = sqrt(((lam_1*lam_2 + epsilon_2)/number_of_samples));
-
-                    
-                    lambda_mat[0] = sigma_1*scaling_factor;
-                    lambda_mat[1] = 0;
-                    lambda_mat[2] = 0;
-                    lambda_mat[3] = sigma_2*scaling_factor;
-                    
-                    R_theta[0] = cos(theta);
-                    R_theta[1] = sin(theta);
-                    R_theta[2] = -sin(theta);
-                    R_theta[3] = cos(theta);
-                    
-                    sigma_1_mat[i + j*rows] = sigma_1;
-                    sigma_2_mat[i + j*rows] =  sigma_2;
-                    theta_mat[i + j*rows] =  theta;
-                    
-                    //evaluate cov_mat = R_theta*lambda_mat*lambda_mat*R_theta';
-                    matrix_multiplication(buffer, R_theta, lambda_mat, 2, 2, 2, 2);
-                    buffer[0];
-                    buffer[1];
-                    buffer[2];
-                    buffer[3];
-                    
-                    matrix_multiplication(buffer_2, buffer, lambda_mat, 2, 2, 2, 2);
-                    buffer_2[0];
-                    buffer_2[1];
-                    buffer_2[2];
-                    buffer_2[3];
-                    
-                    matrix_transpose(R_theta_transpose, R_theta, 2, 2);
-                    R_theta_transpose[0];
-                    R_theta_transpose[1];
-                    R_theta_transpose[2];
-                    R_theta_transpose[3];
-                    
-      
-                    
-                    
-                    matrix_multiplication(cov_mat, buffer_2, R_theta_transpose, 2, 2, 2, 2);
-                    cov_mat[0];
-                    cov_mat[1];
-                    cov_mat[2];
-                    cov_mat[3];
-                    
-                    C00[i + j*rows] = cov_mat[0];
-                    C01[i + j*rows] = cov_mat[1];
-                    C11[i + j*rows] = cov_mat[3];
-                    
-
-                    
-                }
-                else{
-                    C00[i + j*rows] = 1;
-                    C01[i + j*rows] = 0;
-                    C11[i + j*rows] = 1;
-                }
-                
-                /*
-                 * f1 = fopen("z.txt", "w");
-                 * for(ii=0;ii<number_of_samples;ii++)
-                 * {
-                 * for(jj=0;jj<1;jj++)
-                 * {
-                 * fprintf(f1, "%lf ", z[ii+jj*number_of_samples]);
-                 * }
-                 * fprintf(f1, "\n");
-                 * }
-                 * fclose(f1);
-                 */
-            }
+            int i0 = half_kernel_size + (tile % tiles_i)*TILE_SIZE;
+            int j0 = half_kernel_size + (tile / tiles_i)*TILE_SIZE;
+            int i1 = (i0 + TILE_SIZE < rows - half_kernel_size) ? i0 + TILE_SIZE : rows - half_kernel_size;
+            int j1 = (j0 + TILE_SIZE < cols - half_kernel_size) ? j0 + TILE_SIZE : cols - half_kernel_size;
+            
+            if ((V == NULL) || (A == NULL))
+                continue;
+            
+            estimate_steering_tile(C00, C01, C11, sigma_1_mat, sigma_2_mat, theta_mat, input_y, input_x, input_map, pixels_to_be_estimated, min_sigma, half_kernel_size, rows, i0, i1, j0, j1, V, A);
         }
+        
+        free(V);
+        free(A);
     }
     
-    free(S);
-    free(S_transpose);
-
     return 0;
     
 }
@@ -368,7 +168,7 @@ double square_val(double input){
 }
 
 
-int create_exponential_kernel(double *output, double *cov_mat, double h, double *input_map, int rows, int cols, int i, int j, int half_ksize)
+int create_exponential_kernel(double *output, double *cov_mat, double h, double *input_map, int rows, int i, int j, int half_ksize)
 {
 	int ii,jj,k = 0;
 
@@ -2,4 +2,4 @@ close all;
 clear;
 clc;
 
-mex CFLAGS='\$CFLAGS -std=c99' estimate_steering_parameters.c 
\ No newline at end of file
+mex CFLAGS='\$CFLAGS -std=c99 -fopenmp' LDFLAGS='\$LDFLAGS -fopenmp' estimate_steering_parameters.c 
\ No newline at end of file
@@ -0,0 +1,232 @@
+//Steering covariances from the local gradient structure tensor, shared by estimate_steering_parameters.c
+//and the tiled deblocking pipeline (deblocking_filter_tiled_mex.c).
+//
+//The structure tensor [a b; b c] of a pixel is the sum of [gx^2 gx*gy; gx*gy gy^2] over its
+//win_size x win_size window. It is evaluated tile by tile with running window sums, the
+//eigen-decomposition of a whole tile row is written without branches. Whether det > 0 is decided
+//as by a direct sum over the window: from the running sums when their error bound (and that of the
+//direct sum) allows it, otherwise (windows of rank one or close to it) from the direct sum itself.
+
+#ifndef STEERING_TENSOR_H
+#define STEERING_TENSOR_H
+
+#include <math.h>
+#include <float.h>
+
+//size of the square tiles of pixels processed by one thread
+#define TILE_SIZE 64
+//running window sums of gx^2, gx*gy, gy^2, the number of nonzero terms of each, and for each sum the
+//magnitudes its rounding errors are bounded by
+#define CHANNELS 9
+//structure tensor of one pixel: a, b, c and whether det > 0
+#define TENSOR_SIZE 4
+
+
+//adds (or removes, sign = -1) the gradient outer product of pixel k to the window sums s, if the
+//pixel belongs to the map (NULL: every pixel) and its gradient is strong enough; s[3..5] count the nonzero terms,
+//s[6..8] add up the magnitudes of the terms and of the partial sums
+static void add_gradient_product(double *s, const double *input_x, const double *input_y, const double *input_map, int k, double sign)
+{
+    double gx = input_x[k], gy = input_y[k];
+    
+    if (((input_map == NULL) || (input_map[k] == 1)) && (fabs(gx) + fabs(gy) > 2)){
+        s[0] += sign*gx*gx;
+        s[1] += sign*gx*gy;
+        s[2] += sign*gy*gy;
+        s[3] += (gx != 0) ? sign : 0;
+        s[4] += (gx*gy != 0) ? sign : 0;
+        s[5] += (gy != 0) ? sign : 0;
+        s[6] += gx*gx + fabs(s[0]);
+        s[7] += fabs(gx*gy) + fabs(s[1]);
+        s[8] += gy*gy + fabs(s[2]);
+    }
+}
+
+
+//structure tensor of pixel (i, j) summed directly, in the order of S*S' of the original code, for the
+//windows whose running sums cannot decide det > 0
+static void window_structure_tensor(double *s, const double *input_x, const double *input_y, const double *input_map, int half_kernel_size, int rows, int i, int j)
+{
+    double a = 0, b = 0, c = 0;
+    int i_win, j_win, k;
+    
+    for(i_win = i - half_kernel_size; i_win <= i + half_kernel_size; i_win++){
+        for(j_win = j - half_kernel_size; j_win <= j + half_kernel_size; j_win++){
+            double gx, gy;
+            k = i_win + j_win*rows;
+            gx = input_x[k];
+            gy = input_y[k];
+            if (((input_map == NULL) || (input_map[k] == 1)) && (fabs(gx) + fabs(gy) > 2)){
+                a = a + gx*gx;
+                b = b + gy*gx;
+                c = c + gy*gy;
+            }
+        }
+    }
+    s[0] = a;
+    s[1] = b;
+    s[2] = c;
+    s[3] = (a*c - b*b > 0);
+}
+
+
+//structure tensor of pixel (i, j) from its window sums s, with h the magnitudes of the rounding of the
+//row sums. Without gx*gy terms b is exactly zero and det > 0 needs gx and gy terms. Otherwise the
+//direct sum has det > 0 too if the det of the running sums exceeds the error bounds of both; if it
+//does not, the window is summed directly
+static void structure_tensor_from_sums(double *t, const double *s, const double *h, const double *input_x, const double *input_y, const double *input_map, int half_kernel_size, int rows, int i, int j)
+{
+    double terms = (double)(2*half_kernel_size + 1)*(2*half_kernel_size + 1);
+    //a sum without any nonzero term is exactly zero, as in a direct evaluation
+    double a = (s[3] > 0) ? s[0] : 0;
+    double b = (s[4] > 0) ? s[1] : 0;
+    double c = (s[5] > 0) ? s[2] : 0;
+    double e_a, e_b, e_c, det, bound;
+    
+    t[0] = a;
+    t[1] = b;
+    t[2] = c;
+    if (s[4] <= 0){
+        t[3] = (s[3] > 0) && (s[5] > 0);
+        return;
+    }
+    
+    //running sums: the magnitudes gathered in s and h; direct sum: terms roundings of at most a + c
+    e_a = DBL_EPSILON*(s[6] + h[0] + terms*fabs(a));
+    e_b = DBL_EPSILON*(s[7] + h[1] + terms*(fabs(a) + fabs(c)));
+    e_c = DBL_EPSILON*(s[8] + h[2] + terms*fabs(c));
+    det = a*c - b*b;
+    bound = fabs(a)*e_c + fabs(c)*e_a + e_a*e_c + 2*fabs(b)*e_b + e_b*e_b + 2*DBL_EPSILON*(fabs(a*c) + b*b);
+    if (det > bound)
+        t[3] = 1;
+    else
+        window_structure_tensor(t, input_x, input_y, input_map, half_kernel_size, rows, i, j);
+}
+
+
+//closed-form eigen-decomposition of the n structure tensors A (TENSOR_SIZE doubles each) of one tile row,
+//written without branches so the compiler can vectorize it; the outputs have stride ld.
+//pixels_to_be_estimated == NULL estimates every pixel, sigma_1_mat == NULL skips sigma_1, sigma_2 and theta
+static void steering_parameters_row(double *C00, double *C01, double *C11, double *sigma_1_mat, double *sigma_2_mat, double *theta_mat, const double *A, const double *pixels_to_be_estimated, int ld, int n, double min_sigma)
+{
+    double epsilon = 1.0;
+    double max_sigma = 1/min_sigma;
+    int k;
+    
+    #pragma omp simd
+    for(k = 0; k < n; k++){
+        double a = A[TENSOR_SIZE*k], b = A[TENSOR_SIZE*k + 1], c = A[TENSOR_SIZE*k + 2];
+        double det = a*c - b*b;
+        double d, lam_1, lam_2, e0, e1, norm, theta, cos_t, sin_t, sigma_1, sigma_2, s1, s2;
+        int estimate = (pixels_to_be_estimated == NULL) || (pixels_to_be_estimated[k*ld] == 1);
+        int valid = (A[TENSOR_SIZE*k + 3] != 0);
+        //the original code tested abs(b) > 0 with the integer abs(), i.e. |b| >= 1
+        int has_b = (fabs(b) >= 1);
+        
+        d = sqrt(valid ? (a+c)*(a+c) - 4*det : 0);
+        lam_1 = (a+c-d)/2;
+        lam_2 = (a+c+d)/2;
+        
+        //eigenvector of the smallest eigenvalue and its angle
+        e0 = has_b ? -b : 1;
+        e1 = has_b ? (a-lam_1) : 0;
+        norm = sqrt(e0*e0 + e1*e1);
+        e0 = e0/norm;
+        e1 = e1/norm;
+        theta = atan(e1/e0);
+        //cos and sin of theta = atan(e1/e0) in (-pi/2, pi/2), e0 is never zero
+        cos_t = fabs(e0);
+        sin_t = (e0 < 0) ? -e1 : e1;
+        
+        sigma_2 = (lam_1 + epsilon)/(lam_2 + epsilon);
+        sigma_2 = (sigma_2 < min_sigma) ? min_sigma : sigma_2;
+        sigma_2 = (sigma_2 > max_sigma) ? max_sigma : sigma_2;
+        sigma_1 = 1/sigma_2;
+        
+        //cov_mat = R_theta*lambda_mat*lambda_mat*R_theta', R_theta = [cos -sin; sin cos]
+        s1 = sigma_1*sigma_1;
+        s2 = sigma_2*sigma_2;
+        
+        if (estimate){
+            if (valid){
+                C00[k*ld] = cos_t*cos_t*s1 + sin_t*sin_t*s2;
+                C01[k*ld] = sin_t*cos_t*(s1 - s2);
+                C11[k*ld] = sin_t*sin_t*s1 + cos_t*cos_t*s2;
+                if (sigma_1_mat != NULL){
+                    sigma_1_mat[k*ld] = sigma_1;
+                    sigma_2_mat[k*ld] = sigma_2;
+                    theta_mat[k*ld] = theta;
+                }
+            }
+            else{
+                C00[k*ld] = 1;
+                C01[k*ld] = 0;
+                C11[k*ld] = 1;
+            }
+        }
+    }
+}
+
+
+//estimates the pixels [i0, i1) x [j0, j1) of the rows-by-* arrays, which need half_kernel_size valid
+//samples on every side. V holds CHANNELS*TILE_SIZE*(TILE_SIZE + 2*half_kernel_size) doubles, A TENSOR_SIZE*TILE_SIZE;
+//the tile is at most TILE_SIZE x TILE_SIZE
+static void estimate_steering_tile(double *C00, double *C01, double *C11, double *sigma_1_mat, double *sigma_2_mat, double *theta_mat, const double *input_y, const double *input_x, const double *input_map, const double *pixels_to_be_estimated, double min_sigma, int half_kernel_size, int rows, int i0, int i1, int j0, int j1, double *V, double *A)
+{
+    int win_size = 2*half_kernel_size + 1;
+    int i, j, ti, tj, l, i_win, j_win, k;
+    double s[CHANNELS], h[3], d;
+    
+    //window sums along the columns, restarted at every tile so the running sums do not drift
+    for(j_win = j0 - half_kernel_size; j_win < j1 + half_kernel_size; j_win++){
+        double *v = V + CHANNELS*TILE_SIZE*(j_win - j0 + half_kernel_size);
+        for(l = 0; l < CHANNELS; l++)
+            s[l] = 0;
+        for(i_win = i0 - half_kernel_size; i_win <= i0 + half_kernel_size; i_win++)
+            add_gradient_product(s, input_x, input_y, input_map, i_win + j_win*rows, 1);
+        for(i = i0; i < i1; i++){
+            ti = i - i0;
+            for(l = 0; l < CHANNELS; l++)
+                v[CHANNELS*ti + l] = s[l];
+            if (i + 1 < i1){
+                add_gradient_product(s, input_x, input_y, input_map, (i + half_kernel_size + 1) + j_win*rows, 1);
+                add_gradient_product(s, input_x, input_y, input_map, (i - half_kernel_size) + j_win*rows, -1);
+            }
+        }
+    }
+    
+    for(i = i0; i < i1; i++){
+        ti = i - i0;
+        k = i + j0*rows;
+        
+        //window sums along the rows: the structure tensor [a b; b c] of every pixel of the tile row.
+        //The error magnitudes of the column sums slide with them, those of the row additions only grow
+        for(l = 0; l < CHANNELS; l++)
+            s[l] = 0;
+        for(l = 0; l < 3; l++)
+            h[l] = 0;
+        for(tj = 0; tj < win_size; tj++){
+            for(l = 0; l < CHANNELS; l++)
+                s[l] += V[CHANNELS*(TILE_SIZE*tj + ti) + l];
+            for(l = 0; l < 3; l++)
+                h[l] += fabs(s[l]);
+        }
+        for(j = j0; j < j1; j++){
+            tj = j - j0;
+            structure_tensor_from_sums(A + TENSOR_SIZE*tj, s, h, input_x, input_y, input_map, half_kernel_size, rows, i, j);
+            if (j + 1 < j1){
+                for(l = 0; l < CHANNELS; l++){
+                    d = V[CHANNELS*(TILE_SIZE*(tj + win_size) + ti) + l] - V[CHANNELS*(TILE_SIZE*tj + ti) + l];
+                    s[l] += d;
+                    if (l < 3)
+                        h[l] += fabs(d) + fabs(s[l]);
+                }
+            }
+        }
+        
+        steering_parameters_row(C00 + k, C01 + k, C11 + k, sigma_1_mat ? sigma_1_mat + k : NULL, sigma_2_mat ? sigma_2_mat + k : NULL, theta_mat ? theta_mat + k : NULL, A, pixels_to_be_estimated ? pixels_to_be_estimated + k : NULL, rows, j1 - j0, min_sigma);
+    }
+}
+
+
+#endif
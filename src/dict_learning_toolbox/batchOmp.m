@@ -0,0 +1,38 @@
+function X = batchOmp(D, Y, T, epsilon, mask, G)
+% BATCHOMP Batch orthogonal matching pursuit (compiled)
+% X = BATCHOMP(D, Y, T) codes every column of Y over the dictionary D with
+% at most T atoms and returns the sparse size(D,2)-by-size(Y,2) matrix X.
+% The correlations D'*Y are computed in blocks of signals and the coding
+% only uses the Gram matrix G = D'*D with progressive Cholesky updates
+% (batchOmp_mex), so the atoms should have (roughly) unit norm for the
+% selection rule to be that of plain OMP.
+%
+% X = BATCHOMP(D, Y, T, EPSILON) stops the coding of a signal as soon as
+% its squared residual norm drops to EPSILON (or T atoms are selected).
+% X = BATCHOMP(D, Y, T, EPSILON, MASK) codes column i of Y over
+% diag(MASK(:,i))*D, MASK being a binary matrix of the size of Y.
+% X = BATCHOMP(D, Y, T, EPSILON, [], G) reuses a precomputed Gram matrix.
+%
+% See also: SPARSEKSVD_DENOISING, SPARSEKSVD_INPAINTING
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if (~exist('epsilon', 'var') || isempty(epsilon))
+    epsilon = -1;
+end
+if (~exist('mask', 'var'))
+    mask = [];
+end
+if (~exist('G', 'var'))
+    G = [];
+end
+
+X = batchOmp_mex(full(D), full(Y), T, epsilon, double(mask), full(G));
+
+end
@@ -0,0 +1,248 @@
+/**************************************************************************
+ *
+ * File name: batchOmp_mex.c
+ *
+ * X = batchOmp_mex(D, Y, T, EPS, MASK, G)
+ *
+ * Batch-OMP sparse coding of the columns of Y over the dictionary D: every
+ * column of the sparse matrix X has at most T nonzeros, fewer if the
+ * squared residual norm drops to EPS (EPS < 0: no error target).
+ *
+ * The correlations D'*Y are computed in per-thread batches of signals with
+ * one GEMM each; the coding itself only uses the Gram matrix G = D'*D
+ * (computed if empty) and progressive Cholesky updates (ompcore.h).
+ * If MASK (same size as Y) is not empty, signal i is coded over the
+ * masked dictionary diag(MASK(:,i) ~= 0)*D; the Gram columns are then
+ * computed on demand for the selected atoms only.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+
+#include "mex.h"
+#include "blas.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ompcore.h"
+
+
+/* Input Arguments */
+
+#define D_IN        prhs[0]
+#define Y_IN        prhs[1]
+#define T_IN        prhs[2]
+#define EPS_IN      prhs[3]
+#define MASK_IN     prhs[4]
+#define G_IN        prhs[5]
+
+
+/* Output Arguments */
+
+#define X_OUT       plhs[0]
+
+
+/* size of the signal batch of one thread, in bytes */
+#define BATCH_BYTES (1 << 18)
+
+
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray*prhs[])
+
+{
+    double *D, *Y, *G = NULL, *mask = NULL, *Dsq = NULL, *coefs, *pr, eps;
+    mwSize len, K, N, T, batch, nbatches, nnz;
+    mwIndex i, k, *inds, *cnt, *ir, *jc;
+    int failed = 0, ownG = 0;
+
+
+    /* Check for proper number of arguments */
+
+    if (nrhs < 3 || nrhs > 6) {
+      mexErrMsgTxt("Invalid number of input arguments.");
+    } else if (nlhs > 1) {
+      mexErrMsgTxt("Too many output arguments.");
+    }
+
+
+    /* Check the the input dimensions */
+
+    if (!mxIsDouble(D_IN) || mxIsComplex(D_IN) || mxIsSparse(D_IN) || mxGetNumberOfDimensions(D_IN)>2) {
+      mexErrMsgTxt("D should be a full real matrix.");
+    }
+    len = mxGetM(D_IN);
+    K = mxGetN(D_IN);
+    if (!mxIsDouble(Y_IN) || mxIsComplex(Y_IN) || mxIsSparse(Y_IN) || mxGetM(Y_IN) != len) {
+      mexErrMsgTxt("Y should be a full real matrix with as many rows as D.");
+    }
+    N = mxGetN(Y_IN);
+
+    if (mxGetScalar(T_IN) < 0) {
+      mexErrMsgTxt("Invalid sparsity target.");
+    }
+    T = (mwSize)(mxGetScalar(T_IN) + 0.01);
+    if (T > K) T = K;
+    if (T > len) T = len;
+
+    eps = (nrhs > 3 && !mxIsEmpty(EPS_IN)) ? mxGetScalar(EPS_IN) : -1;
+
+    if (nrhs > 4 && !mxIsEmpty(MASK_IN)) {
+      if (!mxIsDouble(MASK_IN) || mxIsSparse(MASK_IN) || mxGetM(MASK_IN) != len || mxGetN(MASK_IN) != N) {
+        mexErrMsgTxt("MASK should be a full double matrix of the size of Y.");
+      }
+      mask = mxGetPr(MASK_IN);
+    }
+
+
+    /* Assign pointers */
+
+    D = mxGetPr(D_IN);
+    Y = mxGetPr(Y_IN);
+
+
+    /* Do the actual computation */
+
+    if (mask) {
+      /* squared atoms, for the masked atom norms (D.^2)'*mask */
+      Dsq = (double*)mxMalloc(len*K*sizeof(double));
+      for (i=0; i<len*K; i++) Dsq[i] = D[i]*D[i];
+    }
+    else if (nrhs > 5 && !mxIsEmpty(G_IN)) {
+      if (!mxIsDouble(G_IN) || mxIsSparse(G_IN) || mxGetM(G_IN) != K || mxGetN(G_IN) != K) {
+        mexErrMsgTxt("G should be the full K-by-K Gram matrix of D.");
+      }
+      G = mxGetPr(G_IN);
+    }
+    else {
+      ptrdiff_t pk = K, pl = len;
+      double one = 1, zero = 0;
+      G = (double*)mxMalloc(K*K*sizeof(double));
+      ownG = 1;
+      if (K > 0) {
+        dsyrk("U", "T", &pk, &pl, &one, D, &pl, &zero, G, &pk);
+      }
+      for (k=0; k<K; k++) {
+        for (i=k+1; i<K; i++) G[k*K+i] = G[i*K+k];
+      }
+    }
+
+    batch = BATCH_BYTES / ((len + 2*K + 1) * sizeof(double));
+    if (batch < 1) batch = 1;
+    nbatches = (N + batch - 1) / batch;
+
+    inds = (mwIndex*)mxMalloc((T*N + 1)*sizeof(mwIndex));
+    coefs = (double*)mxMalloc((T*N + 1)*sizeof(double));
+    cnt = (mwIndex*)mxMalloc((N + 1)*sizeof(mwIndex));
+
+    #pragma omp parallel private(i)
+    {
+      double *alpha0 = (double*)malloc((batch*K + 1)*sizeof(double));
+      double *diag = (double*)malloc((batch*K + K + 1)*sizeof(double));
+      double *Ym = mask ? (double*)malloc((batch*len + 1)*sizeof(double)) : NULL;
+      double *Mb = mask ? (double*)malloc((batch*len + 1)*sizeof(double)) : NULL;
+      int ok;
+      OmpWork w;
+
+      ok = ompWorkAlloc(&w, K, T) && alpha0 && diag && (!mask || (Ym && Mb));
+      if (!ok) {
+        #pragma omp atomic write
+        failed = 1;
+      }
+
+      #pragma omp for schedule(dynamic)
+      for (k=0; k<nbatches; k++) {
+        mwIndex b0 = k*batch, b;
+        mwSize nb = (b0 + batch <= N) ? batch : N - b0;
+        ptrdiff_t pk = K, pn = nb, pl = len;
+        double one = 1, zero = 0;
+        const double *Yb = Y + b0*len;
+        OmpGram g;
+
+        if (!ok) continue;
+
+        g.G = G;
+        g.D = D;
+        g.mask = NULL;
+        g.len = len;
+        g.K = K;
+
+        /* correlations (and masked atom norms) of the whole batch */
+        if (mask) {
+          for (i=0; i<nb*len; i++) {
+            Mb[i] = mask[b0*len + i] != 0;
+            Ym[i] = Mb[i] * Yb[i];
+          }
+          Yb = Ym;
+          if (K > 0 && nb > 0) {
+            dgemm("T", "N", &pk, &pn, &pl, &one, Dsq, &pl, Mb, &pl, &zero, diag, &pk);
+          }
+        }
+        else {
+          for (i=0; i<K; i++) diag[i] = G[i*K+i];
+        }
+        if (K > 0 && nb > 0) {
+          dgemm("T", "N", &pk, &pn, &pl, &one, D, &pl, (double*)Yb, &pl, &zero, alpha0, &pk);
+        }
+
+        for (b=0; b<nb; b++) {
+          const double *y = Yb + b*len;
+          double ynorm2 = 0;
+          for (i=0; i<len; i++) ynorm2 += y[i]*y[i];
+          if (mask) {
+            g.mask = Mb + b*len;
+          }
+          cnt[b0+b] = ompCode(&g, alpha0 + b*K, mask ? diag + b*K : diag, ynorm2, eps, T, &w,
+                              inds + (b0+b)*T, coefs + (b0+b)*T);
+        }
+      }
+
+      ompWorkFree(&w);
+      free(alpha0);
+      free(diag);
+      free(Ym);
+      free(Mb);
+    }
+
+    if (failed) {
+      mexErrMsgTxt("Cannot allocate memory for the OMP workspace.");
+    }
+
+
+    /* Create the sparse output, row indices sorted within every column */
+
+    nnz = 0;
+    for (i=0; i<N; i++) nnz += cnt[i];
+    X_OUT = mxCreateSparse(K, N, nnz > 0 ? nnz : 1, mxREAL);
+    pr = mxGetPr(X_OUT);
+    ir = mxGetIr(X_OUT);
+    jc = mxGetJc(X_OUT);
+
+    jc[0] = 0;
+    for (i=0; i<N; i++) {
+      mwIndex p0 = jc[i], a, b;
+      for (a=0; a<cnt[i]; a++) {
+        mwIndex r = inds[i*T+a];
+        double v = coefs[i*T+a];
+        for (b=p0+a; b>p0 && ir[b-1]>r; b--) {
+          ir[b] = ir[b-1];
+          pr[b] = pr[b-1];
+        }
+        ir[b] = r;
+        pr[b] = v;
+      }
+      jc[i+1] = p0 + cnt[i];
+    }
+
+    if (Dsq) mxFree(Dsq);
+    if (ownG) mxFree(G);
+    mxFree(inds);
+    mxFree(coefs);
+    mxFree(cnt);
+
+    return;
+}
@@ -1,6 +1,8 @@
 function [y, dirClass] = forwardSot(x, D, blkSize, blkSize_tlCorner, dirRange)
 % FORWARDSOT forward sparse orthonormal transform (SOT)
 %
+% See also: FORWARDSOTC
+%
 %
 % This matlab source file is free for use in academic research.
 % All rights reserved.
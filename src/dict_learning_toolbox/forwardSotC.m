@@ -0,0 +1,23 @@
+function [y, dirClass] = forwardSotC(x, D, blkSize, blkSize_tlCorner, dirRange)
+% FORWARDSOTC forward sparse orthonormal transform (SOT), compiled
+% FORWARDSOTC computes the same transform as FORWARDSOT in C
+% (forwardSot_mex), but returns the coefficients in a flat array: column k
+% of y holds the coefficients of block k, the blocks being numbered
+% column-major over the block grid, i.e. y(:, k) = yCell{k} for the cell
+% array yCell of FORWARDSOT. dirClass is the same as in FORWARDSOT.
+%
+% See also: FORWARDSOT, INVERSESOTC, GETPATCHGRADCLASS
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if (~exist('dirRange', 'var'))
+    dirRange = [];
+end
+
+[y, dirClass] = forwardSot_mex(double(x), D, blkSize, blkSize_tlCorner, dirRange);
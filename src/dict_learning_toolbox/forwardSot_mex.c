@@ -0,0 +1,190 @@
+/**************************************************************************
+ *
+ * File name: forwardSot_mex.c
+ *
+ * [Y, DIRCLASS] = forwardSot_mex(X, D, BLKSIZE, TLSIZE, DIRRANGE)
+ *
+ * Forward sparse orthonormal transform of the image X, the compiled core
+ * of FORWARDSOTC. X is cut into blocks as in FORWARDSOT (sotblocks.h);
+ * column k of Y holds the coefficients D'*block(:) of block k, blocks
+ * numbered column-major over the block grid.
+ *
+ * If D is a cell array, every block is first assigned the gradient
+ * direction class of GETPATCHGRADCLASS(block, DIRRANGE) and transformed
+ * by D{class}; DIRCLASS is the class of every block (zero if D is a
+ * matrix). The blocks are classified in parallel, grouped by class, and
+ * every class dictionary is applied to its blocks with a single GEMM.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+
+#include "mex.h"
+#include "blas.h"
+#include <stdlib.h>
+#include <string.h>
+#include "sotblocks.h"
+
+
+/* Input Arguments */
+
+#define X_IN        prhs[0]
+#define D_IN        prhs[1]
+#define BLK_IN      prhs[2]
+#define TL_IN       prhs[3]
+#define DIR_IN      prhs[4]
+
+
+/* Output Arguments */
+
+#define Y_OUT       plhs[0]
+#define CLS_OUT     plhs[1]
+
+
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray*prhs[])
+
+{
+    double *x, *y, *P, *Pc, *Yc, *edges = NULL, *dc;
+    const double **dict;
+    mwSize nclass, natoms, nedges = 0;
+    mwIndex k, c, *ptr, *order;
+    int *cls, classify, badclass = 0, failed = 0;
+    SotGrid grid;
+
+
+    /* Check for proper number of arguments */
+
+    if (nrhs < 4 || nrhs > 5) {
+      mexErrMsgTxt("Invalid number of input arguments.");
+    } else if (nlhs > 2) {
+      mexErrMsgTxt("Too many output arguments.");
+    }
+
+
+    /* Check the the input dimensions */
+
+    if (!mxIsDouble(X_IN) || mxIsComplex(X_IN) || mxIsSparse(X_IN) || mxGetNumberOfDimensions(X_IN)>2) {
+      mexErrMsgTxt("X should be a 2-D real double matrix.");
+    }
+
+    sotGridInit(&grid, mxGetM(X_IN), mxGetN(X_IN), BLK_IN, TL_IN);
+    nclass = sotDictionaries(D_IN, grid.len, &dict, &natoms);
+
+    classify = mxIsCell(D_IN);
+    if (classify) {
+      if (nrhs < 5 || !mxIsDouble(DIR_IN) || mxGetNumberOfElements(DIR_IN) < 3) {
+        mexErrMsgTxt("DIRRANGE should hold at least three bin edges.");
+      }
+      edges = mxGetPr(DIR_IN);
+      nedges = mxGetNumberOfElements(DIR_IN);
+    }
+
+
+    /* Create matrices for the return arguments */
+
+    Y_OUT = mxCreateDoubleMatrix(natoms, grid.nblocks, mxREAL);
+    CLS_OUT = mxCreateDoubleMatrix(grid.ax[0].nb, grid.ax[1].nb, mxREAL);
+
+
+    /* Assign pointers */
+
+    x = mxGetPr(X_IN);
+    y = mxGetPr(Y_OUT);
+    dc = mxGetPr(CLS_OUT);
+
+
+    /* Do the actual computation */
+
+    P = (double*)mxMalloc(grid.len*grid.nblocks*sizeof(double));
+    cls = (int*)mxMalloc(grid.nblocks*sizeof(int));
+    ptr = (mwIndex*)mxMalloc((nclass+2)*sizeof(mwIndex));
+    order = (mwIndex*)mxMalloc(grid.nblocks*sizeof(mwIndex));
+
+    /* extract and classify the blocks */
+    #pragma omp parallel
+    {
+      double *cnt = classify ? (double*)malloc(nedges*sizeof(double)) : NULL;
+
+      if (classify && !cnt) {
+        #pragma omp atomic write
+        failed = 1;
+      }
+
+      #pragma omp for schedule(static)
+      for (k=0; k<grid.nblocks; k++) {
+        sotGather(&grid, x, k, P + k*grid.len);
+        cls[k] = 1;
+        if (classify && cnt) {
+          cls[k] = sotGradClass(P + k*grid.len, grid.bs, edges, nedges, cnt);
+          if ((mwSize)cls[k] > nclass) {
+            #pragma omp atomic write
+            badclass = 1;
+            cls[k] = 1;
+          }
+        }
+      }
+
+      free(cnt);
+    }
+
+    if (failed) {
+      mexErrMsgTxt("Cannot allocate memory for the histograms.");
+    }
+    if (badclass) {
+      mexErrMsgTxt("DIRRANGE has more direction classes than D has dictionaries.");
+    }
+
+    /* group the blocks by class */
+    sotSortByClass(cls, grid.nblocks, nclass, ptr, order);
+    if (nclass > 1) {
+      Pc = (double*)mxMalloc(grid.len*grid.nblocks*sizeof(double));
+      Yc = (double*)mxMalloc(natoms*grid.nblocks*sizeof(double));
+      #pragma omp parallel for schedule(static)
+      for (k=0; k<grid.nblocks; k++) {
+        memcpy(Pc + k*grid.len, P + order[k]*grid.len, grid.len*sizeof(double));
+      }
+    }
+    else {
+      Pc = P;
+      Yc = y;
+    }
+
+    /* one GEMM per class */
+    for (c=1; c<=nclass; c++) {
+      ptrdiff_t pm = natoms, pn = ptr[c+1] - ptr[c], pk = grid.len;
+      double one = 1, zero = 0;
+      if (pn == 0 || pm == 0) continue;
+      dgemm("T", "N", &pm, &pn, &pk, &one, (double*)dict[c-1], &pk, Pc + ptr[c]*grid.len, &pk,
+            &zero, Yc + ptr[c]*natoms, &pm);
+    }
+
+    if (nclass > 1) {
+      #pragma omp parallel for schedule(static)
+      for (k=0; k<grid.nblocks; k++) {
+        memcpy(y + order[k]*natoms, Yc + k*natoms, natoms*sizeof(double));
+      }
+      mxFree(Pc);
+      mxFree(Yc);
+    }
+
+    if (classify) {
+      for (k=0; k<grid.nblocks; k++) {
+        dc[k] = cls[k];
+      }
+    }
+
+    mxFree(P);
+    mxFree(cls);
+    mxFree(ptr);
+    mxFree(order);
+    mxFree((void*)dict);
+    sotGridFree(&grid);
+
+    return;
+}
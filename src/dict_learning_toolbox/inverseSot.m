@@ -1,6 +1,8 @@
 function x = inverseSot(y, m, n, D, blkSize, blkSize_tlCorner, dirClass)
 % INVERSESOT inverse sparse orthonormal transform (iSOT)
 %
+% See also: INVERSESOTC
+%
 %
 % This matlab source file is free for use in academic research.
 % All rights reserved.
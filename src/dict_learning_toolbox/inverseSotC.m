@@ -0,0 +1,20 @@
+function x = inverseSotC(y, m, n, D, blkSize, blkSize_tlCorner, dirClass)
+% INVERSESOTC inverse sparse orthonormal transform (iSOT), compiled
+% INVERSESOTC computes the same transform as INVERSESOT in C
+% (inverseSot_mex) from the flat coefficient array y of FORWARDSOTC.
+%
+% See also: INVERSESOT, FORWARDSOTC
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if (~exist('dirClass', 'var'))
+    dirClass = [];
+end
+
+x = inverseSot_mex(double(y), m, n, D, blkSize, blkSize_tlCorner, dirClass);
@@ -0,0 +1,162 @@
+/**************************************************************************
+ *
+ * File name: inverseSot_mex.c
+ *
+ * X = inverseSot_mex(Y, M, N, D, BLKSIZE, TLSIZE, DIRCLASS)
+ *
+ * Inverse sparse orthonormal transform, the compiled core of INVERSESOTC:
+ * the M-by-N image X whose block k (as in FORWARDSOT_MEX) is the part of
+ * D*Y(:,k) inside the image. If D is a cell array, block k uses the
+ * dictionary D{DIRCLASS(k)}; the blocks are grouped by class so that every
+ * class dictionary is applied with a single GEMM.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+
+#include "mex.h"
+#include "blas.h"
+#include <stdlib.h>
+#include <string.h>
+#include "sotblocks.h"
+
+
+/* Input Arguments */
+
+#define Y_IN        prhs[0]
+#define M_IN        prhs[1]
+#define N_IN        prhs[2]
+#define D_IN        prhs[3]
+#define BLK_IN      prhs[4]
+#define TL_IN       prhs[5]
+#define CLS_IN      prhs[6]
+
+
+/* Output Arguments */
+
+#define X_OUT       plhs[0]
+
+
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray*prhs[])
+
+{
+    double *x, *y, *R, *Yc, *dc;
+    const double **dict;
+    mwSize nclass, natoms, m, n;
+    mwIndex k, c, *ptr, *order;
+    int *cls;
+    SotGrid grid;
+
+
+    /* Check for proper number of arguments */
+
+    if (nrhs < 6 || nrhs > 7) {
+      mexErrMsgTxt("Invalid number of input arguments.");
+    } else if (nlhs > 1) {
+      mexErrMsgTxt("Too many output arguments.");
+    }
+
+
+    /* Check the the input dimensions */
+
+    if (mxGetScalar(M_IN) < 1 || mxGetScalar(N_IN) < 1) {
+      mexErrMsgTxt("Invalid image size.");
+    }
+    m = (mwSize)(mxGetScalar(M_IN) + 0.01);
+    n = (mwSize)(mxGetScalar(N_IN) + 0.01);
+
+    sotGridInit(&grid, m, n, BLK_IN, TL_IN);
+    nclass = sotDictionaries(D_IN, grid.len, &dict, &natoms);
+
+    if (!mxIsDouble(Y_IN) || mxIsComplex(Y_IN) || mxIsSparse(Y_IN) ||
+        mxGetNumberOfElements(Y_IN) != natoms*grid.nblocks) {
+      mexErrMsgTxt("Y should hold size(D,2) real coefficients per block.");
+    }
+
+    cls = (int*)mxMalloc(grid.nblocks*sizeof(int));
+    if (mxIsCell(D_IN)) {
+      if (nrhs < 7 || !mxIsDouble(CLS_IN) || mxGetNumberOfElements(CLS_IN) != grid.nblocks) {
+        mexErrMsgTxt("DIRCLASS should hold the class of every block.");
+      }
+      dc = mxGetPr(CLS_IN);
+      for (k=0; k<grid.nblocks; k++) {
+        if (!(dc[k] >= 1 && dc[k] <= nclass)) {
+          mexErrMsgTxt("Invalid direction class.");
+        }
+        cls[k] = (int)(dc[k] + 0.01);
+      }
+    }
+    else {
+      for (k=0; k<grid.nblocks; k++) {
+        cls[k] = 1;
+      }
+    }
+
+
+    /* Create matrices for the return arguments */
+
+    X_OUT = mxCreateDoubleMatrix(m, n, mxREAL);
+
+
+    /* Assign pointers */
+
+    x = mxGetPr(X_OUT);
+    y = mxGetPr(Y_IN);
+
+
+    /* Do the actual computation */
+
+    ptr = (mwIndex*)mxMalloc((nclass+2)*sizeof(mwIndex));
+    order = (mwIndex*)mxMalloc(grid.nblocks*sizeof(mwIndex));
+    R = (double*)mxMalloc(grid.len*grid.nblocks*sizeof(double));
+
+    /* group the coefficients by class */
+    sotSortByClass(cls, grid.nblocks, nclass, ptr, order);
+    if (nclass > 1) {
+      Yc = (double*)mxMalloc(natoms*grid.nblocks*sizeof(double));
+      #pragma omp parallel for schedule(static)
+      for (k=0; k<grid.nblocks; k++) {
+        memcpy(Yc + k*natoms, y + order[k]*natoms, natoms*sizeof(double));
+      }
+    }
+    else {
+      Yc = y;
+    }
+
+    /* one GEMM per class */
+    for (c=1; c<=nclass; c++) {
+      ptrdiff_t pm = grid.len, pn = ptr[c+1] - ptr[c], pk = natoms;
+      double one = 1, zero = 0;
+      if (pn == 0) continue;
+      if (pk == 0) {
+        memset(R + ptr[c]*grid.len, 0, pn*grid.len*sizeof(double));
+        continue;
+      }
+      dgemm("N", "N", &pm, &pn, &pk, &one, (double*)dict[c-1], &pm, Yc + ptr[c]*natoms, &pk,
+            &zero, R + ptr[c]*grid.len, &pm);
+    }
+
+    /* tile the blocks back, they do not overlap */
+    #pragma omp parallel for schedule(static)
+    for (k=0; k<grid.nblocks; k++) {
+      sotPut(&grid, x, order[k], R + k*grid.len);
+    }
+
+    if (nclass > 1) {
+      mxFree(Yc);
+    }
+    mxFree(R);
+    mxFree(cls);
+    mxFree(ptr);
+    mxFree(order);
+    mxFree((void*)dict);
+    sotGridFree(&grid);
+
+    return;
+}
@@ -0,0 +1,19 @@
+close all;
+clear;
+clc;
+
+fprintf('Compiling with OpenMP ...\n');
+if (isunix) % Linux / MacOS
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" sotTrain_mex.c -lmwlapack -lmwblas
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" forwardSot_mex.c -lmwblas
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" inverseSot_mex.c -lmwblas
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" batchOmp_mex.c -lmwblas
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" sparseKsvdUpdate_mex.c -lmwblas
+else        % Windows
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" sotTrain_mex.c -lmwlapack -lmwblas
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" forwardSot_mex.c -lmwblas
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" inverseSot_mex.c -lmwblas
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" batchOmp_mex.c -lmwblas
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" sparseKsvdUpdate_mex.c -lmwblas
+end
+fprintf('Compiling complete!\n');
@@ -0,0 +1,197 @@
+/**************************************************************************
+ *
+ * File name: ompcore.h
+ *
+ * Orthogonal matching pursuit with progressive Cholesky updates (Batch-OMP
+ * of Rubinstein, Zibulevsky and Elad), shared by batchOmp_mex.c and
+ * sparseKsvdUpdate_mex.c.
+ *
+ * A signal y is coded over a dictionary D of K atoms from alpha0 = D'*y
+ * and the Gram matrix G = D'*D only: the residual is never formed, the
+ * correlations are updated as alpha = alpha0 - G(:,I)*gamma and the
+ * Cholesky factor of G(I,I) grows by one row per selected atom. The Gram
+ * columns are either read from a precomputed G or computed on demand for
+ * a masked dictionary diag(m)*D (inpainting).
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+#ifndef _OMPCORE_H_
+#define _OMPCORE_H_
+
+#include "mex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+/* source of the Gram matrix columns */
+typedef struct {
+    const double *G;      /* K-by-K Gram matrix, or NULL */
+    const double *D;      /* len-by-K dictionary, used if G is NULL */
+    const double *mask;   /* len entries (0 or 1) of the masked dictionary */
+    mwSize len, K;
+} OmpGram;
+
+
+/* per-thread workspace for at most T atoms */
+typedef struct {
+    mwSize K, T;
+    double *L;            /* T-by-T lower Cholesky factor of G(I,I) */
+    double *Gsel;         /* K-by-T columns G(:,I) */
+    double *alpha;        /* K current correlations */
+    double *beta;         /* K, G(:,I)*gamma */
+    double *tmp;          /* T */
+    char *selected;       /* K flags */
+} OmpWork;
+
+
+static int ompWorkAlloc(OmpWork *w, mwSize K, mwSize T)
+{
+    w->K = K;
+    w->T = T;
+    w->L = (double*)malloc((T*T + 1)*sizeof(double));
+    w->Gsel = (double*)malloc((K*T + 1)*sizeof(double));
+    w->alpha = (double*)malloc((K + 1)*sizeof(double));
+    w->beta = (double*)malloc((K + 1)*sizeof(double));
+    w->tmp = (double*)malloc((T + 1)*sizeof(double));
+    w->selected = (char*)malloc(K + 1);
+    return w->L && w->Gsel && w->alpha && w->beta && w->tmp && w->selected;
+}
+
+
+static void ompWorkFree(OmpWork *w)
+{
+    free(w->L);
+    free(w->Gsel);
+    free(w->alpha);
+    free(w->beta);
+    free(w->tmp);
+    free(w->selected);
+}
+
+
+/* column k of the Gram matrix */
+static void ompGramColumn(const OmpGram *g, mwIndex k, double *col)
+{
+    mwIndex j, e;
+
+    if (g->G) {
+        memcpy(col, g->G + k*g->K, g->K*sizeof(double));
+        return;
+    }
+    for (j=0; j<g->K; j++) {
+        const double *dj = g->D + j*g->len, *dk = g->D + k*g->len;
+        double v = 0;
+        if (g->mask) {
+            for (e=0; e<g->len; e++) v += g->mask[e]*dj[e]*dk[e];
+        }
+        else {
+            for (e=0; e<g->len; e++) v += dj[e]*dk[e];
+        }
+        col[j] = v;
+    }
+}
+
+
+/* solves L*L'*x = b in place, L n-by-n lower triangular with leading dimension ld */
+static void cholSolve(const double *L, mwSize n, mwSize ld, double *b)
+{
+    mwIndex i, j;
+
+    for (i=0; i<n; i++) {
+        double v = b[i];
+        for (j=0; j<i; j++) v -= L[j*ld+i]*b[j];
+        b[i] = v / L[i*ld+i];
+    }
+    for (i=n; i-- > 0; ) {
+        double v = b[i];
+        for (j=i+1; j<n; j++) v -= L[i*ld+j]*b[j];
+        b[i] = v / L[i*ld+i];
+    }
+}
+
+
+/* Codes one signal: alpha0 = D'*y, diag = diag(G), ynorm2 = ||y||^2.
+ * Selects at most T atoms, stopping early when ||y - D*x||^2 <= eps
+ * (eps < 0: sparsity target only), when the remaining correlations vanish
+ * or when the next atom is linearly dependent on the selected ones.
+ * Returns the number n of atoms; ind[0..n-1] and coef[0..n-1] hold them in
+ * order of selection. */
+static mwSize ompCode(const OmpGram *g, const double *alpha0, const double *diag, double ynorm2,
+                      double eps, mwSize T, OmpWork *w, mwIndex *ind, double *coef)
+{
+    mwSize K = g->K, n = 0;
+    double err = ynorm2, deltaPrev = 0;
+    mwIndex i, j;
+
+    memcpy(w->alpha, alpha0, K*sizeof(double));
+    memset(w->selected, 0, K);
+
+    while (n < T) {
+        double best = 0, *gk, d;
+        mwIndex k = 0;
+
+        if (eps >= 0 && err <= eps) break;
+
+        /* atom most correlated with the residual */
+        for (j=0; j<K; j++) {
+            if (!w->selected[j] && diag[j] > 0) {
+                double v = fabs(w->alpha[j]) / sqrt(diag[j]);
+                if (v > best) {
+                    best = v;
+                    k = j;
+                }
+            }
+        }
+        if (best <= 1e-14*sqrt(ynorm2)) break;
+
+        /* progressive Cholesky update of G(I,I) */
+        gk = w->Gsel + n*K;
+        ompGramColumn(g, k, gk);
+        d = gk[k];
+        if (n > 0) {
+            double *row = w->tmp;
+            for (i=0; i<n; i++) {
+                double v = gk[ind[i]];
+                for (j=0; j<i; j++) v -= w->L[j*T+i]*row[j];
+                row[i] = v / w->L[i*T+i];
+                d -= row[i]*row[i];
+            }
+            if (d <= 1e-12*gk[k]) break;
+            for (i=0; i<n; i++) w->L[i*T+n] = row[i];
+        }
+        w->L[n*T+n] = sqrt(d);
+        ind[n] = k;
+        w->selected[k] = 1;
+        n++;
+
+        /* gamma = G(I,I) \ alpha0(I), alpha = alpha0 - G(:,I)*gamma */
+        for (i=0; i<n; i++) coef[i] = alpha0[ind[i]];
+        cholSolve(w->L, n, T, coef);
+        memset(w->beta, 0, K*sizeof(double));
+        for (i=0; i<n; i++) {
+            const double *gi = w->Gsel + i*K;
+            double c = coef[i];
+            for (j=0; j<K; j++) w->beta[j] += c*gi[j];
+        }
+        for (j=0; j<K; j++) w->alpha[j] = alpha0[j] - w->beta[j];
+
+        /* residual energy: ||r||^2 = ||y||^2 - gamma'*beta(I) */
+        if (eps >= 0) {
+            double delta = 0;
+            for (i=0; i<n; i++) delta += coef[i]*w->beta[ind[i]];
+            err = err - delta + deltaPrev;
+            deltaPrev = delta;
+        }
+    }
+    return n;
+}
+
+
+#endif
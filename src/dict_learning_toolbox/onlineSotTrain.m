@@ -3,6 +3,8 @@ function [Dout, X, Aout] = onlineSotTrain(Y, Din, t, Ain, nBlocks, option)
 % ONLINESOTTRAIN runs dictionary learning in an online manner by using the
 % previous dictionary as a warm start
 %
+% See also: ONLINESOTTRAINC
+%
 %
 % This matlab source file is free for use in academic research.
 % All rights reserved.
@@ -0,0 +1,88 @@
+function [Dout, X, Aout, cost] = onlineSotTrainC(Y, Din, t, Ain, nBlocks, option)
+% ONLINESOTTRAINC Online sparse orthonormal dictionary learning (compiled)
+% ONLINESOTTRAINC is a drop-in replacement of ONLINESOTTRAIN that runs the
+% whole training loop in C (sotTrain_mex). The patches are streamed in
+% minibatches, the costs are tracked from accumulated sums and the
+% dictionary update uses a Newton iteration for the polar decomposition
+% instead of a full SVD.
+%
+% Y is either the szPatch-by-N matrix of training patches, or a structure
+% describing patches of an image, which are then never extracted:
+%   .image      2-D or 3-D image
+%   .blkSize    patch size
+%   .pos        ndims(image)-by-N 1-based top-left corners of the patches
+%   .normalize  scale every patch to unit norm as GETPATCHES (default true)
+% e.g. for the regular sampling of GETPATCHES
+%   idx = cell(1, 2);
+%   [idx{:}] = reggrid(size(img)-blkSize+1, nBlocks, 'eqnum');
+%   [R, C] = ndgrid(idx{:});
+%   Y = struct('image', img, 'blkSize', blkSize, 'pos', [R(:), C(:)]');
+%
+% option fields as in ONLINESOTTRAIN: lambda (0.1), iterations (100),
+% tol (1e-3) and verbosity (1: print the costs of every iteration).
+% cost is 2-by-#iterations, the costs after the X and the D update.
+% X is only computed when requested.
+%
+% See also: ONLINESOTTRAIN, GETPATCHES
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+% parameter setting
+if (isfield(option, 'lambda'))
+    lambda = option.lambda;
+else
+    lambda = 0.1;
+end
+
+if (isfield(option, 'iterations'))
+    iterations = option.iterations;
+else
+    iterations = 100;
+end
+
+if (isfield(option, 'tol'))
+    tol = option.tol;
+else
+    tol = 1e-3;
+end
+
+if (isfield(option, 'verbosity'))
+    verbosity = option.verbosity;
+else
+    verbosity = 1;
+end
+
+if (~isempty(t))
+    mu = (t * nBlocks + 1 - nBlocks)/(t * nBlocks + 1);
+else
+    mu = 1;
+end
+
+if (isstruct(Y))
+    if (isfield(Y, 'normalize'))
+        normalize = Y.normalize;
+    else
+        normalize = true;
+    end
+    img = double(Y.image);
+    blkSize = double(Y.blkSize);
+    pos = double(Y.pos);
+else
+    normalize = false;
+    img = double(Y);
+    blkSize = [];
+    pos = [];
+end
+
+params = [lambda, iterations, tol, normalize, verbosity];
+if (nargout > 1)
+    [Dout, Aout, X, cost] = sotTrain_mex(img, blkSize, pos, double(Din), double(Ain), mu, params);
+else
+    Dout = sotTrain_mex(img, blkSize, pos, double(Din), double(Ain), mu, params);
+end
@@ -0,0 +1,581 @@
+/**************************************************************************
+ *
+ * File name: sotTrain_mex.c
+ *
+ * [D, A, X, COST] = sotTrain_mex(Y, SZ, POS, D0, A0, MU, PARAMS)
+ *
+ * Online sparse orthonormal transform (SOT) training, the compiled core of
+ * ONLINESOTTRAINC. Alternates the hard thresholding X = T_lambda(D'*Y)
+ * with the Procrustes update D' = polar(MU*A0 + X*Y') until the costs
+ * after both steps differ by less than tol. A = MU*A0 + X*Y' of the last
+ * iteration is returned for the next call.
+ *
+ * The training patches are either the columns of Y (SZ empty) or the
+ * blocks of size SZ of the image Y whose 1-based top-left corners are the
+ * columns of POS. Patches are streamed in minibatches: every batch is
+ * analyzed, thresholded and accumulated into X*Y' with two GEMMs, so
+ * neither the patch matrix nor D*X is formed. With D'*D = I the costs
+ * follow from the accumulated sums,
+ *   ||Y - D*X||_F^2 = ||Y||_F^2 - 2*<D', X*Y'> + ||X||_F^2.
+ *
+ * PARAMS = [lambda iterations tol normalize verbosity]; normalize scales
+ * every patch to unit norm as GETPATCHES. COST is 2-by-#iterations (cost
+ * after the X update and after the D update). X is formed only when
+ * requested.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+
+#include "mex.h"
+#include "blas.h"
+#include "lapack.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/* Input Arguments */
+
+#define Y_IN        prhs[0]
+#define SZ_IN       prhs[1]
+#define POS_IN      prhs[2]
+#define D_IN        prhs[3]
+#define A_IN        prhs[4]
+#define MU_IN       prhs[5]
+#define PARAMS_IN   prhs[6]
+
+
+/* Output Arguments */
+
+#define D_OUT       plhs[0]
+#define A_OUT       plhs[1]
+#define X_OUT       plhs[2]
+#define COST_OUT    plhs[3]
+
+
+/* size of the patch batch of one thread, in bytes */
+#define BATCH_BYTES (1 << 19)
+
+/* maximum number of Newton iterations of the polar decomposition */
+#define POLAR_MAXITER 30
+
+
+typedef struct {
+    const double *y;      /* image, or patch matrix if pos is NULL */
+    const double *pos;    /* ndims-by-npatches 1-based top-left corners */
+    mwSize ndims;
+    mwSize n[3];          /* image size */
+    mwSize sz[3];         /* block size */
+    mwSize len;           /* number of entries of a patch */
+    mwSize npatches;
+    int normalize;
+} PatchSource;
+
+
+/* sums of one pass over the patches */
+typedef struct {
+    double ysq;           /* ||Y||_F^2 */
+    double xsq;           /* ||X||_F^2 */
+    double nnz;           /* nnz(X) */
+} PassStats;
+
+
+/* Patches b0..b0+nb-1 as the columns of a len-by-nb matrix. They are read
+ * from the patch matrix directly when possible, gathered into P otherwise. */
+static const double *getBatch(const PatchSource *s, mwIndex b0, mwSize nb, double *P)
+{
+    mwIndex b, l, m, e;
+
+    if (!s->pos && !s->normalize) {
+        return s->y + b0*s->len;
+    }
+    for (b=0; b<nb; b++) {
+        double *dst = P + b*s->len, nrm = 0;
+        if (s->pos) {
+            const double *c = s->pos + (b0+b)*s->ndims;
+            const double *src = s->y + (mwIndex)(c[0]-0.5) + (mwIndex)(c[1]-0.5)*s->n[0];
+            if (s->ndims == 3) {
+                src += (mwIndex)(c[2]-0.5)*s->n[0]*s->n[1];
+            }
+            for (m=0; m<s->sz[2]; m++) {
+                for (l=0; l<s->sz[1]; l++) {
+                    memcpy(dst + (m*s->sz[1] + l)*s->sz[0], src + m*s->n[0]*s->n[1] + l*s->n[0], s->sz[0]*sizeof(double));
+                }
+            }
+        }
+        else {
+            memcpy(dst, s->y + (b0+b)*s->len, s->len*sizeof(double));
+        }
+        if (s->normalize) {
+            for (e=0; e<s->len; e++) nrm += dst[e]*dst[e];
+            if (nrm > 0) {
+                nrm = 1/sqrt(nrm);
+                for (e=0; e<s->len; e++) dst[e] *= nrm;
+            }
+        }
+    }
+    return P;
+}
+
+
+/* One pass over the patches for the dictionary D (len-by-natoms):
+ * S = X*Y' (natoms-by-len) with X = T_lambda(D'*Y), G = X*X' (upper
+ * triangle) if G is not NULL, X itself (natoms-by-npatches) if X is not
+ * NULL. Every thread accumulates its own S and G over a contiguous range
+ * of batches; they are summed in thread order, so the result does not
+ * depend on the scheduling. Returns 0 if out of memory. */
+static int sotPass(const PatchSource *s, const double *D, mwSize natoms, double lambda,
+                   mwSize batch, double *S, double *G, double *X, PassStats *stats)
+{
+    mwSize nbatches = (s->npatches + batch - 1) / batch, nthreads = 1;
+    mwSize ssize = natoms*s->len, gsize = G ? natoms*natoms : 0;
+    double **acc, *part;
+    mwIndex t, e;
+    int failed = 0;
+
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    if (nthreads > nbatches) nthreads = nbatches > 0 ? nbatches : 1;
+#endif
+
+    acc = (double**)mxCalloc(nthreads, sizeof(double*));
+    part = (double*)mxCalloc(3*nthreads, sizeof(double));
+
+    #pragma omp parallel num_threads(nthreads)
+    {
+        mwIndex k, q, tid = 0;
+        double *P, *C, *St, *Gt, *pt;
+        double ysq = 0, xsq = 0, nnz = 0;
+
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        P = (double*)malloc(batch*s->len*sizeof(double));
+        C = (double*)malloc(batch*natoms*sizeof(double));
+        St = (double*)calloc(ssize + gsize, sizeof(double));
+        Gt = St + ssize;
+        acc[tid] = St;
+
+        if (!P || !C || !St) {
+            #pragma omp atomic write
+            failed = 1;
+        }
+
+        #pragma omp for schedule(static)
+        for (k=0; k<nbatches; k++) {
+            mwIndex b0 = k*batch;
+            mwSize nb = (b0 + batch <= s->npatches) ? batch : s->npatches - b0;
+            ptrdiff_t pm = natoms, pn = nb, pk = s->len, ld = s->len;
+            double one = 1, zero = 0;
+            const double *Pb;
+
+            if (!P || !C || !St) continue;
+
+            Pb = getBatch(s, b0, nb, P);
+            for (q=0; q<nb*s->len; q++) ysq += Pb[q]*Pb[q];
+
+            /* analysis C = D'*P */
+            dgemm("T", "N", &pm, &pn, &pk, &one, (double*)D, &ld, (double*)Pb, &ld, &zero, C, &pm);
+
+            /* hard thresholding */
+            for (q=0; q<nb*natoms; q++) {
+                if (fabs(C[q]) < lambda) {
+                    C[q] = 0;
+                }
+                else {
+                    xsq += C[q]*C[q];
+                    nnz += 1;
+                }
+            }
+            if (X) {
+                memcpy(X + b0*natoms, C, nb*natoms*sizeof(double));
+            }
+
+            /* S += C*P', G += C*C' */
+            pn = s->len; pk = nb;
+            dgemm("N", "T", &pm, &pn, &pk, &one, C, &pm, (double*)Pb, &ld, &one, St, &pm);
+            if (G) {
+                dsyrk("U", "N", &pm, &pk, &one, C, &pm, &one, Gt, &pm);
+            }
+        }
+
+        pt = part + 3*tid;
+        pt[0] = ysq; pt[1] = xsq; pt[2] = nnz;
+        free(P);
+        free(C);
+    }
+
+    memset(stats, 0, sizeof(PassStats));
+    if (!failed) {
+        memset(S, 0, ssize*sizeof(double));
+        if (G) memset(G, 0, gsize*sizeof(double));
+        for (t=0; t<nthreads; t++) {
+            if (!acc[t]) continue;
+            for (e=0; e<ssize; e++) S[e] += acc[t][e];
+            for (e=0; e<gsize; e++) G[e] += acc[t][ssize + e];
+            stats->ysq += part[3*t];
+            stats->xsq += part[3*t+1];
+            stats->nnz += part[3*t+2];
+        }
+    }
+    for (t=0; t<nthreads; t++) {
+        free(acc[t]);
+    }
+    mxFree(acc);
+    mxFree(part);
+
+    return !failed;
+}
+
+
+static double frobNorm(const double *x, mwSize n)
+{
+    mwIndex i;
+    double v = 0;
+    for (i=0; i<n; i++) v += x[i]*x[i];
+    return sqrt(v);
+}
+
+
+/* Q = U*V' from the thin SVD Z = U*S*V' of the m-by-n matrix Z, m <= n */
+static int polarSvd(const double *Z, ptrdiff_t m, ptrdiff_t n, double *Q)
+{
+    ptrdiff_t lwork = -1, info = 0;
+    double *A, *sv, *U, *VT, *work, wsize, one = 1, zero = 0;
+
+    A = (double*)mxMalloc(m*n*sizeof(double));
+    sv = (double*)mxMalloc(m*sizeof(double));
+    U = (double*)mxMalloc(m*m*sizeof(double));
+    VT = (double*)mxMalloc(m*n*sizeof(double));
+    memcpy(A, Z, m*n*sizeof(double));
+
+    dgesvd("S", "S", &m, &n, A, &m, sv, U, &m, VT, &m, &wsize, &lwork, &info);
+    lwork = (ptrdiff_t)wsize;
+    work = (double*)mxMalloc(lwork*sizeof(double));
+    dgesvd("S", "S", &m, &n, A, &m, sv, U, &m, VT, &m, work, &lwork, &info);
+    if (info == 0) {
+        dgemm("N", "N", &m, &n, &m, &one, U, &m, VT, &m, &zero, Q, &m);
+    }
+
+    mxFree(work);
+    mxFree(A);
+    mxFree(sv);
+    mxFree(U);
+    mxFree(VT);
+    return info == 0;
+}
+
+
+/* Orthogonal polar factor Q of the m-by-n matrix Z (m <= n), Z = Q*H with
+ * Q*Q' = I. A square nonsingular Z uses the scaled Newton iteration
+ * Q <- (zeta*Q + inv(Q)'/zeta)/2 (Higham), which needs one LU inverse per
+ * step and converges in a handful of steps; a rectangular or numerically
+ * singular Z, or no convergence, falls back to the SVD. */
+static void polarFactor(const double *Z, mwSize m, mwSize n, double *Q)
+{
+    ptrdiff_t pn = n, lwork = -1, info = 0, *ipiv;
+    double *Xi, *Xn, *work, wsize, delta = 1, prev = HUGE_VAL;
+    mwIndex i, j, iter;
+
+    if (m != n || n == 0) {
+        if (n > 0 && !polarSvd(Z, m, n, Q)) {
+            mexErrMsgTxt("SVD of the dictionary update failed.");
+        }
+        return;
+    }
+
+    Xi = (double*)mxMalloc(n*n*sizeof(double));
+    Xn = (double*)mxMalloc(n*n*sizeof(double));
+    ipiv = (ptrdiff_t*)mxMalloc(n*sizeof(ptrdiff_t));
+    dgetri(&pn, Xi, &pn, ipiv, &wsize, &lwork, &info);
+    lwork = (ptrdiff_t)wsize > pn ? (ptrdiff_t)wsize : pn;
+    work = (double*)mxMalloc(lwork*sizeof(double));
+
+    memcpy(Q, Z, n*n*sizeof(double));
+    for (iter=0; iter<POLAR_MAXITER; iter++) {
+        double zeta = 1, nq, nd = 0, nn = 0;
+
+        memcpy(Xi, Q, n*n*sizeof(double));
+        dgetrf(&pn, &pn, Xi, &pn, ipiv, &info);
+        if (info != 0) break;
+        dgetri(&pn, Xi, &pn, ipiv, work, &lwork, &info);
+        if (info != 0) break;
+
+        /* Frobenius-norm scaling until the iteration is in its quadratic phase */
+        nq = frobNorm(Q, n*n);
+        if (delta > 1e-2) {
+            zeta = sqrt(frobNorm(Xi, n*n) / nq);
+        }
+        for (j=0; j<n; j++) {
+            for (i=0; i<n; i++) {
+                double v = 0.5*(zeta*Q[j*n+i] + Xi[i*n+j]/zeta);
+                nd += (v - Q[j*n+i])*(v - Q[j*n+i]);
+                nn += v*v;
+                Xn[j*n+i] = v;
+            }
+        }
+        memcpy(Q, Xn, n*n*sizeof(double));
+
+        /* stop at convergence, or when rounding errors stall the iteration */
+        delta = sqrt(nd/nn);
+        if (delta < 1e-14 || (delta < 1e-8 && delta >= prev)) break;
+        prev = delta;
+    }
+
+    mxFree(Xi);
+    mxFree(Xn);
+    mxFree(ipiv);
+    mxFree(work);
+
+    if (info != 0 || delta > 1e-8) {
+        if (!polarSvd(Z, m, n, Q)) {
+            mexErrMsgTxt("SVD of the dictionary update failed.");
+        }
+    }
+}
+
+
+/* ||Y - D*X||_F^2 from the pass sums, for any D */
+static double residualGeneral(const double *D, const double *S, const double *G, mwSize len,
+                              mwSize natoms, const PassStats *st)
+{
+    ptrdiff_t pn = natoms, pk = len;
+    double one = 1, zero = 0, cross = 0, quad = 0, *DtD;
+    mwIndex a, b, e;
+
+    for (a=0; a<natoms; a++) {
+        for (e=0; e<len; e++) cross += D[a*len+e]*S[e*natoms+a];
+    }
+
+    DtD = (double*)mxCalloc(natoms*natoms, sizeof(double));
+    dsyrk("U", "T", &pn, &pk, &one, (double*)D, &pk, &zero, DtD, &pn);
+    for (b=0; b<natoms; b++) {
+        for (a=0; a<b; a++) quad += 2*DtD[b*natoms+a]*G[b*natoms+a];
+        quad += DtD[b*natoms+b]*G[b*natoms+b];
+    }
+    mxFree(DtD);
+
+    return st->ysq - 2*cross + quad;
+}
+
+
+/* ||Y - D*X||_F^2 from the pass sums, for D'*D = I */
+static double residualOrtho(const double *D, const double *S, mwSize len, mwSize natoms, const PassStats *st)
+{
+    double cross = 0;
+    mwIndex a, e;
+
+    for (a=0; a<natoms; a++) {
+        for (e=0; e<len; e++) cross += D[a*len+e]*S[e*natoms+a];
+    }
+    return st->ysq - 2*cross + st->xsq;
+}
+
+
+/* whether D'*D = I up to rounding errors */
+static int isOrthonormal(const double *D, mwSize len, mwSize natoms)
+{
+    ptrdiff_t pn = natoms, pk = len;
+    double one = 1, zero = 0, *DtD;
+    mwIndex a, b;
+    int ortho = 1;
+
+    DtD = (double*)mxCalloc(natoms*natoms, sizeof(double));
+    dsyrk("U", "T", &pn, &pk, &one, (double*)D, &pk, &zero, DtD, &pn);
+    for (b=0; b<natoms && ortho; b++) {
+        for (a=0; a<=b; a++) {
+            if (fabs(DtD[b*natoms+a] - (a == b)) > 1e-10) {
+                ortho = 0;
+                break;
+            }
+        }
+    }
+    mxFree(DtD);
+    return ortho;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray*prhs[])
+
+{
+    double *D, *A0, *Z, *S, *G, *Q, *X, *params, *cost, *s, mu, lambda, tol, costX, costD;
+    mwSize natoms, batch, maxiter, iter, npos, e, a;
+    mwIndex i, d;
+    int verbosity, ortho;
+    PatchSource src;
+    PassStats st;
+
+
+    /* Check for proper number of arguments */
+
+    if (nrhs != 7) {
+      mexErrMsgTxt("Invalid number of input arguments.");
+    } else if (nlhs > 4) {
+      mexErrMsgTxt("Too many output arguments.");
+    }
+
+
+    /* Check the the input dimensions */
+
+    if (!mxIsDouble(Y_IN) || mxIsComplex(Y_IN) || mxIsSparse(Y_IN)) {
+      mexErrMsgTxt("Y should be a full real double matrix.");
+    }
+    if (!mxIsDouble(D_IN) || mxIsComplex(D_IN) || mxIsSparse(D_IN) || mxGetNumberOfDimensions(D_IN)>2) {
+      mexErrMsgTxt("D0 should be a full real matrix.");
+    }
+    if (!mxIsDouble(PARAMS_IN) || mxGetNumberOfElements(PARAMS_IN) != 5) {
+      mexErrMsgTxt("PARAMS should be [lambda iterations tol normalize verbosity].");
+    }
+
+    memset(&src, 0, sizeof(PatchSource));
+    src.y = mxGetPr(Y_IN);
+    src.len = mxGetM(D_IN);
+    natoms = mxGetN(D_IN);
+
+    if (natoms > src.len) {
+      mexErrMsgTxt("D0 cannot have more atoms than entries of a patch.");
+    }
+
+    if (mxIsEmpty(SZ_IN)) {
+      /* patch matrix */
+      if (mxGetNumberOfDimensions(Y_IN)>2 || mxGetM(Y_IN) != src.len) {
+        mexErrMsgTxt("Y should have one patch per column, as many rows as D0.");
+      }
+      src.npatches = mxGetN(Y_IN);
+    }
+    else {
+      /* patches of an image */
+      src.ndims = mxGetNumberOfDimensions(Y_IN);
+      if (src.ndims > 3 || !mxIsDouble(SZ_IN) || mxGetNumberOfElements(SZ_IN) != src.ndims) {
+        mexErrMsgTxt("Invalid block size.");
+      }
+      s = mxGetPr(SZ_IN);
+      for (d=0; d<3; d++) {
+        src.n[d] = d < src.ndims ? (mxGetDimensions(Y_IN))[d] : 1;
+        src.sz[d] = d < src.ndims ? (mwSize)(s[d] + 0.01) : 1;
+        if (d < src.ndims && (s[d] < 1 || src.sz[d] > src.n[d])) {
+          mexErrMsgTxt("Invalid block size.");
+        }
+      }
+      if (src.sz[0]*src.sz[1]*src.sz[2] != src.len) {
+        mexErrMsgTxt("D0 should have prod(SZ) rows.");
+      }
+      if (!mxIsDouble(POS_IN) || mxIsComplex(POS_IN) || mxIsSparse(POS_IN) || mxGetM(POS_IN) != src.ndims) {
+        mexErrMsgTxt("POS should have one row per dimension of Y.");
+      }
+      src.pos = mxGetPr(POS_IN);
+      src.npatches = mxGetN(POS_IN);
+      npos = src.npatches*src.ndims;
+      for (i=0; i<npos; i++) {
+        d = i % src.ndims;
+        if (!(src.pos[i] >= 1 && src.pos[i] <= src.n[d]-src.sz[d]+1)) {
+          mexErrMsgTxt("Block position out of range.");
+        }
+      }
+    }
+
+    if (!mxIsEmpty(A_IN) && (!mxIsDouble(A_IN) || mxIsComplex(A_IN) || mxIsSparse(A_IN) ||
+                             mxGetM(A_IN) != natoms || mxGetN(A_IN) != src.len)) {
+      mexErrMsgTxt("A0 should be empty or a full real matrix of the size of D0'.");
+    }
+
+
+    /* Get parameters */
+
+    mu = mxGetScalar(MU_IN);
+    params = mxGetPr(PARAMS_IN);
+    lambda = params[0];
+    maxiter = params[1] > 0 ? (mwSize)(params[1] + 0.01) : 0;
+    tol = params[2];
+    src.normalize = params[3] != 0;
+    verbosity = (int)params[4];
+
+    batch = BATCH_BYTES / ((src.len + natoms) * sizeof(double));
+    if (batch < 16) batch = 16;
+
+
+    /* Create matrices for the return arguments */
+
+    D_OUT = mxDuplicateArray(D_IN);
+    A_OUT = mxCreateDoubleMatrix(natoms, src.len, mxREAL);
+    if (nlhs > 2) {
+      X_OUT = mxCreateDoubleMatrix(natoms, src.npatches, mxREAL);
+    }
+
+
+    /* Assign pointers */
+
+    D = mxGetPr(D_OUT);
+    Z = mxGetPr(A_OUT);
+    A0 = mxIsEmpty(A_IN) ? NULL : mxGetPr(A_IN);
+    X = nlhs > 2 ? mxGetPr(X_OUT) : NULL;
+
+
+    /* Do the actual computation */
+
+    S = (double*)mxMalloc(natoms*src.len*sizeof(double));
+    Q = (double*)mxMalloc(natoms*src.len*sizeof(double));
+    cost = (double*)mxMalloc(2*(maxiter > 0 ? maxiter : 1)*sizeof(double));
+
+    /* the cross terms of D'*D are only needed while D0 is not orthonormal */
+    ortho = isOrthonormal(D, src.len, natoms);
+    G = ortho ? NULL : (double*)mxMalloc(natoms*natoms*sizeof(double));
+
+    for (iter=0; iter<maxiter; iter++) {
+
+      /* fix dictionary, hard thresholding coefficients */
+      if (!sotPass(&src, D, natoms, lambda, batch, S, G, X, &st)) {
+        mexErrMsgTxt("Cannot allocate memory for the batch buffers.");
+      }
+      costX = (G ? residualGeneral(D, S, G, src.len, natoms, &st) :
+                   residualOrtho(D, S, src.len, natoms, &st)) + st.nnz*lambda*lambda;
+
+      /* fix coefficients, update dictionary: D' = polar(mu*A0 + X*Y') */
+      for (e=0; e<natoms*src.len; e++) {
+        Z[e] = A0 ? mu*A0[e] + S[e] : S[e];
+      }
+      polarFactor(Z, natoms, src.len, Q);
+      for (a=0; a<natoms; a++) {
+        for (e=0; e<src.len; e++) D[a*src.len+e] = Q[e*natoms+a];
+      }
+      costD = residualOrtho(D, S, src.len, natoms, &st) + st.nnz*lambda*lambda;
+
+      if (G) {
+        mxFree(G);
+        G = NULL;
+      }
+
+      cost[2*iter] = costX;
+      cost[2*iter+1] = costD;
+      if (verbosity > 0) {
+        mexPrintf("iter = %d, cost_updateX = %f, cost_updateD = %f\n", (int)iter+1, costX, costD);
+      }
+      if (fabs(costD - costX) < tol) {
+        iter++;
+        break;
+      }
+    }
+
+    if (nlhs > 3) {
+      COST_OUT = mxCreateDoubleMatrix(2, iter, mxREAL);
+      memcpy(mxGetPr(COST_OUT), cost, 2*iter*sizeof(double));
+    }
+
+    if (G) mxFree(G);
+    mxFree(S);
+    mxFree(Q);
+    mxFree(cost);
+
+    return;
+}
@@ -0,0 +1,244 @@
+/**************************************************************************
+ *
+ * File name: sotblocks.h
+ *
+ * Block partition, gradient direction classification and class-wise
+ * batching of the sparse orthonormal transform (SOT), shared by
+ * forwardSot_mex.c and inverseSot_mex.c.
+ *
+ * An m-by-n image is cut into a top-left corner block of size TLSIZE,
+ * interior blocks of size BLKSIZE and a bottom-right remainder, as in
+ * FORWARDSOT. Every block is zero-padded to BLKSIZE: the first block row
+ * (column) is aligned with the top (left), the last one with the bottom
+ * (right) of the padded block. Blocks are numbered column-major over the
+ * nbr-by-nbc block grid.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+#ifndef _SOTBLOCKS_H_
+#define _SOTBLOCKS_H_
+
+#include "mex.h"
+#include <string.h>
+#include <math.h>
+
+
+/* blocks along one dimension */
+typedef struct {
+    mwSize nb;            /* number of blocks */
+    mwIndex *start;       /* first image index of every block */
+    mwSize *count;        /* number of image entries of every block */
+    mwIndex *offset;      /* position of the entries in the padded block */
+} SotAxis;
+
+
+typedef struct {
+    mwSize m, n;          /* image size */
+    mwSize bs[2];         /* (padded) block size */
+    mwSize len;           /* bs[0]*bs[1] */
+    SotAxis ax[2];
+    mwSize nblocks;
+} SotGrid;
+
+
+static void sotAxisInit(SotAxis *a, mwSize m, mwSize bs, mwSize tl)
+{
+    mwSize nint = (m - tl) / bs, br = (m - tl) - nint*bs;
+    mwIndex i;
+
+    a->nb = nint + 1 + (br > 0);
+    a->start = (mwIndex*)mxMalloc(a->nb*sizeof(mwIndex));
+    a->count = (mwSize*)mxMalloc(a->nb*sizeof(mwSize));
+    a->offset = (mwIndex*)mxMalloc(a->nb*sizeof(mwIndex));
+
+    /* top (left) corner, aligned with the top of the block */
+    a->start[0] = 0;
+    a->count[0] = tl;
+    a->offset[0] = 0;
+    for (i=1; i<=nint; i++) {
+        a->start[i] = tl + (i-1)*bs;
+        a->count[i] = bs;
+        a->offset[i] = 0;
+    }
+    /* bottom (right) remainder, aligned with the bottom of the block */
+    if (br > 0) {
+        a->start[nint+1] = m - br;
+        a->count[nint+1] = br;
+        a->offset[nint+1] = bs - br;
+    }
+}
+
+
+/* checks and sets up the block grid; BLKSIZE and TLSIZE are 2-element arrays */
+static void sotGridInit(SotGrid *g, mwSize m, mwSize n, const mxArray *blksize, const mxArray *tlsize)
+{
+    double *b, *t;
+    int d;
+
+    if (!mxIsDouble(blksize) || mxGetNumberOfElements(blksize) != 2 ||
+        !mxIsDouble(tlsize) || mxGetNumberOfElements(tlsize) != 2) {
+      mexErrMsgTxt("Block sizes should have two entries.");
+    }
+    b = mxGetPr(blksize);
+    t = mxGetPr(tlsize);
+    if (b[0] < 1 || b[1] < 1 || t[0] < 0 || t[1] < 0) {
+      mexErrMsgTxt("Invalid block size.");
+    }
+    if (b[0] < t[0] || b[1] < t[1]) {
+      mexErrMsgTxt("Corner block size is larger than interior block size!");
+    }
+    if (t[0] > m || t[1] > n) {
+      mexErrMsgTxt("Corner block size is larger than the image.");
+    }
+
+    g->m = m;
+    g->n = n;
+    for (d=0; d<2; d++) {
+      g->bs[d] = (mwSize)(b[d] + 0.01);
+    }
+    g->len = g->bs[0]*g->bs[1];
+    sotAxisInit(&g->ax[0], m, g->bs[0], (mwSize)(t[0] + 0.01));
+    sotAxisInit(&g->ax[1], n, g->bs[1], (mwSize)(t[1] + 0.01));
+    g->nblocks = g->ax[0].nb*g->ax[1].nb;
+}
+
+
+static void sotGridFree(SotGrid *g)
+{
+    int d;
+    for (d=0; d<2; d++) {
+      mxFree(g->ax[d].start);
+      mxFree(g->ax[d].count);
+      mxFree(g->ax[d].offset);
+    }
+}
+
+
+/* copy block k of the image x to the zero-padded block b */
+static void sotGather(const SotGrid *g, const double *x, mwIndex k, double *b)
+{
+    const SotAxis *r = &g->ax[0], *c = &g->ax[1];
+    mwIndex i = k % r->nb, j = k / r->nb, l;
+
+    memset(b, 0, g->len*sizeof(double));
+    for (l=0; l<c->count[j]; l++) {
+        memcpy(b + (c->offset[j] + l)*g->bs[0] + r->offset[i],
+               x + (c->start[j] + l)*g->m + r->start[i], r->count[i]*sizeof(double));
+    }
+}
+
+
+/* copy the image part of the padded block b back to block k of x */
+static void sotPut(const SotGrid *g, double *x, mwIndex k, const double *b)
+{
+    const SotAxis *r = &g->ax[0], *c = &g->ax[1];
+    mwIndex i = k % r->nb, j = k / r->nb, l;
+
+    for (l=0; l<c->count[j]; l++) {
+        memcpy(x + (c->start[j] + l)*g->m + r->start[i],
+               b + (c->offset[j] + l)*g->bs[0] + r->offset[i], r->count[i]*sizeof(double));
+    }
+}
+
+
+/* derivative of MATLAB's GRADIENT at index i of a sequence of n entries
+ * with stride s: central differences inside, one-sided at the ends */
+static double gradAt(const double *v, mwSize n, mwSize s, mwIndex i)
+{
+    if (n < 2) return 0;
+    if (i == 0) return v[s] - v[0];
+    if (i == n-1) return v[i*s] - v[(i-1)*s];
+    return (v[(i+1)*s] - v[(i-1)*s]) / 2;
+}
+
+
+/* Gradient direction class of the bs[0]-by-bs[1] block b, as
+ * GETPATCHGRADCLASS: histogram of atand(gx./gy) over the nedges edges of
+ * dirRange (HISTC, last bin dropped), bins k and nbins+1-k merged, index of
+ * the (first) maximum. cnt holds nedges entries. Returns a 1-based class. */
+static int sotGradClass(const double *b, const mwSize *bs, const double *edges, mwSize nedges, double *cnt)
+{
+    mwSize nbins = nedges - 1, nclass = nbins / 2;
+    mwIndex i, j, e;
+    int best = 0;
+
+    memset(cnt, 0, nedges*sizeof(double));
+    for (j=0; j<bs[1]; j++) {
+        for (i=0; i<bs[0]; i++) {
+            double gx = gradAt(b + i, bs[1], bs[0], j);
+            double gy = gradAt(b + j*bs[0], bs[0], 1, i);
+            double dir = atan(gx / gy) * 180 / M_PI;
+
+            /* NaN (flat spots) and values outside the edges are not counted */
+            if (!(dir >= edges[0] && dir < edges[nbins])) continue;
+            for (e=0; e<nbins-1 && dir >= edges[e+1]; e++);
+            cnt[e] += 1;
+        }
+    }
+
+    for (e=1; e<nclass; e++) {
+        if (cnt[e] + cnt[nbins-1-e] > cnt[best] + cnt[nbins-1-best]) {
+            best = (int)e;
+        }
+    }
+    return best + 1;
+}
+
+
+/* Counting sort of the blocks by class (1..nclass): the blocks of class c
+ * are order[ptr[c]..ptr[c+1]-1], in increasing block order. ptr holds
+ * nclass+2 entries. */
+static void sotSortByClass(const int *cls, mwSize nblocks, mwSize nclass, mwIndex *ptr, mwIndex *order)
+{
+    mwIndex k, c;
+
+    memset(ptr, 0, (nclass+2)*sizeof(mwIndex));
+    for (k=0; k<nblocks; k++) {
+        ptr[cls[k]]++;
+    }
+    for (c=1; c<=nclass; c++) {
+        ptr[c] += ptr[c-1];
+    }
+    for (k=nblocks; k-- > 0; ) {
+        order[--ptr[cls[k]]] = k;
+    }
+    ptr[nclass+1] = nblocks;
+}
+
+
+/* the class dictionaries: a matrix, or a cell array of matrices of the same size */
+static mwSize sotDictionaries(const mxArray *din, mwSize len, const double ***dict, mwSize *natoms)
+{
+    mwSize nclass, c;
+
+    if (mxIsCell(din)) {
+      nclass = mxGetNumberOfElements(din);
+      if (nclass == 0) {
+        mexErrMsgTxt("D should not be an empty cell array.");
+      }
+    }
+    else {
+      nclass = 1;
+    }
+
+    *dict = (const double**)mxMalloc(nclass*sizeof(double*));
+    for (c=0; c<nclass; c++) {
+      const mxArray *d = mxIsCell(din) ? mxGetCell(din, c) : din;
+      if (!d || !mxIsDouble(d) || mxIsComplex(d) || mxIsSparse(d) || mxGetM(d) != len ||
+          (c > 0 && mxGetN(d) != *natoms)) {
+        mexErrMsgTxt("D should be a real matrix (or cell array of matrices of the same size) with prod(BLKSIZE) rows.");
+      }
+      *natoms = mxGetN(d);
+      (*dict)[c] = mxGetPr(d);
+    }
+    return nclass;
+}
+
+
+#endif
@@ -0,0 +1,590 @@
+/**************************************************************************
+ *
+ * File name: sparseKsvdUpdate_mex.c
+ *
+ * [A, X, REPLACED, UNUSED] = sparseKsvdUpdate_mex(Y, B, A0, X0, TDICT, MASK, NRUNS)
+ *
+ * Sparse K-SVD dictionary update of the effective dictionary B*A, atom by
+ * atom: for atom j, with I the signals whose representation uses it,
+ *   g = X(j,I)'/||X(j,I)||,  z = E_I*g,  a = OMP(B, z, TDICT),
+ *   a = a/||B*a||,  X(j,I) = (E_I'*B*a)',
+ * where E_I = Y(:,I) - B*A*X(:,I) without atom j. If MASK (size of Y) is
+ * not empty, the masked update of SPARSEKSVD_INPAINTING is run instead,
+ * alternating NRUNS times between a and g with the missing entries of E_I
+ * filled in by the current rank-one estimate.
+ *
+ * Atoms used by at most one signal are replaced by the OMP code over B of
+ * the worst represented signal that was not used for this before
+ * (REPLACED(j) = 1); UNUSED lists the 1-based indices of the signals still
+ * available for that, as unusedSig of SPARSEKSVD_DENOISING.
+ *
+ * X0 is accessed by rows through a CSR copy of its sparsity pattern, which
+ * the update never changes; B*A is kept up to date one column at a time,
+ * so the residuals only cost one sparse product per signal. The loops
+ * over the signals of an atom run in parallel, with the partial sums of
+ * every thread added in thread order.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+
+#include "mex.h"
+#include "blas.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ompcore.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/* Input Arguments */
+
+#define Y_IN        prhs[0]
+#define B_IN        prhs[1]
+#define A_IN        prhs[2]
+#define X_IN        prhs[3]
+#define TDICT_IN    prhs[4]
+#define MASK_IN     prhs[5]
+#define NRUNS_IN    prhs[6]
+
+
+/* Output Arguments */
+
+#define A_OUT       plhs[0]
+#define X_OUT       plhs[1]
+#define REP_OUT     plhs[2]
+#define UNUSED_OUT  plhs[3]
+
+
+/* sparse matrix with the rows of X also accessible (CSR) */
+typedef struct {
+    mwSize K, N;
+    mwIndex *jc, *ir;     /* CSC pattern */
+    double *pr;           /* CSC values */
+    mwIndex *rowptr;      /* CSR pattern: row j is col[rowptr[j]..rowptr[j+1]-1] */
+    mwIndex *col;
+    mwIndex *pos;         /* CSC position of every CSR entry */
+} SparseRep;
+
+
+/* the number of chunks of the parallel reductions */
+static mwSize numChunks(mwSize n)
+{
+    mwSize nc = 1;
+#ifdef _OPENMP
+    nc = omp_get_max_threads();
+#endif
+    if (nc > n) nc = n;
+    return nc > 0 ? nc : 1;
+}
+
+
+/* CSC copy of the (full or sparse) K-by-N matrix x, and its CSR pattern */
+static void sparseRepInit(SparseRep *s, const mxArray *x)
+{
+    mwSize K = mxGetM(x), N = mxGetN(x), nnz = 0;
+    mwIndex i, j, p, *next;
+    double *v = mxGetPr(x);
+
+    s->K = K;
+    s->N = N;
+    s->jc = (mwIndex*)mxMalloc((N+1)*sizeof(mwIndex));
+    if (mxIsSparse(x)) {
+      mwIndex *xjc = mxGetJc(x), *xir = mxGetIr(x);
+      nnz = xjc[N];
+      s->ir = (mwIndex*)mxMalloc((nnz+1)*sizeof(mwIndex));
+      s->pr = (double*)mxMalloc((nnz+1)*sizeof(double));
+      memcpy(s->jc, xjc, (N+1)*sizeof(mwIndex));
+      memcpy(s->ir, xir, nnz*sizeof(mwIndex));
+      memcpy(s->pr, v, nnz*sizeof(double));
+    }
+    else {
+      for (i=0; i<K*N; i++) nnz += (v[i] != 0);
+      s->ir = (mwIndex*)mxMalloc((nnz+1)*sizeof(mwIndex));
+      s->pr = (double*)mxMalloc((nnz+1)*sizeof(double));
+      s->jc[0] = 0;
+      for (j=0, p=0; j<N; j++) {
+        for (i=0; i<K; i++) {
+          if (v[j*K+i] != 0) {
+            s->ir[p] = i;
+            s->pr[p++] = v[j*K+i];
+          }
+        }
+        s->jc[j+1] = p;
+      }
+    }
+
+    /* transpose the pattern */
+    s->rowptr = (mwIndex*)mxCalloc(K+1, sizeof(mwIndex));
+    s->col = (mwIndex*)mxMalloc((nnz+1)*sizeof(mwIndex));
+    s->pos = (mwIndex*)mxMalloc((nnz+1)*sizeof(mwIndex));
+    next = (mwIndex*)mxMalloc((K+1)*sizeof(mwIndex));
+    for (p=0; p<nnz; p++) s->rowptr[s->ir[p]+1]++;
+    for (i=0; i<K; i++) s->rowptr[i+1] += s->rowptr[i];
+    memcpy(next, s->rowptr, K*sizeof(mwIndex));
+    for (j=0; j<N; j++) {
+      for (p=s->jc[j]; p<s->jc[j+1]; p++) {
+        mwIndex q = next[s->ir[p]]++;
+        s->col[q] = j;
+        s->pos[q] = p;
+      }
+    }
+    mxFree(next);
+}
+
+
+static void sparseRepFree(SparseRep *s)
+{
+    mxFree(s->jc);
+    mxFree(s->ir);
+    mxFree(s->pr);
+    mxFree(s->rowptr);
+    mxFree(s->col);
+    mxFree(s->pos);
+}
+
+
+/* r = y - BA*x for column i of X */
+static void residual(const SparseRep *s, const double *BA, mwSize len, const double *y, mwIndex i, double *r)
+{
+    mwIndex p, e;
+
+    memcpy(r, y, len*sizeof(double));
+    for (p=s->jc[i]; p<s->jc[i+1]; p++) {
+      const double *d = BA + s->ir[p]*len;
+      double c = s->pr[p];
+      for (e=0; e<len; e++) r[e] -= c*d[e];
+    }
+}
+
+
+/* a = OMP code of y (masked by m if not NULL) over B with at most T atoms,
+ * scaled so that ||B*a|| = 1, and w = B*a. A zero code is replaced by the
+ * scaled unit vector of atom j. */
+static void codeAtom(const double *B, const double *GB, mwSize len, mwSize K, const double *y,
+                     const double *m, mwSize T, mwIndex j, OmpWork *w, mwIndex *ind, double *coef,
+                     double *alpha0, double *diag, double *a, double *wa)
+{
+    mwSize n;
+    mwIndex k, e;
+    double ynorm2 = 0, nrm = 0;
+    OmpGram g;
+
+    g.G = m ? NULL : GB;
+    g.D = B;
+    g.mask = m;
+    g.len = len;
+    g.K = K;
+
+    for (k=0; k<K; k++) {
+      const double *b = B + k*len;
+      double v = 0, dg = 0;
+      for (e=0; e<len; e++) {
+        double me = m ? m[e] : 1;
+        v += b[e]*me*y[e];
+        dg += me*b[e]*b[e];
+      }
+      alpha0[k] = v;
+      diag[k] = dg;
+    }
+    for (e=0; e<len; e++) ynorm2 += (m ? m[e] : 1)*y[e]*y[e];
+
+    n = ompCode(&g, alpha0, diag, ynorm2, -1, T, w, ind, coef);
+
+    memset(a, 0, K*sizeof(double));
+    memset(wa, 0, len*sizeof(double));
+    for (k=0; k<n; k++) {
+      const double *b = B + ind[k]*len;
+      a[ind[k]] = coef[k];
+      for (e=0; e<len; e++) wa[e] += coef[k]*b[e];
+    }
+    for (e=0; e<len; e++) nrm += wa[e]*wa[e];
+    if (nrm == 0) {
+      const double *b = B + j*len;
+      a[j] = 1;
+      memcpy(wa, b, len*sizeof(double));
+      for (e=0; e<len; e++) nrm += wa[e]*wa[e];
+    }
+    nrm = nrm > 0 ? 1/sqrt(nrm) : 0;
+    for (k=0; k<K; k++) a[k] *= nrm;
+    for (e=0; e<len; e++) wa[e] *= nrm;
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray*prhs[])
+
+{
+    double *Y, *B, *mask = NULL, *Ad, *BA, *GB, *rep, *part, *E = NULL, *alpha0, *diag, *a, *wa, *coef, *u;
+    double *z, *g;
+    mwSize len, K, N, T, nruns = 10, nunused, nI, nc, nnz;
+    mwIndex i, j, k, p, *unused, *I, *ind, *ip;
+    SparseRep X;
+    OmpWork ow;
+
+
+    /* Check for proper number of arguments */
+
+    if (nrhs < 5 || nrhs > 7) {
+      mexErrMsgTxt("Invalid number of input arguments.");
+    } else if (nlhs > 4) {
+      mexErrMsgTxt("Too many output arguments.");
+    }
+
+
+    /* Check the the input dimensions */
+
+    if (!mxIsDouble(B_IN) || mxIsComplex(B_IN) || mxIsSparse(B_IN) || mxGetNumberOfDimensions(B_IN)>2) {
+      mexErrMsgTxt("B should be a full real matrix.");
+    }
+    len = mxGetM(B_IN);
+    K = mxGetN(B_IN);
+    if (!mxIsDouble(Y_IN) || mxIsComplex(Y_IN) || mxIsSparse(Y_IN) || mxGetM(Y_IN) != len) {
+      mexErrMsgTxt("Y should be a full real matrix with as many rows as B.");
+    }
+    N = mxGetN(Y_IN);
+    if (!mxIsDouble(A_IN) || mxIsComplex(A_IN) || mxGetM(A_IN) != K || mxGetN(A_IN) != K) {
+      mexErrMsgTxt("A0 should be a real K-by-K matrix, K = size(B,2).");
+    }
+    if (!mxIsDouble(X_IN) || mxIsComplex(X_IN) || mxGetM(X_IN) != K || mxGetN(X_IN) != N) {
+      mexErrMsgTxt("X0 should be a real K-by-size(Y,2) matrix.");
+    }
+    if (mxGetScalar(TDICT_IN) < 1) {
+      mexErrMsgTxt("Invalid atom sparsity.");
+    }
+    T = (mwSize)(mxGetScalar(TDICT_IN) + 0.01);
+    if (T > K) T = K;
+    if (T > len) T = len;
+
+    if (nrhs > 5 && !mxIsEmpty(MASK_IN)) {
+      if (!mxIsDouble(MASK_IN) || mxIsSparse(MASK_IN) || mxGetM(MASK_IN) != len || mxGetN(MASK_IN) != N) {
+        mexErrMsgTxt("MASK should be a full double matrix of the size of Y.");
+      }
+      mask = (double*)mxMalloc(len*N*sizeof(double));
+      for (i=0; i<len*N; i++) mask[i] = (mxGetPr(MASK_IN))[i] != 0;
+    }
+    if (nrhs > 6 && !mxIsEmpty(NRUNS_IN)) {
+      nruns = mxGetScalar(NRUNS_IN) >= 1 ? (mwSize)(mxGetScalar(NRUNS_IN) + 0.01) : 1;
+    }
+
+
+    /* Assign pointers */
+
+    Y = mxGetPr(Y_IN);
+    B = mxGetPr(B_IN);
+
+
+    /* Set up A (dense), X (CSC + CSR), B*A and B'*B */
+
+    Ad = (double*)mxCalloc(K*K, sizeof(double));
+    if (mxIsSparse(A_IN)) {
+      mwIndex *ajc = mxGetJc(A_IN), *air = mxGetIr(A_IN);
+      double *apr = mxGetPr(A_IN);
+      for (j=0; j<K; j++) {
+        for (p=ajc[j]; p<ajc[j+1]; p++) Ad[j*K + air[p]] = apr[p];
+      }
+    }
+    else {
+      memcpy(Ad, mxGetPr(A_IN), K*K*sizeof(double));
+    }
+    sparseRepInit(&X, X_IN);
+
+    BA = (double*)mxCalloc(len*K, sizeof(double));
+    GB = (double*)mxCalloc(K*K, sizeof(double));
+    if (K > 0 && len > 0) {
+      ptrdiff_t pl = len, pk = K;
+      double one = 1, zero = 0;
+      dgemm("N", "N", &pl, &pk, &pk, &one, B, &pl, Ad, &pk, &zero, BA, &pl);
+      dsyrk("U", "T", &pk, &pl, &one, B, &pl, &zero, GB, &pk);
+      for (j=0; j<K; j++) {
+        for (i=j+1; i<K; i++) GB[j*K+i] = GB[i*K+j];
+      }
+    }
+
+    REP_OUT = mxCreateDoubleMatrix(1, K, mxREAL);
+    rep = mxGetPr(REP_OUT);
+
+    unused = (mwIndex*)mxMalloc((N+1)*sizeof(mwIndex));
+    for (i=0; i<N; i++) unused[i] = i;
+    nunused = N;
+
+    nc = numChunks(N);
+    part = (double*)mxMalloc(nc*(K + len + 1)*sizeof(double));
+    I = (mwIndex*)mxMalloc((N+1)*sizeof(mwIndex));
+    ip = (mwIndex*)mxMalloc((N+1)*sizeof(mwIndex));
+    g = (double*)mxMalloc((N+1)*sizeof(double));
+    z = (double*)mxMalloc((len+1)*sizeof(double));
+    u = (double*)mxMalloc((K+1)*sizeof(double));
+    a = (double*)mxMalloc((K+1)*sizeof(double));
+    wa = (double*)mxMalloc((len+1)*sizeof(double));
+    alpha0 = (double*)mxMalloc((K+1)*sizeof(double));
+    diag = (double*)mxMalloc((K+1)*sizeof(double));
+    coef = (double*)mxMalloc((T+1)*sizeof(double));
+    ind = (mwIndex*)mxMalloc((T+1)*sizeof(mwIndex));
+    if (!ompWorkAlloc(&ow, K, T)) {
+      mexErrMsgTxt("Cannot allocate memory for the OMP workspace.");
+    }
+
+
+    /* Do the actual computation */
+
+    for (j=0; j<K; j++) {
+      double gnorm = 0;
+
+      /* remove atom j from the dictionary */
+      memset(Ad + j*K, 0, K*sizeof(double));
+      memset(BA + j*len, 0, len*sizeof(double));
+
+      /* signals using atom j */
+      nI = 0;
+      for (p=X.rowptr[j]; p<X.rowptr[j+1]; p++) {
+        double v = X.pr[X.pos[p]];
+        if (v != 0) {
+          I[nI] = X.col[p];
+          ip[nI] = X.pos[p];
+          g[nI++] = v;
+          gnorm += v*v;
+        }
+      }
+
+      if (nI <= 1) {
+        /* replace the atom by the code of the worst represented unused signal */
+        mwIndex best = 0;
+        double besterr = -1;
+
+        if (nunused == 0) continue;
+
+        #pragma omp parallel
+        {
+          double *r = (double*)malloc((len+1)*sizeof(double));
+          double terr = -1;
+          mwIndex tbest = 0, q, e;
+
+          #pragma omp for schedule(static)
+          for (q=0; q<nunused; q++) {
+            double err = 0;
+            if (!r) continue;
+            residual(&X, BA, len, Y + unused[q]*len, unused[q], r);
+            for (e=0; e<len; e++) err += r[e]*r[e];
+            if (err > terr) {
+              terr = err;
+              tbest = q;
+            }
+          }
+
+          /* first maximum over the threads */
+          #pragma omp critical
+          {
+            if (terr > besterr || (terr == besterr && tbest < best)) {
+              besterr = terr;
+              best = tbest;
+            }
+          }
+          free(r);
+        }
+
+        i = unused[best];
+        if (mask) {
+          for (k=0; k<len; k++) z[k] = mask[i*len+k]*Y[i*len+k];
+        }
+        else {
+          memcpy(z, Y + i*len, len*sizeof(double));
+        }
+        codeAtom(B, GB, len, K, z, mask ? mask + i*len : NULL, T, j, &ow, ind, coef, alpha0, diag, a, wa);
+        memcpy(Ad + j*K, a, K*sizeof(double));
+        memcpy(BA + j*len, wa, len*sizeof(double));
+
+        memmove(unused + best, unused + best + 1, (nunused - best - 1)*sizeof(mwIndex));
+        nunused--;
+        rep[j] = 1;
+        continue;
+      }
+
+      gnorm = sqrt(gnorm);
+      for (k=0; k<nI; k++) g[k] /= gnorm;
+      nc = numChunks(nI);
+
+      if (!mask) {
+        /* z = Y(:,I)*g - B*A*(X(:,I)*g) */
+        #pragma omp parallel for schedule(static) private(k, p)
+        for (i=0; i<nc; i++) {
+          double *v = part + i*(K + len), *yg = v + K;
+          mwIndex q0 = i*nI/nc, q1 = (i+1)*nI/nc, q, e;
+          memset(v, 0, (K + len)*sizeof(double));
+          for (q=q0; q<q1; q++) {
+            const double *y = Y + I[q]*len;
+            double gq = g[q];
+            for (p=X.jc[I[q]]; p<X.jc[I[q]+1]; p++) v[X.ir[p]] += gq*X.pr[p];
+            for (e=0; e<len; e++) yg[e] += gq*y[e];
+          }
+        }
+        for (k=0; k<len; k++) z[k] = 0;
+        memset(u, 0, K*sizeof(double));
+        for (i=0; i<nc; i++) {
+          double *v = part + i*(K + len);
+          for (k=0; k<K; k++) u[k] += v[k];
+          for (k=0; k<len; k++) z[k] += v[K + k];
+        }
+        for (k=0; k<K; k++) {
+          if (u[k] != 0) {
+            const double *d = BA + k*len;
+            for (p=0; p<len; p++) z[p] -= u[k]*d[p];
+          }
+        }
+
+        /* a = OMP(B, z), w = B*a */
+        codeAtom(B, GB, len, K, z, NULL, T, j, &ow, ind, coef, alpha0, diag, a, wa);
+
+        /* X(j,I) = (E_I'*w)' = Y(:,I)'*w - X(:,I)'*(BA'*w) */
+        for (k=0; k<K; k++) {
+          const double *d = BA + k*len;
+          double v = 0;
+          for (p=0; p<len; p++) v += d[p]*wa[p];
+          u[k] = v;
+        }
+        #pragma omp parallel for schedule(static) private(p)
+        for (k=0; k<nI; k++) {
+          const double *y = Y + I[k]*len;
+          double v = 0;
+          mwIndex e;
+          for (e=0; e<len; e++) v += y[e]*wa[e];
+          for (p=X.jc[I[k]]; p<X.jc[I[k]+1]; p++) v -= X.pr[p]*u[X.ir[p]];
+          g[k] = v;
+        }
+      }
+      else {
+        mwIndex run;
+
+        /* residuals without atom j, and a = 0 to start with */
+        E = (double*)mxRealloc(E, (len*nI + 1)*sizeof(double));
+        #pragma omp parallel for schedule(static)
+        for (k=0; k<nI; k++) {
+          residual(&X, BA, len, Y + I[k]*len, I[k], E + k*len);
+        }
+        memset(wa, 0, len*sizeof(double));
+        memset(a, 0, K*sizeof(double));
+
+        for (run=0; run<nruns; run++) {
+          if (run > 0) {
+            gnorm = 0;
+            for (k=0; k<nI; k++) gnorm += g[k]*g[k];
+            gnorm = sqrt(gnorm);
+            for (k=0; k<nI; k++) g[k] /= gnorm;
+          }
+
+          /* z = (M.*E + (1-M).*(w*g'))*g */
+          #pragma omp parallel for schedule(static) private(k)
+          for (i=0; i<nc; i++) {
+            double *zc = part + i*(K + len);
+            mwIndex q0 = i*nI/nc, q1 = (i+1)*nI/nc, q, e;
+            memset(zc, 0, len*sizeof(double));
+            for (q=q0; q<q1; q++) {
+              const double *m = mask + I[q]*len, *r = E + q*len;
+              double gq = g[q];
+              for (e=0; e<len; e++) zc[e] += gq*(m[e]*r[e] + (1 - m[e])*wa[e]*gq);
+            }
+          }
+          memset(z, 0, len*sizeof(double));
+          for (i=0; i<nc; i++) {
+            for (k=0; k<len; k++) z[k] += part[i*(K + len) + k];
+          }
+
+          codeAtom(B, GB, len, K, z, NULL, T, j, &ow, ind, coef, alpha0, diag, a, wa);
+
+          /* g = (M.*E + (1-M).*(w*g'))'*w */
+          #pragma omp parallel for schedule(static)
+          for (k=0; k<nI; k++) {
+            const double *m = mask + I[k]*len, *r = E + k*len;
+            double v = 0, gk = g[k];
+            mwIndex e;
+            for (e=0; e<len; e++) v += (m[e]*r[e] + (1 - m[e])*wa[e]*gk)*wa[e];
+            g[k] = v;
+          }
+        }
+      }
+
+      /* put atom j back, store its coefficients */
+      memcpy(Ad + j*K, a, K*sizeof(double));
+      memcpy(BA + j*len, wa, len*sizeof(double));
+      for (k=0; k<nI; k++) {
+        X.pr[ip[k]] = g[k];
+      }
+    }
+
+
+    /* Create matrices for the return arguments */
+
+    nnz = 0;
+    for (i=0; i<K*K; i++) nnz += (Ad[i] != 0);
+    A_OUT = mxCreateSparse(K, K, nnz > 0 ? nnz : 1, mxREAL);
+    {
+      mwIndex *ajc = mxGetJc(A_OUT), *air = mxGetIr(A_OUT);
+      double *apr = mxGetPr(A_OUT);
+      ajc[0] = 0;
+      for (j=0, p=0; j<K; j++) {
+        for (i=0; i<K; i++) {
+          if (Ad[j*K+i] != 0) {
+            air[p] = i;
+            apr[p++] = Ad[j*K+i];
+          }
+        }
+        ajc[j+1] = p;
+      }
+    }
+
+    if (nlhs > 1) {
+      nnz = 0;
+      for (p=0; p<X.jc[N]; p++) nnz += (X.pr[p] != 0);
+      X_OUT = mxCreateSparse(K, N, nnz > 0 ? nnz : 1, mxREAL);
+      {
+        mwIndex *xjc = mxGetJc(X_OUT), *xir = mxGetIr(X_OUT), q = 0;
+        double *xpr = mxGetPr(X_OUT);
+        xjc[0] = 0;
+        for (j=0; j<N; j++) {
+          for (p=X.jc[j]; p<X.jc[j+1]; p++) {
+            if (X.pr[p] != 0) {
+              xir[q] = X.ir[p];
+              xpr[q++] = X.pr[p];
+            }
+          }
+          xjc[j+1] = q;
+        }
+      }
+    }
+
+    if (nlhs > 3) {
+      UNUSED_OUT = mxCreateDoubleMatrix(1, nunused, mxREAL);
+      for (i=0; i<nunused; i++) (mxGetPr(UNUSED_OUT))[i] = unused[i] + 1;
+    }
+
+    ompWorkFree(&ow);
+    sparseRepFree(&X);
+    if (mask) mxFree(mask);
+    if (E) mxFree(E);
+    mxFree(Ad);
+    mxFree(BA);
+    mxFree(GB);
+    mxFree(unused);
+    mxFree(part);
+    mxFree(I);
+    mxFree(ip);
+    mxFree(g);
+    mxFree(z);
+    mxFree(u);
+    mxFree(a);
+    mxFree(wa);
+    mxFree(alpha0);
+    mxFree(diag);
+    mxFree(coef);
+    mxFree(ind);
+
+    return;
+}
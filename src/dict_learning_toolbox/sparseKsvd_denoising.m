@@ -12,6 +12,9 @@ function [A, X, errLasso, errBpdn] = sparseKsvd_denoising(Y, baseSynOp, baseAnaO
 % or
 %      Lasso:   min  |Y_i-B*A*X_i|_2     s.t. |X_i|_1 <= tau            for all i
 %               A,X
+% or, with option.method = 'omp' (compiled, see BATCHOMP and SPARSEKSVDUPDATE_MEX),
+%      OMP:     min  |Y_i-B*A*X_i|_2     s.t. |X_i|_0 <= sigSpThres    for all i
+%               A,X                        |A_j|_0 <= atomSpThres   for all j
 %
 %
 % This matlab source file is free for use in academic research.
@@ -72,7 +75,13 @@ for iter = 1:trainIter
     
     %% solve BPDN problem for each block
     % X_i = argmin_x ||Y_i - B*A*x||_2 s.t. ||x||_1 <= sigSpThres
-    for iblk = 1:nBlocks
+    codedBlocks = 1:nBlocks;
+    if (strcmpi(option.method, 'omp'))
+        % X_i = argmin_x ||Y_i - B*A*x||_2 s.t. ||x||_0 <= sigSpThres, all blocks at once
+        X = batchOmp(PhiSyn * A, Y, sigSpThres);
+        codedBlocks = [];
+    end
+    for iblk = codedBlocks
         if (option.verbosity)
             fprintf('Updating coefficients of block %d\n', iblk);
         end
@@ -96,7 +105,13 @@ for iter = 1:trainIter
     %% dictionary learning and updating
     unusedSig = 1:nBlocks;  % track the signals that were used to replace "dead" atoms.
     replacedAtom = zeros(1, coefLen);  % mark each atom replaced by optimize_atom
-    for iatom = 1:coefLen
+    updatedAtoms = 1:coefLen;
+    if (strcmpi(option.method, 'omp'))
+        % compiled atom update, every column of A coded with at most atomSpThres atoms of B
+        [A, X, replacedAtom, unusedSig] = sparseKsvdUpdate_mex(Y, PhiSyn, A, X, atomSpThres);
+        updatedAtoms = [];
+    end
+    for iatom = updatedAtoms
         if (option.verbosity)
             fprintf('Updating Atom %d\n', iatom);
         end
@@ -185,7 +200,9 @@ for iter = 1:trainIter
         if ( (max(abs(mutCoh))>MUTCOH_THRES || useCount(iatom) < USE_THRES) && ~replacedAtom(iatom) )
             [~, idxErr] = max(err(unusedSig));
             opts = spgSetParms('verbosity', option.verbosity, 'optTol', SPGOPTTOL_ATOM);
-            if (size(PhiSyn, 1) > size(PhiSyn, 2))
+            if (strcmpi(option.method, 'omp'))
+                a = full(batchOmp(PhiSyn, Y(:, unusedSig(idxErr)), atomSpThres));
+            elseif (size(PhiSyn, 1) > size(PhiSyn, 2))
                 a = spg_lasso(@(x, mode) baseOp(x, [], PhiAna * PhiSyn, PhiAna * PhiSyn, mode), PhiAna * Y(:, unusedSig(idxErr)), atomSpThres, opts);
             else
                 a = spg_lasso(@(x, mode) baseOp(x, [], PhiSyn, PhiAna, mode), Y(:, unusedSig(idxErr)), atomSpThres, opts);
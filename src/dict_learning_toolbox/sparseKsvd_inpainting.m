@@ -12,6 +12,9 @@ function [A, X, errLasso, errBpdn] = sparseKsvd_inpainting(Y, mask, baseSynOp, b
 % or
 %      Lasso:   min  |Y_i-B*A*X_i|_2     s.t. |X_i|_1 <= tau            for all i
 %               A,X
+% or, with option.method = 'omp' (compiled, see BATCHOMP and SPARSEKSVDUPDATE_MEX),
+%      OMP:     min  |Y_i-B*A*X_i|_2     s.t. |X_i|_0 <= sigSpThres    for all i
+%               A,X                        |A_j|_0 <= atomSpThres   for all j
 %
 %
 % This matlab source file is free for use in academic research.
@@ -74,7 +77,13 @@ for iter = 1:trainIter
     
     %% solve BPDN problem for each block
     % X_i = argmin_x ||Y_i - B*A*x||_2 s.t. ||x||_1 <= sigSpThres
-    for iblk = 1:nBlocks
+    codedBlocks = 1:nBlocks;
+    if (strcmpi(option.method, 'omp'))
+        % X_i = argmin_x ||Y_i - B*A*x||_2 s.t. ||x||_0 <= sigSpThres, all blocks at once
+        X = batchOmp(PhiSyn * A, Y, sigSpThres, [], mask);
+        codedBlocks = [];
+    end
+    for iblk = codedBlocks
         if (option.verbosity)
             fprintf('Updating coefficients of block %d\n', iblk);
         end
@@ -97,7 +106,13 @@ for iter = 1:trainIter
     %% dictionary learning and updating
     unusedSig = 1:nBlocks;  % track the signals that were used to replace "dead" atoms.
     replacedAtom = zeros(1, coefLen);  % mark each atom replaced by optimize_atom
-    for iatom = 1:coefLen
+    updatedAtoms = 1:coefLen;
+    if (strcmpi(option.method, 'omp'))
+        % compiled atom update, every column of A coded with at most atomSpThres atoms of B
+        [A, X, replacedAtom, unusedSig] = sparseKsvdUpdate_mex(Y, PhiSyn, A, X, atomSpThres, double(mask), N_DICTRUN_ITER);
+        updatedAtoms = [];
+    end
+    for iatom = updatedAtoms
         if (option.verbosity)
             fprintf('Updating Atom %d\n', iatom);
         end
@@ -185,7 +200,11 @@ for iter = 1:trainIter
             [~, idxErr] = max(err(unusedSig));
             y = mask(:, unusedSig(idxErr)) .* Y(:, unusedSig(idxErr));
             opts = spgSetParms('verbosity', option.verbosity, 'optTol', SPGOPTTOL_ATOM);
-            a = spg_lasso(@(x, mode) baseOp(x, mask(:, iblk), PhiSyn, PhiAna, mode), y, atomSpThres, opts);
+            if (strcmpi(option.method, 'omp'))
+                a = full(batchOmp(PhiSyn, y, atomSpThres, [], mask(:, unusedSig(idxErr))));
+            else
+                a = spg_lasso(@(x, mode) baseOp(x, mask(:, iblk), PhiSyn, PhiAna, mode), y, atomSpThres, opts);
+            end
             if (norm(PhiSyn * a, 2) == 0)
                 warning('a is null!');
                 a(randperm(coefLen, 1)) = atomSpThres;
@@ -0,0 +1,99 @@
+function [x, info] = curveletInterp(b, mask, opts)
+% CURVELETINTERP curvelet-domain sparsity-promoting interpolation of
+% seismic data with missing traces (compiled POCS / IST)
+%
+%       [x, info] = curveletInterp(b, mask, opts)
+%
+% input arguments
+% b             recorded data, zeros at the missing traces. An N1 x N2 x K
+%               array is K independent 2-d sections (solved in parallel);
+%               set opts.dim = 3 to treat it as one 3-d volume
+% mask          1 at the recorded samples, 0 at the missing ones (N1 x N2
+%               shared by all sections, or the same size as b)
+% opts          structure of options (all optional)
+%   .method         'pocs' (default) or 'ist'
+%   .nIter          maximum number of iterations (default 50)
+%   .schedule       threshold decay, 'exp' (default) or 'lin'
+%   .lambdaMax      first threshold (default 0: max |C b|)
+%   .lambdaRatio    last threshold / first threshold (default 1e-3)
+%   .alpha          POCS data weight (default 1)
+%   .tol            relative change for early stop (default 1e-4)
+%   .x0             warm start (default b)
+%   .dim            2 (default) or 3
+%   .nbscales       number of scales (default ceil(log2(min(size))) - 3)
+%   .nbangles       number of angles (2-d) or directions per face (3-d) at
+%                   the 2nd coarsest level (default 16 in 2-d, 8 in 3-d)
+%   .finest         1: curvelets at the finest level (default), 2: wavelets
+%
+% output arguments
+% x             interpolated data
+% info          structure with the iterations performed and the last
+%               threshold of every section
+%
+% See also:	CURVELETMASKOP, WRAPPER_FDCT_WRAPPING
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if (nargin < 3)
+    opts = struct();
+end
+
+dim = getOption(opts, 'dim', 2);
+if (dim == 3)
+    n = size(b);
+    nbanglesDefault = 8;
+else
+    n = [size(b, 1), size(b, 2)];
+    nbanglesDefault = 16;
+end
+
+method = getOption(opts, 'method', 'pocs');
+if (strcmpi(method, 'ist'))
+    method = 2;
+else
+    method = 1;
+end
+schedule = getOption(opts, 'schedule', 'exp');
+if (strcmpi(schedule, 'lin'))
+    schedule = 2;
+else
+    schedule = 1;
+end
+nIter = getOption(opts, 'nIter', 50);
+lambdaMax = getOption(opts, 'lambdaMax', 0);
+lambdaRatio = getOption(opts, 'lambdaRatio', 1e-3);
+alpha = getOption(opts, 'alpha', 1);
+tol = getOption(opts, 'tol', 1e-4);
+x0 = getOption(opts, 'x0', []);
+nbscales = getOption(opts, 'nbscales', max(ceil(log2(min(n)) - 3), 2));
+nbangles = getOption(opts, 'nbangles', nbanglesDefault);
+finest = getOption(opts, 'finest', 1);
+
+b = double(b);
+mask = double(mask);
+x0 = double(x0);
+
+if (dim == 3)
+    [x, info.nIter, info.lambda] = curveletInterp3d_mex(b, mask, x0, nbscales, nbangles, finest, ...
+        method, nIter, schedule, lambdaMax, lambdaRatio, alpha, tol);
+else
+    [x, info.nIter, info.lambda] = curveletInterp2d_mex(b, mask, x0, nbscales, nbangles, finest, ...
+        method, nIter, schedule, lambdaMax, lambdaRatio, alpha, tol);
+end
+
+end
+
+
+function val = getOption(opts, field, default)
+if (isfield(opts, field) && ~isempty(opts.(field)))
+    val = opts.(field);
+else
+    val = default;
+end
+end
@@ -0,0 +1,141 @@
+/* ======================================================================
+ *
+ * curveletInterp2d_mex.cpp
+ *
+ * Curvelet-domain sparsity-promoting interpolation of 2-d seismic data,
+ * one or more N1 x N2 slices at a time (POCS or IST).
+ *
+ * [x, nIter, lambda] = curveletInterp2d_mex(b, mask, x0, nbscales, nbangles_coarse, finest,
+ *                                           method, nIter, schedule, lambdaMax, lambdaRatio, alpha, tol)
+ *
+ * b is N1 x N2 x K with zeros at the missing traces, mask is N1 x N2 (shared
+ * by all slices) or N1 x N2 x K, x0 is the warm start (same size as b, or []
+ * to start from b). When there are at least as many slices as threads the
+ * slices are solved in parallel, one curvelet transform per thread;
+ * otherwise (a single 2-d section, say) the slices are solved one after
+ * the other and the threads share the wedges of each transform and the
+ * element-wise mask and threshold passes.
+ *
+ * This C++ source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ ====================================================================== */
+
+#include "mex.h"
+#include "curveletOp2d.hpp"
+
+/* input arguments */
+#define B_IN            prhs[0]
+#define MASK_IN         prhs[1]
+#define X0_IN           prhs[2]
+#define NBSCALES_IN     prhs[3]
+#define NBANGLES_IN     prhs[4]
+#define FINEST_IN       prhs[5]
+#define METHOD_IN       prhs[6]
+#define NITER_IN        prhs[7]
+#define SCHEDULE_IN     prhs[8]
+#define LAMBDAMAX_IN    prhs[9]
+#define LAMBDARATIO_IN  prhs[10]
+#define ALPHA_IN        prhs[11]
+#define TOL_IN          prhs[12]
+
+/* output arguments */
+#define X_OUT           plhs[0]
+#define NITER_OUT       plhs[1]
+#define LAMBDA_OUT      plhs[2]
+
+/* the gateway routine */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* begin of declaration */
+    double *pB, *pMask, *pX0, *pX, *pNIter, *pLambda;
+    int n1, n2, nSlices, nbscales, nbangles, ac, k;
+    long n;
+    bool maskShared, sliceParallel;
+    mwSize ndims;
+    const mwSize *pDims;
+    InterpOptions opts;
+    /* end of declaration */
+
+    if (nrhs < 13)
+    {
+        mexErrMsgTxt("Data, mask, warm start, curvelet parameters and solver options should be all provided!");
+    }
+    if (mxIsComplex(B_IN))
+    {
+        mexErrMsgTxt("Data should be real!");
+    }
+
+    ndims = mxGetNumberOfDimensions(B_IN);
+    pDims = mxGetDimensions(B_IN);
+    n1 = pDims[0];
+    n2 = pDims[1];
+    nSlices = (ndims > 2) ? (int)(mxGetNumberOfElements(B_IN) / ((mwSize)n1 * n2)) : 1;
+    n = (long)n1 * n2;
+
+    if (mxGetNumberOfElements(MASK_IN) == (mwSize)n)
+    {
+        maskShared = true;
+    }
+    else if (mxGetNumberOfElements(MASK_IN) == mxGetNumberOfElements(B_IN))
+    {
+        maskShared = false;
+    }
+    else
+    {
+        mexErrMsgTxt("Mask should be N1 x N2 or the same size as the data!");
+    }
+    if (!mxIsEmpty(X0_IN) && mxGetNumberOfElements(X0_IN) != mxGetNumberOfElements(B_IN))
+    {
+        mexErrMsgTxt("Warm start should be empty or the same size as the data!");
+    }
+
+    pB = mxGetPr(B_IN);
+    pMask = mxGetPr(MASK_IN);
+    pX0 = mxIsEmpty(X0_IN) ? pB : mxGetPr(X0_IN);
+    nbscales = (int)*mxGetPr(NBSCALES_IN);
+    nbangles = (int)*mxGetPr(NBANGLES_IN);
+    ac = ((int)*mxGetPr(FINEST_IN) == 1) ? 1 : 0;      /* finest = 1: curvelets, 2: wavelets */
+
+    opts.method = (int)*mxGetPr(METHOD_IN);
+    opts.nIter = (int)*mxGetPr(NITER_IN);
+    opts.schedule = (int)*mxGetPr(SCHEDULE_IN);
+    opts.lambdaMax = *mxGetPr(LAMBDAMAX_IN);
+    opts.lambdaRatio = *mxGetPr(LAMBDARATIO_IN);
+    opts.alpha = *mxGetPr(ALPHA_IN);
+    opts.tol = *mxGetPr(TOL_IN);
+
+    X_OUT = mxCreateNumericArray(ndims, pDims, mxDOUBLE_CLASS, mxREAL);
+    NITER_OUT = mxCreateDoubleMatrix(1, nSlices, mxREAL);
+    LAMBDA_OUT = mxCreateDoubleMatrix(1, nSlices, mxREAL);
+    pX = mxGetPr(X_OUT);
+    pNIter = mxGetPr(NITER_OUT);
+    pLambda = mxGetPr(LAMBDA_OUT);
+    memcpy(pX, pX0, mxGetNumberOfElements(B_IN) * sizeof(double));
+    mexAtExit(fdct_wrapping_ns::fdct_wrapping_clearplans);
+
+#ifdef _OPENMP
+    sliceParallel = nSlices >= omp_get_max_threads();
+#else
+    sliceParallel = true;
+#endif
+
+    /* one operator per thread, the slices are independent; with too few
+       slices the region is inactive and the parallel loops inside the
+       transform and the solver take the threads instead */
+#pragma omp parallel private(k) if (sliceParallel)
+    {
+        CurveletOp2d op(n1, n2, nbscales, nbangles, ac);
+        InterpInfo info;
+#pragma omp for schedule(dynamic)
+        for (k = 0; k < nSlices; k++)
+        {
+            interpSolve(op, pB + k * n, maskShared ? pMask : pMask + k * n, pX + k * n, opts, info);
+            pNIter[k] = info.nIter;
+            pLambda[k] = info.lambda;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/* ======================================================================
+ *
+ * curveletInterp3d_mex.cpp
+ *
+ * Curvelet-domain sparsity-promoting interpolation of a 3-d seismic
+ * volume (POCS or IST).
+ *
+ * [x, nIter, lambda] = curveletInterp3d_mex(b, mask, x0, nbscales, nbdstz_coarse, finest,
+ *                                           method, nIter, schedule, lambdaMax, lambdaRatio, alpha, tol)
+ *
+ * b is N1 x N2 x N3 with zeros at the missing traces, mask has the same
+ * size, x0 is the warm start (same size as b, or [] to start from b).
+ * The FFTW planner calls of FDCT3D are not guarded, so the transforms
+ * run on one thread and only the element-wise passes of the solver are
+ * parallel.
+ *
+ * This C++ source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ ====================================================================== */
+
+#include "mex.h"
+#include "curveletOp3d.hpp"
+
+/* input arguments */
+#define B_IN            prhs[0]
+#define MASK_IN         prhs[1]
+#define X0_IN           prhs[2]
+#define NBSCALES_IN     prhs[3]
+#define NBDSTZ_IN       prhs[4]
+#define FINEST_IN       prhs[5]
+#define METHOD_IN       prhs[6]
+#define NITER_IN        prhs[7]
+#define SCHEDULE_IN     prhs[8]
+#define LAMBDAMAX_IN    prhs[9]
+#define LAMBDARATIO_IN  prhs[10]
+#define ALPHA_IN        prhs[11]
+#define TOL_IN          prhs[12]
+
+/* output arguments */
+#define X_OUT           plhs[0]
+#define NITER_OUT       plhs[1]
+#define LAMBDA_OUT      plhs[2]
+
+/* the gateway routine */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* begin of declaration */
+    double *pB, *pMask, *pX0, *pX;
+    int n1, n2, n3, nbscales, nbdstz, ac;
+    mwSize ndims;
+    const mwSize *pDims;
+    InterpOptions opts;
+    InterpInfo info;
+    /* end of declaration */
+
+    if (nrhs < 13)
+    {
+        mexErrMsgTxt("Data, mask, warm start, curvelet parameters and solver options should be all provided!");
+    }
+    if (mxIsComplex(B_IN))
+    {
+        mexErrMsgTxt("Data should be real!");
+    }
+
+    ndims = mxGetNumberOfDimensions(B_IN);
+    if (ndims != 3)
+    {
+        mexErrMsgTxt("Data should be a 3-d volume!");
+    }
+    pDims = mxGetDimensions(B_IN);
+    n1 = pDims[0];
+    n2 = pDims[1];
+    n3 = pDims[2];
+
+    if (mxGetNumberOfElements(MASK_IN) != mxGetNumberOfElements(B_IN))
+    {
+        mexErrMsgTxt("Mask should be the same size as the data!");
+    }
+    if (!mxIsEmpty(X0_IN) && mxGetNumberOfElements(X0_IN) != mxGetNumberOfElements(B_IN))
+    {
+        mexErrMsgTxt("Warm start should be empty or the same size as the data!");
+    }
+
+    pB = mxGetPr(B_IN);
+    pMask = mxGetPr(MASK_IN);
+    pX0 = mxIsEmpty(X0_IN) ? pB : mxGetPr(X0_IN);
+    nbscales = (int)*mxGetPr(NBSCALES_IN);
+    nbdstz = (int)*mxGetPr(NBDSTZ_IN);
+    ac = ((int)*mxGetPr(FINEST_IN) == 1) ? 1 : 0;      /* finest = 1: curvelets, 2: wavelets */
+
+    opts.method = (int)*mxGetPr(METHOD_IN);
+    opts.nIter = (int)*mxGetPr(NITER_IN);
+    opts.schedule = (int)*mxGetPr(SCHEDULE_IN);
+    opts.lambdaMax = *mxGetPr(LAMBDAMAX_IN);
+    opts.lambdaRatio = *mxGetPr(LAMBDARATIO_IN);
+    opts.alpha = *mxGetPr(ALPHA_IN);
+    opts.tol = *mxGetPr(TOL_IN);
+
+    X_OUT = mxCreateNumericArray(ndims, pDims, mxDOUBLE_CLASS, mxREAL);
+    pX = mxGetPr(X_OUT);
+    memcpy(pX, pX0, mxGetNumberOfElements(B_IN) * sizeof(double));
+
+    CurveletOp3d op(n1, n2, n3, nbscales, nbdstz, ac);
+    interpSolve(op, pB, pMask, pX, opts, info);
+
+    NITER_OUT = mxCreateDoubleScalar(info.nIter);
+    LAMBDA_OUT = mxCreateDoubleScalar(info.lambda);
+}
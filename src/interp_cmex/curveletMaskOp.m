@@ -0,0 +1,32 @@
+function y = curveletMaskOp(x, mask, finest, nbscales, nbangles_coarse, mode)
+% CURVELETMASKOP restricted curvelet synthesis operator M C' (compiled),
+% can be used as a function handle in spgl1
+%
+% A = @(x, mode) curveletMaskOp(x, mask, finest, nbscales, nbangles_coarse, mode);
+%
+% y = A(x,mode)   if mode == 1 then y = M C' x  (y is m-by-1);
+%                 if mode == 2 then y = C M' x  (y is n-by-1).
+%
+% The coefficient vector is in the order of CURVELET2VEC for the complex
+% wrapping transform, so it can be mixed with WRAPPER_FDCT_WRAPPING.
+%
+% input arguments
+% x             coefficient vector (mode 1) or data (mode 2)
+% mask          N1 x N2 sampling mask, 1 at the recorded samples
+% finest        1: curvelets at the finest level, 2: wavelets
+% mode          transform mode -- 1: inverse transform; 2: transform
+%
+% See also:	CURVELETINTERP, WRAPPER_FDCT_WRAPPING, CURVELET2VEC
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if (mode ~= 1 && mode ~= 2)
+    error('Wrong mode!');
+end
+y = curveletMaskOp2d_mex(x, double(mask), nbscales, nbangles_coarse, finest, mode);
@@ -0,0 +1,135 @@
+/* ======================================================================
+ *
+ * curveletMaskOp2d_mex.cpp
+ *
+ * Restricted curvelet synthesis operator A = M C' and its adjoint, in the
+ * form used by SPGL1 function handles.
+ *
+ * y = curveletMaskOp2d_mex(x, mask, nbscales, nbangles_coarse, finest, mode)
+ *
+ * mode == 1: x is the coefficient vector (CURVELET2VEC order), y = mask .* real(C' x)
+ * mode == 2: x is N1 x N2 data, y = C (mask .* x) as a coefficient vector
+ *
+ * SPGL1 calls the operator with the same parameters at every iteration, so
+ * the transform parameters are kept between calls (rebuilt only when the
+ * size or the curvelet parameters change) and the FFTW plans stay in the
+ * CurveLab plan cache; both are released when the MEX file is cleared.
+ *
+ * This C++ source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ ====================================================================== */
+
+#include "mex.h"
+#include "curveletOp2d.hpp"
+
+/* input arguments */
+#define X_IN            prhs[0]
+#define MASK_IN         prhs[1]
+#define NBSCALES_IN     prhs[2]
+#define NBANGLES_IN     prhs[3]
+#define FINEST_IN       prhs[4]
+#define MODE_IN         prhs[5]
+
+/* output arguments */
+#define Y_OUT           plhs[0]
+
+/* operator of the previous call */
+static CurveletOp2d *cachedOp = NULL;
+
+static void clearCachedOp(void)
+{
+    delete cachedOp;
+    cachedOp = NULL;
+    fdct_wrapping_ns::fdct_wrapping_clearplans();
+}
+
+/* the gateway routine */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* begin of declaration */
+    double *pX, *pXi, *pMask, *pY, *pYi;
+    int n1, n2, nbscales, nbangles, ac, mode;
+    long n, nc, i;
+    /* end of declaration */
+
+    if (nrhs < 6)
+    {
+        mexErrMsgTxt("Input, mask, curvelet parameters and mode should be all provided!");
+    }
+
+    n1 = mxGetM(MASK_IN);
+    n2 = mxGetN(MASK_IN);
+    n = (long)n1 * n2;
+    pMask = mxGetPr(MASK_IN);
+    nbscales = (int)*mxGetPr(NBSCALES_IN);
+    nbangles = (int)*mxGetPr(NBANGLES_IN);
+    ac = ((int)*mxGetPr(FINEST_IN) == 1) ? 1 : 0;      /* finest = 1: curvelets, 2: wavelets */
+    mode = (int)*mxGetPr(MODE_IN);
+
+    if (cachedOp == NULL || cachedOp->n1 != n1 || cachedOp->n2 != n2 || cachedOp->nbscales != nbscales
+        || cachedOp->nbanglesCoarse != nbangles || cachedOp->allCurvelets != ac)
+    {
+        if (cachedOp == NULL)
+        {
+            mexAtExit(clearCachedOp);
+        }
+        delete cachedOp;
+        cachedOp = NULL;
+        cachedOp = new CurveletOp2d(n1, n2, nbscales, nbangles, ac);
+    }
+    CurveletOp2d &op = *cachedOp;
+    nc = op.nCoef();
+    pX = mxGetPr(X_IN);
+    pXi = mxGetPi(X_IN);
+
+    if (mode == 1)
+    {
+        std::vector<cpx> c(nc);
+        std::vector<double> y(n);
+        if ((long)mxGetNumberOfElements(X_IN) != nc)
+        {
+            mexErrMsgTxt("Coefficient vector does not match the curvelet parameters!");
+        }
+#pragma omp parallel for schedule(static)
+        for (i = 0; i < nc; i++)
+        {
+            c[i] = cpx(pX[i], pXi ? pXi[i] : 0.0);
+        }
+        op.synthesis(&c[0], &y[0]);
+        Y_OUT = mxCreateDoubleMatrix(n, 1, mxREAL);
+        pY = mxGetPr(Y_OUT);
+#pragma omp parallel for schedule(static)
+        for (i = 0; i < n; i++)
+        {
+            pY[i] = pMask[i] * y[i];
+        }
+    }
+    else
+    {
+        std::vector<cpx> c(nc);
+        std::vector<double> r(n);
+        if ((long)mxGetNumberOfElements(X_IN) != n)
+        {
+            mexErrMsgTxt("Data does not match the size of the mask!");
+        }
+#pragma omp parallel for schedule(static)
+        for (i = 0; i < n; i++)
+        {
+            r[i] = pMask[i] * pX[i];
+        }
+        op.analysis(&r[0], &c[0]);
+        Y_OUT = mxCreateDoubleMatrix(nc, 1, mxCOMPLEX);
+        pY = mxGetPr(Y_OUT);
+        pYi = mxGetPi(Y_OUT);
+#pragma omp parallel for schedule(static)
+        for (i = 0; i < nc; i++)
+        {
+            pY[i] = c[i].real();
+            pYi[i] = c[i].imag();
+        }
+    }
+}
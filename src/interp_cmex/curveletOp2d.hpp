@@ -0,0 +1,87 @@
+/* ======================================================================
+ *
+ * curveletOp2d.hpp
+ *
+ * 2-d curvelet transform (wrapping version of CurveLab) with the
+ * coefficients stored in one flat complex vector, in the same order as
+ * CURVELET2VEC: scale by scale, wedge by wedge, each wedge column-major,
+ * padded with one zero when the total length is odd.
+ *
+ * This C++ source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ * ====================================================================== */
+
+#ifndef _CURVELETOP2D_HPP_
+#define _CURVELETOP2D_HPP_
+
+#include "fdct_wrapping.hpp"
+#include "interpSolver.hpp"
+
+class CurveletOp2d {
+public:
+    int n1, n2;
+    int nbscales, nbanglesCoarse, allCurvelets;
+    long nc;
+    std::vector< std::vector<int> > nx, ny;     /* wedge sizes */
+
+    CurveletOp2d(int N1, int N2, int nScales, int nAnglesCoarse, int ac)
+        : n1(N1), n2(N2), nbscales(nScales), nbanglesCoarse(nAnglesCoarse), allCurvelets(ac), nc(0)
+    {
+        std::vector< std::vector<double> > sx, sy, fx, fy;
+        fdct_wrapping_ns::fdct_wrapping_param(n1, n2, nbscales, nbanglesCoarse, allCurvelets, sx, sy, fx, fy, nx, ny);
+        for (size_t s = 0; s < nx.size(); s++)
+            for (size_t w = 0; w < nx[s].size(); w++)
+                nc += (long)nx[s][w] * ny[s][w];
+        if (nc % 2)
+            nc++;
+    }
+
+    long nData() const { return (long)n1 * n2; }
+    long nCoef() const { return nc; }
+
+    /* c = C x */
+    void analysis(const double *x, cpx *c)
+    {
+        fdct_wrapping_ns::CpxNumMat X(n1, n2);
+        std::vector< std::vector<fdct_wrapping_ns::CpxNumMat> > cc;
+        long i, pos = 0;
+        for (i = 0; i < nData(); i++)
+            X.data()[i] = x[i];
+        fdct_wrapping_ns::fdct_wrapping(n1, n2, nbscales, nbanglesCoarse, allCurvelets, X, cc);
+        for (size_t s = 0; s < cc.size(); s++) {
+            for (size_t w = 0; w < cc[s].size(); w++) {
+                long len = (long)cc[s][w].m() * cc[s][w].n();
+                memcpy(c + pos, cc[s][w].data(), len * sizeof(cpx));
+                pos += len;
+            }
+        }
+        if (pos < nc)
+            c[pos] = 0.0;
+    }
+
+    /* x = real(C' c) */
+    void synthesis(const cpx *c, double *x)
+    {
+        fdct_wrapping_ns::CpxNumMat X;
+        std::vector< std::vector<fdct_wrapping_ns::CpxNumMat> > cc(nx.size());
+        long i, pos = 0;
+        for (size_t s = 0; s < nx.size(); s++) {
+            cc[s].resize(nx[s].size());
+            for (size_t w = 0; w < nx[s].size(); w++) {
+                long len = (long)nx[s][w] * ny[s][w];
+                cc[s][w].resize(nx[s][w], ny[s][w]);
+                memcpy(cc[s][w].data(), c + pos, len * sizeof(cpx));
+                pos += len;
+            }
+        }
+        fdct_wrapping_ns::ifdct_wrapping(n1, n2, nbscales, nbanglesCoarse, allCurvelets, cc, X);
+        for (i = 0; i < nData(); i++)
+            x[i] = X.data()[i].real();
+    }
+};
+
+#endif
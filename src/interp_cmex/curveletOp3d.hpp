@@ -0,0 +1,87 @@
+/* ======================================================================
+ *
+ * curveletOp3d.hpp
+ *
+ * 3-d curvelet transform (in-core FDCT3D of CurveLab) with the
+ * coefficients stored in one flat complex vector: scale by scale, wedge
+ * by wedge, each wedge column-major, padded with one zero when the total
+ * length is odd.
+ *
+ * This C++ source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ * ====================================================================== */
+
+#ifndef _CURVELETOP3D_HPP_
+#define _CURVELETOP3D_HPP_
+
+#include "fdct3d.hpp"
+#include "interpSolver.hpp"
+
+class CurveletOp3d {
+public:
+    int n1, n2, n3;
+    int nbscales, nbdstzCoarse, allCurvelets;
+    long nc;
+    std::vector< std::vector<int> > nx, ny, nz;     /* wedge sizes */
+
+    CurveletOp3d(int N1, int N2, int N3, int nScales, int nDstzCoarse, int ac)
+        : n1(N1), n2(N2), n3(N3), nbscales(nScales), nbdstzCoarse(nDstzCoarse), allCurvelets(ac), nc(0)
+    {
+        std::vector< std::vector<double> > fx, fy, fz;
+        fdct3d_param(n1, n2, n3, nbscales, nbdstzCoarse, allCurvelets, fx, fy, fz, nx, ny, nz);
+        for (size_t s = 0; s < nx.size(); s++)
+            for (size_t w = 0; w < nx[s].size(); w++)
+                nc += (long)nx[s][w] * ny[s][w] * nz[s][w];
+        if (nc % 2)
+            nc++;
+    }
+
+    long nData() const { return (long)n1 * n2 * n3; }
+    long nCoef() const { return nc; }
+
+    /* c = C x */
+    void analysis(const double *x, cpx *c)
+    {
+        CpxNumTns X(n1, n2, n3);
+        std::vector< std::vector<CpxNumTns> > cc;
+        long i, pos = 0;
+        for (i = 0; i < nData(); i++)
+            X.data()[i] = x[i];
+        fdct3d_forward(n1, n2, n3, nbscales, nbdstzCoarse, allCurvelets, X, cc);
+        for (size_t s = 0; s < cc.size(); s++) {
+            for (size_t w = 0; w < cc[s].size(); w++) {
+                long len = (long)cc[s][w].m() * cc[s][w].n() * cc[s][w].p();
+                memcpy(c + pos, cc[s][w].data(), len * sizeof(cpx));
+                pos += len;
+            }
+        }
+        if (pos < nc)
+            c[pos] = 0.0;
+    }
+
+    /* x = real(C' c) */
+    void synthesis(const cpx *c, double *x)
+    {
+        CpxNumTns X(n1, n2, n3);
+        std::vector< std::vector<CpxNumTns> > cc(nx.size());
+        long i, pos = 0;
+        for (size_t s = 0; s < nx.size(); s++) {
+            cc[s].resize(nx[s].size());
+            for (size_t w = 0; w < nx[s].size(); w++) {
+                long len = (long)nx[s][w] * ny[s][w] * nz[s][w];
+                cc[s][w].resize(nx[s][w], ny[s][w], nz[s][w]);
+                memcpy(cc[s][w].data(), c + pos, len * sizeof(cpx));
+                pos += len;
+            }
+        }
+        fdct3d_inverse(n1, n2, n3, nbscales, nbdstzCoarse, allCurvelets, cc, X);
+        for (i = 0; i < nData(); i++)
+            x[i] = X.data()[i].real();
+    }
+};
+
+#endif
@@ -0,0 +1,256 @@
+/* ======================================================================
+ *
+ * interpSolver.hpp
+ *
+ * Sparsity-promoting trace interpolation in a transform domain:
+ * POCS (projection onto convex sets with hard thresholding) and IST
+ * (iterative soft thresholding), both with a decreasing threshold.
+ *
+ * The solvers are templates on the transform operator, which must provide
+ *
+ *   long nData() const;                          number of data samples
+ *   long nCoef() const;                          number of coefficients
+ *   void analysis(const double *x, cpx *c);      c = C x
+ *   void synthesis(const cpx *c, double *x);     x = real(C' c)
+ *
+ * where C is a tight frame (C'C = I), e.g. the curvelet transform.
+ * All element-wise passes run in parallel with OpenMP.
+ *
+ * This C++ source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ * ====================================================================== */
+
+#ifndef _INTERPSOLVER_HPP_
+#define _INTERPSOLVER_HPP_
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+typedef std::complex<double> cpx;
+
+#define INTERP_POCS     1
+#define INTERP_IST      2
+
+#define INTERP_SCHEDULE_EXP     1
+#define INTERP_SCHEDULE_LIN     2
+
+typedef struct {
+    int method;             /* INTERP_POCS or INTERP_IST */
+    int nIter;              /* maximum number of iterations */
+    int schedule;           /* threshold decay, INTERP_SCHEDULE_EXP or INTERP_SCHEDULE_LIN */
+    double lambdaMax;       /* first threshold, <= 0 to take max |C b| */
+    double lambdaRatio;     /* last threshold / first threshold */
+    double alpha;           /* POCS data weight, 1 to reinsert the recorded traces exactly */
+    double tol;             /* stop when ||x_k - x_{k-1}|| <= tol * ||x_k|| */
+} InterpOptions;
+
+typedef struct {
+    int nIter;              /* iterations performed */
+    double lambda;          /* last threshold used */
+    double relChange;       /* last relative change of x */
+} InterpInfo;
+
+/* threshold of iteration k out of n */
+inline double interpLambda(const InterpOptions &opts, double lambdaMax, int k)
+{
+    double t = (opts.nIter > 1) ? (double)k / (double)(opts.nIter - 1) : 1.0;
+    if (opts.schedule == INTERP_SCHEDULE_LIN)
+        return lambdaMax * (1.0 - (1.0 - opts.lambdaRatio) * t);
+    return lambdaMax * pow(opts.lambdaRatio, t);
+}
+
+/* max_i |c_i| */
+inline double interpMaxAbs(const cpx *c, long n)
+{
+    double val = 0.0;
+    long i;
+#pragma omp parallel for reduction(max:val) schedule(static)
+    for (i = 0; i < n; i++) {
+        double a = std::abs(c[i]);
+        if (a > val)
+            val = a;
+    }
+    return val;
+}
+
+/* c_i = 0 where |c_i| <= lambda */
+inline void interpHardThreshold(cpx *c, long n, double lambda)
+{
+    double lambdaSq = lambda * lambda;
+    long i;
+#pragma omp parallel for schedule(static)
+    for (i = 0; i < n; i++) {
+        if (std::norm(c[i]) <= lambdaSq)
+            c[i] = 0.0;
+    }
+}
+
+/* c_i = max(|c_i| - lambda, 0) * c_i / |c_i| */
+inline void interpSoftThreshold(cpx *c, long n, double lambda)
+{
+    long i;
+#pragma omp parallel for schedule(static)
+    for (i = 0; i < n; i++) {
+        double a = std::abs(c[i]);
+        c[i] = (a > lambda) ? c[i] * ((a - lambda) / a) : cpx(0.0);
+    }
+}
+
+/* x = alpha * b + (1 - alpha * mask) .* y, returns ||x - xOld||^2 and ||x||^2 */
+inline void interpPocsUpdate(double *x, const double *y, const double *b, const double *mask, long n,
+                             double alpha, double *diffSq, double *normSq)
+{
+    double d = 0.0, s = 0.0;
+    long i;
+#pragma omp parallel for reduction(+:d, s) schedule(static)
+    for (i = 0; i < n; i++) {
+        double v = alpha * b[i] + (1.0 - alpha * mask[i]) * y[i];
+        double e = v - x[i];
+        d += e * e;
+        s += v * v;
+        x[i] = v;
+    }
+    *diffSq = d;
+    *normSq = s;
+}
+
+/* r = mask .* (b - y) */
+inline void interpResidual(double *r, const double *y, const double *b, const double *mask, long n)
+{
+    long i;
+#pragma omp parallel for schedule(static)
+    for (i = 0; i < n; i++)
+        r[i] = mask[i] * (b[i] - y[i]);
+}
+
+/* c = c + g */
+inline void interpAccumulate(cpx *c, const cpx *g, long n)
+{
+    long i;
+#pragma omp parallel for schedule(static)
+    for (i = 0; i < n; i++)
+        c[i] += g[i];
+}
+
+/* ||x - xOld||^2 and ||x||^2, then xOld = x */
+inline void interpChange(const double *x, double *xOld, long n, double *diffSq, double *normSq)
+{
+    double d = 0.0, s = 0.0;
+    long i;
+#pragma omp parallel for reduction(+:d, s) schedule(static)
+    for (i = 0; i < n; i++) {
+        double e = x[i] - xOld[i];
+        d += e * e;
+        s += x[i] * x[i];
+        xOld[i] = x[i];
+    }
+    *diffSq = d;
+    *normSq = s;
+}
+
+/*
+ * POCS: x_{k+1} = alpha b + (1 - alpha M) C' H_{lambda_k}(C x_k)
+ * b holds the recorded data (zero at the missing traces) and mask is 1 at the
+ * recorded samples. x holds the warm start on input and the result on output.
+ */
+template <class Op>
+int interpPocs(Op &op, const double *b, const double *mask, double *x, const InterpOptions &opts, InterpInfo &info)
+{
+    long n = op.nData();
+    long nc = op.nCoef();
+    std::vector<cpx> c(nc);
+    std::vector<double> y(n);
+    double lambdaMax = opts.lambdaMax;
+    int k;
+
+    if (lambdaMax <= 0.0) {
+        op.analysis(b, &c[0]);
+        lambdaMax = interpMaxAbs(&c[0], nc);
+    }
+
+    info.nIter = 0;
+    info.lambda = lambdaMax;
+    info.relChange = 0.0;
+    for (k = 0; k < opts.nIter; k++) {
+        double diffSq, normSq;
+        info.lambda = interpLambda(opts, lambdaMax, k);
+        op.analysis(x, &c[0]);
+        interpHardThreshold(&c[0], nc, info.lambda);
+        op.synthesis(&c[0], &y[0]);
+        interpPocsUpdate(x, &y[0], b, mask, n, opts.alpha, &diffSq, &normSq);
+        info.nIter = k + 1;
+        info.relChange = (normSq > 0.0) ? sqrt(diffSq / normSq) : 0.0;
+        if (k > 0 && info.relChange <= opts.tol)
+            break;
+    }
+    return 0;
+}
+
+/*
+ * IST: c_{k+1} = S_{lambda_k}(c_k + C M (b - M C' c_k)), x = C' c
+ * c holds the warm start coefficients on input (zeros for a cold start) and
+ * the final coefficients on output, x receives the reconstructed data.
+ */
+template <class Op>
+int interpIst(Op &op, const double *b, const double *mask, cpx *c, double *x, const InterpOptions &opts, InterpInfo &info)
+{
+    long n = op.nData();
+    long nc = op.nCoef();
+    std::vector<cpx> g(nc);
+    std::vector<double> r(n), xOld(n);
+    double lambdaMax = opts.lambdaMax;
+    int k;
+
+    if (lambdaMax <= 0.0) {
+        op.analysis(b, &g[0]);
+        lambdaMax = interpMaxAbs(&g[0], nc);
+    }
+
+    op.synthesis(c, x);
+    memcpy(&xOld[0], x, n * sizeof(double));
+    info.nIter = 0;
+    info.lambda = lambdaMax;
+    info.relChange = 0.0;
+    for (k = 0; k < opts.nIter; k++) {
+        double diffSq, normSq;
+        info.lambda = interpLambda(opts, lambdaMax, k);
+        interpResidual(&r[0], x, b, mask, n);
+        op.analysis(&r[0], &g[0]);
+        interpAccumulate(c, &g[0], nc);
+        interpSoftThreshold(c, nc, info.lambda);
+        op.synthesis(c, x);
+        interpChange(x, &xOld[0], n, &diffSq, &normSq);
+        info.nIter = k + 1;
+        info.relChange = (normSq > 0.0) ? sqrt(diffSq / normSq) : 0.0;
+        if (k > 0 && info.relChange <= opts.tol)
+            break;
+    }
+    return 0;
+}
+
+/*
+ * Runs the method selected in opts with x as the warm start (IST starts from
+ * the coefficients C x), x receives the result.
+ */
+template <class Op>
+int interpSolve(Op &op, const double *b, const double *mask, double *x, const InterpOptions &opts, InterpInfo &info)
+{
+    if (opts.method == INTERP_IST) {
+        std::vector<cpx> c(op.nCoef());
+        op.analysis(x, &c[0]);
+        return interpIst(op, b, mask, &c[0], x, opts, info);
+    }
+    return interpPocs(op, b, mask, x, opts, info);
+}
+
+#endif
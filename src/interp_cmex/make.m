@@ -0,0 +1,21 @@
+close all;
+clear;
+clc;
+
+CURVELAB_2D = '../CurveLab-2.1.3/fdct_wrapping_cpp/src';
+CURVELAB_3D = '../CurveLab-2.1.3/fdct3d/src';
+SRC_2D = {[CURVELAB_2D, '/fdct_wrapping.cpp'], [CURVELAB_2D, '/ifdct_wrapping.cpp'], [CURVELAB_2D, '/fdct_wrapping_param.cpp']};
+SRC_3D = {[CURVELAB_3D, '/fdct3d_forward.cpp'], [CURVELAB_3D, '/fdct3d_inverse.cpp'], [CURVELAB_3D, '/fdct3d_param.cpp']};
+FFTW_LIB = '-lfftw';    % FFTW 2.1.5, as used by CurveLab
+
+fprintf('Compiling with OpenMP ...\n');
+if (isunix) % Linux / MacOS
+    mex('COPTIMFLAGS=-O3', 'CXXOPTIMFLAGS=-O3', 'CXXFLAGS=$CXXFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', ['-I', CURVELAB_2D], 'curveletInterp2d_mex.cpp', SRC_2D{:}, FFTW_LIB);
+    mex('COPTIMFLAGS=-O3', 'CXXOPTIMFLAGS=-O3', 'CXXFLAGS=$CXXFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', ['-I', CURVELAB_2D], 'curveletMaskOp2d_mex.cpp', SRC_2D{:}, FFTW_LIB);
+    mex('COPTIMFLAGS=-O3', 'CXXOPTIMFLAGS=-O3', 'CXXFLAGS=$CXXFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', ['-I', CURVELAB_3D], 'curveletInterp3d_mex.cpp', SRC_3D{:}, FFTW_LIB);
+else        % Windows
+    mex('CXXFLAGS=$CXXFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', ['-I', CURVELAB_2D], 'curveletInterp2d_mex.cpp', SRC_2D{:}, FFTW_LIB);
+    mex('CXXFLAGS=$CXXFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', ['-I', CURVELAB_2D], 'curveletMaskOp2d_mex.cpp', SRC_2D{:}, FFTW_LIB);
+    mex('CXXFLAGS=$CXXFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', ['-I', CURVELAB_3D], 'curveletInterp3d_mex.cpp', SRC_3D{:}, FFTW_LIB);
+end
+fprintf('Compiling complete!\n');
@@ -12,7 +12,7 @@ function a = col2imstep(b, n, sz, s)
 % with a stepsize of [S1 S2].
 %
 %
-% See also IM2COLSTEP, IM2COL, COUNTCOVER
+% See also IM2COLSTEP, IM2COL, COUNTCOVER, PATCHDICTOP
 
 % Ron Rubinstein
 % Computer Science Department
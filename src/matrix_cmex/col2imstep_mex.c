@@ -10,10 +10,14 @@
  *
  * Last Updated: 31.8.2009
  *
+ * Blocks are accumulated in parallel (OpenMP) over strips of block
+ * columns, two-colored so that no two threads add to the same entry.
+ *
  *************************************************************************/
 
 
 #include "mex.h"
+#include "patchstep.h"
 
 
 /* Input Arguments */
@@ -35,7 +39,10 @@ void mexFunction(int nlhs, mxArray *plhs[],
 { 
     double *x, *b, *s;
     mwSize sz[3], stepsize[3], n[3], ndims;
-    mwIndex i, j, k, l, m, t, blocknum;
+    mwIndex i, j, k, t, *strip;
+    mwSize nstrips;
+    int color, ncolors;
+    PatchGrid grid;
     
     
     /* Check for proper number of arguments */
@@ -104,7 +111,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
       mexErrMsgTxt("Block size too large.");
     }
 
-    if (mxGetN(B_IN) != ((n[0]-sz[0])/stepsize[0]+1)*((n[1]-sz[1])/stepsize[1]+1)*((n[2]-sz[2])/stepsize[2]+1)) {
+    patchGridInit(&grid, n, sz, stepsize);
+    if (mxGetM(B_IN) != grid.len || mxGetN(B_IN) != grid.nblocks) {
       mexErrMsgTxt("Invalid number of columns in B. Please use IM2COLSTEP to compute B.");
     }
     
@@ -122,26 +130,29 @@ void mexFunction(int nlhs, mxArray *plhs[],
     
     /* Do the actual computation */
     
-    blocknum = 0;
-    
-    /* iterate over all blocks */
-    for (k=0; k<=n[2]-sz[2]; k+=stepsize[2]) {
-      for (j=0; j<=n[1]-sz[1]; j+=stepsize[1]) {
-        for (i=0; i<=n[0]-sz[0]; i+=stepsize[0]) {
-          
-          /* add single block */
-          for (m=0; m<sz[2]; m++) {
-            for (l=0; l<sz[1]; l++) {
-              for (t=0; t<sz[0]; t++) {
-                (x+(k+m)*n[0]*n[1]+(j+l)*n[0]+i)[t] += (b + blocknum*sz[0]*sz[1]*sz[2] + m*sz[0]*sz[1] + l*sz[0])[t];
-              }
+    strip = (mwIndex*)mxMalloc((grid.nb[1]+1)*sizeof(mwIndex));
+    nstrips = patchStrips(&grid, strip);
+    ncolors = patchColors(&grid);
+    
+    /* accumulate strips of block columns in parallel, strips of the same
+       color do not overlap */
+    for (color=0; color<ncolors; color++) {
+      #pragma omp parallel for schedule(dynamic) private(i,j,k)
+      for (t=color; t<nstrips; t+=ncolors) {
+        for (k=0; k<grid.nb[2]; k++) {
+          for (j=strip[t]; j<strip[t+1]; j++) {
+            for (i=0; i<grid.nb[0]; i++) {
+              
+              /* add single block */
+              patchScatterAdd(&grid, x, i, j, k, b + patchIndex(&grid, i, j, k)*grid.len);
+              
             }
           }
-          blocknum++;
-          
         }
       }
     }
     
+    mxFree(strip);
+    
     return;
 }
@@ -20,7 +20,7 @@ function b = im2colstep(x, sz, s)
 % Note: the call IM2COLSTEP(A,[N1 N2]) produces the same output as Matlab's
 % IM2COL(A,[N1 N2],'sliding'). However, it is significantly faster.
 %
-% See also COL2IMSTEP, IM2COL, COUNTCOVER
+% See also COL2IMSTEP, IM2COL, COUNTCOVER, PATCHDICTOP
 
 % Ron Rubinstein
 % Computer Science Department
@@ -10,11 +10,14 @@
  *
  * Last Updated: 31.8.2009
  *
+ * Blocks are copied in parallel (OpenMP) over block columns.
+ *
  *************************************************************************/
 
 
 #include "mex.h"
 #include <string.h>
+#include "patchstep.h"
 
 
 /* Input Arguments */
@@ -35,7 +38,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
 { 
     double *x, *b, *s;
     mwSize sz[3], stepsize[3], n[3], ndims;
-    mwIndex i, j, k, l, m, blocknum;
+    mwIndex i, l;
+    PatchGrid grid;
     
     
     /* Check for proper number of arguments */
@@ -98,7 +102,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
     
     /* Create a matrix for the return argument */
     
-    B_OUT = mxCreateDoubleMatrix(sz[0]*sz[1]*sz[2], ((n[0]-sz[0])/stepsize[0]+1)*((n[1]-sz[1])/stepsize[1]+1)*((n[2]-sz[2])/stepsize[2]+1), mxREAL);
+    patchGridInit(&grid, n, sz, stepsize);
+    B_OUT = mxCreateDoubleMatrix(grid.len, grid.nblocks, mxREAL);
     
     
     /* Assign pointers */
@@ -109,22 +114,15 @@ void mexFunction(int nlhs, mxArray *plhs[],
     
     /* Do the actual computation */
     
-    blocknum = 0;
-    
-    /* iterate over all blocks */
-    for (k=0; k<=n[2]-sz[2]; k+=stepsize[2]) {
-      for (j=0; j<=n[1]-sz[1]; j+=stepsize[1]) {
-        for (i=0; i<=n[0]-sz[0]; i+=stepsize[0]) {
-          
-          /* copy single block */
-          for (m=0; m<sz[2]; m++) {
-            for (l=0; l<sz[1]; l++) {
-              memcpy(b + blocknum*sz[0]*sz[1]*sz[2] + m*sz[0]*sz[1] + l*sz[0], x+(k+m)*n[0]*n[1]+(j+l)*n[0]+i, sz[0]*sizeof(double));
-            }
-          }
-          blocknum++;
-          
-        }
+    /* iterate over all blocks, block columns in parallel */
+    #pragma omp parallel for schedule(static) private(i)
+    for (l=0; l<grid.nb[1]*grid.nb[2]; l++) {
+      mwIndex jb = l % grid.nb[1], kb = l / grid.nb[1];
+      for (i=0; i<grid.nb[0]; i++) {
+        
+        /* copy single block */
+        patchGather(&grid, x, i, jb, kb, b + patchIndex(&grid, i, jb, kb)*grid.len);
+        
       }
     }
     
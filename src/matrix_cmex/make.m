@@ -0,0 +1,17 @@
+close all;
+clear;
+clc;
+
+fprintf('Compiling with OpenMP ...\n');
+if (isunix) % Linux / MacOS
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" im2colstep_mex.c
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" col2imstep_mex.c
+    mex COPTIMFLAGS="-O3" CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" patchdictop_mex.c
+    mex COPTIMFLAGS="-O3" addtocols_mex.c
+else        % Windows
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" im2colstep_mex.c
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" col2imstep_mex.c
+    mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" patchdictop_mex.c
+    mex addtocols_mex.c
+end
+fprintf('Compiling complete!\n');
@@ -0,0 +1,52 @@
+function [y, cnt] = patchdictop(x, D, sz, s, method, param, W)
+% PATCHDICTOP Patch-wise dictionary thresholding with overlap-add.
+% Y = PATCHDICTOP(X,D,[N1 N2],[S1 S2],METHOD,PARAM) processes every
+% N1-by-N2 block of the 2-D matrix X taken with step (S1,S2), exactly as
+% IM2COLSTEP(X,[N1 N2],[S1 S2]) would, computes its coefficients C = D'*B,
+% thresholds them and returns the average over the overlapping blocks of
+% the reconstructions D*C. It is equivalent to
+%
+%   B = im2colstep(x, sz, s);
+%   C = threshold(D' * B);
+%   y = col2imstep(D * C, size(x), sz, s) ./ countcover(size(x), sz, s);
+%
+% but never forms B: the blocks are streamed through cache-sized batches
+% and accumulated in parallel, so memory stays at the size of X.
+%
+% METHOD is one of
+%   'hard'  keep the coefficients with |c| >= PARAM,
+%   'soft'  soft-threshold the coefficients by PARAM,
+%   'topk'  keep the PARAM coefficients of largest magnitude per block.
+%
+% Y = PATCHDICTOP(X,D,[N1 N2 N3],[S1 S2 S3],...) operates on a 3-D X.
+%
+% Y = PATCHDICTOP(...,W) uses the analysis matrix W (same size as D) to
+% compute C = W'*B, e.g. the dual frame of a non-orthogonal D.
+%
+% [Y,CNT] = PATCHDICTOP(...) also returns COUNTCOVER(SIZE(X),SZ,S).
+%
+% See also IM2COLSTEP, COL2IMSTEP, COUNTCOVER
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+if (nargin < 7)
+    W = [];
+end
+
+switch lower(method)
+    case 'hard'
+        m = 0;
+    case 'soft'
+        m = 1;
+    case 'topk'
+        m = 2;
+    otherwise
+        error('Invalid thresholding method! Should be ''hard'', ''soft'' or ''topk''');
+end
+
+[y, cnt] = patchdictop_mex(x, D, sz, s, m, param, W);
@@ -0,0 +1,350 @@
+/**************************************************************************
+ *
+ * File name: patchdictop_mex.c
+ *
+ * [Y, CNT] = patchdictop_mex(X, D, SZ, S, METHOD, PARAM, W)
+ *
+ * Streaming patch-wise dictionary operator: for every block of X (in the
+ * sense of IM2COLSTEP(X,SZ,S)) computes c = W'*block, thresholds c
+ * (METHOD 0: hard threshold |c| >= PARAM, 1: soft threshold by PARAM,
+ * 2: keep the PARAM largest |c|), and adds D*c back into Y, which is
+ * then divided by the number of blocks covering every entry (CNT).
+ *
+ * The blocks are processed in cache-sized batches per thread, so the
+ * prod(SZ)-by-#blocks matrix of IM2COLSTEP is never formed; the overlap-
+ * add is parallel over two-colored strips of block columns (patchstep.h).
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+
+#include "mex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "patchstep.h"
+
+
+/* Input Arguments */
+
+#define X_IN        prhs[0]
+#define D_IN        prhs[1]
+#define SZ_IN       prhs[2]
+#define S_IN        prhs[3]
+#define METHOD_IN   prhs[4]
+#define PARAM_IN    prhs[5]
+#define W_IN        prhs[6]
+
+
+/* Output Arguments */
+
+#define Y_OUT       plhs[0]
+#define CNT_OUT     plhs[1]
+
+
+/* size of the batch of blocks of one thread, in bytes */
+#define BATCH_BYTES (1 << 17)
+
+
+#define METHOD_HARD 0
+#define METHOD_SOFT 1
+#define METHOD_TOPK 2
+
+
+/* k-th largest entry of a[0..n-1] (1 <= k <= n), reorders a */
+static double kthLargest(double *a, mwSize n, mwSize k)
+{
+    long lo = 0, hi = (long)n - 1, target = (long)k - 1;
+    while (lo < hi) {
+        double pivot = a[(lo + hi) / 2], tmp;
+        long i = lo, j = hi;
+        while (i <= j) {
+            while (a[i] > pivot) i++;
+            while (a[j] < pivot) j--;
+            if (i <= j) {
+                tmp = a[i]; a[i] = a[j]; a[j] = tmp;
+                i++; j--;
+            }
+        }
+        if (target <= j) hi = j;
+        else if (target >= i) lo = i;
+        else break;
+    }
+    return a[target];
+}
+
+
+/* thresholds the coefficients c in place, work holds n doubles */
+static void thresholdCoef(double *c, mwSize n, int method, double param, double *work)
+{
+    mwIndex a;
+
+    if (method == METHOD_HARD) {
+        for (a=0; a<n; a++) {
+            if (fabs(c[a]) < param) c[a] = 0;
+        }
+    }
+    else if (method == METHOD_SOFT) {
+        for (a=0; a<n; a++) {
+            double v = fabs(c[a]) - param;
+            c[a] = (v > 0) ? (c[a] > 0 ? v : -v) : 0;
+        }
+    }
+    else {
+        /* keep the k largest magnitudes, ties resolved by position as a sort would */
+        mwSize k, kept = 0, above = 0;
+        double t;
+        if (param >= (double)n) return;
+        k = (mwSize)param;
+        if (k == 0) {
+            memset(c, 0, n*sizeof(double));
+            return;
+        }
+        for (a=0; a<n; a++) work[a] = fabs(c[a]);
+        t = kthLargest(work, n, k);
+        for (a=0; a<n; a++) {
+            if (fabs(c[a]) > t) above++;
+        }
+        for (a=0; a<n; a++) {
+            double v = fabs(c[a]);
+            if (v > t) continue;
+            if (v == t && above + kept < k) kept++;
+            else c[a] = 0;
+        }
+    }
+}
+
+
+/* number of blocks covering every index of one dimension */
+static void coverCount(mwSize n, mwSize sz, mwSize step, double *cnt)
+{
+    mwIndex i, b, nb = (n-sz)/step + 1;
+    for (i=0; i<n; i++) cnt[i] = 0;
+    for (b=0; b<nb; b++) {
+        for (i=b*step; i<b*step+sz; i++) cnt[i] += 1;
+    }
+}
+
+
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray*prhs[])
+
+{
+    double *x, *y, *D, *W, *s, *cnt, *cover[3], param;
+    mwSize sz[3], stepsize[3], n[3], ndims, natoms, batch, nstrips;
+    mwIndex i, j, k, t, *strip;
+    int method, color, ncolors, failed = 0;
+    PatchGrid grid;
+
+
+    /* Check for proper number of arguments */
+
+    if (nrhs < 6 || nrhs > 7) {
+      mexErrMsgTxt("Invalid number of input arguments.");
+    } else if (nlhs > 2) {
+      mexErrMsgTxt("Too many output arguments.");
+    }
+
+
+    /* Check the the input dimensions */
+
+    ndims = mxGetNumberOfDimensions(X_IN);
+
+    if (!mxIsDouble(X_IN) || mxIsComplex(X_IN) || ndims>3) {
+      mexErrMsgTxt("X should be a 2-D or 3-D double matrix.");
+    }
+    if (!mxIsDouble(SZ_IN) || mxIsComplex(SZ_IN) || mxGetNumberOfDimensions(SZ_IN)>2 || mxGetM(SZ_IN)*mxGetN(SZ_IN)!=ndims) {
+      mexErrMsgTxt("Invalid block size.");
+    }
+    if (!mxIsDouble(S_IN) || mxIsComplex(S_IN) || mxGetNumberOfDimensions(S_IN)>2 || mxGetM(S_IN)*mxGetN(S_IN)!=ndims) {
+      mexErrMsgTxt("Invalid step size.");
+    }
+
+
+    /* Get parameters */
+
+    s = mxGetPr(SZ_IN);
+    if (s[0]<1 || s[1]<1 || (ndims==3 && s[2]<1)) {
+      mexErrMsgTxt("Invalid block size.");
+    }
+    sz[0] = (mwSize)(s[0] + 0.01);
+    sz[1] = (mwSize)(s[1] + 0.01);
+    sz[2] = ndims==3 ? (mwSize)(s[2] + 0.01) : 1;
+
+    s = mxGetPr(S_IN);
+    if (s[0]<1 || s[1]<1 || (ndims==3 && s[2]<1)) {
+      mexErrMsgTxt("Invalid step size.");
+    }
+    stepsize[0] = (mwSize)(s[0] + 0.01);
+    stepsize[1] = (mwSize)(s[1] + 0.01);
+    stepsize[2] = ndims==3 ? (mwSize)(s[2] + 0.01) : 1;
+
+    n[0] = (mxGetDimensions(X_IN))[0];
+    n[1] = (mxGetDimensions(X_IN))[1];
+    n[2] = ndims==3 ? (mxGetDimensions(X_IN))[2] : 1;
+
+    if (n[0]<sz[0] || n[1]<sz[1] || (ndims==3 && n[2]<sz[2])) {
+      mexErrMsgTxt("Block size too large.");
+    }
+
+    patchGridInit(&grid, n, sz, stepsize);
+
+    if (!mxIsDouble(D_IN) || mxIsComplex(D_IN) || mxIsSparse(D_IN) || mxGetM(D_IN) != grid.len) {
+      mexErrMsgTxt("D should be a full real matrix with prod(SZ) rows.");
+    }
+    natoms = mxGetN(D_IN);
+    D = mxGetPr(D_IN);
+    W = D;
+    if (nrhs == 7 && !mxIsEmpty(W_IN)) {
+      if (!mxIsDouble(W_IN) || mxIsComplex(W_IN) || mxIsSparse(W_IN) || mxGetM(W_IN) != grid.len || mxGetN(W_IN) != natoms) {
+        mexErrMsgTxt("W should be a full real matrix of the same size as D.");
+      }
+      W = mxGetPr(W_IN);
+    }
+
+    method = (int)mxGetScalar(METHOD_IN);
+    param = mxGetScalar(PARAM_IN);
+    if (method < METHOD_HARD || method > METHOD_TOPK) {
+      mexErrMsgTxt("Invalid thresholding method.");
+    }
+    if (method == METHOD_TOPK && !(param >= 0)) {
+      mexErrMsgTxt("The number of coefficients to keep should be nonnegative.");
+    }
+
+
+    /* Create matrices for the return arguments */
+
+    Y_OUT = mxCreateNumericArray(ndims, n, mxDOUBLE_CLASS, mxREAL);
+
+
+    /* Assign pointers */
+
+    x = mxGetPr(X_IN);
+    y = mxGetPr(Y_OUT);
+
+
+    /* Do the actual computation */
+
+    batch = BATCH_BYTES / ((grid.len + natoms) * sizeof(double));
+    if (batch < 1) batch = 1;
+
+    strip = (mwIndex*)mxMalloc((grid.nb[1]+1)*sizeof(mwIndex));
+    nstrips = patchStrips(&grid, strip);
+    ncolors = patchColors(&grid);
+
+    for (color=0; color<ncolors; color++) {
+      #pragma omp parallel private(i,j,k)
+      {
+        /* batch buffers of this thread: blocks, coefficients, block positions */
+        double *P = (double*)malloc(batch*grid.len*sizeof(double));
+        double *C = (double*)malloc((batch*natoms + natoms)*sizeof(double));
+        double *r = (double*)malloc(grid.len*sizeof(double));
+        mwIndex *pos = (mwIndex*)malloc(3*batch*sizeof(mwIndex));
+
+        if (!P || !C || !r || !pos) {
+          #pragma omp atomic write
+          failed = 1;
+        }
+
+        #pragma omp for schedule(dynamic)
+        for (t=color; t<nstrips; t+=ncolors) {
+          mwSize nbat = 0;
+          mwIndex a, q, b, e;
+
+          if (!P || !C || !r || !pos) continue;
+
+          for (k=0; k<grid.nb[2]; k++) {
+            for (j=strip[t]; j<strip[t+1]; j++) {
+              for (i=0; i<grid.nb[0]; i++) {
+
+                /* collect the block */
+                patchGather(&grid, x, i, j, k, P + nbat*grid.len);
+                pos[3*nbat] = i; pos[3*nbat+1] = j; pos[3*nbat+2] = k;
+                nbat++;
+
+                if (nbat < batch && !(k == grid.nb[2]-1 && j == strip[t+1]-1 && i == grid.nb[0]-1)) {
+                  continue;
+                }
+
+                /* C = W' * P, atom by atom so that every atom is reused over the batch */
+                for (a=0; a<natoms; a++) {
+                  const double *w = W + a*grid.len;
+                  for (b=0; b<nbat; b++) {
+                    const double *p = P + b*grid.len;
+                    double v = 0;
+                    for (e=0; e<grid.len; e++) v += w[e]*p[e];
+                    C[b*natoms + a] = v;
+                  }
+                }
+
+                /* threshold, synthesize and add back */
+                for (b=0; b<nbat; b++) {
+                  double *c = C + b*natoms;
+                  thresholdCoef(c, natoms, method, param, C + batch*natoms);
+                  memset(r, 0, grid.len*sizeof(double));
+                  for (a=0; a<natoms; a++) {
+                    if (c[a] != 0) {
+                      const double *d = D + a*grid.len;
+                      for (q=0; q<grid.len; q++) r[q] += c[a]*d[q];
+                    }
+                  }
+                  patchScatterAdd(&grid, y, pos[3*b], pos[3*b+1], pos[3*b+2], r);
+                }
+                nbat = 0;
+              }
+            }
+          }
+        }
+
+        free(P);
+        free(C);
+        free(r);
+        free(pos);
+      }
+    }
+
+    mxFree(strip);
+
+    if (failed) {
+      mexErrMsgTxt("Cannot allocate memory for the batch buffers.");
+    }
+
+
+    /* Average over the blocks covering every entry */
+
+    for (t=0; t<3; t++) {
+      cover[t] = (double*)mxMalloc(n[t]*sizeof(double));
+      coverCount(n[t], sz[t], stepsize[t], cover[t]);
+    }
+    if (nlhs > 1) {
+      CNT_OUT = mxCreateNumericArray(ndims, n, mxDOUBLE_CLASS, mxREAL);
+      cnt = mxGetPr(CNT_OUT);
+    }
+    else {
+      cnt = NULL;
+    }
+
+    #pragma omp parallel for private(j,i)
+    for (k=0; k<n[2]; k++) {
+      for (j=0; j<n[1]; j++) {
+        double *yy = y + (k*n[1] + j)*n[0];
+        double cjk = cover[2][k]*cover[1][j];
+        for (i=0; i<n[0]; i++) {
+          double c = cjk*cover[0][i];
+          if (c > 0) yy[i] /= c;
+          if (cnt) cnt[(k*n[1] + j)*n[0] + i] = c;
+        }
+      }
+    }
+
+    for (t=0; t<3; t++) {
+      mxFree(cover[t]);
+    }
+
+    return;
+}
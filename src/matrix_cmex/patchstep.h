@@ -0,0 +1,129 @@
+/**************************************************************************
+ *
+ * File name: patchstep.h
+ *
+ * Streaming iteration over the (possibly overlapping) blocks of a 2-D or
+ * 3-D matrix in the order of IM2COLSTEP, shared by im2colstep_mex.c,
+ * col2imstep_mex.c and patchdictop_mex.c.
+ *
+ * Blocks are grouped in strips of consecutive block columns (second
+ * dimension). Strips are wide enough that strip s only overlaps strips
+ * s-1 and s+1, so all even strips and then all odd strips can be
+ * accumulated in parallel without atomics (two-coloring).
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ *************************************************************************/
+
+#ifndef _PATCHSTEP_H_
+#define _PATCHSTEP_H_
+
+#include "mex.h"
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+typedef struct {
+    mwSize n[3];          /* matrix size */
+    mwSize sz[3];         /* block size */
+    mwSize step[3];       /* step size */
+    mwSize nb[3];         /* number of blocks along every dimension */
+    mwSize len;           /* number of entries of a block */
+    mwSize nblocks;       /* total number of blocks */
+} PatchGrid;
+
+
+static void patchGridInit(PatchGrid *g, const mwSize *n, const mwSize *sz, const mwSize *step)
+{
+    int d;
+    g->len = 1;
+    g->nblocks = 1;
+    for (d = 0; d < 3; d++) {
+        g->n[d] = n[d];
+        g->sz[d] = sz[d];
+        g->step[d] = step[d];
+        g->nb[d] = (n[d]-sz[d])/step[d] + 1;
+        g->len *= sz[d];
+        g->nblocks *= g->nb[d];
+    }
+}
+
+
+/* column of block (ib,jb,kb) in the IM2COLSTEP matrix */
+static mwIndex patchIndex(const PatchGrid *g, mwIndex ib, mwIndex jb, mwIndex kb)
+{
+    return (kb*g->nb[1] + jb)*g->nb[0] + ib;
+}
+
+
+/* copy block (ib,jb,kb) of x to the contiguous vector b */
+static void patchGather(const PatchGrid *g, const double *x, mwIndex ib, mwIndex jb, mwIndex kb, double *b)
+{
+    mwIndex l, m;
+    const double *src = x + (kb*g->step[2])*g->n[0]*g->n[1] + (jb*g->step[1])*g->n[0] + ib*g->step[0];
+    for (m=0; m<g->sz[2]; m++) {
+        for (l=0; l<g->sz[1]; l++) {
+            memcpy(b + m*g->sz[0]*g->sz[1] + l*g->sz[0], src + m*g->n[0]*g->n[1] + l*g->n[0], g->sz[0]*sizeof(double));
+        }
+    }
+}
+
+
+/* add the contiguous vector b to block (ib,jb,kb) of x */
+static void patchScatterAdd(const PatchGrid *g, double *x, mwIndex ib, mwIndex jb, mwIndex kb, const double *b)
+{
+    mwIndex t, l, m;
+    double *dst = x + (kb*g->step[2])*g->n[0]*g->n[1] + (jb*g->step[1])*g->n[0] + ib*g->step[0];
+    for (m=0; m<g->sz[2]; m++) {
+        for (l=0; l<g->sz[1]; l++) {
+            double *d = dst + m*g->n[0]*g->n[1] + l*g->n[0];
+            const double *s = b + m*g->sz[0]*g->sz[1] + l*g->sz[0];
+            for (t=0; t<g->sz[0]; t++) {
+                d[t] += s[t];
+            }
+        }
+    }
+}
+
+
+/* Splits the block columns 0..nb[1]-1 into strips [start[s], start[s+1]),
+ * about four per thread, each at least ceil(sz[1]/step[1]) block columns
+ * wide so that strips s and s+2 never overlap. start holds nb[1]+1
+ * entries; returns the number of strips. */
+static mwSize patchStrips(const PatchGrid *g, mwIndex *start)
+{
+    mwSize s, nstrips, width, minwidth;
+    int nthreads = 1;
+
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    minwidth = (g->sz[1] + g->step[1] - 1) / g->step[1];
+    width = (g->nb[1] + 4*nthreads - 1) / (4*nthreads);
+    if (width < minwidth) {
+        width = minwidth;
+    }
+    nstrips = (g->nb[1] + width - 1) / width;
+    for (s=0; s<nstrips; s++) {
+        start[s] = s*width;
+    }
+    start[nstrips] = g->nb[1];
+    return nstrips;
+}
+
+
+/* number of colors (passes) needed to accumulate strips without races */
+static int patchColors(const PatchGrid *g)
+{
+    return (g->step[1] >= g->sz[1]) ? 1 : 2;
+}
+
+
+#endif
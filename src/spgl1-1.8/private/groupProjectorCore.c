@@ -0,0 +1,242 @@
+/* groupProjectorCore.c
+
+   Group-L2 norms, duals and projections for NormL12 (MMV) and
+   NormGroupL2 on contiguous group layouts, see groupProjectorCore.h.
+
+   The row layout is traversed column by column over a block of rows,
+   so the inner loops are unit-stride and vectorize; blocks of rows
+   (and groups in the pointer layout) are distributed over threads.
+   The projection of the group norms onto the weighted simplex is
+   done by projectI / projectD of oneProjectorCore.c.
+*/
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "groupProjectorCore.h"
+#include "oneProjectorCore.h"
+
+/* Problems with fewer entries are handled on a single thread */
+#define GROUP_PARALLEL_MIN (1 << 15)
+
+/* Rows per block of the row layout (the block of partial sums stays in L1) */
+#define GROUP_ROW_BLOCK 512
+
+
+/* ----------------------------------------------------------------------- */
+void groupNormsRows(const double *xr, const double *xi, long inc, long m, long g, double *a)
+/* ----------------------------------------------------------------------- */
+{  long blk, nBlk = (m + GROUP_ROW_BLOCK - 1) / GROUP_ROW_BLOCK;
+
+   #pragma omp parallel for schedule(static) if (m * g >= GROUP_PARALLEL_MIN)
+   for (blk = 0; blk < nBlk; blk++)
+   {  long i, j, i0 = blk * GROUP_ROW_BLOCK;
+      long i1 = (i0 + GROUP_ROW_BLOCK < m) ? i0 + GROUP_ROW_BLOCK : m;
+      double *s = a + i0;
+      long len = i1 - i0;
+
+      for (i = 0; i < len; i++) s[i] = 0;
+      for (j = 0; j < g; j++)
+      {  const double *pr = xr + (j * m + i0) * inc;
+         if (inc == 1)
+         {
+            #pragma omp simd
+            for (i = 0; i < len; i++) s[i] += pr[i] * pr[i];
+            if (xi)
+            {  const double *pi = xi + j * m + i0;
+               #pragma omp simd
+               for (i = 0; i < len; i++) s[i] += pi[i] * pi[i];
+            }
+         }
+         else if (xi)
+         {  const double *pi = xi + (j * m + i0) * inc;
+            for (i = 0; i < len; i++) s[i] += pr[i*inc] * pr[i*inc] + pi[i*inc] * pi[i*inc];
+         }
+         else
+         {  for (i = 0; i < len; i++) s[i] += pr[i*inc] * pr[i*inc];
+         }
+      }
+      for (i = 0; i < len; i++) s[i] = sqrt(s[i]);
+   }
+}
+
+
+/* ----------------------------------------------------------------------- */
+void groupNormsPtr(const double *xr, const double *xi, long inc, const long *ptr, long nGroups, double *a)
+/* ----------------------------------------------------------------------- */
+{  long k;
+
+   #pragma omp parallel for schedule(static) if (ptr[nGroups] - ptr[0] >= GROUP_PARALLEL_MIN)
+   for (k = 0; k < nGroups; k++)
+   {  long i;
+      double s = 0;
+      if (inc == 1)
+      {
+         #pragma omp simd reduction(+:s)
+         for (i = ptr[k]; i < ptr[k+1]; i++) s += xr[i] * xr[i];
+         if (xi)
+         {
+            #pragma omp simd reduction(+:s)
+            for (i = ptr[k]; i < ptr[k+1]; i++) s += xi[i] * xi[i];
+         }
+      }
+      else
+      {  for (i = ptr[k]; i < ptr[k+1]; i++)
+         {  s += xr[i*inc] * xr[i*inc];
+            if (xi) s += xi[i*inc] * xi[i*inc];
+         }
+      }
+      a[k] = sqrt(s);
+   }
+}
+
+
+/* ----------------------------------------------------------------------- */
+void groupScaleRows(double *xr, double *xi, long inc, long m, long g, const double *c)
+/* ----------------------------------------------------------------------- */
+{  long j;
+
+   #pragma omp parallel for schedule(static) if (m * g >= GROUP_PARALLEL_MIN)
+   for (j = 0; j < g; j++)
+   {  long i;
+      double *pr = xr + j * m * inc;
+      if (inc == 1)
+      {
+         #pragma omp simd
+         for (i = 0; i < m; i++) pr[i] *= c[i];
+         if (xi)
+         {  double *pi = xi + j * m;
+            #pragma omp simd
+            for (i = 0; i < m; i++) pi[i] *= c[i];
+         }
+      }
+      else
+      {  double *pi = xi ? xi + j * m * inc : NULL;
+         for (i = 0; i < m; i++)
+         {  pr[i*inc] *= c[i];
+            if (pi) pi[i*inc] *= c[i];
+         }
+      }
+   }
+}
+
+
+/* ----------------------------------------------------------------------- */
+void groupScalePtr(double *xr, double *xi, long inc, const long *ptr, long nGroups, const double *c)
+/* ----------------------------------------------------------------------- */
+{  long k;
+
+   #pragma omp parallel for schedule(static) if (ptr[nGroups] - ptr[0] >= GROUP_PARALLEL_MIN)
+   for (k = 0; k < nGroups; k++)
+   {  long i;
+      double ck = c[k];
+      for (i = ptr[k]; i < ptr[k+1]; i++)
+      {  xr[i*inc] *= ck;
+         if (xi) xi[i*inc] *= ck;
+      }
+   }
+}
+
+
+/* ----------------------------------------------------------------------- */
+double groupPrimal(const double *a, const double *w, double weight, long nGroups)
+/* ----------------------------------------------------------------------- */
+{  long k;
+   double p = 0;
+
+   if (w)
+   {
+      #pragma omp parallel for simd reduction(+:p) if (nGroups >= GROUP_PARALLEL_MIN)
+      for (k = 0; k < nGroups; k++) p += w[k] * a[k];
+      return p;
+   }
+   #pragma omp parallel for simd reduction(+:p) if (nGroups >= GROUP_PARALLEL_MIN)
+   for (k = 0; k < nGroups; k++) p += a[k];
+   return weight * p;
+}
+
+
+/* ----------------------------------------------------------------------- */
+double groupDual(const double *a, const double *w, double weight, long nGroups)
+/* ----------------------------------------------------------------------- */
+{  long k;
+   double d = 0;
+
+   if (w)
+   {
+      #pragma omp parallel for simd reduction(max:d) if (nGroups >= GROUP_PARALLEL_MIN)
+      for (k = 0; k < nGroups; k++) d = (a[k] / w[k] > d) ? a[k] / w[k] : d;
+      return d;
+   }
+   #pragma omp parallel for simd reduction(max:d) if (nGroups >= GROUP_PARALLEL_MIN)
+   for (k = 0; k < nGroups; k++) d = (a[k] > d) ? a[k] : d;
+   return d / weight;
+}
+
+
+/* ----------------------------------------------------------------------- */
+int groupProjectScales(double *a, const double *w, double weight, double tau, long nGroups, double *work)
+/* ----------------------------------------------------------------------- */
+/* Same as  xc = oneProjector(a,w,tau); xc = xc./a; xc(a < eps) = 0  */
+{  long k, n;
+   int nnz = 0;
+   double *c = work, *x = c + nGroups, *b = x + nGroups, *d = b + nGroups, *dOrg = d + nGroups;
+
+   memcpy((void *)c, (void *)a, nGroups * sizeof(double));
+   if (w == NULL)
+   {  /* A zero weight leaves the norms unconstrained */
+      if (weight != 0)
+         nnz = projectI(c, a, tau / fabs(weight), (int)nGroups);
+   }
+   else
+   {  /* Project the groups with nonzero weight only, as oneProjector.m */
+      for (n = 0, k = 0; k < nGroups; k++)
+      {  if (fabs(w[k]) > DBL_EPSILON)
+         {  b[n] = a[k]; dOrg[n] = fabs(w[k]); n++;
+         }
+      }
+      if (n > 0)
+      {  memcpy((void *)d, (void *)dOrg, n * sizeof(double));
+         nnz = projectD(x, b, d, dOrg, tau, (int)n);
+         for (n = 0, k = 0; k < nGroups; k++)
+            if (fabs(w[k]) > DBL_EPSILON) c[k] = x[n++];
+      }
+   }
+
+   #pragma omp parallel for simd if (nGroups >= GROUP_PARALLEL_MIN)
+   for (k = 0; k < nGroups; k++)
+      a[k] = (a[k] < DBL_EPSILON) ? 0 : c[k] / a[k];
+
+   return nnz;
+}
+
+
+/* ----------------------------------------------------------------------- */
+int projectL12(double *xr, double *xi, long inc, long m, long g,
+               const double *w, double weight, double tau, double *work)
+/* ----------------------------------------------------------------------- */
+{  double *a = work;
+   int nnz;
+
+   groupNormsRows(xr, xi, inc, m, g, a);
+   nnz = groupProjectScales(a, w, weight, tau, m, a + m);
+   groupScaleRows(xr, xi, inc, m, g, a);
+
+   return nnz;
+}
+
+
+/* ----------------------------------------------------------------------- */
+int projectGroupL2(double *xr, double *xi, long inc, const long *ptr, long nGroups,
+                   const double *w, double weight, double tau, double *work)
+/* ----------------------------------------------------------------------- */
+{  double *a = work;
+   int nnz;
+
+   groupNormsPtr(xr, xi, inc, ptr, nGroups, a);
+   nnz = groupProjectScales(a, w, weight, tau, nGroups, a + nGroups);
+   groupScalePtr(xr, xi, inc, ptr, nGroups, a);
+
+   return nnz;
+}
@@ -0,0 +1,53 @@
+/* groupProjectorCore.h
+
+   Group-L2 norms, duals and projections for NormL12 (MMV) and
+   NormGroupL2, on contiguous group layouts.
+
+   Vector x has real parts xr[i*inc] and, when xi is not NULL,
+   imaginary parts xi[i*inc]; inc = 1 for MATLAB split storage and
+   inc = 2 (xi = xr + 1) for interleaved complex storage.
+
+   Row layout (NormL12):   x is an m-by-g column-major matrix and
+                           group k is row k, so there are m groups.
+   Pointer layout (Group): group k is entries ptr[k] .. ptr[k+1]-1.
+
+   Weights are one per group (w != NULL) or the scalar weight.
+*/
+#ifndef __GROUPPROJECTORCORE_H__
+#define __GROUPPROJECTORCORE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Work space in doubles needed by the projections for nGroups groups */
+#define GROUP_PROJECT_WORK(nGroups) (6 * (nGroups))
+
+/* a[k] = ||x_{G_k}||_2 */
+void groupNormsRows( const double *xr, const double *xi, long inc, long m, long g, double *a );
+void groupNormsPtr ( const double *xr, const double *xi, long inc, const long *ptr, long nGroups, double *a );
+
+/* x_{G_k} *= c[k] */
+void groupScaleRows( double *xr, double *xi, long inc, long m, long g, const double *c );
+void groupScalePtr ( double *xr, double *xi, long inc, const long *ptr, long nGroups, const double *c );
+
+/* sum_k w_k a_k and max_k a_k / w_k of the group norms a */
+double groupPrimal( const double *a, const double *w, double weight, long nGroups );
+double groupDual  ( const double *a, const double *w, double weight, long nGroups );
+
+/* Overwrites a with the scale factors oneProjector(a,w,tau) ./ a
+   (zero where a < eps) that project x onto the ball of radius tau;
+   work holds 5 nGroups doubles. Returns the number of nonzero groups. */
+int groupProjectScales( double *a, const double *w, double weight, double tau, long nGroups, double *work );
+
+/* In-place projections; work holds GROUP_PROJECT_WORK(nGroups) doubles */
+int projectL12    ( double *xr, double *xi, long inc, long m, long g,
+                    const double *w, double weight, double tau, double *work );
+int projectGroupL2( double *xr, double *xi, long inc, const long *ptr, long nGroups,
+                    const double *w, double weight, double tau, double *work );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
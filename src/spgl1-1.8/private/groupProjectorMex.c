@@ -0,0 +1,311 @@
+/* groupProjectorMex.c
+
+   [y, itn] = groupProjectorMex(mode, x, groups, weights, tau)
+
+   Group-L2 projections, primal and dual norms for NormL12_* (MMV) and
+   NormGroupL2_*, for a batch of vectors at once.
+
+   mode     0: project, 1: primal norm, 2: dual norm.
+   x        n-by-K, real or complex; every column is a separate problem.
+   groups   Scalar g: every column of x is an m-by-g matrix whose rows
+            are the groups (NormL12).  Otherwise the nGroups-by-n group
+            matrix G of NormGroupL2, dense or sparse, with nonnegative
+            entries: the group norms are sqrt(G * abs(x).^2) and the
+            projection scales x(i) by sum_k G(k,i) s_k, as in
+            groupProjectorMex.m.  The usual sparse binary matrix, where a
+            variable belongs to at most one group, takes the fast path
+            below; variables in no group project to zero.
+   weights  Scalar or one weight per group.
+   tau      Scalar or one radius per column (projection only).
+
+   y is n-by-K for the projection and 1-by-K for the norms; itn is the
+   number of nonzero groups of every projected column.
+
+   The columns are processed in parallel; within a column the norms and
+   scaling use the threaded, vectorized kernels of groupProjectorCore.c.
+   Groups that are not contiguous in x are gathered into a contiguous
+   buffer first.  Overlapping or weighted group matrices are applied
+   entry by entry from their compressed columns.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "groupProjectorCore.h"
+#include "mex.h"
+
+/* Layouts of the groups */
+#define LAYOUT_ROWS    0   /* scalar g, NormL12 */
+#define LAYOUT_PTR     1   /* binary, at most one group per variable */
+#define LAYOUT_MATRIX  2   /* general nonnegative group matrix */
+
+
+/* ----------------------------------------------------------------------- */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+/* ----------------------------------------------------------------------- */
+{  const mxArray *matrixX, *groups, *weights, *tau;
+   double        *xr, *xi, *yr, *yi, *w, *tauPtr, *itnPtr = NULL;
+   double         weight;
+   double        *gv = NULL;
+   long          *ptr = NULL, *perm = NULL, *gjc = NULL, *gir = NULL;
+   long           n, K, m = 0, g = 0, nGroups, nGrouped = 0, nTau, i, k;
+   int            mode, isComplex, layout, contiguous = 1, failed = 0;
+
+   /* Check for proper number of arguments */
+   if (nrhs != 5) { mexErrMsgTxt("Five input arguments required."); }
+   if (nlhs  > 2) { mexErrMsgTxt("Too many output arguments.");     }
+
+   mode    = (int)mxGetScalar(prhs[0]);
+   matrixX = prhs[1];
+   groups  = prhs[2];
+   weights = prhs[3];
+   tau     = prhs[4];
+   nTau    = mxGetNumberOfElements(tau);
+
+   if (!mxIsDouble(matrixX) || mxIsSparse(matrixX) || (mxGetNumberOfDimensions(matrixX) != 2))
+   {  mexErrMsgTxt("Parameter 'x' has to be a full double matrix.");
+   }
+   n         = mxGetM(matrixX);
+   K         = mxGetN(matrixX);
+   isComplex = mxIsComplex(matrixX);
+   xr        = mxGetPr(matrixX);
+   xi        = isComplex ? mxGetPi(matrixX) : NULL;
+
+   /* Group structure */
+   if (mxGetNumberOfElements(groups) == 1 && !mxIsSparse(groups))
+      layout = LAYOUT_ROWS;
+   else
+   {  mwIndex  nz;
+      double  *pr;
+
+      if (!mxIsDouble(groups) || mxIsComplex(groups) || (mxGetNumberOfDimensions(groups) != 2))
+      {  mexErrMsgTxt("The group matrix has to be a real double matrix.");
+      }
+      if ((long)mxGetN(groups) != n)
+      {  mexErrMsgTxt("The group matrix needs one column per entry of 'x'.");
+      }
+      pr = mxGetPr(groups);
+      nz = mxIsSparse(groups) ? mxGetJc(groups)[n] : mxGetNumberOfElements(groups);
+      layout = mxIsSparse(groups) ? LAYOUT_PTR : LAYOUT_MATRIX;
+      for (i = 0; i < (long)nz; i++)
+      {  if (!(pr[i] >= 0) || mxIsInf(pr[i]))
+         {  mexErrMsgTxt("The group matrix has to be finite and nonnegative.");
+         }
+         if (pr[i] != 1) layout = LAYOUT_MATRIX;
+      }
+      if (layout == LAYOUT_PTR)
+      {  mwIndex *jc = mxGetJc(groups);
+         for (i = 0; i < n; i++)
+         {  if (jc[i+1] - jc[i] > 1) { layout = LAYOUT_MATRIX; break; }
+         }
+      }
+   }
+
+   if (layout == LAYOUT_ROWS)
+   {  g = (long)mxGetScalar(groups);
+      if ((g < 1) || (n % g != 0))
+      {  mexErrMsgTxt("The number of groups has to divide the length of 'x'.");
+      }
+      m       = n / g;
+      nGroups = m;
+   }
+   else if (layout == LAYOUT_PTR)
+   {  mwIndex *ir = mxGetIr(groups), *jc = mxGetJc(groups);
+      long    *count;
+
+      nGroups = mxGetM(groups);
+      ptr     = (long *)mxCalloc(nGroups + 1, sizeof(long));
+      perm    = (long *)mxMalloc((n > 0 ? n : 1) * sizeof(long));
+      count   = (long *)mxCalloc(nGroups + 1, sizeof(long));
+
+      /* Counting sort of the variables by group */
+      for (i = 0; i < n; i++)
+      {  if (jc[i+1] > jc[i]) { count[ir[jc[i]] + 1] ++; nGrouped ++; }
+      }
+      for (k = 0; k < nGroups; k++) ptr[k+1] = ptr[k] + count[k+1];
+      memcpy((void *)count, (void *)ptr, nGroups * sizeof(long));
+      for (i = 0; i < n; i++)
+      {  if (jc[i+1] > jc[i])
+         {  perm[count[ir[jc[i]]] ++] = i;
+         }
+      }
+      for (i = 0; i < nGrouped; i++)
+      {  if (perm[i] != i) { contiguous = 0; break; }
+      }
+      if (nGrouped < n) contiguous = 0;
+      mxFree(count);
+   }
+   else
+   {  /* Compressed columns of the nonzero entries of G */
+      const double *pr = mxGetPr(groups);
+      long          nz = 0, p;
+
+      nGroups = mxGetM(groups);
+      gjc     = (long *)mxMalloc((n + 1) * sizeof(long));
+      if (mxIsSparse(groups))
+      {  mwIndex *ir = mxGetIr(groups), *jc = mxGetJc(groups);
+         nz  = (long)jc[n];
+         gir = (long *)mxMalloc((nz > 0 ? nz : 1) * sizeof(long));
+         gv  = (double *)mxMalloc((nz > 0 ? nz : 1) * sizeof(double));
+         for (i = 0; i <= n; i++) gjc[i] = (long)jc[i];
+         for (p = 0; p < nz; p++) { gir[p] = (long)ir[p]; gv[p] = pr[p]; }
+      }
+      else
+      {  for (p = 0; p < nGroups * n; p++) if (pr[p] != 0) nz ++;
+         gir = (long *)mxMalloc((nz > 0 ? nz : 1) * sizeof(long));
+         gv  = (double *)mxMalloc((nz > 0 ? nz : 1) * sizeof(double));
+         gjc[0] = 0;
+         for (i = 0, p = 0; i < n; i++)
+         {  for (k = 0; k < nGroups; k++)
+            {  if (pr[k + i * nGroups] != 0) { gir[p] = k; gv[p] = pr[k + i * nGroups]; p ++; }
+            }
+            gjc[i+1] = p;
+         }
+      }
+   }
+
+   /* Weights */
+   if (mxGetNumberOfElements(weights) == 1)
+   {  w      = NULL;
+      weight = mxGetScalar(weights);
+   }
+   else if ((long)mxGetNumberOfElements(weights) == nGroups)
+   {  w      = mxGetPr(weights);
+      weight = 1;
+   }
+   else
+   {  mexErrMsgTxt("Parameter 'weights' has to be a scalar or have one entry per group.");
+   }
+
+   /* Outputs */
+   if (mode == 0)
+   {  if ((nTau != 1) && (nTau != K))
+      {  mexErrMsgTxt("Parameter 'tau' has to be a scalar or have one entry per column.");
+      }
+      tauPtr  = mxGetPr(tau);
+      plhs[0] = mxDuplicateArray(matrixX);
+      if (nlhs > 1)
+      {  plhs[1] = mxCreateDoubleMatrix(1, K, mxREAL);
+         itnPtr  = mxGetPr(plhs[1]);
+      }
+   }
+   else if ((mode == 1) || (mode == 2))
+   {  tauPtr  = NULL;
+      plhs[0] = mxCreateDoubleMatrix(1, K, mxREAL);
+   }
+   else
+   {  mexErrMsgTxt("Parameter 'mode' has to be 0 (project), 1 (primal) or 2 (dual).");
+   }
+   yr = mxGetPr(plhs[0]);
+   yi = (mode == 0 && isComplex) ? mxGetPi(plhs[0]) : NULL;
+
+   /* Process the columns */
+   #pragma omp parallel if (K > 1)
+   {  double *work, *bufR = NULL, *bufI = NULL;
+      int     ok;
+
+      work = (double *)malloc((GROUP_PROJECT_WORK(nGroups) + 1) * sizeof(double));
+      ok   = (work != NULL);
+      if ((layout == LAYOUT_PTR) && !contiguous && ok)
+      {  bufR = (double *)malloc((nGrouped + 1) * sizeof(double));
+         bufI = isComplex ? (double *)malloc((nGrouped + 1) * sizeof(double)) : NULL;
+         ok   = (bufR != NULL) && (!isComplex || bufI != NULL);
+      }
+      if (!ok)
+      {
+         #pragma omp atomic write
+         failed = 1;
+      }
+
+      #pragma omp for schedule(dynamic)
+      for (k = 0; k < K; k++)
+      {  double *cr, *ci, *sr, *si;
+         long    j;
+         int     nnz = 0;
+
+         if (!ok) continue;
+
+         /* Source (mode 1, 2) or in-place target (mode 0) of column k */
+         if (mode == 0)
+         {  cr = yr + k * n; ci = yi ? yi + k * n : NULL;
+         }
+         else
+         {  cr = xr + k * n; ci = xi ? xi + k * n : NULL;
+         }
+
+         if (layout == LAYOUT_ROWS)
+         {  if (mode == 0)
+               nnz = projectL12(cr, ci, 1, m, g, w, weight, tauPtr[nTau == 1 ? 0 : k], work);
+            else
+               groupNormsRows(cr, ci, 1, m, g, work);
+         }
+         else if (layout == LAYOUT_MATRIX)
+         {  /* a = sqrt(G * abs(x).^2), x(i) *= sum_k G(k,i) s_k */
+            double *a = work;
+            long    p;
+
+            for (j = 0; j < nGroups; j++) a[j] = 0;
+            for (j = 0; j < n; j++)
+            {  double v = ci ? cr[j] * cr[j] + ci[j] * ci[j] : cr[j] * cr[j];
+               for (p = gjc[j]; p < gjc[j+1]; p++) a[gir[p]] += gv[p] * v;
+            }
+            for (j = 0; j < nGroups; j++) a[j] = sqrt(a[j]);
+
+            if (mode == 0)
+            {  nnz = groupProjectScales(a, w, weight, tauPtr[nTau == 1 ? 0 : k], nGroups, a + nGroups);
+               for (j = 0; j < n; j++)
+               {  double c = 0;
+                  for (p = gjc[j]; p < gjc[j+1]; p++) c += gv[p] * a[gir[p]];
+                  cr[j] *= c;
+                  if (ci) ci[j] *= c;
+               }
+            }
+         }
+         else
+         {  /* Gather the grouped variables when they are not in group order */
+            sr = cr; si = ci;
+            if (!contiguous)
+            {  sr = bufR; si = ci ? bufI : NULL;
+               for (j = 0; j < nGrouped; j++) sr[j] = cr[perm[j]];
+               if (si) for (j = 0; j < nGrouped; j++) si[j] = ci[perm[j]];
+            }
+
+            if (mode == 0)
+               nnz = projectGroupL2(sr, si, 1, ptr, nGroups, w, weight, tauPtr[nTau == 1 ? 0 : k], work);
+            else
+               groupNormsPtr(sr, si, 1, ptr, nGroups, work);
+
+            if ((mode == 0) && !contiguous)
+            {  /* Scatter back; variables in no group are projected to zero */
+               if (nGrouped < n)
+               {  for (j = 0; j < n; j++) cr[j] = 0;
+                  if (ci) for (j = 0; j < n; j++) ci[j] = 0;
+               }
+               for (j = 0; j < nGrouped; j++) cr[perm[j]] = sr[j];
+               if (ci) for (j = 0; j < nGrouped; j++) ci[perm[j]] = si[j];
+            }
+         }
+
+         if (mode == 0)
+         {  if (itnPtr) itnPtr[k] = nnz;
+         }
+         else if (mode == 1)
+            yr[k] = groupPrimal(work, w, weight, nGroups);
+         else
+            yr[k] = groupDual(work, w, weight, nGroups);
+      }
+
+      free(work);
+      free(bufR);
+      free(bufI);
+   }
+
+   if (ptr  != NULL) mxFree(ptr);
+   if (perm != NULL) mxFree(perm);
+   if (gjc  != NULL) mxFree(gjc);
+   if (gir  != NULL) mxFree(gir);
+   if (gv   != NULL) mxFree(gv);
+   if (failed) { mexErrMsgTxt("Cannot allocate memory for scratch"); }
+
+   return ;
+}
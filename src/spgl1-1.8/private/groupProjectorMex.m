@@ -0,0 +1,52 @@
+function [y, itn] = groupProjectorMex(mode,x,groups,weights,tau)
+% [y, itn] = groupProjectorMex(mode,x,groups,weights,tau)
+% Group-L2 projection (mode 0), primal norm (mode 1) or dual norm
+% (mode 2) of every column of x. Groups is either the number of
+% columns g of the MMV matrix reshape(x(:,k),[],g), whose rows are the
+% groups, or the group matrix of NormGroupL2 (dense or sparse, finite
+% and nonnegative, groups may overlap). Tau is a scalar or holds one
+% radius per column.
+%
+% This is the reference version of groupProjectorMex.c, used when the
+% MEX interface has not been compiled (see spgsetup).
+%
+% See also NormL12_project, NormGroupL2_project, oneProjector.
+
+[n,K] = size(x);
+if isscalar(groups)
+   m = round(n / groups);
+end
+
+if mode == 0
+   y   = x;
+   itn = zeros(1,K);
+else
+   y   = zeros(1,K);
+end
+
+for k = 1:K
+   % Two-norms of the groups
+   if isscalar(groups)
+      xa = sqrt(sum(abs(reshape(x(:,k),m,groups)).^2,2));
+   else
+      xa = sqrt(groups * abs(x(:,k)).^2);
+   end
+
+   switch mode
+      case 0
+         % Project onto the one-norm ball and scale the original
+         idx = xa < eps;
+         xc  = oneProjector(xa,weights,tau(min(k,end)));
+         itn(k) = nnz(xc);
+         xc  = xc ./ xa; xc(idx) = 0;
+         if isscalar(groups)
+            y(:,k) = reshape(spdiags(xc,0,m,m)*reshape(x(:,k),m,groups),[],1);
+         else
+            y(:,k) = full(groups' * xc).*x(:,k);
+         end
+      case 1
+         y(k) = sum(weights.*xa);
+      case 2
+         y(k) = norm(xa./weights,inf);
+   end
+end
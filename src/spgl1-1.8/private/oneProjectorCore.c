@@ -30,21 +30,294 @@
 #include <assert.h>
 #include <float.h>     /* provides DBL_EPSILON */
 #include <sys/types.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "oneProjectorCore.h"
-#include "heap.h"
+
+/* Vectors shorter than this are projected on a single thread */
+#define PROJECT_PARALLEL_MIN  (1 << 18)
+
+
+/* ----------------------------------------------------------------------- */
+static double thresholdI(double y[], double aux[], double tau, int n, int *m)
+/* ----------------------------------------------------------------------- */
+/* Threshold of the projection of y >= 0 onto the simplex of radius tau,
+   found in expected linear time (L. Condat, "Fast projection onto the
+   simplex and the l1 ball", Math. Program., 2016).  Requires n >= 1.
+   The candidate list is built in aux[], which may coincide with y[].
+   On return aux[0..*m-1] holds the entries of y above the threshold.  */
+{  int
+       i, k,
+       len,         /* End of the current candidate list v              */
+       start;       /* Start of v, the entries before it were set aside */
+   double
+       yi,
+       sum,         /* Sum of the entries in v                          */
+       soft;        /* Threshold determined by v                        */
+
+   aux[0] = y[0];
+   sum    = y[0];
+   soft   = y[0] - tau;
+   len    = 1;
+   start  = 0;
+
+   /* Single pass: grow v, restart it whenever an entry alone beats it */
+   for (i = 1; i < n; i++)
+   {  yi = y[i];
+      if (yi > soft)
+      {  aux[len++] = yi;
+         sum  += yi;
+         soft  = (sum - tau) / (len - start);
+         if (soft <= yi - tau)
+         {  start = len - 1;
+            sum   = yi;
+            soft  = yi - tau;
+         }
+      }
+   }
+
+   /* Reconsider the entries set aside, prepending those above soft to v */
+   for (k = start - 1, i = start; k >= 0; k--)
+   {  yi = aux[k];
+      if (yi > soft)
+      {  aux[--i] = yi;
+         sum  += yi;
+         soft  = (sum - tau) / (len - i);
+      }
+   }
+   start = i;
+
+   /* Remove entries below the threshold until v no longer changes */
+   do
+   {  k = len;
+      for (i = start, len = start; i < k; i++)
+      {  yi = aux[i];
+         if (yi > soft)
+            aux[len++] = yi;
+         else
+         {  sum  -= yi;
+            soft  = (sum - tau) / (k - i - 1 + len - start);
+         }
+      }
+   } while (len < k);
+
+   /* Move v to the front of aux */
+   if (start > 0) memmove((void *)aux, (void *)(aux + start), (len - start) * sizeof(double));
+   *m = len - start;
+
+   return soft;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double thresholdD(double z[], double w[], double tau, int n, int *m)
+/* ----------------------------------------------------------------------- */
+/* Weighted counterpart of thresholdI: z[] holds the ratios b./d and w[]
+   the weights d.  The threshold soft solves sum d.*max(b - d*soft,0) = tau,
+   and every candidate list v gives a lower bound (sum_v d.*b - tau) /
+   sum_v d.^2, so Condat's argument carries over unchanged.  Both arrays
+   are compacted in place; on return z[0..*m-1] and w[0..*m-1] hold the
+   entries above the threshold.  Requires n >= 1.                         */
+{  int
+       i, k,
+       len,
+       start;
+   double
+       zi, wi, w2,
+       csdb,        /* Sum of d.*b over v   */
+       csd2,        /* Sum of d.^2 over v   */
+       soft;
+
+   w2     = w[0] * w[0];
+   csdb   = z[0] * w2;
+   csd2   = w2;
+   soft   = (csdb - tau) / csd2;
+   len    = 1;
+   start  = 0;
+
+   for (i = 1; i < n; i++)
+   {  zi = z[i];
+      if (zi > soft)
+      {  wi = w[i];
+         w2 = wi * wi;
+         z[len] = zi;
+         w[len] = wi;
+         len++;
+         csdb += zi * w2;
+         csd2 += w2;
+         soft  = (csdb - tau) / csd2;
+         if (soft <= zi - tau / w2)
+         {  start = len - 1;
+            csdb  = zi * w2;
+            csd2  = w2;
+            soft  = zi - tau / w2;
+         }
+      }
+   }
+
+   for (k = start - 1, i = start; k >= 0; k--)
+   {  zi = z[k];
+      if (zi > soft)
+      {  wi = w[k];
+         w2 = wi * wi;
+         --i;
+         z[i] = zi;
+         w[i] = wi;
+         csdb += zi * w2;
+         csd2 += w2;
+         soft  = (csdb - tau) / csd2;
+      }
+   }
+   start = i;
+
+   do
+   {  k = len;
+      for (i = start, len = start; i < k; i++)
+      {  zi = z[i];
+         wi = w[i];
+         if (zi > soft)
+         {  z[len] = zi;
+            w[len] = wi;
+            len++;
+         }
+         else
+         {  w2    = wi * wi;
+            csdb -= zi * w2;
+            csd2 -= w2;
+            soft  = (csdb - tau) / csd2;
+         }
+      }
+   } while (len < k);
+
+   if (start > 0)
+   {  memmove((void *)z, (void *)(z + start), (len - start) * sizeof(double));
+      memmove((void *)w, (void *)(w + start), (len - start) * sizeof(double));
+   }
+   *m = len - start;
+
+   return soft;
+}
+
+
+#ifdef _OPENMP
+/* ----------------------------------------------------------------------- */
+static double parallelThresholdI(double xPtr[], double bPtr[], double tau, int n, int *m)
+/* ----------------------------------------------------------------------- */
+/* The threshold of any subset of b is a lower bound on the threshold of
+   b.  Each thread projects its own block, the largest block threshold
+   discards most entries, and the survivors are gathered at the front of
+   xPtr[] for a final serial pass.                                       */
+{  int
+       t, nThreads, *count, *first;
+   double
+       *soft, lower = 0;
+
+   nThreads = omp_get_max_threads();
+   count    = (int *)malloc(2 * nThreads * sizeof(int));
+   first    = count + nThreads;
+   soft     = (double *)malloc(nThreads * sizeof(double));
+
+   #pragma omp parallel num_threads(nThreads)
+   {  int    i, k, lo, hi, tid = omp_get_thread_num(), nt = omp_get_num_threads();
+      double csb = 0;
+
+      lo = (int)(((long)n * tid) / nt);
+      hi = (int)(((long)n * (tid + 1)) / nt);
+
+      #pragma omp simd reduction(+:csb)
+      for (i = lo; i < hi; i++) csb += bPtr[i];
+      soft[tid] = (hi > lo && csb > tau) ? thresholdI(bPtr + lo, xPtr + lo, tau, hi - lo, &k) : 0;
+
+      #pragma omp barrier
+      #pragma omp single
+      {  for (t = 0; t < nt; t++) if (soft[t] > lower) lower = soft[t];
+      }
+
+      for (i = lo, k = lo; i < hi; i++)
+         if (bPtr[i] > lower) xPtr[k++] = bPtr[i];
+      count[tid] = k - lo;
+      first[tid] = lo;
+      if (tid == 0) nThreads = nt;
+   }
+
+   for (*m = 0, t = 0; t < nThreads; t++)
+   {  memmove((void *)(xPtr + *m), (void *)(xPtr + first[t]), count[t] * sizeof(double));
+      *m += count[t];
+   }
+   free(count);
+   free(soft);
+
+   return thresholdI(xPtr, xPtr, tau, *m, m);
+}
+
+
+/* ----------------------------------------------------------------------- */
+static double parallelThresholdD(double xPtr[], double bPtr[], double dPtr[], double dOrg[], double tau, int n, int *m)
+/* ----------------------------------------------------------------------- */
+/* Weighted counterpart of parallelThresholdI; on entry xPtr[] holds b./d
+   and dPtr[] a copy of d, both are used as workspace.                   */
+{  int
+       t, nThreads, *count, *first;
+   double
+       *soft, lower = 0;
+
+   nThreads = omp_get_max_threads();
+   count    = (int *)malloc(2 * nThreads * sizeof(int));
+   first    = count + nThreads;
+   soft     = (double *)malloc(nThreads * sizeof(double));
+
+   #pragma omp parallel num_threads(nThreads)
+   {  int    i, k, lo, hi, tid = omp_get_thread_num(), nt = omp_get_num_threads();
+      double csdb = 0, bd;
+
+      lo = (int)(((long)n * tid) / nt);
+      hi = (int)(((long)n * (tid + 1)) / nt);
+
+      #pragma omp simd reduction(+:csdb)
+      for (i = lo; i < hi; i++) csdb += dOrg[i] * bPtr[i];
+      soft[tid] = (hi > lo && csdb > tau) ? thresholdD(xPtr + lo, dPtr + lo, tau, hi - lo, &k) : 0;
+
+      #pragma omp barrier
+      #pragma omp single
+      {  for (t = 0; t < nt; t++) if (soft[t] > lower) lower = soft[t];
+      }
+
+      for (i = lo, k = lo; i < hi; i++)
+      {  bd = bPtr[i] / dOrg[i];
+         if (bd > lower)
+         {  xPtr[k] = bd;
+            dPtr[k] = dOrg[i];
+            k++;
+         }
+      }
+      count[tid] = k - lo;
+      first[tid] = lo;
+      if (tid == 0) nThreads = nt;
+   }
+
+   for (*m = 0, t = 0; t < nThreads; t++)
+   {  memmove((void *)(xPtr + *m), (void *)(xPtr + first[t]), count[t] * sizeof(double));
+      memmove((void *)(dPtr + *m), (void *)(dPtr + first[t]), count[t] * sizeof(double));
+      *m += count[t];
+   }
+   free(count);
+   free(soft);
+
+   return thresholdD(xPtr, dPtr, tau, *m, m);
+}
+#endif
 
 
 /* ----------------------------------------------------------------------- */
 int projectI(double xPtr[], double bPtr[], double tau, int n)
 /* ----------------------------------------------------------------------- */
 {  int
-       i, j;
+       i, m;
    double
-       b,          /* Current element of vector b */
-       csb,        /* Cumulative sum of b */
-       alpha = 0,
-       soft  = 0;  /* Soft thresholding value */
+       csb  = 0,   /* Cumulative sum of b */
+       soft = 0;   /* Soft thresholding value */
 
    /* The vector xPtr[] is initialized to bPtr[] prior to the function call */
 
@@ -55,44 +328,27 @@ int projectI(double xPtr[], double bPtr[], double tau, int n)
    }
 
    /* Check if ||b||_1 <= lambda.  Exit with x = b. */
-   for (csb = 0, i = 0; i < n; i++) csb += bPtr[i];
+   #pragma omp parallel for simd reduction(+:csb) if (n >= PROJECT_PARALLEL_MIN)
+   for (i = 0; i < n; i++) csb += bPtr[i];
    if (csb <= tau)
        return 0;
 
-   /* Set up the heap */
-   heap_build(n, xPtr);
-
-   /* Initialise csb with -tau so we don't have to subtract this at every iteration */
-   csb = -tau;
-
    /* Determine threshold value `soft' */
-   for (i = n, j = 0; j < n; soft = alpha)
-   {  
-      b = xPtr[0];       /* Get current maximum heap element         */
-      j ++;              /* Give compiler some room for optimization */
-      csb += b;          /* Update the cumulative sum of b           */
-
-      /* Move heap to next maximum value */
-      i = heap_del_max(i, xPtr);
-
-      /* Compute the required step to satisfy the tau constraint */
-      alpha  = csb / j;
-
-      /* We are done as soon as the constraint can be satisfied    */
-      /* without exceeding the current minimum value in `vector' b */
-      if (alpha >= b)
-          break;
-   }
+#ifdef _OPENMP
+   if (n >= PROJECT_PARALLEL_MIN && omp_get_max_threads() > 1 && !omp_in_parallel())
+        soft = parallelThresholdI(xPtr, bPtr, tau, n, &m);
+   else
+#endif
+        soft = thresholdI(bPtr, xPtr, tau, n, &m);
 
    /* Set the solution by applying soft-thresholding with `soft' */
+   #pragma omp parallel for simd if (n >= PROJECT_PARALLEL_MIN)
    for (i = 0; i < n; i++)
-   {  b = bPtr[i];
-      if (b <= soft)
-           xPtr[i] = 0;
-      else xPtr[i] = b - soft; 
+   {  double x = bPtr[i] - soft;
+      xPtr[i] = (x > 0) ? x : 0;
    }
 
-   return j;
+   return m;
 }
 
 
@@ -100,15 +356,10 @@ int projectI(double xPtr[], double bPtr[], double tau, int n)
 int projectD(double xPtr[], double bPtr[], double dPtr[], double dOrg[], double tau, int n)
 /* ----------------------------------------------------------------------- */
 {  int
-       i, j;
+       i, m;
    double
-       csdb,        /* Cumulative sum of d.*b          */
-       csd2,        /* Cumulative sum of d.^2          */
-       b,           /* Current element of vector b     */
-       d,           /* Current element of vector d     */
-       bd,          /* Current element of vector b / d */
-       alpha  = 0,
-       soft   = 0;
+       csdb = 0,    /* Cumulative sum of d.*b          */
+       soft = 0;
 
    /* Check if tau is essentially zero.  Exit with x = 0. */
    if (tau < DBL_EPSILON)
@@ -117,11 +368,10 @@ int projectD(double xPtr[], double bPtr[], double dPtr[], double dOrg[], double
    }
 
    /* Preliminary check on trivial solution x = b (meanwhile, scale x) */
-   for (csdb = 0, i = 0; i < n; i++)
-   {  d = dPtr[i];
-      b = xPtr[i];
-      csdb += (d * b);
-      xPtr[i] = b / d;
+   #pragma omp parallel for simd reduction(+:csdb) if (n >= PROJECT_PARALLEL_MIN)
+   for (i = 0; i < n; i++)
+   {  csdb   += dOrg[i] * bPtr[i];
+      xPtr[i] = bPtr[i] / dOrg[i];
    }
 
    if (csdb <= tau)
@@ -131,42 +381,20 @@ int projectD(double xPtr[], double bPtr[], double dPtr[], double dOrg[], double
       return 0;
    }
 
-   /* Set up the heap (we have to sort on b./d) */
-   heap_build_2(n, xPtr, dPtr);
-
-   /* Initialise csbd with -tau so we don't have to subtract this at every iteration */
-   csdb = -tau;
-   csd2 =  0;
-
-   /* Determine the threshold level `soft' */
-   for (i = n, j = 0; j < n; soft = alpha)
-   {
-      bd    = xPtr[0];        /* Get current maximum b / d                */
-      j    ++;                /* Give compiler some room for optimization */
-      d     = dPtr[0];        /* Get current value of d                   */
-      d    *= d;              /* Compute d squared                        */
-      csd2 += d;              /* Update the cumulative sum of d.*d        */
-      csdb += bd * d;         /* Update the cumulative sum of d.*b        */
-
-      /* Move heap to next maximum value */
-      i = heap_del_max_2(i, xPtr, dPtr);
-
-      /* Compute the required step to satisfy the lambda constraint */
-      alpha  = csdb / csd2;
-
-      /* We are done as soon as the constraint can be satisfied */
-      /* without exceeding the current minimum value of b / d   */
-      if (alpha >= bd) break;
-   }
+   /* Determine the threshold level `soft' on b./d */
+#ifdef _OPENMP
+   if (n >= PROJECT_PARALLEL_MIN && omp_get_max_threads() > 1 && !omp_in_parallel())
+        soft = parallelThresholdD(xPtr, bPtr, dPtr, dOrg, tau, n, &m);
+   else
+#endif
+        soft = thresholdD(xPtr, dPtr, tau, n, &m);
 
    /* Set the solution */
+   #pragma omp parallel for simd if (n >= PROJECT_PARALLEL_MIN)
    for (i = 0; i < n; i++)
-   {  b     = bPtr[i];
-      alpha = dOrg[i] * soft; /* Use the original values of d here */
-      if (b <= alpha)
-           xPtr[i] = 0;
-      else xPtr[i] = b - alpha;
+   {  double x = bPtr[i] - dOrg[i] * soft; /* Use the original values of d here */
+      xPtr[i] = (x > 0) ? x : 0;
    }
 
-   return j;
+   return m;
 }
@@ -27,7 +27,9 @@
 #ifndef __ONEPROJECTORCORE_H__
 #define __ONEPROJECTORCORE_H__
 
-/* The entries in b are non-negative, those in d strictly positive */
+/* The entries in b are non-negative, those in d strictly positive.
+   Both run in expected linear time; the return value is the number of
+   nonzero entries in x. */
 int projectI( double xPtr[], double bPtr[],                double tau, int n );
 int projectD( double xPtr[], double bPtr[], double dPtr[], double dOrg[], double tau, int n );
 
@@ -29,12 +29,22 @@
 root = pwd;
 try
     cd('private')
-    mex oneProjectorMex.c oneProjectorCore.c heap.c -output oneProjectorMex -DNDEBUG
+    if (isunix) % Linux / MacOS, multithreaded projection for long vectors
+        mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" oneProjectorMex.c oneProjectorCore.c -output oneProjectorMex -DNDEBUG
+    else
+        mex oneProjectorMex.c oneProjectorCore.c -output oneProjectorMex -DNDEBUG
+    end
     fprintf('Successfully compiled oneProjector.\n');
+    if (isunix)
+        mex CFLAGS="\$CFLAGS -fopenmp" LDFLAGS="\$LDFLAGS -fopenmp" groupProjectorMex.c groupProjectorCore.c oneProjectorCore.c -output groupProjectorMex -DNDEBUG
+    else
+        mex groupProjectorMex.c groupProjectorCore.c oneProjectorCore.c -output groupProjectorMex -DNDEBUG
+    end
+    fprintf('Successfully compiled groupProjector.\n');
     cd(root)
 catch
     cd(root)
-    fprintf('Could not compile oneProjector.');
+    fprintf('Could not compile oneProjector / groupProjector.');
     fprintf('You can still use the slower ".m" version.');
     rethrow(lasterr);
 end
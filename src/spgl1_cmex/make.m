@@ -0,0 +1,21 @@
+close all;
+clear;
+clc;
+
+SPGL1_PRIVATE = '../spgl1-1.8/private';
+INTERP_CMEX = '../interp_cmex';
+CURVELAB_2D = '../CurveLab-2.1.3/fdct_wrapping_cpp/src';
+SRC_2D = {[CURVELAB_2D, '/fdct_wrapping.cpp'], [CURVELAB_2D, '/ifdct_wrapping.cpp'], [CURVELAB_2D, '/fdct_wrapping_param.cpp']};
+FFTW_LIB = '-lfftw';    % FFTW 2.1.5, as used by CurveLab (native curvelet operator)
+
+fprintf('Compiling with OpenMP ...\n');
+if (isunix) % Linux / MacOS
+    mex('COPTIMFLAGS=-O3', 'CXXOPTIMFLAGS=-O3', 'CFLAGS=$CFLAGS -fopenmp', 'CXXFLAGS=$CXXFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', ...
+        ['-I', SPGL1_PRIVATE], ['-I', INTERP_CMEX], ['-I', CURVELAB_2D], ...
+        'spgl1C_mex.c', 'spgl1Core.c', 'spgl1NativeOp.cpp', [SPGL1_PRIVATE, '/oneProjectorCore.c'], [SPGL1_PRIVATE, '/groupProjectorCore.c'], SRC_2D{:}, FFTW_LIB);
+else        % Windows
+    mex('CFLAGS=$CFLAGS -fopenmp', 'CXXFLAGS=$CXXFLAGS -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp', ...
+        ['-I', SPGL1_PRIVATE], ['-I', INTERP_CMEX], ['-I', CURVELAB_2D], ...
+        'spgl1C_mex.c', 'spgl1Core.c', 'spgl1NativeOp.cpp', [SPGL1_PRIVATE, '/oneProjectorCore.c'], [SPGL1_PRIVATE, '/groupProjectorCore.c'], SRC_2D{:}, FFTW_LIB);
+end
+fprintf('Compiling complete!\n');
@@ -0,0 +1,36 @@
+function [x,r,g,info] = spg_groupC( A, b, groups, sigma, options )
+% SPG_GROUPC native version of SPG_GROUP: solve jointly-sparse basis
+% pursuit denoise over groups of variables
+%
+% [x, r, g, info] = spg_groupC(A, b, groups, sigma, options)
+%
+% Same arguments as SPG_GROUP; groups holds the group label of every
+% variable. See SPGL1C for the operator types handled natively.
+%
+% See also:	SPG_GROUP, SPGL1C
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if ~exist('options','var'), options = []; end
+if ~exist('sigma','var') || isempty(sigma), sigma = 0; end
+if ~exist('groups','var') || isempty(groups)
+    error('Third argument cannot be empty.');
+end
+if ~exist('b','var') || isempty(b)
+    error('Second argument cannot be empty.');
+end
+if ~exist('A','var') || isempty(A)
+    error('First argument cannot be empty.');
+end
+
+[gidx,idx1,idx2] = unique(groups(:));
+
+tau = 0;
+x0  = [];
+[x,r,g,info] = spgl1C(A,b,tau,sigma,x0,options,struct('groups',idx2));
@@ -0,0 +1,39 @@
+function [x,r,g,info] = spg_mmvC( A, B, sigma, options )
+% SPG_MMVC native version of SPG_MMV: solve multi-measurement basis
+% pursuit denoise, min ||X||_{1,2} s.t. ||AX - B||_F <= sigma
+%
+% [x, r, g, info] = spg_mmvC(A, B, sigma, options)
+%
+% Same arguments as SPG_MMV. See SPGL1C for the operator types handled
+% natively.
+%
+% See also:	SPG_MMV, SPGL1C
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+if ~exist('options','var'), options = []; end
+if ~exist('sigma','var'), sigma = 0; end
+if ~exist('B','var') || isempty(B)
+    error('Second argument cannot be empty.');
+end
+if ~exist('A','var') || isempty(A)
+    error('First argument cannot be empty.');
+end
+
+groups = size(B,2);
+
+tau = 0;
+x0  = [];
+[x,r,g,info] = spgl1C(A,B(:),tau,sigma,x0,options,struct('nCols',groups));
+
+n = round(length(x) / groups);
+m = size(B,1);
+x = reshape(x,n,groups);
+r = reshape(r,m,groups);
+g = reshape(g,n,groups);
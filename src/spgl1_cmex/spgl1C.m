@@ -0,0 +1,153 @@
+function [x,r,g,info] = spgl1C( A, b, tau, sigma, x, options, normSpec )
+% SPGL1C native SPGL1 solver, a drop-in replacement of SPGL1
+%
+% [x, r, g, info] = spgl1C(A, b, tau, sigma, x0, options)
+%
+% Solves the same problems as SPGL1 (BPDN, Lasso, BP) with the same
+% arguments and options (see SPGSETPARMS), but runs the whole iteration in
+% C (spgl1C_mex). A real explicit matrix (dense or sparse) is applied in
+% C; a function handle A(x,mode) is called through MATLAB.
+%
+% A can also be a structure naming an operator compiled into spgl1C_mex,
+% applied in C as well (x0 may then be [], the operator knows its size):
+%   A = struct('name','mask', 'mask',M)   y = M .* x
+%   A = struct('name','curvelet', 'mask',M, 'nbscales',nbscales, ...
+%              'nbangles_coarse',nbangles_coarse, 'finest',finest)
+%                                         y = M .* real(C' x), the operator
+%                                         of CURVELETMASKOP (mask optional
+%                                         with 'dims',[N1 N2])
+%
+% Options the native solver does not implement (subspaceMin, or a custom
+% options.project) fall back to SPGL1. For function handles with complex
+% x, A x is taken complex only when b is complex.
+%
+% normSpec is used by SPG_GROUPC and SPG_MMVC:
+%   .groups     1-based group of every entry of x (group-L2 norm)
+%   .nCols      number of columns of an MMV problem (A applied per column,
+%               L1,2 norm over the rows of X)
+%
+% See also:	SPGL1, SPG_BPDN, SPG_LASSO, SPG_GROUPC, SPG_MMVC, SPGSETPARMS
+%
+%
+% This matlab source file is free for use in academic research.
+% All rights reserved.
+%
+% Center for Signal and Information Processing, Center for Energy & Geo Processing
+% Georgia Institute of Technology
+
+
+m = length(b);
+
+if ~exist('options','var'), options = []; end
+if ~exist('x','var'), x = []; end
+if ~exist('sigma','var'), sigma = []; end
+if ~exist('tau','var'), tau = []; end
+if ~exist('normSpec','var'), normSpec = []; end
+
+if nargin < 2 || isempty(b) || isempty(A)
+   error('At least two arguments are required');
+elseif isempty(tau) && isempty(sigma)
+   tau = 0;
+   sigma = 0;
+   singleTau = false;
+elseif isempty(sigma) % && ~isempty(tau)  <-- implied
+   singleTau = true;
+   sigma = 0;
+else
+   if isempty(tau)
+      tau = 0;
+   end
+   singleTau = false;
+end
+
+defaultopts = spgSetParms(...
+'fid'        ,      1 , ... % File ID for output
+'verbosity'  ,      2 , ... % Verbosity level
+'iterations' ,   10*m , ... % Max number of iterations
+'nPrevVals'  ,      3 , ... % Number previous func values for linesearch
+'bpTol'      ,  1e-06 , ... % Tolerance for basis pursuit solution
+'lsTol'      ,  1e-06 , ... % Least-squares optimality tolerance
+'optTol'     ,  1e-04 , ... % Optimality tolerance
+'decTol'     ,  1e-04 , ... % Req'd rel. change in primal obj. for Newton
+'stepMin'    ,  1e-16 , ... % Minimum spectral step
+'stepMax'    ,  1e+05 , ... % Maximum spectral step
+'rootMethod' ,      2 , ... % Root finding method: 2=quad,1=linear (not used).
+'activeSetIt',    Inf , ... % Exit with EXIT_ACTIVE_SET if nnz same for # its.
+'subspaceMin',      0 , ... % Use subspace minimization
+'iscomplex'  ,    NaN , ... % Flag set to indicate complex problem
+'maxMatvec'  ,    Inf , ... % Maximum matrix-vector multiplies allowed
+'weights'    ,      1 , ... % Weights W in ||Wx||_1
+'project'    , @NormL1_project , ...
+'primal_norm', @NormL1_primal  , ...
+'dual_norm'  , @NormL1_dual      ...
+   );
+options = spgSetParms(defaultopts, options);
+
+% Features handled by spgl1.m only
+if isstruct(A) && (options.subspaceMin || ~isequal(options.project, @NormL1_project))
+   error('Native operators do not support subspaceMin or a custom options.project');
+end
+if isempty(normSpec) && (options.subspaceMin || ~isequal(options.project, @NormL1_project))
+   [x,r,g,info] = spgl1(A, b, tau, sigma, x, options);
+   return;
+end
+
+nCols = 1;
+groups = [];
+if isfield(normSpec, 'nCols') && ~isempty(normSpec.nCols), nCols = normSpec.nCols; end
+if isfield(normSpec, 'groups'), groups = normSpec.groups(:); end
+
+% Complex explicit matrices are applied through MATLAB
+if isnumeric(A) && ~isreal(A)
+   M = A;
+   A = @(z,mode) explicitProd(M, z, mode);
+end
+
+if isstruct(A)
+   % sized and typed by the native operator
+   realx = isempty(x) || isreal(x);
+   x = double(x);
+elseif isempty(x)
+   if isnumeric(A)
+      n = size(A,2) * nCols;
+      realx = isreal(A) && isreal(b);
+   else
+      y = A(b(1:m/nCols), 2);
+      n = length(y) * nCols;
+      realx = isreal(y) && isreal(b);
+   end
+   x = zeros(n,1);
+else
+   n     = length(x);
+   realx = isreal(x) && isreal(b);
+end
+if isnumeric(A), realx = realx && isreal(A); end;
+if (~isnan(options.iscomplex)), realx = (options.iscomplex == 0); end
+
+weights = options.weights;
+if ~isempty(weights)
+  if any(~isfinite(weights))
+     error('Entries in options.weights must be finite');
+  end
+  if any(weights <= 0)
+     error('Entries in options.weights must be strictly positive');
+  end
+else
+  options.weights = 1;
+end
+if (options.fid ~= 1), options.verbosity = 0; end
+
+if isnumeric(A) && ~issparse(A), A = full(double(A)); end
+[x,r,g,info] = spgl1C_mex(A, double(b(:)), tau, sigma, double(x(:)), singleTau, options, groups, nCols, ~realx);
+info.options = options;
+
+end
+
+
+function y = explicitProd(A, x, mode)
+if mode == 1
+   y = A * x;
+else
+   y = A' * x;
+end
+end
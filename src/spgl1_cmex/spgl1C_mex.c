@@ -0,0 +1,504 @@
+/* ======================================================================
+ *
+ * spgl1C_mex.c
+ *
+ * Gateway of the native SPGL1 solver (spgl1Core.c), called by spgl1C.m
+ *
+ * [x, r, g, info] = spgl1C_mex(A, b, tau, sigma, x0, singleTau, options, groups, nCols, isComplexX)
+ *
+ * A is a real (dense or sparse) matrix, applied in C, a structure naming
+ * one of the native operators of spgl1NativeOp.cpp (A.name plus its
+ * parameters), also applied in C, or a function handle A(x, mode) called
+ * through MATLAB. x0 may be empty for a native operator, which knows its
+ * own size. With nCols > 1 the operator is
+ * applied column by column to x = [x_1 ... x_nCols] (MMV). groups is [] for
+ * the weighted L1 norm or the 1-based group of every entry of x for the
+ * group-L2 norm. options is a structure from spgSetParms.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ ====================================================================== */
+
+#include "mex.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "spgl1Core.h"
+#include "spgl1NativeOp.h"
+
+/* input arguments */
+#define A_IN            prhs[0]
+#define B_IN            prhs[1]
+#define TAU_IN          prhs[2]
+#define SIGMA_IN        prhs[3]
+#define X0_IN           prhs[4]
+#define SINGLETAU_IN    prhs[5]
+#define OPTIONS_IN      prhs[6]
+#define GROUPS_IN       prhs[7]
+#define NCOLS_IN        prhs[8]
+#define COMPLEXX_IN     prhs[9]
+
+/* output arguments */
+#define X_OUT           plhs[0]
+#define R_OUT           plhs[1]
+#define G_OUT           plhs[2]
+#define INFO_OUT        plhs[3]
+
+/* operator data */
+typedef struct
+{
+    const mxArray *A;       /* matrix, function handle or native operator parameters */
+    int isHandle;
+    const SpgNativeOp *native;  /* entry of the native operator table, or NULL */
+    void *nativeState;
+    long m, n;              /* rows and columns of one block, in entries */
+    int nCols;              /* number of blocks (MMV columns) */
+    int complexX, complexB; /* storage of x and b */
+} MexOperator;
+
+
+/* ======================================================================
+ *
+ * Conversions between mxArrays and interleaved storage
+ *
+ * ====================================================================== */
+static void toInterleaved(const mxArray *a, double *y, long n, int isComplex)
+{
+    const double *pr = mxGetPr(a), *pi = mxGetPi(a);
+    long i;
+    if (!isComplex)
+    {
+        memcpy(y, pr, n * sizeof(double));
+        return;
+    }
+    for (i = 0; i < n; i++)
+    {
+        y[2*i] = pr[i];
+        y[2*i+1] = pi ? pi[i] : 0.0;
+    }
+}
+
+static mxArray* fromInterleaved(const double *y, long n, int isComplex)
+{
+    mxArray *a = mxCreateDoubleMatrix(n, 1, isComplex ? mxCOMPLEX : mxREAL);
+    double *pr = mxGetPr(a), *pi = mxGetPi(a);
+    long i;
+    if (!isComplex)
+    {
+        memcpy(pr, y, n * sizeof(double));
+        return a;
+    }
+    for (i = 0; i < n; i++)
+    {
+        pr[i] = y[2*i];
+        pi[i] = y[2*i+1];
+    }
+    return a;
+}
+
+
+/* ======================================================================
+ *
+ * Explicit real matrix: y = A x or y = A' x for one block, with
+ * interleaved complex x and y handled component by component (stride s)
+ *
+ * ====================================================================== */
+static void denseApply(const double *A, long m, long n, int mode, const double *x, double *y, int s)
+{
+    long i, j;
+    int c;
+    if (mode == 1)
+    {
+        /* row strips, each thread runs down the columns of its strip */
+#pragma omp parallel private(i, j, c)
+        {
+            long i0, i1;
+#ifdef _OPENMP
+            int t = omp_get_thread_num(), nt = omp_get_num_threads();
+#else
+            int t = 0, nt = 1;
+#endif
+            i0 = (m * t) / nt;
+            i1 = (m * (t + 1)) / nt;
+            for (i = i0; i < i1; i++)
+                for (c = 0; c < s; c++)
+                    y[s*i+c] = 0.0;
+            for (j = 0; j < n; j++)
+            {
+                const double *a = A + j * m;
+                for (c = 0; c < s; c++)
+                {
+                    double xj = x[s*j+c];
+                    if (xj != 0.0)
+                        for (i = i0; i < i1; i++)
+                            y[s*i+c] += a[i] * xj;
+                }
+            }
+        }
+    }
+    else
+    {
+#pragma omp parallel for private(i, c)
+        for (j = 0; j < n; j++)
+        {
+            const double *a = A + j * m;
+            for (c = 0; c < s; c++)
+            {
+                double v = 0.0;
+                for (i = 0; i < m; i++)
+                    v += a[i] * x[s*i+c];
+                y[s*j+c] = v;
+            }
+        }
+    }
+}
+
+static void sparseApply(const mxArray *A, long m, long n, int mode, const double *x, double *y, int s)
+{
+    const double *pr = mxGetPr(A);
+    const mwIndex *ir = mxGetIr(A), *jc = mxGetJc(A);
+    long j;
+    mwIndex k;
+    int c;
+    if (mode == 1)
+    {
+        memset(y, 0, s * m * sizeof(double));
+        for (j = 0; j < n; j++)
+            for (c = 0; c < s; c++)
+            {
+                double xj = x[s*j+c];
+                if (xj != 0.0)
+                    for (k = jc[j]; k < jc[j+1]; k++)
+                        y[s*ir[k]+c] += pr[k] * xj;
+            }
+    }
+    else
+    {
+#pragma omp parallel for private(k, c)
+        for (j = 0; j < n; j++)
+            for (c = 0; c < s; c++)
+            {
+                double v = 0.0;
+                for (k = jc[j]; k < jc[j+1]; k++)
+                    v += pr[k] * x[s*ir[k]+c];
+                y[s*j+c] = v;
+            }
+    }
+}
+
+
+/* ======================================================================
+ *
+ * Function handle: y = A(x, mode) for one block through MATLAB
+ *
+ * ====================================================================== */
+static int handleApply(MexOperator *op, int mode, const double *x, double *y)
+{
+    mxArray *rhs[3], *lhs[1], *err;
+    long nIn = (mode == 1) ? op->n : op->m;
+    long nOut = (mode == 1) ? op->m : op->n;
+    int cIn = (mode == 1) ? op->complexX : op->complexB;
+    int cOut = (mode == 1) ? op->complexB : op->complexX;
+
+    rhs[0] = (mxArray *)op->A;
+    rhs[1] = fromInterleaved(x, nIn, cIn);
+    rhs[2] = mxCreateDoubleScalar(mode);
+    err = mexCallMATLABWithTrap(1, lhs, 3, rhs, "feval");
+    mxDestroyArray(rhs[1]);
+    mxDestroyArray(rhs[2]);
+    if (err)
+    {
+        char msg[1024] = "A(x,mode) raised an error.";
+        mxArray *message = mxGetProperty(err, 0, "message");
+        if (message)
+        {
+            mxGetString(message, msg, sizeof(msg));
+            mxDestroyArray(message);
+        }
+        mxDestroyArray(err);
+        mexPrintf("%s\n", msg);
+        return 1;
+    }
+    if ((long)mxGetNumberOfElements(lhs[0]) != nOut || !mxIsDouble(lhs[0]) || mxIsSparse(lhs[0]))
+    {
+        mexPrintf("A(x,%d) returned %d elements of an unexpected type, expected %ld doubles.\n", mode,
+                  (int)mxGetNumberOfElements(lhs[0]), nOut);
+        mxDestroyArray(lhs[0]);
+        return 1;
+    }
+    if (!cOut && mxIsComplex(lhs[0]))
+    {
+        mexPrintf("A(x,%d) is complex: pass a complex b (and x0) to spgl1C.\n", mode);
+        mxDestroyArray(lhs[0]);
+        return 1;
+    }
+    toInterleaved(lhs[0], y, nOut, cOut);
+    mxDestroyArray(lhs[0]);
+    return 0;
+}
+
+
+/* ====================================================================== */
+static int mexOperatorApply(void *data, int mode, const double *x, double *y)
+{
+    MexOperator *op = (MexOperator *)data;
+    long nIn = (mode == 1) ? op->n : op->m, nOut = (mode == 1) ? op->m : op->n;
+    long strideIn = nIn * ((mode == 1) ? 1 + op->complexX : 1 + op->complexB);
+    long strideOut = nOut * ((mode == 1) ? 1 + op->complexB : 1 + op->complexX);
+    int k;
+
+    for (k = 0; k < op->nCols; k++)
+    {
+        const double *xk = x + k * strideIn;
+        double *yk = y + k * strideOut;
+        if (op->native)
+        {
+            if (op->native->apply(op->nativeState, mode, xk, yk))
+                return 1;
+        }
+        else if (op->isHandle)
+        {
+            if (handleApply(op, mode, xk, yk))
+                return 1;
+        }
+        else if (op->complexX == op->complexB)
+        {
+            /* real A: the same product on every component */
+            if (mxIsSparse(op->A))
+                sparseApply(op->A, op->m, op->n, mode, xk, yk, 1 + op->complexX);
+            else
+                denseApply(mxGetPr(op->A), op->m, op->n, mode, xk, yk, 1 + op->complexX);
+        }
+        else
+            return 1;
+    }
+    return 0;
+}
+
+
+/* ====================================================================== */
+static double getOption(const mxArray *options, const char *name, double def)
+{
+    mxArray *f = options ? mxGetField(options, 0, name) : NULL;
+    if (f == NULL || mxIsEmpty(f) || !mxIsNumeric(f))
+        return def;
+    return mxGetScalar(f);
+}
+
+static void mexPrint(const char *fmt, ...)
+{
+    char buf[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    mexPrintf("%s", buf);
+}
+
+
+/* the gateway routine */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    /* begin of declaration */
+    MexOperator op;
+    SpgOperator A;
+    SpgNorm nrm;
+    SpgOptions opts;
+    SpgInfo info;
+    const mxArray *weightsIn;
+    double *b, *x, *r, *g, tau, sigma, *weights = NULL;
+    int *groups = NULL, singleTau, err;
+    long nEntries, mEntries, i;
+    const char *infoFields[] = {"tau", "rNorm", "rGap", "gNorm", "stat", "iter", "nProdA", "nProdAt", "nNewton",
+                                "nLineTot", "timeProject", "timeMatProd", "timeTotal", "xNorm1", "rNorm2", "lambda"};
+    /* end of declaration */
+
+    if (nrhs < 10)
+    {
+        mexErrMsgTxt("Operator, data, tau, sigma, initial guess, mode, options, groups, columns and complexity should be all provided!");
+    }
+    if (!mxIsClass(A_IN, "function_handle") && !mxIsStruct(A_IN) && (!mxIsDouble(A_IN) || mxIsComplex(A_IN)))
+    {
+        mexErrMsgTxt("A should be a real double matrix, a native operator or a function handle!");
+    }
+
+    op.A = A_IN;
+    op.isHandle = mxIsClass(A_IN, "function_handle");
+    op.native = NULL;
+    op.nativeState = NULL;
+    op.nCols = (int)mxGetScalar(NCOLS_IN);
+    op.complexX = (int)mxGetScalar(COMPLEXX_IN);
+    op.complexB = mxIsComplex(B_IN) || (!op.isHandle && op.complexX);
+    nEntries = mxGetNumberOfElements(X0_IN);
+    mEntries = mxGetNumberOfElements(B_IN);
+    op.n = nEntries / op.nCols;
+    op.m = mEntries / op.nCols;
+    if (mxIsStruct(A_IN))
+    {
+        /* native operator, selected by name */
+        const mxArray *nameIn = mxGetField(A_IN, 0, "name");
+        const char *msg = NULL;
+        char name[64];
+        if (nameIn == NULL || !mxIsChar(nameIn) || mxGetString(nameIn, name, sizeof(name)))
+        {
+            mexErrMsgTxt("A native operator should have a field name!");
+        }
+        op.native = spgFindNativeOp(name);
+        if (op.native == NULL)
+        {
+            mexPrintf("Native operators: %s\n", spgNativeOpNames());
+            mexErrMsgTxt("Unknown native operator!");
+        }
+        op.complexB = mxIsComplex(B_IN);
+        op.nativeState = op.native->create(A_IN, &op.m, &op.n, &op.complexX, &op.complexB, &msg);
+        if (op.nativeState == NULL)
+        {
+            mexErrMsgTxt(msg ? msg : "The native operator could not be created!");
+        }
+        if (nEntries == 0)
+            nEntries = op.n * op.nCols;
+        if (op.m * op.nCols != mEntries || op.n * op.nCols != nEntries)
+        {
+            op.native->destroy(op.nativeState);
+            mexErrMsgTxt("The size of the native operator does not match b and x0!");
+        }
+    }
+    else if (!op.isHandle && ((long)mxGetM(A_IN) != op.m || (long)mxGetN(A_IN) != op.n))
+    {
+        mexErrMsgTxt("The size of A does not match b and x0!");
+    }
+
+    A.m = mEntries * (1 + op.complexB);
+    A.n = nEntries * (1 + op.complexX);
+    A.isComplex = op.complexB;
+    A.data = &op;
+    A.apply = mexOperatorApply;
+
+    /* norm */
+    weightsIn = mxGetField(OPTIONS_IN, 0, "weights");
+    nrm.isComplex = op.complexX;
+    nrm.nEntries = nEntries;
+    nrm.weights = NULL;
+    nrm.weight = 1.0;
+    nrm.groups = NULL;
+    nrm.nGroups = 0;
+    if (mxIsEmpty(GROUPS_IN) && op.nCols > 1)
+    {
+        /* MMV: the rows of X = [x_1 ... x_nCols] are the groups */
+        nrm.type = SPG_NORM_L12;
+        nrm.nGroups = op.n;
+    }
+    else if (mxIsEmpty(GROUPS_IN))
+        nrm.type = SPG_NORM_L1;
+    else
+    {
+        const double *pg = mxGetPr(GROUPS_IN);
+        nrm.type = SPG_NORM_GROUP;
+        groups = (int *)mxMalloc(nEntries * sizeof(int));
+        for (i = 0; i < nEntries; i++)
+        {
+            groups[i] = (int)pg[i] - 1;
+            if (groups[i] + 1 > nrm.nGroups)
+                nrm.nGroups = groups[i] + 1;
+        }
+        nrm.groups = groups;
+    }
+    if (weightsIn && mxGetNumberOfElements(weightsIn) > 1)
+    {
+        long nw = (nrm.type == SPG_NORM_L1) ? nEntries : nrm.nGroups;
+        if ((long)mxGetNumberOfElements(weightsIn) != nw)
+        {
+            if (op.native)
+                op.native->destroy(op.nativeState);
+            mexErrMsgTxt("options.weights should have one entry per variable (L1) or per group!");
+        }
+        weights = (double *)mxMalloc(nw * sizeof(double));
+        for (i = 0; i < nw; i++)
+            weights[i] = fabs(mxGetPr(weightsIn)[i]);
+        nrm.weights = weights;
+    }
+    else if (weightsIn && mxGetNumberOfElements(weightsIn) == 1)
+        nrm.weight = fabs(mxGetScalar(weightsIn));
+
+    /* options, same defaults as spgl1.m */
+    spgDefaultOptions(&opts, mEntries);
+    opts.verbosity = (int)getOption(OPTIONS_IN, "verbosity", opts.verbosity);
+    opts.iterations = (int)fmin(getOption(OPTIONS_IN, "iterations", opts.iterations), 2147483647.0);
+    opts.nPrevVals = (int)getOption(OPTIONS_IN, "nPrevVals", opts.nPrevVals);
+    opts.bpTol = getOption(OPTIONS_IN, "bpTol", opts.bpTol);
+    opts.lsTol = getOption(OPTIONS_IN, "lsTol", opts.lsTol);
+    opts.optTol = getOption(OPTIONS_IN, "optTol", opts.optTol);
+    opts.decTol = getOption(OPTIONS_IN, "decTol", opts.decTol);
+    opts.stepMin = getOption(OPTIONS_IN, "stepMin", opts.stepMin);
+    opts.stepMax = getOption(OPTIONS_IN, "stepMax", opts.stepMax);
+    opts.activeSetIt = getOption(OPTIONS_IN, "activeSetIt", opts.activeSetIt);
+    opts.maxMatvec = getOption(OPTIONS_IN, "maxMatvec", opts.maxMatvec);
+
+    tau = mxGetScalar(TAU_IN);
+    sigma = mxGetScalar(SIGMA_IN);
+    singleTau = (int)mxGetScalar(SINGLETAU_IN);
+
+    /* interleaved copies of b and x0, r and g */
+    b = (double *)mxMalloc(A.m * sizeof(double));
+    r = (double *)mxMalloc(A.m * sizeof(double));
+    x = (double *)mxMalloc(A.n * sizeof(double));
+    g = (double *)mxMalloc(A.n * sizeof(double));
+    toInterleaved(B_IN, b, mEntries, op.complexB);
+    if (mxIsEmpty(X0_IN))
+        memset(x, 0, A.n * sizeof(double));
+    else
+        toInterleaved(X0_IN, x, nEntries, op.complexX);
+
+    err = spgSolve(&A, &nrm, b, tau, sigma, singleTau, x, r, g, &opts, &info, mexPrint);
+    if (op.native)
+        op.native->destroy(op.nativeState);
+    if (err == SPG_ERR_MEMORY)
+    {
+        mexErrMsgTxt("Out of memory in spgl1C!");
+    }
+    if (err == SPG_ERR_OPERATOR)
+    {
+        spgFreeInfo(&info);
+        mexErrMsgTxt("Evaluation of the operator failed!");
+    }
+
+    X_OUT = fromInterleaved(x, nEntries, op.complexX);
+    R_OUT = fromInterleaved(r, mEntries, op.complexB);
+    G_OUT = fromInterleaved(g, nEntries, op.complexX);
+
+    INFO_OUT = mxCreateStructMatrix(1, 1, 16, infoFields);
+    mxSetField(INFO_OUT, 0, "tau", mxCreateDoubleScalar(info.tau));
+    mxSetField(INFO_OUT, 0, "rNorm", mxCreateDoubleScalar(info.rNorm));
+    mxSetField(INFO_OUT, 0, "rGap", mxCreateDoubleScalar(info.rGap));
+    mxSetField(INFO_OUT, 0, "gNorm", mxCreateDoubleScalar(info.gNorm));
+    mxSetField(INFO_OUT, 0, "stat", mxCreateDoubleScalar(info.stat));
+    mxSetField(INFO_OUT, 0, "iter", mxCreateDoubleScalar(info.iter));
+    mxSetField(INFO_OUT, 0, "nProdA", mxCreateDoubleScalar(info.nProdA));
+    mxSetField(INFO_OUT, 0, "nProdAt", mxCreateDoubleScalar(info.nProdAt));
+    mxSetField(INFO_OUT, 0, "nNewton", mxCreateDoubleScalar(info.nNewton));
+    mxSetField(INFO_OUT, 0, "nLineTot", mxCreateDoubleScalar(info.nLineTot));
+    mxSetField(INFO_OUT, 0, "timeProject", mxCreateDoubleScalar(info.timeProject));
+    mxSetField(INFO_OUT, 0, "timeMatProd", mxCreateDoubleScalar(info.timeMatProd));
+    mxSetField(INFO_OUT, 0, "timeTotal", mxCreateDoubleScalar(info.timeTotal));
+    mxSetField(INFO_OUT, 0, "xNorm1", fromInterleaved(info.xNorm1, info.iter, 0));
+    mxSetField(INFO_OUT, 0, "rNorm2", fromInterleaved(info.rNorm2, info.iter, 0));
+    mxSetField(INFO_OUT, 0, "lambda", fromInterleaved(info.lambda, info.iter, 0));
+
+    spgFreeInfo(&info);
+    mxFree(b);
+    mxFree(r);
+    mxFree(x);
+    mxFree(g);
+    if (groups)
+        mxFree(groups);
+    if (weights)
+        mxFree(weights);
+}
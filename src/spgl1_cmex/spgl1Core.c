@@ -0,0 +1,928 @@
+/* ======================================================================
+ *
+ * spgl1Core.c
+ *
+ * Native SPGL1 solver, see spgl1Core.h. The iteration, the exit tests,
+ * the Newton update of tau and both line searches are those of spgl1.m;
+ * every vector is allocated once and the element-wise updates are fused
+ * into single passes (multithreaded with OpenMP for long vectors).
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ * ====================================================================== */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "oneProjectorCore.h"
+#include "groupProjectorCore.h"
+#include "spgl1Core.h"
+
+/* vectors shorter than this are updated on a single thread */
+#define SPG_PARALLEL_MIN        (1 << 15)
+
+#define SPG_LINE_CONVERGED      0
+#define SPG_LINE_ITERATIONS     1
+#define SPG_LINE_NODESCENT      2
+
+/* solver state shared by the helpers below */
+typedef struct
+{
+    const SpgOperator *A;
+    const SpgNorm *nrm;
+    const double *b;
+    long m, n;              /* lengths of b and x in doubles */
+    double maxMatvec;
+    int nProdA, nProdAt;
+    double timeProject, timeMatProd;
+    double *work;           /* projection / norm workspace */
+} SpgState;
+
+
+/* ====================================================================== */
+static double spgTime(void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+/* ======================================================================
+ *
+ * Norms and projection
+ *
+ * ====================================================================== */
+
+/* |x_i| for every entry */
+static void spgEntryAbs(const SpgNorm *nrm, const double *x, double *a)
+{
+    long i, n = nrm->nEntries;
+    if (nrm->isComplex)
+    {
+#pragma omp parallel for if (n > SPG_PARALLEL_MIN)
+        for (i = 0; i < n; i++)
+            a[i] = sqrt(x[2*i] * x[2*i] + x[2*i+1] * x[2*i+1]);
+    }
+    else
+    {
+#pragma omp parallel for if (n > SPG_PARALLEL_MIN)
+        for (i = 0; i < n; i++)
+            a[i] = fabs(x[i]);
+    }
+}
+
+/* ||x_{G_k}||_2 for every group */
+static void spgGroupAbs(const SpgNorm *nrm, const double *x, double *a)
+{
+    long i, n = nrm->nEntries;
+    int k;
+    memset(a, 0, nrm->nGroups * sizeof(double));
+    for (i = 0; i < n; i++)
+    {
+        k = nrm->groups[i];
+        a[k] += nrm->isComplex ? x[2*i] * x[2*i] + x[2*i+1] * x[2*i+1] : x[i] * x[i];
+    }
+    for (i = 0; i < nrm->nGroups; i++)
+        a[i] = sqrt(a[i]);
+}
+
+/* magnitudes the norm is taken of, returns their number */
+static long spgMagnitudes(const SpgNorm *nrm, const double *x, double *a)
+{
+    if (nrm->type == SPG_NORM_L12)
+    {
+        groupNormsRows(x, nrm->isComplex ? x + 1 : NULL, nrm->isComplex ? 2 : 1,
+                       nrm->nGroups, nrm->nEntries / nrm->nGroups, a);
+        return nrm->nGroups;
+    }
+    if (nrm->type == SPG_NORM_GROUP)
+    {
+        spgGroupAbs(nrm, x, a);
+        return nrm->nGroups;
+    }
+    spgEntryAbs(nrm, x, a);
+    return nrm->nEntries;
+}
+
+/* ====================================================================== */
+double spgPrimalNorm(const SpgNorm *nrm, const double *x, double *work)
+{
+    long i, n = spgMagnitudes(nrm, x, work);
+    double p = 0.0;
+    if (nrm->weights)
+    {
+#pragma omp parallel for reduction(+:p) if (n > SPG_PARALLEL_MIN)
+        for (i = 0; i < n; i++)
+            p += nrm->weights[i] * work[i];
+    }
+    else
+    {
+#pragma omp parallel for reduction(+:p) if (n > SPG_PARALLEL_MIN)
+        for (i = 0; i < n; i++)
+            p += work[i];
+        p *= nrm->weight;
+    }
+    return p;
+}
+
+/* ====================================================================== */
+double spgDualNorm(const SpgNorm *nrm, const double *x, double *work)
+{
+    long i, n = spgMagnitudes(nrm, x, work);
+    double d = 0.0;
+    if (nrm->weights)
+    {
+#pragma omp parallel for reduction(max:d) if (n > SPG_PARALLEL_MIN)
+        for (i = 0; i < n; i++)
+            if (work[i] / nrm->weights[i] > d)
+                d = work[i] / nrm->weights[i];
+    }
+    else
+    {
+#pragma omp parallel for reduction(max:d) if (n > SPG_PARALLEL_MIN)
+        for (i = 0; i < n; i++)
+            if (work[i] > d)
+                d = work[i];
+        d /= nrm->weight;
+    }
+    return d;
+}
+
+/* ======================================================================
+ *
+ * spgProject
+ * Same as NormL1_project.m / NormGroupL2_project.m: project the
+ * magnitudes onto the weighted simplex (oneProjector), then rescale.
+ *
+ * ====================================================================== */
+void spgProject(const SpgNorm *nrm, double *x, double tau, double *work)
+{
+    long i, n, nEntries = nrm->nEntries;
+    double *a = work, *c, *d;
+
+    if (nrm->type == SPG_NORM_L12)
+    {
+        projectL12(x, nrm->isComplex ? x + 1 : NULL, nrm->isComplex ? 2 : 1, nrm->nGroups,
+                   nEntries / nrm->nGroups, nrm->weights, nrm->weight, tau, work);
+        return;
+    }
+
+    n = spgMagnitudes(nrm, x, a);
+    c = a + n;
+    d = c + n;
+
+    /* c = oneProjector(a, weights, tau), projectI/D expect c = a on entry */
+    memcpy(c, a, n * sizeof(double));
+    if (nrm->weights)
+    {
+        memcpy(d, nrm->weights, n * sizeof(double));
+        projectD(c, a, d, (double *)nrm->weights, tau, (int)n);
+    }
+    else if (nrm->weight > 0.0)
+        projectI(c, a, tau / nrm->weight, (int)n);
+
+    /* scale factors c / a, zero where a is below eps */
+#pragma omp parallel for if (n > SPG_PARALLEL_MIN)
+    for (i = 0; i < n; i++)
+        c[i] = (a[i] < DBL_EPSILON) ? 0.0 : c[i] / a[i];
+
+    if (nrm->type == SPG_NORM_GROUP)
+    {
+        const int *grp = nrm->groups;
+        if (nrm->isComplex)
+        {
+#pragma omp parallel for if (nEntries > SPG_PARALLEL_MIN)
+            for (i = 0; i < nEntries; i++)
+            {
+                x[2*i] *= c[grp[i]];
+                x[2*i+1] *= c[grp[i]];
+            }
+        }
+        else
+        {
+#pragma omp parallel for if (nEntries > SPG_PARALLEL_MIN)
+            for (i = 0; i < nEntries; i++)
+                x[i] *= c[grp[i]];
+        }
+    }
+    else if (nrm->isComplex)
+    {
+#pragma omp parallel for if (nEntries > SPG_PARALLEL_MIN)
+        for (i = 0; i < nEntries; i++)
+        {
+            x[2*i] *= c[i];
+            x[2*i+1] *= c[i];
+        }
+    }
+    else
+    {
+        /* real case of oneProjector.m: sign(x) .* projected |x| */
+#pragma omp parallel for if (nEntries > SPG_PARALLEL_MIN)
+        for (i = 0; i < nEntries; i++)
+            x[i] = (a[i] < DBL_EPSILON) ? 0.0 : x[i] * c[i];
+    }
+}
+
+
+/* ======================================================================
+ *
+ * Fused vector kernels
+ *
+ * ====================================================================== */
+
+/* real(u'*v) */
+static double spgDot(const double *u, const double *v, long n)
+{
+    long i;
+    double s = 0.0;
+#pragma omp parallel for reduction(+:s) if (n > SPG_PARALLEL_MIN)
+    for (i = 0; i < n; i++)
+        s += u[i] * v[i];
+    return s;
+}
+
+/* y = b - y, returns ||y||^2 / 2 */
+static double spgResidual(double *y, const double *b, long m)
+{
+    long i;
+    double f = 0.0;
+#pragma omp parallel for reduction(+:f) if (m > SPG_PARALLEL_MIN)
+    for (i = 0; i < m; i++)
+    {
+        y[i] = b[i] - y[i];
+        f += y[i] * y[i];
+    }
+    return 0.5 * f;
+}
+
+/* y = -y */
+static void spgNegate(double *y, long n)
+{
+    long i;
+#pragma omp parallel for if (n > SPG_PARALLEL_MIN)
+    for (i = 0; i < n; i++)
+        y[i] = -y[i];
+}
+
+/* z = x + alpha * y */
+static void spgAxpy(double *z, const double *x, double alpha, const double *y, long n)
+{
+    long i;
+#pragma omp parallel for if (n > SPG_PARALLEL_MIN)
+    for (i = 0; i < n; i++)
+        z[i] = x[i] + alpha * y[i];
+}
+
+/* y = y - x, returns the infinity norm of y over the entries */
+static double spgDiffInf(double *y, const double *x, long n, int isComplex)
+{
+    long i;
+    double e = 0.0;
+    if (isComplex)
+    {
+#pragma omp parallel for reduction(max:e) if (n > SPG_PARALLEL_MIN)
+        for (i = 0; i < n; i += 2)
+        {
+            double a;
+            y[i] -= x[i];
+            y[i+1] -= x[i+1];
+            a = sqrt(y[i] * y[i] + y[i+1] * y[i+1]);
+            if (a > e)
+                e = a;
+        }
+    }
+    else
+    {
+#pragma omp parallel for reduction(max:e) if (n > SPG_PARALLEL_MIN)
+        for (i = 0; i < n; i++)
+        {
+            y[i] -= x[i];
+            if (fabs(y[i]) > e)
+                e = fabs(y[i]);
+        }
+    }
+    return e;
+}
+
+/* real((x - xOld)'*g) and ||x - xOld||^2 */
+static void spgStepStats(const double *x, const double *xOld, const double *g, long n, double *gts, double *sts)
+{
+    long i;
+    double a = 0.0, c = 0.0;
+#pragma omp parallel for reduction(+:a, c) if (n > SPG_PARALLEL_MIN)
+    for (i = 0; i < n; i++)
+    {
+        double s = x[i] - xOld[i];
+        a += g[i] * s;
+        c += s * s;
+    }
+    *gts = a;
+    *sts = c;
+}
+
+/* s = x - xOld, y = g - gOld, returns s'*s and s'*y */
+static void spgBBStats(const double *x, const double *xOld, const double *g, const double *gOld, long n,
+                       double *sts, double *sty)
+{
+    long i;
+    double a = 0.0, c = 0.0;
+#pragma omp parallel for reduction(+:a, c) if (n > SPG_PARALLEL_MIN)
+    for (i = 0; i < n; i++)
+    {
+        double s = x[i] - xOld[i];
+        a += s * s;
+        c += s * (g[i] - gOld[i]);
+    }
+    *sts = a;
+    *sty = c;
+}
+
+
+/* ======================================================================
+ *
+ * Operator and projection wrappers (counting and timing as in spgl1.m)
+ *
+ * ====================================================================== */
+
+/* returns 0, SPG_EXIT_MATVEC_LIMIT when the budget is used up, or SPG_ERR_OPERATOR */
+static int spgAprod(SpgState *S, int mode, const double *x, double *y)
+{
+    double tStart;
+    int err;
+    if (S->nProdA + S->nProdAt >= S->maxMatvec)
+        return SPG_EXIT_MATVEC_LIMIT;
+    tStart = spgTime();
+    if (mode == 1)
+        S->nProdA++;
+    else
+        S->nProdAt++;
+    err = S->A->apply(S->A->data, mode, x, y);
+    S->timeMatProd += spgTime() - tStart;
+    return err ? SPG_ERR_OPERATOR : 0;
+}
+
+static void spgProjectTimed(SpgState *S, double *x, double tau)
+{
+    double tStart = spgTime();
+    spgProject(S->nrm, x, tau, S->work);
+    S->timeProject += spgTime() - tStart;
+}
+
+/* r = b - A x, returns ||r||^2 / 2 in *f */
+static int spgResidualOf(SpgState *S, const double *x, double *r, double *f)
+{
+    int err = spgAprod(S, 1, x, r);
+    if (err)
+        return err;
+    *f = spgResidual(r, S->b, S->m);
+    return 0;
+}
+
+
+/* ======================================================================
+ *
+ * spgLineCurvy
+ * Projected backtracking along the curve P(x - step * scale * g);
+ * g is the scaled gradient gStep * g of spgl1.m, passed as gScale * g.
+ *
+ * ====================================================================== */
+static int spgLineCurvy(SpgState *S, const double *x, const double *g, double gScale, double fMax, double tau,
+                        double *xNew, double *rNew, double *fNew, int *nLine, double *stepOut, int *lnErr)
+{
+    const double gamma = 1e-4;
+    const int maxIts = 10;
+    double step = 1.0, sNorm = 0.0, sNormOld, scale = 1.0, gts, sts, gNorm = -1.0;
+    double sqrtN = sqrt((double)S->nrm->nEntries);
+    int nSafe = 0, iter = 0, err;
+
+    while (1)
+    {
+        spgAxpy(xNew, x, -step * scale * gScale, g, S->n);
+        spgProjectTimed(S, xNew, tau);
+        if ((err = spgResidualOf(S, xNew, rNew, fNew)))
+            return err;
+        spgStepStats(xNew, x, g, S->n, &gts, &sts);
+        gts *= scale * gScale;
+        if (gts >= 0)
+        {
+            *lnErr = SPG_LINE_NODESCENT;
+            break;
+        }
+
+        if (*fNew < fMax + gamma * step * gts)
+        {
+            *lnErr = SPG_LINE_CONVERGED;
+            break;
+        }
+        else if (iter >= maxIts)
+        {
+            *lnErr = SPG_LINE_ITERATIONS;
+            break;
+        }
+
+        iter++;
+        step /= 2;
+
+        /* safeguard: rescale when the projected step stops changing */
+        sNormOld = sNorm;
+        sNorm = sqrt(sts) / sqrtN;
+        if (fabs(sNorm - sNormOld) <= 1e-6 * sNorm)
+        {
+            if (gNorm < 0)
+                gNorm = gScale * sqrt(spgDot(g, g, S->n)) / sqrtN;
+            scale = sNorm / gNorm / ldexp(1.0, nSafe);
+            nSafe++;
+        }
+    }
+    *nLine = iter;
+    *stepOut = step;
+    return 0;
+}
+
+
+/* ======================================================================
+ *
+ * spgLine
+ * Nonmonotone backtracking along the fixed direction d.
+ *
+ * ====================================================================== */
+static int spgLine(SpgState *S, double f, const double *x, const double *d, double gtd, double fMax,
+                   double *xNew, double *rNew, double *fNew, int *nLine, int *lnErr)
+{
+    const double gamma = 1e-4;
+    const int maxIts = 10;
+    double step = 1.0, tmp;
+    int iter = 0, err;
+
+    gtd = -fabs(gtd);
+    while (1)
+    {
+        spgAxpy(xNew, x, step, d, S->n);
+        if ((err = spgResidualOf(S, xNew, rNew, fNew)))
+            return err;
+
+        if (*fNew < fMax + gamma * step * gtd)
+        {
+            *lnErr = SPG_LINE_CONVERGED;
+            break;
+        }
+        else if (iter >= maxIts)
+        {
+            *lnErr = SPG_LINE_ITERATIONS;
+            break;
+        }
+
+        iter++;
+        if (step <= 0.1)
+            step /= 2;
+        else
+        {
+            tmp = (-gtd * step * step) / (2 * (*fNew - f - step * gtd));
+            if (tmp < 0.1 || tmp > 0.9 * step || tmp != tmp)
+                tmp = step / 2;
+            step = tmp;
+        }
+    }
+    *nLine = iter;
+    return 0;
+}
+
+
+/* ======================================================================
+ *
+ * spgActiveVars
+ * Active-set bookkeeping of spgl1.m (activeVars): entries at the bound
+ * with the gradient at the dual norm. Comparisons use real parts, as
+ * MATLAB does for complex x.
+ *
+ * ====================================================================== */
+static void spgActiveVars(SpgState *S, const double *x, const double *g, double optTol, unsigned char *nnzIdx,
+                          int first, long *nnzX, long *nnzG, long *nnzDiff)
+{
+    const SpgNorm *nrm = S->nrm;
+    long i, n = nrm->nEntries, cX = 0, cG = 0, cD = 0;
+    int stride = nrm->isComplex ? 2 : 1;
+    double xTol = (10 * optTol < 0.1) ? 10 * optTol : 0.1;
+    double gTol = xTol;
+    double gNorm = spgDualNorm(nrm, g, S->work);
+
+#pragma omp parallel for reduction(+:cX, cG, cD) if (n > SPG_PARALLEL_MIN)
+    for (i = 0; i < n; i++)
+    {
+        double xr = x[stride*i], gr = g[stride*i];
+        double xa = (stride == 2) ? sqrt(xr * xr + x[2*i+1] * x[2*i+1]) : fabs(xr);
+        unsigned char active = (xr > xTol && gNorm + gr < gTol) || (xr < -xTol && gNorm - gr < gTol);
+        if (xa >= xTol)
+            cX++;
+        cG += active;
+        cD += (active != nnzIdx[i]);
+        nnzIdx[i] = active;
+    }
+    *nnzX = cX;
+    *nnzG = cG;
+    *nnzDiff = first ? -1 : cD;
+}
+
+
+/* ====================================================================== */
+void spgDefaultOptions(SpgOptions *opts, long m)
+{
+    opts->verbosity = 2;
+    opts->iterations = (int)(10 * m);
+    opts->nPrevVals = 3;
+    opts->bpTol = 1e-6;
+    opts->lsTol = 1e-6;
+    opts->optTol = 1e-4;
+    opts->decTol = 1e-4;
+    opts->stepMin = 1e-16;
+    opts->stepMax = 1e+5;
+    opts->activeSetIt = HUGE_VAL;
+    opts->maxMatvec = HUGE_VAL;
+}
+
+/* ====================================================================== */
+void spgFreeInfo(SpgInfo *info)
+{
+    free(info->xNorm1);
+    info->xNorm1 = info->rNorm2 = info->lambda = NULL;
+}
+
+/* append one entry to the histories, growing them geometrically */
+static int spgRecord(SpgInfo *info, long *cap, int iter, double xNorm1, double rNorm2, double lambda)
+{
+    if (iter >= *cap)
+    {
+        long newCap = (*cap > 0) ? 2 * (*cap) : 1024;
+        double *h = (double *)malloc(3 * newCap * sizeof(double));
+        if (!h)
+            return SPG_ERR_MEMORY;
+        if (info->xNorm1)
+        {
+            memcpy(h, info->xNorm1, iter * sizeof(double));
+            memcpy(h + newCap, info->rNorm2, iter * sizeof(double));
+            memcpy(h + 2 * newCap, info->lambda, iter * sizeof(double));
+            free(info->xNorm1);
+        }
+        info->xNorm1 = h;
+        info->rNorm2 = h + newCap;
+        info->lambda = h + 2 * newCap;
+        *cap = newCap;
+    }
+    info->xNorm1[iter] = xNorm1;
+    info->rNorm2[iter] = rNorm2;
+    info->lambda[iter] = lambda;
+    return 0;
+}
+
+#define SPG_SWAP(p, q) do { double *t_ = (p); (p) = (q); (q) = t_; } while (0)
+#define SPG_PRINT(...) do { if (print && opts->verbosity > 0) print(__VA_ARGS__); } while (0)
+
+/* ======================================================================
+ *
+ * spgSolve
+ *
+ * ====================================================================== */
+int spgSolve(const SpgOperator *A, const SpgNorm *nrm, const double *b, double tau, double sigma, int singleTau,
+             double *xOut, double *rOut, double *gOut, const SpgOptions *opts, SpgInfo *info, SpgPrint print)
+{
+    /* begin of declaration */
+    SpgState S;
+    long m = A->m, n = A->n, nWork, cap = 0, nnzX = 0, nnzG = 0, nnzDiff;
+    double *mem, *x, *xOld, *xBest, *dx, *g, *gOld, *r, *rOld, *lastFv;
+    unsigned char *nnzIdx;
+    double f, fOld, fBest, fMax, gNorm = 0, rNorm = 0, bNorm, gap, gapIm, rGap = 0;
+    double aError1, aError2, rError1, rError2, dxNorm, gStep, stepG = 1.0, tauOld, sts, sty, gtd;
+    double stepMax = opts->stepMax, tStart = spgTime();
+    int iter = 0, stat = 0, nNewton = 0, nLine, nLineTot = 0, lnErr = 0, err = 0, k;
+    int maxLineErrors = 10, printTau = 0, testUpdateTau = 0, nnzIter = 0, firstActive = 1;
+    int nPrevVals = (opts->nPrevVals > 0) ? opts->nPrevVals : 1;
+    /* end of declaration */
+
+    memset(info, 0, sizeof(SpgInfo));
+
+    /* workspace: six x-vectors, two b-vectors, the projection scratch */
+    nWork = SPG_NORM_WORK(nrm);
+    mem = (double *)malloc((6 * n + 2 * m + nWork + nPrevVals) * sizeof(double));
+    nnzIdx = (unsigned char *)calloc(nrm->nEntries > 0 ? nrm->nEntries : 1, 1);
+    if (!mem || !nnzIdx)
+    {
+        free(mem);
+        free(nnzIdx);
+        return SPG_ERR_MEMORY;
+    }
+    x = mem;            xOld = x + n;       xBest = xOld + n;
+    dx = xBest + n;     g = dx + n;         gOld = g + n;
+    r = gOld + n;       rOld = r + m;
+    S.work = rOld + m;  lastFv = S.work + nWork;
+
+    S.A = A;
+    S.nrm = nrm;
+    S.b = b;
+    S.m = m;
+    S.n = n;
+    S.maxMatvec = (opts->maxMatvec > 3) ? opts->maxMatvec : 3;
+    S.nProdA = S.nProdAt = 0;
+    S.timeProject = S.timeMatProd = 0.0;
+
+    for (k = 0; k < nPrevVals; k++)
+        lastFv[k] = -HUGE_VAL;
+    bNorm = sqrt(spgDot(b, b, m));
+    memcpy(x, xOut, n * sizeof(double));
+
+    if (bNorm <= sigma)
+    {
+        SPG_PRINT("W: sigma >= ||b||.  Exact solution is x = 0.\n");
+        tau = 0;
+        singleTau = 1;
+    }
+
+    SPG_PRINT("\n %s\n", "================================================================================");
+    SPG_PRINT(" SPGL1  (native)\n");
+    SPG_PRINT(" %s\n", "================================================================================");
+    SPG_PRINT(" %-22s: %8ld %4s", "No. rows", (long)(A->isComplex ? m / 2 : m), "");
+    SPG_PRINT(" %-22s: %8ld\n", "No. columns", nrm->nEntries);
+    SPG_PRINT(" %-22s: %8.2e %4s", "Initial tau", tau, "");
+    SPG_PRINT(" %-22s: %8.2e\n", "Two-norm of b", bNorm);
+    SPG_PRINT(" %-22s: %8.2e %4s", "Optimality tol", opts->optTol, "");
+    if (singleTau)
+        SPG_PRINT(" %-22s: %8.2e\n", "Target one-norm of x", tau);
+    else
+        SPG_PRINT(" %-22s: %8.2e\n", "Target objective", sigma);
+    SPG_PRINT(" %-22s: %8.2e %4s", "Basis pursuit tol", opts->bpTol, "");
+    SPG_PRINT(" %-22s: %8i\n\n", "Maximum iterations", opts->iterations);
+    if (singleTau)
+        SPG_PRINT(" %5s  %13s  %13s  %9s  %6s  %6s  %6s\n", "Iter", "Objective", "Relative Gap", "gNorm", "stepG", "nnzX", "nnzG");
+    else
+        SPG_PRINT(" %5s  %13s  %13s  %9s  %9s  %6s  %6s  %6s  %13s\n", "Iter", "Objective", "Relative Gap", "Rel Error",
+                  "gNorm", "stepG", "nnzX", "nnzG", "tau");
+
+    /* x = project(x,tau), r = b - A x, g = -A'r */
+    spgProjectTimed(&S, x, tau);
+    if ((err = spgResidualOf(&S, x, r, &f)) || (err = spgAprod(&S, 2, r, g)))
+        goto cleanup;
+    spgNegate(g, n);
+
+    lastFv[0] = f;
+    fBest = f;
+    memcpy(xBest, x, n * sizeof(double));
+    fOld = f;
+
+    /* initial spectral step from the projected gradient step */
+    spgAxpy(dx, x, -1.0, g, n);
+    spgProjectTimed(&S, dx, tau);
+    dxNorm = spgDiffInf(dx, x, n, nrm->isComplex);
+    if (dxNorm < 1 / stepMax)
+        gStep = stepMax;
+    else
+        gStep = fmin(stepMax, fmax(opts->stepMin, 1 / dxNorm));
+
+    while (1)
+    {
+        /* test exit conditions */
+        gNorm = spgDualNorm(nrm, g, S.work);
+        rNorm = sqrt(2 * f);
+        gap = spgDot(r, r, m) - spgDot(r, b, m) + tau * gNorm;
+        gapIm = 0.0;
+        if (A->isComplex)
+        {
+            /* imaginary part of r'*(r-b) = -imag(r'*b) */
+            long i;
+            for (i = 0; i < m; i += 2)
+                gapIm -= r[i] * b[i+1] - r[i+1] * b[i];
+        }
+        rGap = sqrt(gap * gap + gapIm * gapIm) / fmax(1, f);
+        aError1 = rNorm - sigma;
+        aError2 = f - sigma * sigma / 2;
+        rError1 = fabs(aError1) / fmax(1, rNorm);
+        rError2 = fabs(aError2) / fmax(1, f);
+
+        spgActiveVars(&S, x, g, opts->optTol, nnzIdx, firstActive, &nnzX, &nnzG, &nnzDiff);
+        if (firstActive || nnzDiff)
+            nnzIter = 0;
+        else
+        {
+            nnzIter++;
+            if (nnzIter >= opts->activeSetIt)
+                stat = SPG_EXIT_ACTIVE_SET;
+        }
+        firstActive = 0;
+
+        if (singleTau)
+        {
+            if (rGap <= opts->optTol || rNorm < opts->optTol * bNorm)
+                stat = SPG_EXIT_OPTIMAL;
+        }
+        else
+        {
+            int testRelChange1, testRelChange2;
+            if (gNorm <= opts->lsTol * rNorm)
+                stat = SPG_EXIT_LEAST_SQUARES;
+
+            if (rGap <= fmax(opts->optTol, rError2) || rError1 <= opts->optTol)
+            {
+                if (rNorm <= sigma)                 stat = SPG_EXIT_SUBOPTIMAL_BP;
+                if (rError1 <= opts->optTol)        stat = SPG_EXIT_ROOT_FOUND;
+                if (rNorm <= opts->bpTol * bNorm)   stat = SPG_EXIT_BPSOL_FOUND;
+            }
+
+            testRelChange1 = (fabs(f - fOld) <= opts->decTol * f);
+            testRelChange2 = (fabs(f - fOld) <= 1e-1 * f * fabs(rNorm - sigma));
+            testUpdateTau = ((testRelChange1 && rNorm > 2 * sigma) || (testRelChange2 && rNorm <= 2 * sigma))
+                            && !stat && !testUpdateTau;
+
+            if (testUpdateTau)
+            {
+                /* Newton step on the Pareto curve */
+                tauOld = tau;
+                tau = fmax(0, tau + (rNorm * aError1) / gNorm);
+                nNewton++;
+                printTau = fabs(tauOld - tau) >= 1e-6 * tau;
+                if (tau < tauOld)
+                    spgProjectTimed(&S, x, tau);
+            }
+        }
+
+        if (!stat && iter >= opts->iterations)
+            stat = SPG_EXIT_ITERATIONS;
+
+        /* print log */
+        if (opts->verbosity >= 2 || singleTau || printTau || iter == 0 || stat)
+        {
+            if (singleTau)
+                SPG_PRINT(" %5i  %13.7e  %13.7e  %9.2e  %6.1f  %6li  %6li\n", iter, rNorm, rGap, gNorm, log10(stepG), nnzX, nnzG);
+            else if (printTau)
+                SPG_PRINT(" %5i  %13.7e  %13.7e  %9.2e  %9.3e  %6.1f  %6li  %6li  %13.7e\n", iter, rNorm, rGap, rError1, gNorm,
+                          log10(stepG), nnzX, nnzG, tau);
+            else
+                SPG_PRINT(" %5i  %13.7e  %13.7e  %9.2e  %9.3e  %6.1f  %6li  %6li\n", iter, rNorm, rGap, rError1, gNorm,
+                          log10(stepG), nnzX, nnzG);
+        }
+        printTau = 0;
+
+        if ((err = spgRecord(info, &cap, iter, spgPrimalNorm(nrm, x, S.work), rNorm, gNorm)))
+            goto cleanup;
+
+        if (stat)
+            break;
+
+        /* iterations begin here */
+        iter++;
+        SPG_SWAP(x, xOld);
+        SPG_SWAP(g, gOld);
+        SPG_SWAP(r, rOld);
+        fOld = f;
+
+        fMax = lastFv[0];
+        for (k = 1; k < nPrevVals; k++)
+            fMax = fmax(fMax, lastFv[k]);
+
+        err = spgLineCurvy(&S, xOld, gOld, gStep, fMax, tau, x, r, &f, &nLine, &stepG, &lnErr);
+        if (!err)
+        {
+            nLineTot += nLine;
+            if (lnErr)
+            {
+                /* projected backtracking failed, retry along the projected direction */
+                spgAxpy(dx, xOld, -gStep, gOld, n);
+                spgProjectTimed(&S, dx, tau);
+                spgDiffInf(dx, xOld, n, nrm->isComplex);
+                gtd = spgDot(gOld, dx, n);
+                err = spgLine(&S, fOld, xOld, dx, gtd, fMax, x, r, &f, &nLine, &lnErr);
+                nLineTot += nLine;
+            }
+        }
+        if (!err && lnErr)
+        {
+            /* both line searches failed: restore the previous iterate */
+            memcpy(x, xOld, n * sizeof(double));
+            memcpy(r, rOld, m * sizeof(double));
+            f = fOld;
+            if (maxLineErrors <= 0)
+                stat = SPG_EXIT_LINE_ERROR;
+            else
+            {
+                stepMax /= 10;
+                SPG_PRINT("W: Linesearch failed with error %i. Damping max BB scaling to %6.1e.\n", lnErr, stepMax);
+                maxLineErrors--;
+            }
+        }
+
+        /* update the gradient and the Barzilai-Borwein scaling */
+        if (!err)
+        {
+            if (!lnErr)
+            {
+                if (!(err = spgAprod(&S, 2, r, g)))
+                {
+                    spgNegate(g, n);
+                    spgBBStats(x, xOld, g, gOld, n, &sts, &sty);
+                    if (sty <= 0)
+                        gStep = stepMax;
+                    else
+                        gStep = fmin(stepMax, fmax(opts->stepMin, sts / sty));
+                }
+            }
+            else
+            {
+                memcpy(g, gOld, n * sizeof(double));
+                gStep = fmin(stepMax, gStep);
+            }
+        }
+
+        if (err == SPG_EXIT_MATVEC_LIMIT)
+        {
+            stat = SPG_EXIT_MATVEC_LIMIT;
+            iter--;
+            SPG_SWAP(x, xOld);
+            SPG_SWAP(g, gOld);
+            SPG_SWAP(r, rOld);
+            f = fOld;
+            err = 0;
+            break;
+        }
+        if (err)
+            goto cleanup;
+
+        if (singleTau || f > sigma * sigma / 2)
+        {
+            lastFv[iter % nPrevVals] = f;
+            if (fBest > f)
+            {
+                fBest = f;
+                memcpy(xBest, x, n * sizeof(double));
+            }
+        }
+    }
+
+    /* restore the best iterate */
+    if (singleTau && f > fBest)
+    {
+        rNorm = sqrt(2 * fBest);
+        SPG_PRINT("\n Restoring best iterate to objective %13.7e\n", rNorm);
+        memcpy(x, xBest, n * sizeof(double));
+        if (!(err = spgResidualOf(&S, x, r, &f)) && !(err = spgAprod(&S, 2, r, g)))
+        {
+            spgNegate(g, n);
+            gNorm = spgDualNorm(nrm, g, S.work);
+            rNorm = sqrt(2 * f);
+        }
+        if (err == SPG_EXIT_MATVEC_LIMIT)
+            err = 0;
+    }
+
+    switch (stat)
+    {
+        case SPG_EXIT_OPTIMAL:          SPG_PRINT("\n EXIT -- Optimal solution found\n"); break;
+        case SPG_EXIT_ITERATIONS:       SPG_PRINT("\n ERROR EXIT -- Too many iterations\n"); break;
+        case SPG_EXIT_ROOT_FOUND:       SPG_PRINT("\n EXIT -- Found a root\n"); break;
+        case SPG_EXIT_BPSOL_FOUND:      SPG_PRINT("\n EXIT -- Found a BP solution\n"); break;
+        case SPG_EXIT_LEAST_SQUARES:    SPG_PRINT("\n EXIT -- Found a least-squares solution\n"); break;
+        case SPG_EXIT_LINE_ERROR:       SPG_PRINT("\n ERROR EXIT -- Linesearch error (%i)\n", lnErr); break;
+        case SPG_EXIT_SUBOPTIMAL_BP:    SPG_PRINT("\n EXIT -- Found a suboptimal BP solution\n"); break;
+        case SPG_EXIT_MATVEC_LIMIT:     SPG_PRINT("\n EXIT -- Maximum matrix-vector operations reached\n"); break;
+        case SPG_EXIT_ACTIVE_SET:       SPG_PRINT("\n EXIT -- Found a possible active set\n"); break;
+    }
+
+    info->timeTotal = spgTime() - tStart;
+    SPG_PRINT("\n %-20s:  %6i %6s %-20s:  %6.1f\n", "Products with A", S.nProdA, "", "Total time   (secs)", info->timeTotal);
+    SPG_PRINT(" %-20s:  %6i %6s %-20s:  %6.1f\n", "Products with A'", S.nProdAt, "", "Project time (secs)", S.timeProject);
+    SPG_PRINT(" %-20s:  %6i %6s %-20s:  %6.1f\n", "Newton iterations", nNewton, "", "Mat-vec time (secs)", S.timeMatProd);
+    SPG_PRINT(" %-20s:  %6i\n\n", "Line search its", nLineTot);
+
+cleanup:
+    memcpy(xOut, x, n * sizeof(double));
+    memcpy(rOut, r, m * sizeof(double));
+    memcpy(gOut, g, n * sizeof(double));
+
+    info->tau = tau;
+    info->rNorm = rNorm;
+    info->rGap = rGap;
+    info->gNorm = gNorm;
+    info->stat = stat;
+    info->iter = iter;
+    info->nProdA = S.nProdA;
+    info->nProdAt = S.nProdAt;
+    info->nNewton = nNewton;
+    info->nLineTot = nLineTot;
+    info->timeProject = S.timeProject;
+    info->timeMatProd = S.timeMatProd;
+    if (!info->timeTotal)
+        info->timeTotal = spgTime() - tStart;
+
+    free(mem);
+    free(nnzIdx);
+    return (err < 0) ? err : 0;
+}
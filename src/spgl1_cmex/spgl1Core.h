@@ -0,0 +1,138 @@
+#ifndef _SPGL1CORE_H
+#define _SPGL1CORE_H
+
+/* ======================================================================
+ *
+ * spgl1Core.h
+ *
+ * Native SPGL1 (spectral projected gradient for L1 and group-L2 balls)
+ * for basis pursuit denoise, Lasso and group / MMV problems, following
+ * spgl1.m of SPGL1 1.8 iteration by iteration (without the optional
+ * LSQR subspace minimization).
+ *
+ * Complex vectors are stored interleaved (re, im), so the real inner
+ * product real(u'*v) is a plain dot product of the double arrays.
+ *
+ * This C source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ * ====================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* exit conditions, same codes as info.stat of spgl1.m */
+#define SPG_EXIT_ROOT_FOUND     1
+#define SPG_EXIT_BPSOL_FOUND    2
+#define SPG_EXIT_LEAST_SQUARES  3
+#define SPG_EXIT_OPTIMAL        4
+#define SPG_EXIT_ITERATIONS     5
+#define SPG_EXIT_LINE_ERROR     6
+#define SPG_EXIT_SUBOPTIMAL_BP  7
+#define SPG_EXIT_MATVEC_LIMIT   8
+#define SPG_EXIT_ACTIVE_SET     9
+
+/* error codes returned by spgSolve and by operator callbacks */
+#define SPG_ERR_MEMORY          -1
+#define SPG_ERR_OPERATOR        -2
+
+/* norm of the constraint */
+#define SPG_NORM_L1             1   /* sum_i w_i |x_i| */
+#define SPG_NORM_GROUP          2   /* sum_k w_k ||x_{G_k}||_2 */
+#define SPG_NORM_L12            3   /* sum_k w_k ||X(k,:)||_2 for x = X(:) with nGroups rows (MMV) */
+
+/*
+ * Linear operator A: x (n doubles) -> b (m doubles).
+ * apply(data, 1, x, y) computes y = A x, apply(data, 2, x, y) computes
+ * y = A' x; it returns 0 on success, anything else aborts the solver
+ * with SPG_ERR_OPERATOR.
+ */
+typedef struct
+{
+    long m;                 /* length of b in doubles */
+    long n;                 /* length of x in doubles */
+    int isComplex;          /* b is complex */
+    void *data;
+    int (*apply)(void *data, int mode, const double *x, double *y);
+} SpgOperator;
+
+typedef struct
+{
+    int type;               /* SPG_NORM_L1 or SPG_NORM_GROUP */
+    int isComplex;          /* entries of x are complex */
+    long nEntries;          /* number of entries of x */
+    const double *weights;  /* one per entry (L1) or per group, NULL for all ones */
+    double weight;          /* scalar weight used when weights is NULL */
+    const int *groups;      /* SPG_NORM_GROUP: 0-based group of every entry */
+    long nGroups;           /* number of groups (rows of X for SPG_NORM_L12) */
+} SpgNorm;
+
+typedef struct
+{
+    int verbosity;          /* 0: silent, 1: some output, 2: every iteration */
+    int iterations;         /* maximum number of iterations */
+    int nPrevVals;          /* number of previous function values for the line search */
+    double bpTol;
+    double lsTol;
+    double optTol;
+    double decTol;
+    double stepMin;
+    double stepMax;
+    double activeSetIt;     /* exit when the active set is fixed for this many iterations */
+    double maxMatvec;       /* maximum number of products with A and A' */
+} SpgOptions;
+
+typedef struct
+{
+    double tau;
+    double rNorm;
+    double rGap;
+    double gNorm;
+    int stat;
+    int iter;
+    int nProdA;
+    int nProdAt;
+    int nNewton;
+    int nLineTot;
+    double timeProject;
+    double timeMatProd;
+    double timeTotal;
+    double *xNorm1;         /* histories of length iter, malloc'ed, free with spgFreeInfo */
+    double *rNorm2;
+    double *lambda;
+} SpgInfo;
+
+typedef void (*SpgPrint)(const char *fmt, ...);
+
+/* default options of spgl1.m for m rows */
+void spgDefaultOptions(SpgOptions *opts, long m);
+
+/*
+ * Solves min ||x||_1 s.t. ||A x - b||_2 <= sigma (singleTau == 0) or
+ * min ||A x - b||_2 s.t. ||x||_1 <= tau (singleTau != 0), with ||.||_1 the
+ * (weighted, group) norm described by nrm.
+ * x holds the initial guess on input and the solution on output; r and g
+ * receive the residual b - A x and the gradient -A'r.
+ * Returns 0 on success (the exit condition is in info->stat) or an
+ * SPG_ERR_* code.
+ */
+int spgSolve(const SpgOperator *A, const SpgNorm *nrm, const double *b, double tau, double sigma, int singleTau,
+             double *x, double *r, double *g, const SpgOptions *opts, SpgInfo *info, SpgPrint print);
+
+/* Euclidean projection of x onto {z : ||z|| <= tau}, in place; work holds SPG_NORM_WORK(nrm) doubles */
+#define SPG_NORM_WORK(nrm) (6 * ((nrm)->nGroups > (nrm)->nEntries ? (nrm)->nGroups : (nrm)->nEntries))
+void spgProject(const SpgNorm *nrm, double *x, double tau, double *work);
+double spgPrimalNorm(const SpgNorm *nrm, const double *x, double *work);
+double spgDualNorm(const SpgNorm *nrm, const double *x, double *work);
+
+void spgFreeInfo(SpgInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
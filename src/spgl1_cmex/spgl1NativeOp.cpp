@@ -0,0 +1,267 @@
+/* ======================================================================
+ *
+ * spgl1NativeOp.cpp
+ *
+ * Operators applied natively by spgl1C_mex, selected by the field 'name'
+ * of the operator structure:
+ *
+ *   name = 'mask'      y = mask .* x (its own adjoint), real or complex
+ *       .mask              N1 x N2 (or any size) real weights, 1 at the recorded samples
+ *
+ *   name = 'curvelet'  y = mask .* real(C' x), the restricted synthesis of
+ *                      curveletMaskOp, x complex in CURVELET2VEC order, y real
+ *       .mask              N1 x N2 real mask (optional, all ones when absent)
+ *       .dims              [N1 N2] (required without .mask)
+ *       .nbscales          default floor(log2(min(N1,N2)))-3
+ *       .nbangles_coarse   default 16
+ *       .finest            1: curvelets, 2: wavelets at the finest level (default 2)
+ *
+ * The FFTW plans of the curvelet transform are shared across calls and
+ * released when the MEX file is cleared.
+ *
+ * This C++ source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ * ====================================================================== */
+
+#include <cmath>
+#include <new>
+#include "spgl1NativeOp.h"
+#include "curveletOp2d.hpp"
+
+
+static double getParam(const mxArray *params, const char *name, double def)
+{
+    mxArray *f = mxGetField(params, 0, name);
+    if (f == NULL || mxIsEmpty(f) || !mxIsNumeric(f))
+        return def;
+    return mxGetScalar(f);
+}
+
+/* real double array field, NULL when absent */
+static const mxArray* getArray(const mxArray *params, const char *name, const char **err)
+{
+    mxArray *f = mxGetField(params, 0, name);
+    if (f == NULL || mxIsEmpty(f))
+        return NULL;
+    if (!mxIsDouble(f) || mxIsComplex(f) || mxIsSparse(f))
+    {
+        *err = "The mask of a native operator should be a real full double array!";
+        return NULL;
+    }
+    return f;
+}
+
+
+/* ======================================================================
+ *
+ * Mask: y = mask .* x
+ *
+ * ====================================================================== */
+typedef struct
+{
+    const double *mask;
+    long n;
+    int s;                  /* 2 for interleaved complex vectors */
+} MaskOp;
+
+static void* maskCreate(const mxArray *params, long *m, long *n, int *complexX, int *complexB, const char **err)
+{
+    const mxArray *mask = getArray(params, "mask", err);
+    MaskOp *op;
+    if (mask == NULL)
+    {
+        if (*err == NULL)
+            *err = "The mask operator needs the field mask!";
+        return NULL;
+    }
+    op = new (std::nothrow) MaskOp;
+    if (op == NULL)
+    {
+        *err = "Out of memory in spgl1C!";
+        return NULL;
+    }
+    op->mask = mxGetPr(mask);
+    op->n = (long)mxGetNumberOfElements(mask);
+    *complexX = *complexB = (*complexX || *complexB);
+    op->s = 1 + *complexX;
+    *m = *n = op->n;
+    return op;
+}
+
+static int maskApply(void *state, int mode, const double *x, double *y)
+{
+    MaskOp *op = (MaskOp *)state;
+    long i;
+    int c;
+    (void)mode;
+#pragma omp parallel for private(c) schedule(static)
+    for (i = 0; i < op->n; i++)
+        for (c = 0; c < op->s; c++)
+            y[op->s*i+c] = op->mask[i] * x[op->s*i+c];
+    return 0;
+}
+
+static void maskDestroy(void *state)
+{
+    delete (MaskOp *)state;
+}
+
+
+/* ======================================================================
+ *
+ * Restricted curvelet synthesis: y = mask .* real(C' x), A' y = C (mask .* y)
+ *
+ * ====================================================================== */
+typedef struct
+{
+    CurveletOp2d *op;
+    const double *mask;     /* NULL for all ones */
+    std::vector<double> *r; /* masked data of the adjoint */
+} CurveletMaskOp;
+
+static void curveletDestroy(void *state)
+{
+    CurveletMaskOp *op = (CurveletMaskOp *)state;
+    if (op == NULL)
+        return;
+    delete op->op;
+    delete op->r;
+    delete op;
+}
+
+static void* curveletCreate(const mxArray *params, long *m, long *n, int *complexX, int *complexB, const char **err)
+{
+    const mxArray *mask = getArray(params, "mask", err), *dims;
+    CurveletMaskOp *op;
+    int n1, n2, nbscales, nbangles, ac;
+
+    if (*err)
+        return NULL;
+    if (mask)
+    {
+        if (mxGetNumberOfDimensions(mask) != 2)
+        {
+            *err = "The mask of the curvelet operator should be N1 x N2!";
+            return NULL;
+        }
+        n1 = (int)mxGetM(mask);
+        n2 = (int)mxGetN(mask);
+    }
+    else
+    {
+        dims = mxGetField(params, 0, "dims");
+        if (dims == NULL || !mxIsDouble(dims) || mxGetNumberOfElements(dims) != 2)
+        {
+            *err = "The curvelet operator needs the field mask or dims = [N1 N2]!";
+            return NULL;
+        }
+        n1 = (int)mxGetPr(dims)[0];
+        n2 = (int)mxGetPr(dims)[1];
+    }
+    if (*complexB)
+    {
+        *err = "The curvelet operator maps to real data: b should be real!";
+        return NULL;
+    }
+    nbscales = (int)getParam(params, "nbscales", floor(log2((double)std::min(n1, n2))) - 3);
+    nbangles = (int)getParam(params, "nbangles_coarse", 16);
+    ac = ((int)getParam(params, "finest", 2) == 1) ? 1 : 0;     /* finest = 1: curvelets, 2: wavelets */
+    if (n1 < 1 || n2 < 1 || nbscales < 2 || nbangles < 8 || nbangles % 4)
+    {
+        *err = "Curvelet operator needs nbscales >= 2 and nbangles_coarse a multiple of 4, at least 8!";
+        return NULL;
+    }
+
+    op = new (std::nothrow) CurveletMaskOp;
+    if (op == NULL)
+    {
+        *err = "Out of memory in spgl1C!";
+        return NULL;
+    }
+    op->op = NULL;
+    op->r = NULL;
+    op->mask = mask ? mxGetPr(mask) : NULL;
+    try
+    {
+        op->op = new CurveletOp2d(n1, n2, nbscales, nbangles, ac);
+        op->r = new std::vector<double>(op->op->nData());
+    }
+    catch (...)
+    {
+        curveletDestroy(op);
+        *err = "Out of memory in spgl1C!";
+        return NULL;
+    }
+    mexAtExit(fdct_wrapping_ns::fdct_wrapping_clearplans);
+
+    *complexX = 1;
+    *complexB = 0;
+    *m = op->op->nData();
+    *n = op->op->nCoef();
+    return op;
+}
+
+static int curveletApply(void *state, int mode, const double *x, double *y)
+{
+    CurveletMaskOp *op = (CurveletMaskOp *)state;
+    long i, n = op->op->nData();
+    try
+    {
+        if (mode == 1)
+        {
+            op->op->synthesis((const cpx *)x, y);
+            if (op->mask)
+            {
+#pragma omp parallel for schedule(static)
+                for (i = 0; i < n; i++)
+                    y[i] *= op->mask[i];
+            }
+        }
+        else
+        {
+            const double *r = x;
+            if (op->mask)
+            {
+                double *w = &(*op->r)[0];
+#pragma omp parallel for schedule(static)
+                for (i = 0; i < n; i++)
+                    w[i] = op->mask[i] * x[i];
+                r = w;
+            }
+            op->op->analysis(r, (cpx *)y);
+        }
+    }
+    catch (...)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+
+/* ====================================================================== */
+static const SpgNativeOp nativeOps[] =
+{
+    {"mask", maskCreate, maskApply, maskDestroy},
+    {"curvelet", curveletCreate, curveletApply, curveletDestroy}
+};
+
+const SpgNativeOp* spgFindNativeOp(const char *name)
+{
+    size_t k;
+    for (k = 0; k < sizeof(nativeOps) / sizeof(nativeOps[0]); k++)
+    {
+        if (strcmp(nativeOps[k].name, name) == 0)
+            return &nativeOps[k];
+    }
+    return NULL;
+}
+
+const char* spgNativeOpNames(void)
+{
+    return "mask, curvelet";
+}
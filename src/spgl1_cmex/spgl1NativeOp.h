@@ -0,0 +1,55 @@
+#ifndef _SPGL1NATIVEOP_H
+#define _SPGL1NATIVEOP_H
+
+/* ======================================================================
+ *
+ * spgl1NativeOp.h
+ *
+ * Registry of the operators spgl1C_mex applies natively, without calling
+ * back into MATLAB. spgl1C.m passes such an operator as a structure whose
+ * field 'name' selects the entry of the table; the other fields are the
+ * parameters of the operator (see spgl1NativeOp.cpp).
+ *
+ * Vectors are stored interleaved when complex, as in spgl1Core.h.
+ *
+ * This C++ source file is free for use in academic research.
+ * All rights reserved.
+ *
+ * Center for Signal and Information Processing, Center for Energy & Geo Processing
+ * Georgia Institute of Technology
+ *
+ * ====================================================================== */
+
+#include "mex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    const char *name;
+    /*
+     * Builds the operator from the parameter structure. On input complexX
+     * and complexB tell whether the caller has complex x and b; the
+     * operator sets them to the storage it works with and sets m and n to
+     * the number of entries of b and x of one block. Returns the operator
+     * state, or NULL with a message in *err.
+     */
+    void* (*create)(const mxArray *params, long *m, long *n, int *complexX, int *complexB, const char **err);
+    /* y = A x (mode 1) or y = A' x (mode 2) for one block, 0 on success */
+    int (*apply)(void *state, int mode, const double *x, double *y);
+    void (*destroy)(void *state);
+} SpgNativeOp;
+
+/* entry of the table with the given name, NULL if there is none */
+const SpgNativeOp* spgFindNativeOp(const char *name);
+
+/* names of all entries, separated by ", ", for error messages */
+const char* spgNativeOpNames(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif